@@ -0,0 +1,375 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpack.cpp
+// ============
+// single memory-mapped archive for the cooked scene assets
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AssetPack.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// "APAK" - asset pack
+	const unsigned int PACK_MAGIC = 0x4B415041;
+	const unsigned int PACK_VERSION = 1;
+	// asset data starts on a page, so uploads read whole mapped pages
+	const unsigned long long PACK_ALIGNMENT = 4096;
+
+	struct PACK_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int entryCount;
+		// bytes of names after the entries
+		unsigned int namesSize;
+	};
+
+	struct PACK_ENTRY
+	{
+		unsigned long long offset;
+		unsigned long long size;
+		unsigned int type;
+		unsigned int nameOffset;
+		unsigned int nameLength;
+		unsigned int reserved;
+	};
+}
+
+/***********************************************************
+ *  AssetPack()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AssetPack::AssetPack()
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_residentFraction = -1.0;
+#ifdef _WIN32
+	m_fileHandle = nullptr;
+	m_mappingHandle = nullptr;
+#endif
+}
+
+/***********************************************************
+ *  ~AssetPack()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to map a pack into memory and read
+ *  its index.  A missing pack is not reported, since the
+ *  loose files are used instead.  Before anything is read
+ *  the page cache is checked, which tells a cold start from
+ *  a warm one, and the kernel is asked to start reading the
+ *  rest of the file in the background.
+ ***********************************************************/
+bool AssetPack::Open(const char* filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+	{
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	if (mapping == nullptr)
+	{
+		std::cout << "ERROR: Could not map asset pack " << filePath << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_size = (size_t)fileSize.QuadPart;
+	m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int file = open(filePath, O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat fileInfo;
+	if ((fstat(file, &fileInfo) != 0) || (fileInfo.st_size <= 0))
+	{
+		std::cout << "ERROR: Could not map asset pack " << filePath << std::endl;
+		close(file);
+		return false;
+	}
+	m_size = (size_t)fileInfo.st_size;
+	void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, file, 0);
+	// the mapping keeps the file open by itself
+	close(file);
+	m_data = (mapped == MAP_FAILED) ? nullptr : (const unsigned char*)mapped;
+#endif
+	if (nullptr == m_data)
+	{
+		std::cout << "ERROR: Could not map asset pack " << filePath << std::endl;
+		Close();
+		return false;
+	}
+
+#ifdef __linux__
+	long pageSize = sysconf(_SC_PAGESIZE);
+	std::vector<unsigned char> resident((m_size + pageSize - 1) / pageSize);
+	if (mincore((void*)m_data, m_size, resident.data()) == 0)
+	{
+		size_t residentPages = 0;
+		for (unsigned char page : resident)
+		{
+			residentPages += (page & 1);
+		}
+		m_residentFraction = (double)residentPages / resident.size();
+	}
+	madvise((void*)m_data, m_size, MADV_WILLNEED);
+#endif
+
+	PACK_HEADER header;
+	if (m_size < sizeof(header))
+	{
+		header.magic = 0;
+	}
+	else
+	{
+		memcpy(&header, m_data, sizeof(header));
+	}
+	size_t indexSize = sizeof(PACK_HEADER) + (size_t)header.entryCount * sizeof(PACK_ENTRY) + header.namesSize;
+	if ((header.magic != PACK_MAGIC) || (header.version != PACK_VERSION) || (indexSize > m_size))
+	{
+		std::cout << "ERROR: " << filePath << " is not a version " << PACK_VERSION << " asset pack" << std::endl;
+		Close();
+		return false;
+	}
+
+	const char* names = (const char*)m_data + sizeof(PACK_HEADER) + header.entryCount * sizeof(PACK_ENTRY);
+	for (unsigned int i = 0; i < header.entryCount; i++)
+	{
+		PACK_ENTRY entry;
+		memcpy(&entry, m_data + sizeof(PACK_HEADER) + i * sizeof(PACK_ENTRY), sizeof(entry));
+		if (((unsigned long long)entry.nameOffset + entry.nameLength > header.namesSize) ||
+			(entry.offset > m_size) || (entry.size > m_size - entry.offset))
+		{
+			std::cout << "ERROR: Asset pack " << filePath << " has a bad entry " << i << std::endl;
+			Close();
+			return false;
+		}
+
+		ASSET asset;
+		asset.type = (ASSET_TYPE)entry.type;
+		asset.data = m_data + entry.offset;
+		asset.size = (size_t)entry.size;
+		m_assets[std::string(names + entry.nameOffset, entry.nameLength)] = asset;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used to unmap the pack.  Every pointer
+ *  into it is invalid afterwards.
+ ***********************************************************/
+void AssetPack::Close()
+{
+	m_assets.clear();
+#ifdef _WIN32
+	if (nullptr != m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (nullptr != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+		m_mappingHandle = nullptr;
+	}
+	if (nullptr != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+		m_fileHandle = nullptr;
+	}
+#else
+	if (nullptr != m_data)
+	{
+		munmap((void*)m_data, m_size);
+	}
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_residentFraction = -1.0;
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used to look up an asset by name.
+ ***********************************************************/
+const AssetPack::ASSET* AssetPack::Find(const std::string& name) const
+{
+	std::unordered_map<std::string, ASSET>::const_iterator found = m_assets.find(name);
+	if (found == m_assets.end())
+	{
+		return nullptr;
+	}
+	return &found->second;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to write the index and then every
+ *  file's bytes, each padded out to a page.  The pack is
+ *  written to a temporary name and renamed, so a running
+ *  app never maps a half written file.
+ ***********************************************************/
+bool AssetPack::Build(const char* filePath, const std::vector<SOURCE_FILE>& files)
+{
+	std::vector<std::string> names;
+	std::string nameTable;
+	for (const SOURCE_FILE& file : files)
+	{
+		names.push_back(GetAssetName(file.filePath));
+		nameTable += names.back();
+	}
+
+	PACK_HEADER header;
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.entryCount = (unsigned int)files.size();
+	header.namesSize = (unsigned int)nameTable.size();
+
+	// the data offsets are known up front from the file sizes
+	std::vector<PACK_ENTRY> entries(files.size());
+	unsigned long long offset = sizeof(PACK_HEADER) + entries.size() * sizeof(PACK_ENTRY) + nameTable.size();
+	unsigned int nameOffset = 0;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		std::ifstream source(files[i].filePath, std::ios::binary | std::ios::ate);
+		if (!source.is_open())
+		{
+			std::cout << "ERROR: Could not open " << files[i].filePath << std::endl;
+			return false;
+		}
+		offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+		entries[i].offset = offset;
+		entries[i].size = (unsigned long long)source.tellg();
+		entries[i].type = (unsigned int)files[i].type;
+		entries[i].nameOffset = nameOffset;
+		entries[i].nameLength = (unsigned int)names[i].size();
+		entries[i].reserved = 0;
+		offset += entries[i].size;
+		nameOffset += entries[i].nameLength;
+	}
+
+	std::string tempPath = std::string(filePath) + ".tmp";
+	{
+		std::ofstream pack(tempPath, std::ios::binary | std::ios::trunc);
+		if (!pack.is_open())
+		{
+			std::cout << "ERROR: Could not write " << filePath << std::endl;
+			return false;
+		}
+		pack.write((const char*)&header, sizeof(header));
+		pack.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PACK_ENTRY)));
+		pack.write(nameTable.data(), (std::streamsize)nameTable.size());
+
+		std::vector<char> buffer;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			while ((unsigned long long)pack.tellp() < entries[i].offset)
+			{
+				pack.put(0);
+			}
+			std::ifstream source(files[i].filePath, std::ios::binary);
+			buffer.resize((size_t)entries[i].size);
+			if (!source.read(buffer.data(), (std::streamsize)buffer.size()) ||
+				!pack.write(buffer.data(), (std::streamsize)buffer.size()))
+			{
+				std::cout << "ERROR: Could not pack " << files[i].filePath << std::endl;
+				pack.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+	}
+
+	std::remove(filePath);
+	if (std::rename(tempPath.c_str(), filePath) != 0)
+	{
+		std::cout << "ERROR: Could not write " << filePath << std::endl;
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  GetTypeFromName()
+ *
+ *  This method is used to pick the asset type from a file
+ *  extension.  Unknown extensions are packed as ASSET_OTHER.
+ ***********************************************************/
+AssetPack::ASSET_TYPE AssetPack::GetTypeFromName(const std::string& name)
+{
+	size_t dot = name.find_last_of('.');
+	std::string extension = (dot == std::string::npos) ? "" : name.substr(dot);
+	if (extension == ".ktx2")
+	{
+		return ASSET_TEXTURE;
+	}
+	if (extension == ".mesh")
+	{
+		return ASSET_MESH;
+	}
+	if ((extension == ".glsl") || (extension == ".vert") || (extension == ".frag"))
+	{
+		return ASSET_SHADER;
+	}
+	if (extension == ".mat")
+	{
+		return ASSET_MATERIAL;
+	}
+	return ASSET_OTHER;
+}
+
+/***********************************************************
+ *  GetAssetName()
+ *
+ *  This method is used to strip the folders from a path.
+ ***********************************************************/
+std::string AssetPack::GetAssetName(const std::string& filePath)
+{
+	size_t slash = filePath.find_last_of("/\\");
+	return (slash == std::string::npos) ? filePath : filePath.substr(slash + 1);
+}
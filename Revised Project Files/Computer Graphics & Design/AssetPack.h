@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpack.h
+// ============
+// single memory-mapped archive for the cooked scene assets
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  AssetPack
+ *
+ *  This class opens a pack built by the AssetPacker tool.
+ *  The file starts with an index of every asset, and each
+ *  asset's bytes start on a page boundary.  The whole file is
+ *  memory mapped, so finding an asset costs no file open and
+ *  no copy - callers read, or upload to the GPU, straight
+ *  from the mapped pages.
+ ***********************************************************/
+class AssetPack
+{
+public:
+	enum ASSET_TYPE
+	{
+		ASSET_OTHER,
+		ASSET_TEXTURE,
+		ASSET_MESH,
+		ASSET_SHADER,
+		ASSET_MATERIAL
+	};
+
+	// one asset - the data points into the mapped file
+	struct ASSET
+	{
+		ASSET_TYPE type;
+		const unsigned char* data;
+		size_t size;
+	};
+
+	// a file to be written into a pack by Build()
+	struct SOURCE_FILE
+	{
+		std::string filePath;
+		ASSET_TYPE type;
+	};
+
+	// constructor
+	AssetPack();
+	// destructor
+	~AssetPack();
+
+	// map a pack and read its index, false if it is missing or broken
+	bool Open(const char* filePath);
+	void Close();
+	bool IsOpen() const { return nullptr != m_data; }
+
+	// find an asset by file name ("floor_tile.ktx2"), nullptr when not packed
+	const ASSET* Find(const std::string& name) const;
+	int GetAssetCount() const { return (int)m_assets.size(); }
+
+	// how much of the pack was already in memory when it was opened,
+	// 1 for a warm start, or -1 where this cannot be measured
+	double GetResidentFraction() const { return m_residentFraction; }
+
+	// write a pack holding the passed in files
+	static bool Build(const char* filePath, const std::vector<SOURCE_FILE>& files);
+	// the asset type a file extension is packed as
+	static ASSET_TYPE GetTypeFromName(const std::string& name);
+	// the name an asset is found by - the file name without its folders
+	static std::string GetAssetName(const std::string& filePath);
+
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+	double m_residentFraction;
+	std::unordered_map<std::string, ASSET> m_assets;
+
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+};
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+// assetpacker.cpp
+// ============
+// offline tool that writes the cooked assets into one memory-mapped pack
+//
+//  Build this file with AssetPack.cpp as its own executable.  Run it after
+//  TextureCook and MeshCook, so the packed textures and models are the
+//  compressed .ktx2 and binary .mesh files:
+//
+//    AssetPacker --out ../../Utilities/assets.pack
+//        --dir ../../Utilities/textures --dir ../../Utilities/shaders
+//        --dir ../../Utilities/models
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <filesystem>       // --dir folder listing
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AssetPack.h"
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function is used to collect the files named on the
+ *  command line, or found in the --dir folders, and write
+ *  them into the pack.  Folders only add the known asset
+ *  types, so the source images next to the cooked textures
+ *  are left out.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	const char* outputPath = nullptr;
+	std::vector<AssetPack::SOURCE_FILE> files;
+	// assets are found by file name, so two files cannot share one
+	std::set<std::string> names;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::vector<std::string> paths;
+		if ((strcmp(argv[i], "--out") == 0) && (i + 1 < argc))
+		{
+			outputPath = argv[++i];
+			continue;
+		}
+		else if ((strcmp(argv[i], "--dir") == 0) && (i + 1 < argc))
+		{
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(argv[++i], error))
+			{
+				if (entry.is_regular_file() &&
+					(AssetPack::GetTypeFromName(entry.path().string()) != AssetPack::ASSET_OTHER))
+				{
+					paths.push_back(entry.path().string());
+				}
+			}
+			if (error)
+			{
+				std::cout << "ERROR: Could not list " << argv[i] << std::endl;
+				return(EXIT_FAILURE);
+			}
+		}
+		else if (argv[i][0] == '-')
+		{
+			std::cout << "Unknown option: " << argv[i] << std::endl;
+			continue;
+		}
+		else
+		{
+			paths.push_back(argv[i]);
+		}
+
+		for (const std::string& path : paths)
+		{
+			if (names.insert(AssetPack::GetAssetName(path)).second == false)
+			{
+				std::cout << "ERROR: More than one asset is named " << AssetPack::GetAssetName(path) << std::endl;
+				return(EXIT_FAILURE);
+			}
+			AssetPack::SOURCE_FILE file;
+			file.filePath = path;
+			file.type = AssetPack::GetTypeFromName(path);
+			files.push_back(file);
+		}
+	}
+
+	if ((nullptr == outputPath) || files.empty())
+	{
+		std::cout << "Usage: AssetPacker --out FILE [--dir FOLDER] [file ...]" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	if (AssetPack::Build(outputPath, files) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	std::cout << "Packed " << files.size() << " assets into " << outputPath << std::endl;
+	return(EXIT_SUCCESS);
+}
@@ -0,0 +1,393 @@
+///////////////////////////////////////////////////////////////////////////////
+// blockcompression.cpp
+// ============
+// BC1, BC3 and BC7 encoders for the offline texture cook
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BlockCompression.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// helpers shared by the encoders
+namespace
+{
+	// BC7 interpolation weights for 4 bit indices (out of 64)
+	const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	/***********************************************************
+	 *  FindEndpoints()
+	 *
+	 *  This function is used to fit a line through the block
+	 *  texels.  The line runs along the principal axis of the
+	 *  first channelCount channels, found by power iteration on
+	 *  the covariance, and ends at the outermost texels.
+	 ***********************************************************/
+	void FindEndpoints(const unsigned char texels[64], int channelCount, float start[4], float end[4])
+	{
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < channelCount; c++)
+			{
+				mean[c] += texels[i * 4 + c] / 16.0f;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			for (int a = 0; a < channelCount; a++)
+			{
+				for (int b = 0; b < channelCount; b++)
+				{
+					covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+				}
+			}
+		}
+
+		// start from the channel with the most spread, so the guess
+		// is never at right angles to the real axis
+		float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		int widest = 0;
+		for (int c = 1; c < channelCount; c++)
+		{
+			if (covariance[c][c] > covariance[widest][widest])
+			{
+				widest = c;
+			}
+		}
+		for (int c = 0; c < channelCount; c++)
+		{
+			axis[c] = covariance[widest][c];
+		}
+
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float length = 0.0f;
+			for (int a = 0; a < channelCount; a++)
+			{
+				for (int b = 0; b < channelCount; b++)
+				{
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+			length = std::sqrt(length);
+			// a flat block has no axis, both endpoints are the mean
+			if (length < 1e-6f)
+			{
+				memset(axis, 0, sizeof(axis));
+				break;
+			}
+			for (int c = 0; c < channelCount; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float minT = 0.0f;
+		float maxT = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channelCount; c++)
+			{
+				t += (texels[i * 4 + c] - mean[c]) * axis[c];
+			}
+			minT = (i == 0) ? t : std::fmin(minT, t);
+			maxT = (i == 0) ? t : std::fmax(maxT, t);
+		}
+
+		for (int c = 0; c < 4; c++)
+		{
+			start[c] = (c < channelCount) ? std::fmin(std::fmax(mean[c] + axis[c] * minT, 0.0f), 255.0f) : 255.0f;
+			end[c] = (c < channelCount) ? std::fmin(std::fmax(mean[c] + axis[c] * maxT, 0.0f), 255.0f) : 255.0f;
+		}
+	}
+
+	/***********************************************************
+	 *  Pack565() / Unpack565()
+	 *
+	 *  These functions are used to convert between 8 bit RGB
+	 *  and the 5:6:5 endpoint colors of a BC1 block.
+	 ***********************************************************/
+	unsigned short Pack565(const float color[4])
+	{
+		int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	void Unpack565(unsigned short packed, int color[3])
+	{
+		int r = (packed >> 11) & 0x1F;
+		int g = (packed >> 5) & 0x3F;
+		int b = packed & 0x1F;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	/***********************************************************
+	 *  WriteBits()
+	 *
+	 *  This function is used to append a value to a block,
+	 *  least significant bit first, as the BC7 layout expects.
+	 ***********************************************************/
+	void WriteBits(unsigned char* block, int& bitPosition, unsigned int value, int bitCount)
+	{
+		for (int i = 0; i < bitCount; i++)
+		{
+			if ((value >> i) & 1)
+			{
+				block[bitPosition >> 3] |= (unsigned char)(1 << (bitPosition & 7));
+			}
+			bitPosition++;
+		}
+	}
+
+	/***********************************************************
+	 *  QuantizeBC7Endpoint()
+	 *
+	 *  This function is used to reduce an endpoint to 7 bits
+	 *  per channel plus the shared p-bit that gives the eighth
+	 *  bit.  Both p-bit values are tried and the closer kept.
+	 ***********************************************************/
+	void QuantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pBit)
+	{
+		float bestError = -1.0f;
+		for (int p = 0; p < 2; p++)
+		{
+			int candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				int q = (int)std::floor((endpoint[c] - p) / 2.0f + 0.5f);
+				candidate[c] = (q < 0) ? 0 : ((q > 127) ? 127 : q);
+				float difference = endpoint[c] - (float)((candidate[c] << 1) | p);
+				error += difference * difference;
+			}
+			if ((bestError < 0.0f) || (error < bestError))
+			{
+				bestError = error;
+				pBit = p;
+				memcpy(quantized, candidate, sizeof(candidate));
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  EncodeBC1()
+ *
+ *  This function is used to encode a block as BC1.  The two
+ *  endpoints are stored with color0 > color1, which selects
+ *  the four color mode with no transparent index.
+ ***********************************************************/
+void BlockCompression::EncodeBC1(const unsigned char texels[64], unsigned char block[8])
+{
+	float start[4];
+	float end[4];
+	FindEndpoints(texels, 3, start, end);
+
+	unsigned short color0 = Pack565(end);
+	unsigned short color1 = Pack565(start);
+	if (color0 < color1)
+	{
+		unsigned short swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	int palette[4][3];
+	Unpack565(color0, palette[0]);
+	Unpack565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+	}
+
+	unsigned int indices = 0;
+	// equal endpoints leave every index at 0
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestError = -1;
+			for (int p = 0; p < 4; p++)
+			{
+				int error = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int difference = texels[i * 4 + c] - palette[p][c];
+					error += difference * difference;
+				}
+				if ((bestError < 0) || (error < bestError))
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			indices |= (unsigned int)bestIndex << (i * 2);
+		}
+	}
+
+	block[0] = (unsigned char)(color0 & 0xFF);
+	block[1] = (unsigned char)(color0 >> 8);
+	block[2] = (unsigned char)(color1 & 0xFF);
+	block[3] = (unsigned char)(color1 >> 8);
+	for (int i = 0; i < 4; i++)
+	{
+		block[4 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+	}
+}
+
+/***********************************************************
+ *  EncodeBC3()
+ *
+ *  This function is used to encode a block as BC3.  The
+ *  alpha goes in an 8 level block between the lowest and
+ *  highest alpha, followed by a BC1 color block.
+ ***********************************************************/
+void BlockCompression::EncodeBC3(const unsigned char texels[64], unsigned char block[16])
+{
+	int alpha0 = texels[3];
+	int alpha1 = texels[3];
+	for (int i = 1; i < 16; i++)
+	{
+		alpha0 = (texels[i * 4 + 3] > alpha0) ? texels[i * 4 + 3] : alpha0;
+		alpha1 = (texels[i * 4 + 3] < alpha1) ? texels[i * 4 + 3] : alpha1;
+	}
+
+	// alpha0 > alpha1 selects the 8 level mode
+	int levels[8];
+	levels[0] = alpha0;
+	levels[1] = alpha1;
+	for (int i = 2; i < 8; i++)
+	{
+		levels[i] = ((8 - i) * alpha0 + (i - 1) * alpha1 + 3) / 7;
+	}
+
+	unsigned long long indices = 0;
+	if (alpha0 != alpha1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestError = 256;
+			for (int level = 0; level < 8; level++)
+			{
+				int error = std::abs(texels[i * 4 + 3] - levels[level]);
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = level;
+				}
+			}
+			indices |= (unsigned long long)bestIndex << (i * 3);
+		}
+	}
+
+	block[0] = (unsigned char)alpha0;
+	block[1] = (unsigned char)alpha1;
+	for (int i = 0; i < 6; i++)
+	{
+		block[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+	}
+
+	EncodeBC1(texels, block + 8);
+}
+
+/***********************************************************
+ *  EncodeBC7()
+ *
+ *  This function is used to encode a block as BC7 mode 6:
+ *  one RGBA line with 7 bit endpoints, a p-bit for each
+ *  endpoint, and 4 bit indices.  The first texel's index
+ *  must have its top bit clear, so the endpoints are swapped
+ *  when it does not.
+ ***********************************************************/
+void BlockCompression::EncodeBC7(const unsigned char texels[64], unsigned char block[16])
+{
+	float start[4];
+	float end[4];
+	FindEndpoints(texels, 4, start, end);
+
+	int endpoints[2][4];
+	int pBits[2];
+	QuantizeBC7Endpoint(start, endpoints[0], pBits[0]);
+	QuantizeBC7Endpoint(end, endpoints[1], pBits[1]);
+
+	int palette[16][4];
+	for (int c = 0; c < 4; c++)
+	{
+		int e0 = (endpoints[0][c] << 1) | pBits[0];
+		int e1 = (endpoints[1][c] << 1) | pBits[1];
+		for (int i = 0; i < 16; i++)
+		{
+			palette[i][c] = ((64 - BC7_WEIGHTS[i]) * e0 + BC7_WEIGHTS[i] * e1 + 32) >> 6;
+		}
+	}
+
+	int indices[16];
+	for (int i = 0; i < 16; i++)
+	{
+		int bestError = -1;
+		for (int p = 0; p < 16; p++)
+		{
+			int error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				int difference = texels[i * 4 + c] - palette[p][c];
+				error += difference * difference;
+			}
+			if ((bestError < 0) || (error < bestError))
+			{
+				bestError = error;
+				indices[i] = p;
+			}
+		}
+	}
+
+	if (indices[0] & 8)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			int swap = endpoints[0][c];
+			endpoints[0][c] = endpoints[1][c];
+			endpoints[1][c] = swap;
+		}
+		int swap = pBits[0];
+		pBits[0] = pBits[1];
+		pBits[1] = swap;
+		for (int i = 0; i < 16; i++)
+		{
+			indices[i] = 15 - indices[i];
+		}
+	}
+
+	memset(block, 0, 16);
+	int bitPosition = 0;
+	// mode 6 is six zero bits and then a one
+	WriteBits(block, bitPosition, 1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		WriteBits(block, bitPosition, endpoints[0][c], 7);
+		WriteBits(block, bitPosition, endpoints[1][c], 7);
+	}
+	WriteBits(block, bitPosition, pBits[0], 1);
+	WriteBits(block, bitPosition, pBits[1], 1);
+	// the anchor index drops its (always zero) top bit
+	WriteBits(block, bitPosition, indices[0], 3);
+	for (int i = 1; i < 16; i++)
+	{
+		WriteBits(block, bitPosition, indices[i], 4);
+	}
+}
@@ -0,0 +1,27 @@
+///////////////////////////////////////////////////////////////////////////////
+// blockcompression.h
+// ============
+// BC1, BC3 and BC7 encoders for the offline texture cook
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  BlockCompression
+ *
+ *  These functions encode one 4x4 block of RGBA8 texels
+ *  (row by row, 64 bytes) into the GPU block formats.  They
+ *  favour simple, predictable quality over speed, since they
+ *  only run when the textures are cooked.
+ *
+ *  BC1 - RGB, 8 bytes per block (opaque textures)
+ *  BC3 - RGB plus a separate alpha block, 16 bytes
+ *  BC7 - RGBA with 7 bit endpoints and 16 levels (mode 6), 16 bytes
+ ***********************************************************/
+namespace BlockCompression
+{
+	void EncodeBC1(const unsigned char texels[64], unsigned char block[8]);
+	void EncodeBC3(const unsigned char texels[64], unsigned char block[16]);
+	void EncodeBC7(const unsigned char texels[64], unsigned char block[16]);
+}
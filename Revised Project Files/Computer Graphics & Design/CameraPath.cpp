@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// scripted camera path for headless and benchmark runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// the default orbit - it matches the starting camera of the window
+	const int DEFAULT_KEYFRAMES = 8;
+	const float DEFAULT_RADIUS = 12.0f;
+	const float DEFAULT_HEIGHT = 5.0f;
+	const glm::vec3 DEFAULT_TARGET = glm::vec3(0.0f, 1.5f, 0.0f);
+
+	/***********************************************************
+	 *  CatmullRom()
+	 *
+	 *  This function is used to blend between p1 and p2 using
+	 *  their neighbors to keep the curve smooth.
+	 ***********************************************************/
+	glm::vec3 CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+		return 0.5f * ((2.0f * p1) +
+			(-p0 + p2) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+	}
+}
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+}
+
+/***********************************************************
+ *  LoadFromFile()
+ *
+ *  This method is used to read the keyframes from a text
+ *  file.  Blank lines and lines starting with '#' are
+ *  skipped, and the keyframes are sorted by time.
+ ***********************************************************/
+bool CameraPath::LoadFromFile(const char* filePath)
+{
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not open camera path " << filePath << std::endl;
+		return false;
+	}
+
+	m_keyframes.clear();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if ((first == std::string::npos) || (line[first] == '#'))
+		{
+			continue;
+		}
+
+		KEYFRAME keyframe;
+		std::istringstream values(line);
+		if (!(values >> keyframe.time
+			>> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+			>> keyframe.target.x >> keyframe.target.y >> keyframe.target.z))
+		{
+			std::cout << "ERROR: Bad camera keyframe on line " << lineNumber << " of " << filePath << std::endl;
+			return false;
+		}
+		m_keyframes.push_back(keyframe);
+	}
+
+	if (m_keyframes.empty())
+	{
+		std::cout << "ERROR: Camera path " << filePath << " has no keyframes" << std::endl;
+		return false;
+	}
+
+	std::sort(m_keyframes.begin(), m_keyframes.end(),
+		[](const KEYFRAME& a, const KEYFRAME& b) { return a.time < b.time; });
+	return true;
+}
+
+/***********************************************************
+ *  CreateDefaultPath()
+ *
+ *  This method is used to build a full orbit around the
+ *  desk, starting and ending at the default camera position.
+ ***********************************************************/
+void CameraPath::CreateDefaultPath()
+{
+	m_keyframes.clear();
+	for (int i = 0; i <= DEFAULT_KEYFRAMES; i++)
+	{
+		float angle = glm::radians(360.0f) * i / DEFAULT_KEYFRAMES;
+		KEYFRAME keyframe;
+		keyframe.time = (float)i / DEFAULT_KEYFRAMES;
+		keyframe.position = glm::vec3(
+			DEFAULT_RADIUS * std::sin(angle),
+			DEFAULT_HEIGHT,
+			DEFAULT_RADIUS * std::cos(angle));
+		keyframe.target = DEFAULT_TARGET;
+		m_keyframes.push_back(keyframe);
+	}
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used to get the camera at a point along
+ *  the path.  t runs from 0 to 1 over the keyframe times.
+ ***********************************************************/
+void CameraPath::Evaluate(float t, glm::vec3& position, glm::vec3& front) const
+{
+	if (m_keyframes.empty())
+	{
+		return;
+	}
+
+	// map t onto the keyframe times
+	float startTime = m_keyframes.front().time;
+	float endTime = m_keyframes.back().time;
+	float time = startTime + (endTime - startTime) * std::max(0.0f, std::min(t, 1.0f));
+
+	// find the segment holding the time
+	int last = (int)m_keyframes.size() - 1;
+	int segment = 0;
+	while ((segment < last - 1) && (m_keyframes[segment + 1].time < time))
+	{
+		segment++;
+	}
+
+	int i0 = std::max(segment - 1, 0);
+	int i1 = segment;
+	int i2 = std::min(segment + 1, last);
+	int i3 = std::min(segment + 2, last);
+
+	float segmentLength = m_keyframes[i2].time - m_keyframes[i1].time;
+	float local = (segmentLength > 0.0f) ? ((time - m_keyframes[i1].time) / segmentLength) : 0.0f;
+
+	position = CatmullRom(m_keyframes[i0].position, m_keyframes[i1].position,
+		m_keyframes[i2].position, m_keyframes[i3].position, local);
+	glm::vec3 target = CatmullRom(m_keyframes[i0].target, m_keyframes[i1].target,
+		m_keyframes[i2].target, m_keyframes[i3].target, local);
+
+	front = target - position;
+	if (glm::length(front) > 0.0f)
+	{
+		front = glm::normalize(front);
+	}
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// scripted camera path for headless and benchmark runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class holds a list of camera keyframes and blends
+ *  between them with a Catmull-Rom spline, so a run can move
+ *  the camera the same way every time with no user input.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	struct KEYFRAME
+	{
+		float time;
+		glm::vec3 position;
+		glm::vec3 target;
+	};
+
+	// constructor
+	CameraPath();
+
+	// read keyframes from a text file, one "time px py pz tx ty tz" per line
+	bool LoadFromFile(const char* filePath);
+	// a slow orbit around the desk, used when no file is given
+	void CreateDefaultPath();
+
+	// camera position and view direction at t, from 0 to 1 along the path
+	void Evaluate(float t, glm::vec3& position, glm::vec3& front) const;
+
+	int GetKeyframeCount() const { return (int)m_keyframes.size(); }
+
+private:
+	std::vector<KEYFRAME> m_keyframes;
+};
@@ -0,0 +1,494 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusterculler.cpp
+// ============
+// cull the meshlets of the large meshes against the view each frame
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusterCuller.h"
+#include "MeshPool.h"
+#include "MeshletBuilder.h"
+#include "ShaderUtils.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// meshes that split into fewer meshlets are drawn whole, since
+	// culling them would cost more than the triangles it saves
+	const int MIN_MESHLETS = 4;
+	// meshlets tested by one compute work group
+	const int CULL_GROUP_SIZE = 64;
+
+	const char* g_CullComputeShader = R"(
+#version 430 core
+layout(local_size_x = 64) in;
+
+struct Meshlet
+{
+	vec4 sphere;
+	vec4 cone;
+	uint firstIndex;
+	uint indexCount;
+	int baseVertex;
+	uint padding;
+};
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer Meshlets { Meshlet meshlets[]; };
+layout(std430, binding = 1) writeonly buffer DrawCommands { DrawCommand commands[]; };
+
+uniform mat4 model;
+uniform float modelScale;
+uniform vec4 frustumPlanes[6];
+// in mesh space
+uniform vec3 cameraPosition;
+uniform bool coneCulling;
+uniform uint firstMeshlet;
+uniform uint meshletCount;
+uniform uint firstCommand;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= meshletCount)
+	{
+		return;
+	}
+	Meshlet meshlet = meshlets[firstMeshlet + index];
+
+	vec3 center = (model * vec4(meshlet.sphere.xyz, 1.0)).xyz;
+	float radius = meshlet.sphere.w * modelScale;
+	bool visible = true;
+	for (int i = 0; i < 6; i++)
+	{
+		visible = visible && (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w > -radius);
+	}
+	if (coneCulling)
+	{
+		vec3 toMeshlet = meshlet.sphere.xyz - cameraPosition;
+		visible = visible && (dot(toMeshlet, meshlet.cone.xyz) < meshlet.cone.w * length(toMeshlet) + meshlet.sphere.w);
+	}
+
+	commands[firstCommand + index] = DrawCommand(meshlet.indexCount, visible ? 1u : 0u,
+		meshlet.firstIndex, meshlet.baseVertex, 0u);
+}
+)";
+}
+
+/***********************************************************
+ *  ClusterCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusterCuller::ClusterCuller()
+{
+	m_uploadedMeshlets = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		m_frustumPlanes[i] = glm::vec4(0.0f);
+	}
+	m_viewPosition = glm::vec3(0.0f);
+	m_bOrthographic = false;
+	m_commandCount = 0;
+	m_cullProgram = 0;
+	m_modelLocation = -1;
+	m_modelScaleLocation = -1;
+	m_frustumPlanesLocation = -1;
+	m_cameraPositionLocation = -1;
+	m_coneCullingLocation = -1;
+	m_firstMeshletLocation = -1;
+	m_meshletCountLocation = -1;
+	m_firstCommandLocation = -1;
+	m_meshletBuffer = 0;
+	m_commandBuffer = 0;
+	m_commandCapacity = 0;
+}
+
+/***********************************************************
+ *  ~ClusterCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusterCuller::~ClusterCuller()
+{
+	glDeleteProgram(m_cullProgram);
+	glDeleteBuffers(1, &m_meshletBuffer);
+	glDeleteBuffers(1, &m_commandBuffer);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to compile the compute program that
+ *  culls the meshlets.  Without OpenGL 4.3, or if it fails
+ *  to build, the meshlets are culled on the CPU instead, so
+ *  this only reports which path is used.
+ ***********************************************************/
+bool ClusterCuller::Initialize()
+{
+	if (GLEW_VERSION_4_3)
+	{
+		m_cullProgram = ShaderUtils::CreateComputeProgram(g_CullComputeShader, "meshlet cull");
+	}
+	if (m_cullProgram != 0)
+	{
+		m_modelLocation = glGetUniformLocation(m_cullProgram, "model");
+		m_modelScaleLocation = glGetUniformLocation(m_cullProgram, "modelScale");
+		m_frustumPlanesLocation = glGetUniformLocation(m_cullProgram, "frustumPlanes");
+		m_cameraPositionLocation = glGetUniformLocation(m_cullProgram, "cameraPosition");
+		m_coneCullingLocation = glGetUniformLocation(m_cullProgram, "coneCulling");
+		m_firstMeshletLocation = glGetUniformLocation(m_cullProgram, "firstMeshlet");
+		m_meshletCountLocation = glGetUniformLocation(m_cullProgram, "meshletCount");
+		m_firstCommandLocation = glGetUniformLocation(m_cullProgram, "firstCommand");
+		glGenBuffers(1, &m_meshletBuffer);
+		glGenBuffers(1, &m_commandBuffer);
+	}
+
+	std::cout << "INFO: Meshlet culling on the " << ((m_cullProgram != 0) ? "GPU" : "CPU") << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used to build the meshlets of a mesh
+ *  that has just been added to the pool, from the same
+ *  vertices and indices.  The meshlet index ranges are
+ *  moved to where the mesh sits in the shared buffers.
+ ***********************************************************/
+bool ClusterCuller::AddMesh(
+	const MeshPool& meshPool,
+	int handle,
+	const MeshVertex* vertices,
+	size_t vertexCount,
+	const unsigned int* indices,
+	size_t indexCount)
+{
+	if ((int)m_meshes.size() <= handle)
+	{
+		MESH_MESHLETS empty;
+		empty.firstMeshlet = 0;
+		empty.meshletCount = 0;
+		empty.bClosed = false;
+		empty.center = glm::vec3(0.0f);
+		empty.radius = 0.0f;
+		m_meshes.resize(handle + 1, empty);
+	}
+
+	// a mesh below the limit cannot split into enough meshlets
+	if (indexCount / 3 < (size_t)(MIN_MESHLETS * MeshletBuilder::MAX_TRIANGLES / 2))
+	{
+		return false;
+	}
+	std::vector<Meshlet> meshlets;
+	MeshletBuilder::Build(vertices, vertexCount, indices, indexCount, meshlets);
+	if ((int)meshlets.size() < MIN_MESHLETS)
+	{
+		return false;
+	}
+
+	MESH_MESHLETS& mesh = m_meshes[handle];
+	mesh.firstMeshlet = (int)m_meshlets.size();
+	mesh.meshletCount = (int)meshlets.size();
+	mesh.bClosed = MeshletBuilder::IsClosed(vertices, vertexCount, indices, indexCount);
+
+	glm::vec3 boundsMin = vertices[0].position;
+	glm::vec3 boundsMax = boundsMin;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertices[i].position);
+		boundsMax = glm::max(boundsMax, vertices[i].position);
+	}
+	mesh.center = (boundsMin + boundsMax) * 0.5f;
+	mesh.radius = 0.0f;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		mesh.radius = std::max(mesh.radius, glm::length(vertices[i].position - mesh.center));
+	}
+
+	GLuint firstIndex = meshPool.GetFirstIndex(handle);
+	GLint baseVertex = meshPool.GetBaseVertex(handle);
+	for (const Meshlet& meshlet : meshlets)
+	{
+		GPU_MESHLET gpuMeshlet;
+		gpuMeshlet.sphere[0] = meshlet.center.x;
+		gpuMeshlet.sphere[1] = meshlet.center.y;
+		gpuMeshlet.sphere[2] = meshlet.center.z;
+		gpuMeshlet.sphere[3] = meshlet.radius;
+		gpuMeshlet.cone[0] = meshlet.coneAxis.x;
+		gpuMeshlet.cone[1] = meshlet.coneAxis.y;
+		gpuMeshlet.cone[2] = meshlet.coneAxis.z;
+		gpuMeshlet.cone[3] = meshlet.coneCutoff;
+		gpuMeshlet.firstIndex = firstIndex + meshlet.firstIndex;
+		gpuMeshlet.indexCount = meshlet.indexCount;
+		gpuMeshlet.baseVertex = baseVertex;
+		gpuMeshlet.padding = 0;
+		m_meshlets.push_back(gpuMeshlet);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used to copy the meshlet table to the GPU
+ *  once meshes have been added.  The table is only written
+ *  while loading, so it is simply replaced as a whole.
+ ***********************************************************/
+bool ClusterCuller::Upload()
+{
+	if ((m_cullProgram == 0) || (m_uploadedMeshlets == m_meshlets.size()))
+	{
+		return true;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_meshletBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(m_meshlets.size() * sizeof(GPU_MESHLET)),
+		m_meshlets.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	m_uploadedMeshlets = m_meshlets.size();
+
+	std::cout << "INFO: Meshlet table holds " << m_meshlets.size() << " meshlets, "
+		<< m_meshlets.size() * sizeof(GPU_MESHLET) / 1024 << " KB" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start a frame.  The six frustum
+ *  planes are taken from the rows of the view projection
+ *  matrix and normalized, so a sphere can be tested against
+ *  each one with a single dot product.
+ ***********************************************************/
+void ClusterCuller::BeginFrame(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPosition)
+{
+	glm::mat4 viewProjection = projection * view;
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row]);
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_frustumPlanes[axis * 2] = rows[3] + rows[axis];
+		m_frustumPlanes[axis * 2 + 1] = rows[3] - rows[axis];
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(m_frustumPlanes[i]));
+		if (length > 0.0f)
+		{
+			m_frustumPlanes[i] /= length;
+		}
+	}
+
+	m_viewPosition = viewPosition;
+	// an orthographic camera looks the same way everywhere, which
+	// the cone test does not handle, so it only culls to the frustum
+	m_bOrthographic = (projection[3][3] == 1.0f);
+	m_draws.clear();
+	m_commandCount = 0;
+	m_counts.clear();
+	m_offsets.clear();
+	m_baseVertices.clear();
+}
+
+/***********************************************************
+ *  AddDraw()
+ *
+ *  This method is used to queue an item for culling.  The
+ *  CPU path culls it straight away; the compute path waits
+ *  for EndFrame(), once the command buffer size is known.
+ ***********************************************************/
+int ClusterCuller::AddDraw(int handle, const glm::mat4& model, bool bBackfaceCulling)
+{
+	if ((handle >= (int)m_meshes.size()) || (m_meshes[handle].meshletCount == 0))
+	{
+		return -1;
+	}
+
+	ITEM_DRAW draw;
+	draw.handle = handle;
+	draw.model = model;
+	draw.bBackfaceCulling = bBackfaceCulling;
+	draw.firstCommand = m_commandCount;
+	draw.commandCount = m_meshes[handle].meshletCount;
+	if (m_cullProgram != 0)
+	{
+		m_commandCount += draw.commandCount;
+	}
+	else
+	{
+		CullOnCpu(draw);
+	}
+	m_draws.push_back(draw);
+	return (int)m_draws.size() - 1;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to run the compute culling for the
+ *  queued items, one dispatch each, into a command buffer
+ *  that holds a slot for every meshlet of every item.  The
+ *  barrier makes the commands visible to the indirect draws.
+ ***********************************************************/
+void ClusterCuller::EndFrame()
+{
+	if ((m_cullProgram == 0) || m_draws.empty())
+	{
+		return;
+	}
+
+	if (m_commandCount > m_commandCapacity)
+	{
+		m_commandCapacity = std::max(m_commandCount, m_commandCapacity * 2);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)m_commandCapacity * sizeof(DRAW_COMMAND), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	glUseProgram(m_cullProgram);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_meshletBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_commandBuffer);
+	glUniform4fv(m_frustumPlanesLocation, 6, glm::value_ptr(m_frustumPlanes[0]));
+	for (const ITEM_DRAW& draw : m_draws)
+	{
+		const MESH_MESHLETS& mesh = m_meshes[draw.handle];
+		glm::vec3 camera(0.0f);
+		bool bConeCulling = GetConeCamera(draw, mesh, camera);
+		float modelScale = std::max(glm::length(glm::vec3(draw.model[0])),
+			std::max(glm::length(glm::vec3(draw.model[1])), glm::length(glm::vec3(draw.model[2]))));
+
+		glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, glm::value_ptr(draw.model));
+		glUniform1f(m_modelScaleLocation, modelScale);
+		glUniform3fv(m_cameraPositionLocation, 1, glm::value_ptr(camera));
+		glUniform1i(m_coneCullingLocation, bConeCulling ? 1 : 0);
+		glUniform1ui(m_firstMeshletLocation, (GLuint)mesh.firstMeshlet);
+		glUniform1ui(m_meshletCountLocation, (GLuint)mesh.meshletCount);
+		glUniform1ui(m_firstCommandLocation, (GLuint)draw.firstCommand);
+		glDispatchCompute((GLuint)((mesh.meshletCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+	}
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glUseProgram(0);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw the meshlets of a queued item
+ *  that survived culling.  The mesh pool has to be bound,
+ *  since the draws read its index buffer.
+ ***********************************************************/
+void ClusterCuller::Draw(int draw) const
+{
+	const ITEM_DRAW& itemDraw = m_draws[draw];
+	if (itemDraw.commandCount == 0)
+	{
+		return;
+	}
+
+	if (m_cullProgram != 0)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void*)((size_t)itemDraw.firstCommand * sizeof(DRAW_COMMAND)), itemDraw.commandCount, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else
+	{
+		glMultiDrawElementsBaseVertex(GL_TRIANGLES, &m_counts[itemDraw.firstCommand], GL_UNSIGNED_INT,
+			&m_offsets[itemDraw.firstCommand], itemDraw.commandCount, &m_baseVertices[itemDraw.firstCommand]);
+	}
+}
+
+/***********************************************************
+ *  GetConeCamera()
+ *
+ *  This method is used to decide whether the cone test can
+ *  be used for an item, and to move the camera into mesh
+ *  space for it.  Facing does not change under an affine
+ *  transform, so the test is exact in mesh space however
+ *  the item is scaled or mirrored.
+ ***********************************************************/
+bool ClusterCuller::GetConeCamera(const ITEM_DRAW& draw, const MESH_MESHLETS& mesh, glm::vec3& camera) const
+{
+	if ((draw.bBackfaceCulling == false) || (mesh.bClosed == false) || m_bOrthographic)
+	{
+		return false;
+	}
+	camera = glm::vec3(glm::inverse(draw.model) * glm::vec4(m_viewPosition, 1.0f));
+	// from inside a closed mesh, every triangle in view is a back face
+	return glm::length(camera - mesh.center) > mesh.radius;
+}
+
+/***********************************************************
+ *  CullOnCpu()
+ *
+ *  This method is used to run the same tests as the compute
+ *  shader on the CPU.  Meshlets of one mesh follow each
+ *  other in the index buffer, so neighbouring survivors are
+ *  joined into one run and drawn with a single count.
+ ***********************************************************/
+void ClusterCuller::CullOnCpu(ITEM_DRAW& draw)
+{
+	const MESH_MESHLETS& mesh = m_meshes[draw.handle];
+	glm::vec3 camera(0.0f);
+	bool bConeCulling = GetConeCamera(draw, mesh, camera);
+	float modelScale = std::max(glm::length(glm::vec3(draw.model[0])),
+		std::max(glm::length(glm::vec3(draw.model[1])), glm::length(glm::vec3(draw.model[2]))));
+
+	draw.firstCommand = (int)m_counts.size();
+	GLuint runEnd = 0;
+	for (int i = 0; i < mesh.meshletCount; i++)
+	{
+		const GPU_MESHLET& meshlet = m_meshlets[mesh.firstMeshlet + i];
+		glm::vec3 localCenter(meshlet.sphere[0], meshlet.sphere[1], meshlet.sphere[2]);
+		glm::vec3 center = glm::vec3(draw.model * glm::vec4(localCenter, 1.0f));
+		float radius = meshlet.sphere[3] * modelScale;
+		bool bVisible = true;
+		for (int plane = 0; (plane < 6) && bVisible; plane++)
+		{
+			bVisible = (glm::dot(glm::vec3(m_frustumPlanes[plane]), center) + m_frustumPlanes[plane].w > -radius);
+		}
+		if (bVisible && bConeCulling)
+		{
+			glm::vec3 toMeshlet = localCenter - camera;
+			glm::vec3 axis(meshlet.cone[0], meshlet.cone[1], meshlet.cone[2]);
+			bVisible = (glm::dot(toMeshlet, axis) < meshlet.cone[3] * glm::length(toMeshlet) + meshlet.sphere[3]);
+		}
+		if (bVisible == false)
+		{
+			continue;
+		}
+
+		if (((int)m_counts.size() > draw.firstCommand) && (runEnd == meshlet.firstIndex))
+		{
+			m_counts.back() += (GLsizei)meshlet.indexCount;
+		}
+		else
+		{
+			m_counts.push_back((GLsizei)meshlet.indexCount);
+			m_offsets.push_back((const void*)((size_t)meshlet.firstIndex * sizeof(unsigned int)));
+			m_baseVertices.push_back(meshlet.baseVertex);
+		}
+		runEnd = meshlet.firstIndex + meshlet.indexCount;
+	}
+	draw.commandCount = (int)m_counts.size() - draw.firstCommand;
+}
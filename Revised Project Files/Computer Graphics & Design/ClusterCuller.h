@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusterculler.h
+// ============
+// cull the meshlets of the large meshes against the view each frame
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+class MeshPool;
+
+/***********************************************************
+ *  ClusterCuller
+ *
+ *  This class keeps the meshlets of every mesh pool mesh
+ *  that is large enough to split, and each frame works out
+ *  which meshlets of each drawn item can be seen.  A meshlet
+ *  is dropped when its bounding sphere is outside the view
+ *  frustum, or when its normal cone shows that all of its
+ *  triangles face away from the camera.  The cone test is
+ *  only used on opaque, closed meshes with the camera
+ *  outside them - the scene draws both sides of every
+ *  triangle, so on anything else a back face can be seen.
+ *
+ *  With OpenGL 4.3 a compute shader tests every meshlet and
+ *  writes one indirect draw command each, with an instance
+ *  count of 0 for the culled ones, and an item is drawn with
+ *  a single glMultiDrawElementsIndirect.  Older contexts
+ *  test the meshlets on the CPU and draw the runs that
+ *  survive with glMultiDrawElementsBaseVertex.  Either way
+ *  the triangles submitted follow what is on screen rather
+ *  than the size of the mesh.
+ ***********************************************************/
+class ClusterCuller
+{
+public:
+	// constructor
+	ClusterCuller();
+	// destructor
+	~ClusterCuller();
+
+	// compile the cull program when compute shaders are supported
+	bool Initialize();
+	bool IsGpuCulling() const { return m_cullProgram != 0; }
+
+	// split a mesh that was just added to the pool, false when it is too small to be worth it
+	bool AddMesh(
+		const MeshPool& meshPool,
+		int handle,
+		const MeshVertex* vertices,
+		size_t vertexCount,
+		const unsigned int* indices,
+		size_t indexCount);
+	// copy the meshlet table to the GPU after meshes were added
+	bool Upload();
+	int GetMeshletCount() const { return (int)m_meshlets.size(); }
+
+	// start culling a frame for the passed in camera
+	void BeginFrame(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPosition);
+	// queue one item for culling, returns the draw for Draw() or -1 when the mesh has no meshlets
+	int AddDraw(int handle, const glm::mat4& model, bool bBackfaceCulling);
+	// run the culling for every queued item
+	void EndFrame();
+	// draw the visible meshlets of a queued item, with the mesh pool bound
+	void Draw(int draw) const;
+
+private:
+	// the meshlets of one pool mesh, meshletCount is 0 when it has none
+	struct MESH_MESHLETS
+	{
+		int firstMeshlet;
+		int meshletCount;
+		// back faces are hidden, from outside the bounding sphere
+		bool bClosed;
+		glm::vec3 center;
+		float radius;
+	};
+
+	// one meshlet in the layout of the compute shader's buffer
+	struct GPU_MESHLET
+	{
+		// bounding sphere centre and radius
+		float sphere[4];
+		// cone axis and cutoff
+		float cone[4];
+		// range in the shared index buffer
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+		GLuint padding;
+	};
+
+	// the layout glMultiDrawElementsIndirect reads
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// one item queued this frame
+	struct ITEM_DRAW
+	{
+		int handle;
+		glm::mat4 model;
+		bool bBackfaceCulling;
+		// commands written for it, or CPU draw ranges that survived
+		int firstCommand;
+		int commandCount;
+	};
+
+	// indexed by mesh pool handle
+	std::vector<MESH_MESHLETS> m_meshes;
+	std::vector<GPU_MESHLET> m_meshlets;
+	size_t m_uploadedMeshlets;
+
+	// this frame's camera, with the frustum planes in world space
+	glm::vec4 m_frustumPlanes[6];
+	glm::vec3 m_viewPosition;
+	bool m_bOrthographic;
+	std::vector<ITEM_DRAW> m_draws;
+	int m_commandCount;
+
+	// compute path
+	GLuint m_cullProgram;
+	GLint m_modelLocation;
+	GLint m_modelScaleLocation;
+	GLint m_frustumPlanesLocation;
+	GLint m_cameraPositionLocation;
+	GLint m_coneCullingLocation;
+	GLint m_firstMeshletLocation;
+	GLint m_meshletCountLocation;
+	GLint m_firstCommandLocation;
+	GLuint m_meshletBuffer;
+	GLuint m_commandBuffer;
+	int m_commandCapacity;
+
+	// CPU path - the surviving runs of every item, back to back
+	std::vector<GLsizei> m_counts;
+	std::vector<const void*> m_offsets;
+	std::vector<GLint> m_baseVertices;
+
+	// whether the camera is outside the bounding sphere of a mesh,
+	// and where it is in mesh space for the cone test
+	bool GetConeCamera(const ITEM_DRAW& draw, const MESH_MESHLETS& mesh, glm::vec3& camera) const;
+	// test the meshlets of one item on the CPU and keep the visible runs
+	void CullOnCpu(ITEM_DRAW& draw);
+};
@@ -0,0 +1,289 @@
+///////////////////////////////////////////////////////////////////////////////
+// cookedmesh.cpp
+// ============
+// read and write imported meshes in the binary .mesh format
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CookedMesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// file layout, all little endian:
+	//
+	//   0   "MESH", version, level count
+	//   12  bounds minimum and maximum, bounding radius, 3 floats reserved
+	//   64  one LEVEL_ENTRY_SIZE entry per level: vertex offset and index
+	//       offset (64 bit), vertex count, index count, error, reserved
+	//
+	// then each level's vertices on a 16 byte boundary and its indices
+	const unsigned char MESH_IDENTIFIER[4] = { 'M', 'E', 'S', 'H' };
+	const unsigned int MESH_VERSION = 1;
+	const size_t MESH_HEADER_SIZE = 64;
+	const size_t LEVEL_ENTRY_SIZE = 32;
+	const size_t VERTEX_ALIGNMENT = 16;
+	// more levels than any chain has, to reject a broken header early
+	const unsigned int MAX_LEVELS = 16;
+
+	static_assert(sizeof(MeshVertex) == 32, "the .mesh vertex layout is 8 packed floats");
+
+	unsigned int ReadU32(const unsigned char* data)
+	{
+		return (unsigned int)data[0] | ((unsigned int)data[1] << 8) |
+			((unsigned int)data[2] << 16) | ((unsigned int)data[3] << 24);
+	}
+
+	unsigned long long ReadU64(const unsigned char* data)
+	{
+		return (unsigned long long)ReadU32(data) | ((unsigned long long)ReadU32(data + 4) << 32);
+	}
+
+	float ReadFloat(const unsigned char* data)
+	{
+		unsigned int bits = ReadU32(data);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	void WriteU32(std::vector<unsigned char>& out, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			out.push_back((unsigned char)((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	void WriteFloat(std::vector<unsigned char>& out, float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		WriteU32(out, bits);
+	}
+
+	void PatchU32(std::vector<unsigned char>& out, size_t offset, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			out[offset + i] = (unsigned char)((value >> (i * 8)) & 0xFF);
+		}
+	}
+
+	void PatchU64(std::vector<unsigned char>& out, size_t offset, unsigned long long value)
+	{
+		PatchU32(out, offset, (unsigned int)(value & 0xFFFFFFFF));
+		PatchU32(out, offset + 4, (unsigned int)(value >> 32));
+	}
+}
+
+/***********************************************************
+ *  CookedMesh()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CookedMesh::CookedMesh()
+{
+	m_boundsMin = glm::vec3(0.0f);
+	m_boundsMax = glm::vec3(0.0f);
+	m_radius = 0.0f;
+}
+
+/***********************************************************
+ *  LoadFromFile()
+ *
+ *  This method is used to read a .mesh file into memory and
+ *  parse it.  A missing file is not reported, since callers
+ *  fall back to the shapes the scene builds itself.
+ ***********************************************************/
+bool CookedMesh::LoadFromFile(const char* filePath)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	m_fileData.resize((size_t)size);
+	if ((size <= 0) || !file.read((char*)m_fileData.data(), size))
+	{
+		std::cout << "ERROR: Could not read " << filePath << std::endl;
+		m_fileData.clear();
+		return false;
+	}
+
+	return LoadFromMemory(m_fileData.data(), m_fileData.size(), filePath);
+}
+
+/***********************************************************
+ *  LoadFromMemory()
+ *
+ *  This method is used to check the header of a .mesh file
+ *  and find its levels.  Each level has to lie inside the
+ *  data and be aligned for the type it is read as.  The
+ *  indices are trusted to be in range, as the cook wrote
+ *  them, so no time is spent walking them.
+ ***********************************************************/
+bool CookedMesh::LoadFromMemory(const unsigned char* data, size_t size, const char* name)
+{
+	m_levels.clear();
+
+	if ((size < MESH_HEADER_SIZE) || (memcmp(data, MESH_IDENTIFIER, sizeof(MESH_IDENTIFIER)) != 0))
+	{
+		std::cout << "ERROR: " << name << " is not a mesh file" << std::endl;
+		return false;
+	}
+	unsigned int version = ReadU32(data + 4);
+	unsigned int levelCount = ReadU32(data + 8);
+	if ((version != MESH_VERSION) || (levelCount == 0) || (levelCount > MAX_LEVELS) ||
+		(size < MESH_HEADER_SIZE + levelCount * LEVEL_ENTRY_SIZE))
+	{
+		std::cout << "ERROR: " << name << " has an unsupported mesh header (version " << version << ")" << std::endl;
+		return false;
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		m_boundsMin[i] = ReadFloat(data + 12 + i * 4);
+		m_boundsMax[i] = ReadFloat(data + 24 + i * 4);
+	}
+	m_radius = ReadFloat(data + 36);
+
+	for (unsigned int level = 0; level < levelCount; level++)
+	{
+		const unsigned char* entry = data + MESH_HEADER_SIZE + level * LEVEL_ENTRY_SIZE;
+		unsigned long long vertexOffset = ReadU64(entry);
+		unsigned long long indexOffset = ReadU64(entry + 8);
+		unsigned int vertexCount = ReadU32(entry + 16);
+		unsigned int indexCount = ReadU32(entry + 20);
+		if ((vertexOffset % alignof(MeshVertex) != 0) || (indexOffset % sizeof(unsigned int) != 0) ||
+			(vertexOffset + (unsigned long long)vertexCount * sizeof(MeshVertex) > size) ||
+			(indexOffset + (unsigned long long)indexCount * sizeof(unsigned int) > size) ||
+			(indexCount % 3 != 0))
+		{
+			std::cout << "ERROR: " << name << " level " << level << " is outside the file" << std::endl;
+			m_levels.clear();
+			return false;
+		}
+
+		MESH_LEVEL meshLevel;
+		meshLevel.vertices = (const MeshVertex*)(data + vertexOffset);
+		meshLevel.vertexCount = vertexCount;
+		meshLevel.indices = (const unsigned int*)(data + indexOffset);
+		meshLevel.indexCount = indexCount;
+		meshLevel.error = ReadFloat(entry + 24);
+		m_levels.push_back(meshLevel);
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SaveToFile()
+ *
+ *  This method is used to write the levels of a mesh, with
+ *  the bounds of the full mesh, into a .mesh file.  The
+ *  level table is filled in once the data offsets are known.
+ ***********************************************************/
+bool CookedMesh::SaveToFile(
+	const char* filePath,
+	const std::vector<MeshData>& levels,
+	const std::vector<float>& errors)
+{
+	if (levels.empty() || (levels.size() > MAX_LEVELS) || (levels.size() != errors.size()) ||
+		levels[0].vertices.empty())
+	{
+		std::cout << "ERROR: No mesh levels to write to " << filePath << std::endl;
+		return false;
+	}
+
+	const std::vector<MeshVertex>& vertices = levels[0].vertices;
+	glm::vec3 boundsMin = vertices[0].position;
+	glm::vec3 boundsMax = vertices[0].position;
+	for (const MeshVertex& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+	for (const MeshVertex& vertex : vertices)
+	{
+		radius = std::max(radius, glm::length(vertex.position - center));
+	}
+
+	std::vector<unsigned char> out(MESH_IDENTIFIER, MESH_IDENTIFIER + sizeof(MESH_IDENTIFIER));
+	WriteU32(out, MESH_VERSION);
+	WriteU32(out, (unsigned int)levels.size());
+	for (int i = 0; i < 3; i++)
+	{
+		WriteFloat(out, boundsMin[i]);
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		WriteFloat(out, boundsMax[i]);
+	}
+	WriteFloat(out, radius);
+	out.resize(MESH_HEADER_SIZE, 0);
+
+	size_t levelTableOffset = out.size();
+	out.resize(out.size() + levels.size() * LEVEL_ENTRY_SIZE, 0);
+
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		while ((out.size() % VERTEX_ALIGNMENT) != 0)
+		{
+			out.push_back(0);
+		}
+		size_t entry = levelTableOffset + level * LEVEL_ENTRY_SIZE;
+		const MeshData& mesh = levels[level];
+
+		// the vertex struct is packed floats, so its bytes are the file layout
+		PatchU64(out, entry, out.size());
+		const unsigned char* vertexBytes = (const unsigned char*)mesh.vertices.data();
+		out.insert(out.end(), vertexBytes, vertexBytes + mesh.vertices.size() * sizeof(MeshVertex));
+
+		PatchU64(out, entry + 8, out.size());
+		const unsigned char* indexBytes = (const unsigned char*)mesh.indices.data();
+		out.insert(out.end(), indexBytes, indexBytes + mesh.indices.size() * sizeof(unsigned int));
+
+		PatchU32(out, entry + 16, (unsigned int)mesh.vertices.size());
+		PatchU32(out, entry + 20, (unsigned int)mesh.indices.size());
+		unsigned int errorBits;
+		memcpy(&errorBits, &errors[level], sizeof(errorBits));
+		PatchU32(out, entry + 24, errorBits);
+	}
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file.is_open() || !file.write((const char*)out.data(), (std::streamsize)out.size()))
+	{
+		std::cout << "ERROR: Could not write " << filePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  GetCookedPath()
+ *
+ *  This method is used to swap the extension of a source
+ *  model for .mesh, keeping it in the same folder.
+ ***********************************************************/
+std::string CookedMesh::GetCookedPath(const char* sourcePath)
+{
+	std::string path = sourcePath;
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if ((dot != std::string::npos) && ((slash == std::string::npos) || (dot > slash)))
+	{
+		path.erase(dot);
+	}
+	return(path + ".mesh");
+}
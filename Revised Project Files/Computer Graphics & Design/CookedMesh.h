@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// cookedmesh.h
+// ============
+// read and write imported meshes in the binary .mesh format
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CookedMesh
+ *
+ *  This class holds a mesh as written by the MeshCook tool:
+ *  its levels of detail, already optimized, with the error
+ *  of each level and the bounds of the mesh.  The vertices
+ *  are stored in the float MeshVertex layout and the indices
+ *  as 32 bit values, so loading only checks the header and
+ *  points at the data - nothing is parsed per vertex, and a
+ *  mesh in the asset pack is read straight from its mapped
+ *  pages.  It has no OpenGL code, so the cook tool can use
+ *  it without a context.
+ ***********************************************************/
+class CookedMesh
+{
+public:
+	// one level of detail - the data points into the loaded file
+	struct MESH_LEVEL
+	{
+		const MeshVertex* vertices;
+		unsigned int vertexCount;
+		const unsigned int* indices;
+		unsigned int indexCount;
+		// how far the level is from the full mesh, in mesh units
+		float error;
+	};
+
+	// constructor
+	CookedMesh();
+
+	// read a .mesh file, false if it is missing or not a mesh file
+	bool LoadFromFile(const char* filePath);
+	// parse a .mesh file that is already in memory, which must outlive the levels
+	bool LoadFromMemory(const unsigned char* data, size_t size, const char* name);
+
+	// write a .mesh file from its levels of detail, the full mesh first
+	static bool SaveToFile(
+		const char* filePath,
+		const std::vector<MeshData>& levels,
+		const std::vector<float>& errors);
+
+	// the cooked file that goes with a source model ("bottle.obj" -> "bottle.mesh")
+	static std::string GetCookedPath(const char* sourcePath);
+
+	int GetLevelCount() const { return (int)m_levels.size(); }
+	const MESH_LEVEL& GetLevel(int level) const { return m_levels[level]; }
+	const glm::vec3& GetBoundsMin() const { return m_boundsMin; }
+	const glm::vec3& GetBoundsMax() const { return m_boundsMax; }
+	// radius of a sphere around the middle of the bounds that holds the mesh
+	float GetRadius() const { return m_radius; }
+
+private:
+	// file contents when read with LoadFromFile()
+	std::vector<unsigned char> m_fileData;
+	std::vector<MESH_LEVEL> m_levels;
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
+	float m_radius;
+};
@@ -0,0 +1,624 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.cpp
+// ============
+// G-buffer and light volume passes for the deferred shading path
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredRenderer.h"
+#include "ShaderUtils.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// texture units used by the lighting pass
+	const int ALBEDO_UNIT = 0;
+	const int NORMAL_UNIT = 1;
+	const int MATERIAL_UNIT = 2;
+	const int DEPTH_UNIT = 3;
+	const int MATERIAL_TABLE_UNIT = 4;
+
+	// rows in the material lookup texture
+	const int MATERIAL_TABLE_ROWS = 3;
+
+	// the G-buffer pass uses the same vertex layout as the scene shader
+	const char* g_GeometryVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+uniform vec2 UVscale;
+
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+
+void main()
+{
+	gl_Position = projection * view * model * vec4(inVertexPosition, 1.0);
+	fragmentVertexNormal = normalMatrix * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate * UVscale;
+}
+)";
+
+	const char* g_GeometryFragmentShader = R"(
+#version 330 core
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+uniform bool bUseTexture;
+uniform sampler2D objectTexture;
+uniform uint materialIndex;
+
+layout (location = 0) out vec4 outAlbedo;
+layout (location = 1) out vec4 outNormal;
+layout (location = 2) out uint outMaterial;
+
+void main()
+{
+	vec3 albedo = vec3(1.0);
+	if (bUseTexture)
+	{
+		albedo = texture(objectTexture, fragmentTextureCoordinate).rgb;
+	}
+	outAlbedo = vec4(albedo, 1.0);
+	outNormal = vec4(normalize(fragmentVertexNormal), 0.0);
+	outMaterial = materialIndex;
+}
+)";
+
+	// full screen triangle generated from gl_VertexID, no vertex buffer needed
+	const char* g_LightingVertexShader = R"(
+#version 330 core
+void main()
+{
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+	// per-light Phong terms - kept in line with the forward fragment shader
+	const char* g_LightingFragmentShader = R"(
+#version 330 core
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+	float radius;
+};
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform usampler2D gMaterial;
+uniform sampler2D gDepth;
+uniform sampler2D materialTable;
+
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize;
+uniform vec3 viewPosition;
+uniform LightSource light;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, texel, 0).r;
+	if (depth >= 1.0)
+	{
+		discard;
+	}
+
+	// rebuild the world position from the depth buffer
+	vec4 clipPosition = vec4((gl_FragCoord.xy / screenSize) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 worldPosition = inverseViewProjection * clipPosition;
+	vec3 fragmentPosition = worldPosition.xyz / worldPosition.w;
+
+	vec3 albedo = texelFetch(gAlbedo, texel, 0).rgb;
+	vec3 lightNormal = normalize(texelFetch(gNormal, texel, 0).xyz);
+	int material = int(texelFetch(gMaterial, texel, 0).r);
+	vec4 ambientValues = texelFetch(materialTable, ivec2(material, 0), 0);
+	vec4 diffuseValues = texelFetch(materialTable, ivec2(material, 1), 0);
+	vec4 specularValues = texelFetch(materialTable, ivec2(material, 2), 0);
+
+	vec3 ambient = light.ambientColor * ambientValues.rgb * ambientValues.a;
+
+	vec3 lightDirection = normalize(light.position - fragmentPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0);
+	vec3 diffuse = impact * light.diffuseColor * diffuseValues.rgb;
+
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+	vec3 reflectDir = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), light.focalStrength);
+	vec3 specular = light.specularIntensity * specularComponent * light.specularColor * specularValues.rgb;
+
+	// bounded lights fade out to zero at the edge of their volume
+	float attenuation = 1.0;
+	if (light.radius > 0.0)
+	{
+		float falloff = clamp(1.0 - pow(length(light.position - fragmentPosition) / light.radius, 2.0), 0.0, 1.0);
+		attenuation = falloff * falloff;
+	}
+
+	outFragmentColor = vec4((ambient + diffuse + specular) * albedo * attenuation, 1.0);
+}
+)";
+}
+
+/***********************************************************
+ *  DeferredRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredRenderer::DeferredRenderer()
+{
+	m_gBuffer = 0;
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_materialTexture = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_allocatedWidth = 0;
+	m_allocatedHeight = 0;
+	m_materialTable = 0;
+	m_geometryProgram = 0;
+	m_lightingProgram = 0;
+	m_emptyVAO = 0;
+	m_modelLocation = -1;
+	m_normalMatrixLocation = -1;
+	m_uvScaleLocation = -1;
+	m_useTextureLocation = -1;
+	m_textureLocation = -1;
+	m_materialIndexLocation = -1;
+	m_viewLocation = -1;
+	m_projectionLocation = -1;
+	m_inverseViewProjectionLocation = -1;
+	m_screenSizeLocation = -1;
+	m_viewPositionLocation = -1;
+	m_lightPositionLocation = -1;
+	m_lightAmbientLocation = -1;
+	m_lightDiffuseLocation = -1;
+	m_lightSpecularLocation = -1;
+	m_lightFocalLocation = -1;
+	m_lightIntensityLocation = -1;
+	m_lightRadiusLocation = -1;
+	m_viewProjection = glm::mat4(1.0f);
+}
+
+/***********************************************************
+ *  ~DeferredRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	DestroyGBuffer();
+	glDeleteTextures(1, &m_materialTable);
+	glDeleteProgram(m_geometryProgram);
+	glDeleteProgram(m_lightingProgram);
+	glDeleteVertexArrays(1, &m_emptyVAO);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to compile the programs for both
+ *  passes and cache the uniform locations they set each
+ *  frame.
+ ***********************************************************/
+bool DeferredRenderer::Initialize()
+{
+	m_geometryProgram = ShaderUtils::CreateProgram(
+		g_GeometryVertexShader, g_GeometryFragmentShader, "G-buffer");
+	m_lightingProgram = ShaderUtils::CreateProgram(
+		g_LightingVertexShader, g_LightingFragmentShader, "deferred lighting");
+	if ((m_geometryProgram == 0) || (m_lightingProgram == 0))
+	{
+		return false;
+	}
+
+	m_modelLocation = glGetUniformLocation(m_geometryProgram, "model");
+	m_normalMatrixLocation = glGetUniformLocation(m_geometryProgram, "normalMatrix");
+	m_uvScaleLocation = glGetUniformLocation(m_geometryProgram, "UVscale");
+	m_useTextureLocation = glGetUniformLocation(m_geometryProgram, "bUseTexture");
+	m_textureLocation = glGetUniformLocation(m_geometryProgram, "objectTexture");
+	m_materialIndexLocation = glGetUniformLocation(m_geometryProgram, "materialIndex");
+	m_viewLocation = glGetUniformLocation(m_geometryProgram, "view");
+	m_projectionLocation = glGetUniformLocation(m_geometryProgram, "projection");
+
+	m_inverseViewProjectionLocation = glGetUniformLocation(m_lightingProgram, "inverseViewProjection");
+	m_screenSizeLocation = glGetUniformLocation(m_lightingProgram, "screenSize");
+	m_viewPositionLocation = glGetUniformLocation(m_lightingProgram, "viewPosition");
+	m_lightPositionLocation = glGetUniformLocation(m_lightingProgram, "light.position");
+	m_lightAmbientLocation = glGetUniformLocation(m_lightingProgram, "light.ambientColor");
+	m_lightDiffuseLocation = glGetUniformLocation(m_lightingProgram, "light.diffuseColor");
+	m_lightSpecularLocation = glGetUniformLocation(m_lightingProgram, "light.specularColor");
+	m_lightFocalLocation = glGetUniformLocation(m_lightingProgram, "light.focalStrength");
+	m_lightIntensityLocation = glGetUniformLocation(m_lightingProgram, "light.specularIntensity");
+	m_lightRadiusLocation = glGetUniformLocation(m_lightingProgram, "light.radius");
+
+	// the lighting samplers always live on the same texture units
+	glUseProgram(m_lightingProgram);
+	ShaderUtils::SetSamplerUnit(m_lightingProgram, "gAlbedo", ALBEDO_UNIT);
+	ShaderUtils::SetSamplerUnit(m_lightingProgram, "gNormal", NORMAL_UNIT);
+	ShaderUtils::SetSamplerUnit(m_lightingProgram, "gMaterial", MATERIAL_UNIT);
+	ShaderUtils::SetSamplerUnit(m_lightingProgram, "gDepth", DEPTH_UNIT);
+	ShaderUtils::SetSamplerUnit(m_lightingProgram, "materialTable", MATERIAL_TABLE_UNIT);
+	glUseProgram(0);
+
+	// a core profile context needs a bound VAO even with no attributes
+	glGenVertexArrays(1, &m_emptyVAO);
+
+	std::cout << "INFO: Deferred renderer initialized" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyGBuffer()
+ *
+ *  This method is used to free the G-buffer attachments.
+ ***********************************************************/
+void DeferredRenderer::DestroyGBuffer()
+{
+	GLuint textures[4] = { m_albedoTexture, m_normalTexture, m_materialTexture, m_depthTexture };
+	glDeleteTextures(4, textures);
+	glDeleteFramebuffers(1, &m_gBuffer);
+
+	m_gBuffer = 0;
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_materialTexture = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_allocatedWidth = 0;
+	m_allocatedHeight = 0;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used to set the size rendered into the
+ *  G-buffer.  The attachments are only reallocated when the
+ *  size grows past them, so a changing render scale only
+ *  uses a smaller part of the same G-buffer.
+ ***********************************************************/
+void DeferredRenderer::Resize(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+	if ((width <= m_allocatedWidth) && (height <= m_allocatedHeight))
+	{
+		m_width = width;
+		m_height = height;
+		return;
+	}
+
+	int allocateWidth = std::max(width, m_allocatedWidth);
+	int allocateHeight = std::max(height, m_allocatedHeight);
+	DestroyGBuffer();
+	m_width = width;
+	m_height = height;
+	m_allocatedWidth = allocateWidth;
+	m_allocatedHeight = allocateHeight;
+
+	glGenFramebuffers(1, &m_gBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_gBuffer);
+
+	// all G-buffer targets are read with texelFetch, so no filtering - the
+	// depth has the D24S8 format of the targets CopyDepthTo() blits it into,
+	// since a depth blit between different formats copies nothing
+	GLuint* targets[4] = { &m_albedoTexture, &m_normalTexture, &m_materialTexture, &m_depthTexture };
+	const GLenum internalFormats[4] = { GL_RGBA8, GL_RGBA16F, GL_R8UI, GL_DEPTH24_STENCIL8 };
+	const GLenum formats[4] = { GL_RGBA, GL_RGBA, GL_RED_INTEGER, GL_DEPTH_STENCIL };
+	const GLenum types[4] = { GL_UNSIGNED_BYTE, GL_HALF_FLOAT, GL_UNSIGNED_BYTE, GL_UNSIGNED_INT_24_8 };
+	const GLenum attachments[4] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_DEPTH_STENCIL_ATTACHMENT };
+
+	for (int i = 0; i < 4; i++)
+	{
+		glGenTextures(1, targets[i]);
+		glBindTexture(GL_TEXTURE_2D, *targets[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], m_allocatedWidth, m_allocatedHeight, 0, formats[i], types[i], nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		if (attachments[i] == GL_DEPTH_STENCIL_ATTACHMENT)
+		{
+			// the lighting pass samples the depth, not the stencil
+			glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_DEPTH_COMPONENT);
+		}
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachments[i], GL_TEXTURE_2D, *targets[i], 0);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	glDrawBuffers(3, drawBuffers);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: G-buffer framebuffer is incomplete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used to reallocate the G-buffer at the new
+ *  window size, so shrinking the window also frees memory.
+ ***********************************************************/
+void DeferredRenderer::Reserve(int width, int height)
+{
+	if ((width <= 0) || (height <= 0) ||
+		((width == m_allocatedWidth) && (height == m_allocatedHeight)))
+	{
+		return;
+	}
+
+	DestroyGBuffer();
+	Resize(width, height);
+}
+
+/***********************************************************
+ *  UploadMaterials()
+ *
+ *  This method is used to pack the defined materials into a
+ *  small float texture, indexed by the G-buffer material id.
+ ***********************************************************/
+void DeferredRenderer::UploadMaterials(const std::vector<SceneManager::OBJECT_MATERIAL>& materials)
+{
+	if (materials.empty())
+	{
+		return;
+	}
+
+	// the material id is stored in 8 bits
+	int materialCount = std::min((int)materials.size(), 256);
+	std::vector<glm::vec4> table(materialCount * MATERIAL_TABLE_ROWS);
+	for (int i = 0; i < materialCount; i++)
+	{
+		table[i] = glm::vec4(materials[i].ambientColor, materials[i].ambientStrength);
+		table[materialCount + i] = glm::vec4(materials[i].diffuseColor, materials[i].shininess);
+		table[(materialCount * 2) + i] = glm::vec4(materials[i].specularColor, 0.0f);
+	}
+
+	if (m_materialTable == 0)
+	{
+		glGenTextures(1, &m_materialTable);
+	}
+	glBindTexture(GL_TEXTURE_2D, m_materialTable);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, materialCount, MATERIAL_TABLE_ROWS, 0, GL_RGBA, GL_FLOAT, table.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used to bind and clear the G-buffer and
+ *  set the camera values into the G-buffer program.
+ ***********************************************************/
+void DeferredRenderer::BeginGeometryPass(const glm::mat4& view, const glm::mat4& projection, RenderStats& stats)
+{
+	m_viewProjection = projection * view;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_gBuffer);
+	glViewport(0, 0, m_width, m_height);
+
+	// the integer material target has to be cleared on its own
+	const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLuint clearMaterial[4] = { 0, 0, 0, 0 };
+	const GLfloat clearDepth = 1.0f;
+	glClearBufferfv(GL_COLOR, 0, clearColor);
+	glClearBufferfv(GL_COLOR, 1, clearColor);
+	glClearBufferuiv(GL_COLOR, 2, clearMaterial);
+	glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glUseProgram(m_geometryProgram);
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(m_projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+	stats.programSwitches++;
+	stats.uniformUploads += 2;
+}
+
+/***********************************************************
+ *  SetDrawItem()
+ *
+ *  This method is used to set the per-object values into
+ *  the G-buffer program before the mesh is drawn.  The
+ *  model matrix already includes the decode transform of
+ *  the mesh.
+ ***********************************************************/
+void DeferredRenderer::SetDrawItem(const SceneManager::DRAW_ITEM& item, const glm::mat4& model, RenderStats& stats)
+{
+	// the normal matrix is done once per object here instead of per vertex
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+	glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+	glUniformMatrix3fv(m_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+	glUniform2f(m_uvScaleLocation, item.uvScale.x, item.uvScale.y);
+	glUniform1i(m_useTextureLocation, (item.textureSlot >= 0) ? 1 : 0);
+	glUniform1i(m_textureLocation, std::max(item.textureSlot, 0));
+	glUniform1ui(m_materialIndexLocation, (GLuint)std::max(item.materialIndex, 0));
+	stats.uniformUploads += 6;
+}
+
+/***********************************************************
+ *  EndGeometryPass()
+ *
+ *  This method is used to finish writing to the G-buffer.
+ ***********************************************************/
+void DeferredRenderer::EndGeometryPass()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  GetLightScissor()
+ *
+ *  This method is used to project the bounding box of a
+ *  light onto the screen.  Returns false when the light
+ *  volume is completely off screen.
+ ***********************************************************/
+bool DeferredRenderer::GetLightScissor(const SceneManager::LIGHT_SOURCE& light, GLint rect[4]) const
+{
+	// unbounded lights cover the full screen
+	rect[0] = 0;
+	rect[1] = 0;
+	rect[2] = m_width;
+	rect[3] = m_height;
+	if (light.radius <= 0.0f)
+	{
+		return true;
+	}
+
+	glm::vec2 ndcMin(1.0f);
+	glm::vec2 ndcMax(-1.0f);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 offset(
+			(corner & 1) ? light.radius : -light.radius,
+			(corner & 2) ? light.radius : -light.radius,
+			(corner & 4) ? light.radius : -light.radius);
+		glm::vec4 clip = m_viewProjection * glm::vec4(light.position + offset, 1.0f);
+
+		// the camera is inside or behind part of the volume
+		if (clip.w <= 0.0001f)
+		{
+			return true;
+		}
+		glm::vec2 ndc(clip.x / clip.w, clip.y / clip.w);
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	ndcMin = glm::max(ndcMin, glm::vec2(-1.0f));
+	ndcMax = glm::min(ndcMax, glm::vec2(1.0f));
+	if ((ndcMin.x >= ndcMax.x) || (ndcMin.y >= ndcMax.y))
+	{
+		return false;
+	}
+
+	rect[0] = (GLint)((ndcMin.x * 0.5f + 0.5f) * m_width);
+	rect[1] = (GLint)((ndcMin.y * 0.5f + 0.5f) * m_height);
+	rect[2] = (GLint)((ndcMax.x * 0.5f + 0.5f) * m_width) - rect[0] + 1;
+	rect[3] = (GLint)((ndcMax.y * 0.5f + 0.5f) * m_height) - rect[1] + 1;
+
+	return true;
+}
+
+/***********************************************************
+ *  RunLightingPass()
+ *
+ *  This method is used to additively shade every light over
+ *  the screen area its volume covers.
+ ***********************************************************/
+void DeferredRenderer::RunLightingPass(
+	const std::vector<SceneManager::LIGHT_SOURCE>& lights,
+	const glm::vec3& viewPosition,
+	GLuint targetFramebuffer,
+	RenderStats& stats)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+	glViewport(0, 0, m_width, m_height);
+
+	glActiveTexture(GL_TEXTURE0 + ALBEDO_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_albedoTexture);
+	glActiveTexture(GL_TEXTURE0 + NORMAL_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_normalTexture);
+	glActiveTexture(GL_TEXTURE0 + MATERIAL_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_materialTexture);
+	glActiveTexture(GL_TEXTURE0 + DEPTH_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glActiveTexture(GL_TEXTURE0 + MATERIAL_TABLE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_materialTable);
+
+	glUseProgram(m_lightingProgram);
+	glm::mat4 inverseViewProjection = glm::inverse(m_viewProjection);
+	glUniformMatrix4fv(m_inverseViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniform2f(m_screenSizeLocation, (float)m_width, (float)m_height);
+	glUniform3fv(m_viewPositionLocation, 1, glm::value_ptr(viewPosition));
+	stats.textureBinds += 5;
+	stats.programSwitches++;
+	stats.uniformUploads += 3;
+
+	// every light adds its contribution on top of the previous ones
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glEnable(GL_SCISSOR_TEST);
+	glBindVertexArray(m_emptyVAO);
+
+	for (const SceneManager::LIGHT_SOURCE& light : lights)
+	{
+		GLint rect[4];
+		if (GetLightScissor(light, rect) == false)
+		{
+			// lights entirely off screen are culled
+			stats.culledObjects++;
+			continue;
+		}
+		glScissor(rect[0], rect[1], rect[2], rect[3]);
+
+		glUniform3fv(m_lightPositionLocation, 1, glm::value_ptr(light.position));
+		glUniform3fv(m_lightAmbientLocation, 1, glm::value_ptr(light.ambientColor));
+		glUniform3fv(m_lightDiffuseLocation, 1, glm::value_ptr(light.diffuseColor));
+		glUniform3fv(m_lightSpecularLocation, 1, glm::value_ptr(light.specularColor));
+		glUniform1f(m_lightFocalLocation, light.focalStrength);
+		glUniform1f(m_lightIntensityLocation, light.specularIntensity);
+		glUniform1f(m_lightRadiusLocation, light.radius);
+
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		stats.drawCalls++;
+		stats.uniformUploads += 7;
+	}
+
+	// put back the state the forward path expects
+	glBindVertexArray(0);
+	glDisable(GL_SCISSOR_TEST);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  CopyDepthTo()
+ *
+ *  This method is used to copy the G-buffer depth into the
+ *  target framebuffer, so the forward transparent pass is
+ *  correctly hidden behind the deferred opaque objects.
+ ***********************************************************/
+void DeferredRenderer::CopyDepthTo(GLuint targetFramebuffer)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_gBuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+	glBlitFramebuffer(
+		0, 0, m_width, m_height,
+		0, 0, m_width, m_height,
+		GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+}
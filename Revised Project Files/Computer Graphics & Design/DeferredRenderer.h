@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.h
+// ============
+// G-buffer and light volume passes for the deferred shading path
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager_revised.h"
+
+#include <vector>
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  This class owns the G-buffer and the programs for the
+ *  deferred shading path.  The geometry pass writes albedo,
+ *  normal, material index and depth; the lighting pass then
+ *  shades each light once over its scissored screen volume,
+ *  so the cost is objects + lights instead of objects x lights.
+ ***********************************************************/
+class DeferredRenderer
+{
+public:
+	// constructor
+	DeferredRenderer();
+	// destructor
+	~DeferredRenderer();
+
+	// compile the G-buffer and lighting programs
+	bool Initialize();
+
+	// set the render size - the G-buffer is only reallocated when it grows
+	void Resize(int width, int height);
+	// reallocate the G-buffer at exactly this size (used on window resize)
+	void Reserve(int width, int height);
+
+	// pack the defined materials into the material lookup texture
+	void UploadMaterials(const std::vector<SceneManager::OBJECT_MATERIAL>& materials);
+
+	// geometry pass - bind the G-buffer and the G-buffer program
+	void BeginGeometryPass(const glm::mat4& view, const glm::mat4& projection, RenderStats& stats);
+	// set the per-object values before a mesh is drawn
+	void SetDrawItem(const SceneManager::DRAW_ITEM& item, const glm::mat4& model, RenderStats& stats);
+	// geometry pass - restore the default framebuffer
+	void EndGeometryPass();
+
+	// accumulate every light into the target framebuffer
+	void RunLightingPass(
+		const std::vector<SceneManager::LIGHT_SOURCE>& lights,
+		const glm::vec3& viewPosition,
+		GLuint targetFramebuffer,
+		RenderStats& stats);
+
+	// copy the G-buffer depth so forward items are depth tested
+	void CopyDepthTo(GLuint targetFramebuffer);
+
+private:
+	// G-buffer framebuffer and attachments
+	GLuint m_gBuffer;
+	GLuint m_albedoTexture;
+	GLuint m_normalTexture;
+	GLuint m_materialTexture;
+	GLuint m_depthTexture;
+	// size being rendered, and the size the attachments were allocated at
+	int m_width;
+	int m_height;
+	int m_allocatedWidth;
+	int m_allocatedHeight;
+
+	// material lookup texture (3 texels per material)
+	GLuint m_materialTable;
+
+	// programs for the two passes
+	GLuint m_geometryProgram;
+	GLuint m_lightingProgram;
+
+	// empty vertex array for the full screen triangle
+	GLuint m_emptyVAO;
+
+	// cached uniform locations for the geometry pass
+	GLint m_modelLocation;
+	GLint m_normalMatrixLocation;
+	GLint m_uvScaleLocation;
+	GLint m_useTextureLocation;
+	GLint m_textureLocation;
+	GLint m_materialIndexLocation;
+	GLint m_viewLocation;
+	GLint m_projectionLocation;
+
+	// cached uniform locations for the lighting pass
+	GLint m_inverseViewProjectionLocation;
+	GLint m_screenSizeLocation;
+	GLint m_viewPositionLocation;
+	GLint m_lightPositionLocation;
+	GLint m_lightAmbientLocation;
+	GLint m_lightDiffuseLocation;
+	GLint m_lightSpecularLocation;
+	GLint m_lightFocalLocation;
+	GLint m_lightIntensityLocation;
+	GLint m_lightRadiusLocation;
+
+	// cached view values for the lighting pass
+	glm::mat4 m_viewProjection;
+
+	// free the G-buffer attachments
+	void DestroyGBuffer();
+	// work out the screen rectangle covered by a light
+	bool GetLightScissor(const SceneManager::LIGHT_SOURCE& light, GLint rect[4]) const;
+};
@@ -0,0 +1,337 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// offscreen render target with a GPU frame time driven resolution scale
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+#include "ShaderUtils.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the scale moves in 5% steps so small timing noise is ignored
+	const float SCALE_STEP = 0.05f;
+	// frames to wait after a change, so the queries catch up with it
+	const int SETTLE_FRAMES = 8;
+	// smoothing applied to the GPU frame times
+	const float GPU_TIME_SMOOTHING = 0.1f;
+
+	const char* g_UpscaleVertexShader = R"(
+#version 330 core
+out vec2 fragmentTextureCoordinate;
+void main()
+{
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	fragmentTextureCoordinate = position;
+	gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+	// bilinear upscale with a light 5-tap sharpen to win back detail
+	const char* g_UpscaleFragmentShader = R"(
+#version 330 core
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D sceneTexture;
+uniform vec2 uvScale;
+uniform vec2 texelSize;
+uniform float sharpness;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+	vec2 uv = fragmentTextureCoordinate * uvScale;
+	vec3 center = texture(sceneTexture, uv).rgb;
+	if (sharpness > 0.0)
+	{
+		vec3 neighbors = texture(sceneTexture, uv + vec2(texelSize.x, 0.0)).rgb +
+			texture(sceneTexture, uv - vec2(texelSize.x, 0.0)).rgb +
+			texture(sceneTexture, uv + vec2(0.0, texelSize.y)).rgb +
+			texture(sceneTexture, uv - vec2(0.0, texelSize.y)).rgb;
+		center = clamp(center + (center * 4.0 - neighbors) * (sharpness * 0.25), 0.0, 1.0);
+	}
+	outFragmentColor = vec4(center, 1.0);
+}
+)";
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_framebuffer = 0;
+	m_colorTexture = 0;
+	m_depthBuffer = 0;
+	m_allocatedWidth = 0;
+	m_allocatedHeight = 0;
+	m_outputWidth = 0;
+	m_outputHeight = 0;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_upscaleProgram = 0;
+	m_uvScaleLocation = -1;
+	m_texelSizeLocation = -1;
+	m_sharpnessLocation = -1;
+	m_emptyVAO = 0;
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		m_queries[i] = 0;
+		m_queryIssued[i] = false;
+	}
+	m_frameIndex = 0;
+	m_scale = 1.0f;
+	m_minScale = 0.5f;
+	m_maxScale = 1.0f;
+	m_targetFrameMs = 16.6f;
+	m_filteredGpuMs = 0.0f;
+	m_sharpness = 0.2f;
+	m_framesSinceChange = 0;
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	glDeleteFramebuffers(1, &m_framebuffer);
+	glDeleteTextures(1, &m_colorTexture);
+	glDeleteRenderbuffers(1, &m_depthBuffer);
+	glDeleteQueries(QUERY_COUNT, m_queries);
+	glDeleteProgram(m_upscaleProgram);
+	glDeleteVertexArrays(1, &m_emptyVAO);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to compile the upscale program and
+ *  create the GPU timer queries.
+ ***********************************************************/
+bool DynamicResolution::Initialize()
+{
+	m_upscaleProgram = ShaderUtils::CreateProgram(
+		g_UpscaleVertexShader, g_UpscaleFragmentShader, "upscale");
+	if (m_upscaleProgram == 0)
+	{
+		return false;
+	}
+
+	m_uvScaleLocation = glGetUniformLocation(m_upscaleProgram, "uvScale");
+	m_texelSizeLocation = glGetUniformLocation(m_upscaleProgram, "texelSize");
+	m_sharpnessLocation = glGetUniformLocation(m_upscaleProgram, "sharpness");
+	glUseProgram(m_upscaleProgram);
+	ShaderUtils::SetSamplerUnit(m_upscaleProgram, "sceneTexture", 0);
+	glUseProgram(0);
+
+	glGenVertexArrays(1, &m_emptyVAO);
+	glGenQueries(QUERY_COUNT, m_queries);
+
+	std::cout << "INFO: Dynamic resolution enabled, target " << m_targetFrameMs << " ms" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetScaleLimits()
+ *
+ *  This method is used to set the range the resolution
+ *  scale is allowed to move in.
+ ***********************************************************/
+void DynamicResolution::SetScaleLimits(float minScale, float maxScale)
+{
+	m_minScale = std::max(0.1f, std::min(minScale, 1.0f));
+	m_maxScale = std::max(m_minScale, std::min(maxScale, 1.0f));
+	m_scale = std::max(m_minScale, std::min(m_scale, m_maxScale));
+}
+
+/***********************************************************
+ *  AllocateTarget()
+ *
+ *  This method is used to allocate the offscreen color and
+ *  depth buffers at the full window size.
+ ***********************************************************/
+void DynamicResolution::AllocateTarget(int width, int height)
+{
+	if (m_framebuffer == 0)
+	{
+		glGenFramebuffers(1, &m_framebuffer);
+		glGenTextures(1, &m_colorTexture);
+		glGenRenderbuffers(1, &m_depthBuffer);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: Dynamic resolution framebuffer is incomplete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_allocatedWidth = width;
+	m_allocatedHeight = height;
+}
+
+/***********************************************************
+ *  ReadGpuTimes()
+ *
+ *  This method is used to collect the oldest timer query.
+ *  If its result is not ready yet it is simply skipped, so
+ *  the CPU never waits on the GPU.
+ ***********************************************************/
+void DynamicResolution::ReadGpuTimes()
+{
+	int index = m_frameIndex % QUERY_COUNT;
+	if (m_queryIssued[index] == false)
+	{
+		return;
+	}
+
+	GLint available = 0;
+	glGetQueryObjectiv(m_queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available == 0)
+	{
+		return;
+	}
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(m_queries[index], GL_QUERY_RESULT, &elapsed);
+	m_queryIssued[index] = false;
+
+	UpdateScale((float)(elapsed / 1000000.0));
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used to move the resolution scale toward
+ *  the target frame time.  The cost is roughly proportional
+ *  to the pixel count, which goes with the square of the scale.
+ ***********************************************************/
+void DynamicResolution::UpdateScale(float gpuMilliseconds)
+{
+	if (m_filteredGpuMs <= 0.0f)
+	{
+		m_filteredGpuMs = gpuMilliseconds;
+	}
+	else
+	{
+		m_filteredGpuMs += (gpuMilliseconds - m_filteredGpuMs) * GPU_TIME_SMOOTHING;
+	}
+
+	m_framesSinceChange++;
+	if ((m_framesSinceChange < SETTLE_FRAMES) || (m_filteredGpuMs <= 0.0f))
+	{
+		return;
+	}
+
+	// leave the scale alone inside the dead band around the target
+	if ((m_filteredGpuMs <= m_targetFrameMs) && (m_filteredGpuMs >= m_targetFrameMs * 0.85f))
+	{
+		return;
+	}
+
+	float desired = m_scale * std::sqrt(m_targetFrameMs / m_filteredGpuMs);
+	// drop quickly when over budget, climb back slowly
+	desired = std::max(m_scale - 0.1f, std::min(desired, m_scale + SCALE_STEP));
+	desired = std::round(desired / SCALE_STEP) * SCALE_STEP;
+	desired = std::max(m_minScale, std::min(desired, m_maxScale));
+
+	if (desired != m_scale)
+	{
+		m_scale = desired;
+		m_framesSinceChange = 0;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to bind the offscreen target and set
+ *  the viewport to the scaled size for this frame.
+ ***********************************************************/
+void DynamicResolution::BeginFrame(int outputWidth, int outputHeight)
+{
+	// the target is only reallocated when the window size really changes
+	if ((outputWidth != m_allocatedWidth) || (outputHeight != m_allocatedHeight))
+	{
+		AllocateTarget(outputWidth, outputHeight);
+	}
+
+	ReadGpuTimes();
+
+	m_outputWidth = outputWidth;
+	m_outputHeight = outputHeight;
+	m_renderWidth = std::max(1, (int)(outputWidth * m_scale));
+	m_renderHeight = std::max(1, (int)(outputHeight * m_scale));
+
+	int index = m_frameIndex % QUERY_COUNT;
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[index]);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_renderWidth, m_renderHeight);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to upscale the rendered sub-rectangle
+ *  of the offscreen target into the default framebuffer.
+ ***********************************************************/
+void DynamicResolution::EndFrame()
+{
+	GpuScope profileScope("upscale");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, m_outputWidth, m_outputHeight);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glUseProgram(m_upscaleProgram);
+	glUniform2f(m_uvScaleLocation,
+		(float)m_renderWidth / (float)m_allocatedWidth,
+		(float)m_renderHeight / (float)m_allocatedHeight);
+	glUniform2f(m_texelSizeLocation, 1.0f / (float)m_allocatedWidth, 1.0f / (float)m_allocatedHeight);
+	// no sharpening is needed when rendering at full size
+	glUniform1f(m_sharpnessLocation, (m_scale < 1.0f) ? m_sharpness : 0.0f);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+	glBindVertexArray(m_emptyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glEnable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+
+	int index = m_frameIndex % QUERY_COUNT;
+	glEndQuery(GL_TIME_ELAPSED);
+	m_queryIssued[index] = true;
+	m_frameIndex++;
+}
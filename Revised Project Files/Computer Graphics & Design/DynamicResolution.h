@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// offscreen render target with a GPU frame time driven resolution scale
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class renders the scene into an offscreen target at
+ *  a fraction of the window resolution.  GPU frame times are
+ *  read back from timer queries a few frames late (so there
+ *  is never a stall), and a small controller moves the scale
+ *  toward a target frame time.  The result is then upscaled
+ *  into the default framebuffer with a bilinear filter and
+ *  an optional sharpening pass.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// constructor
+	DynamicResolution();
+	// destructor
+	~DynamicResolution();
+
+	// compile the upscale program and create the timer queries
+	bool Initialize();
+
+	// settings for the controller and the upscale filter
+	void SetTargetFrameTime(float milliseconds) { m_targetFrameMs = milliseconds; }
+	void SetScaleLimits(float minScale, float maxScale);
+	void SetSharpness(float sharpness) { m_sharpness = sharpness; }
+
+	// bind the offscreen target at the current scale for the window size
+	void BeginFrame(int outputWidth, int outputHeight);
+	// upscale the offscreen target into the default framebuffer
+	void EndFrame();
+
+	// the offscreen framebuffer and the size being rendered this frame
+	GLuint GetFramebuffer() const { return m_framebuffer; }
+	int GetRenderWidth() const { return m_renderWidth; }
+	int GetRenderHeight() const { return m_renderHeight; }
+	float GetScale() const { return m_scale; }
+	float GetGpuFrameTime() const { return m_filteredGpuMs; }
+
+private:
+	// number of timer queries in flight - results are read this many frames late
+	static const int QUERY_COUNT = 4;
+
+	// offscreen target - allocated at the window size and rendered
+	// into a sub-rectangle, so only a window resize reallocates it
+	GLuint m_framebuffer;
+	GLuint m_colorTexture;
+	GLuint m_depthBuffer;
+	int m_allocatedWidth;
+	int m_allocatedHeight;
+
+	// sizes for the current frame
+	int m_outputWidth;
+	int m_outputHeight;
+	int m_renderWidth;
+	int m_renderHeight;
+
+	// upscale program and its uniforms
+	GLuint m_upscaleProgram;
+	GLint m_uvScaleLocation;
+	GLint m_texelSizeLocation;
+	GLint m_sharpnessLocation;
+	GLuint m_emptyVAO;
+
+	// GPU frame timing
+	GLuint m_queries[QUERY_COUNT];
+	bool m_queryIssued[QUERY_COUNT];
+	int m_frameIndex;
+
+	// controller state
+	float m_scale;
+	float m_minScale;
+	float m_maxScale;
+	float m_targetFrameMs;
+	float m_filteredGpuMs;
+	float m_sharpness;
+	int m_framesSinceChange;
+
+	// (re)allocate the offscreen target when the window size changes
+	void AllocateTarget(int width, int height);
+	// read back any finished timer query without waiting
+	void ReadGpuTimes();
+	// move the scale toward the target frame time
+	void UpdateScale(float gpuMilliseconds);
+};
@@ -0,0 +1,188 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// report when watched files have been saved, without blocking
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// quiet time after the last write before a change is reported
+	const double SETTLE_SECONDS = 0.15;
+	// how often file times are checked where inotify is not available
+	const double TIME_CHECK_SECONDS = 0.5;
+
+	/***********************************************************
+	 *  GetWriteTime()
+	 *
+	 *  This function is used to get the last write time of a
+	 *  file, or the default time when it cannot be read.
+	 ***********************************************************/
+	std::filesystem::file_time_type GetWriteTime(const std::string& filePath)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(filePath, error);
+		return(error ? std::filesystem::file_time_type() : writeTime);
+	}
+}
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_inotifyFD = -1;
+	m_lastTimeCheck = Clock::now();
+	m_bChangePending = false;
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (m_inotifyFD >= 0)
+	{
+		close(m_inotifyFD);
+	}
+#endif
+}
+
+/***********************************************************
+ *  Watch()
+ *
+ *  This method is used to start watching the files.  On
+ *  Linux their folders are watched rather than the files,
+ *  since many editors save by writing a new file and moving
+ *  it over the old one.
+ ***********************************************************/
+bool FileWatcher::Watch(const std::vector<std::string>& filePaths)
+{
+	m_filePaths = filePaths;
+	m_fileNames.clear();
+	m_writeTimes.clear();
+	for (const std::string& path : m_filePaths)
+	{
+		m_fileNames.push_back(std::filesystem::path(path).filename().string());
+		m_writeTimes.push_back(GetWriteTime(path));
+	}
+
+#ifdef __linux__
+	m_inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotifyFD >= 0)
+	{
+		for (const std::string& path : m_filePaths)
+		{
+			std::string folder = std::filesystem::path(path).parent_path().string();
+			if (folder.empty())
+			{
+				folder = ".";
+			}
+			int watch = inotify_add_watch(m_inotifyFD, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+			if (watch >= 0)
+			{
+				m_watchDescriptors.push_back(watch);
+			}
+		}
+	}
+	if (m_watchDescriptors.empty())
+	{
+		std::cout << "inotify is not available, checking file times instead" << std::endl;
+	}
+#endif
+
+	return true;
+}
+
+/***********************************************************
+ *  CheckForChanges()
+ *
+ *  This method is used to find out, without blocking, if a
+ *  watched file has been written.  Other files written in
+ *  the same folders are ignored.
+ ***********************************************************/
+bool FileWatcher::CheckForChanges()
+{
+#ifdef __linux__
+	if (!m_watchDescriptors.empty())
+	{
+		bool bChanged = false;
+		alignas(struct inotify_event) char buffer[4096];
+		ssize_t length = 0;
+		while ((length = read(m_inotifyFD, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* next = buffer; next < buffer + length; )
+			{
+				const struct inotify_event* event = (const struct inotify_event*)next;
+				for (size_t i = 0; (i < m_fileNames.size()) && (event->len > 0); i++)
+				{
+					if (m_fileNames[i] == event->name)
+					{
+						bChanged = true;
+					}
+				}
+				next += sizeof(struct inotify_event) + event->len;
+			}
+		}
+		return(bChanged);
+	}
+#endif
+
+	// without inotify, compare the file times every so often
+	Clock::time_point now = Clock::now();
+	if (std::chrono::duration<double>(now - m_lastTimeCheck).count() < TIME_CHECK_SECONDS)
+	{
+		return false;
+	}
+	m_lastTimeCheck = now;
+
+	bool bChanged = false;
+	for (size_t i = 0; i < m_filePaths.size(); i++)
+	{
+		std::filesystem::file_time_type writeTime = GetWriteTime(m_filePaths[i]);
+		if (writeTime != m_writeTimes[i])
+		{
+			m_writeTimes[i] = writeTime;
+			bChanged = true;
+		}
+	}
+	return(bChanged);
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used once per frame to pick up file
+ *  changes, reporting each one when its writes have settled.
+ ***********************************************************/
+bool FileWatcher::Poll()
+{
+	if (CheckForChanges())
+	{
+		m_bChangePending = true;
+		m_changeTime = Clock::now();
+	}
+
+	if (m_bChangePending &&
+		(std::chrono::duration<double>(Clock::now() - m_changeTime).count() >= SETTLE_SECONDS))
+	{
+		m_bChangePending = false;
+		return true;
+	}
+	return false;
+}
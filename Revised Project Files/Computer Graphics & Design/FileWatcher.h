@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// report when watched files have been saved, without blocking
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class watches a few files for the hot reloaders
+ *  (inotify on Linux, file times elsewhere).  Editors save
+ *  in several steps, so a change is only reported once the
+ *  writes have settled, and reported once however many
+ *  writes it took.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// start watching the passed in files
+	bool Watch(const std::vector<std::string>& filePaths);
+
+	// call once per frame - returns true when a watched file was
+	// saved and has not been written to since for a moment
+	bool Poll();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<std::string> m_filePaths;
+	std::vector<std::string> m_fileNames;
+	std::vector<std::filesystem::file_time_type> m_writeTimes;
+
+	int m_inotifyFD;
+	std::vector<int> m_watchDescriptors;
+	Clock::time_point m_lastTimeCheck;
+	bool m_bChangePending;
+	Clock::time_point m_changeTime;
+
+	// true when a watched file has been written since the last call
+	bool CheckForChanges();
+};
@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.cpp
+// ============
+// per-frame timing samples and the JSON report for --bench runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	struct SUMMARY
+	{
+		double mean;
+		double p50;
+		double p95;
+		double p99;
+		double max;
+	};
+
+	/***********************************************************
+	 *  Summarize()
+	 *
+	 *  This function is used to get the mean, nearest-rank
+	 *  percentiles and maximum of a list of values.
+	 ***********************************************************/
+	SUMMARY Summarize(std::vector<double> values)
+	{
+		SUMMARY summary = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+		if (values.empty())
+		{
+			return summary;
+		}
+
+		std::sort(values.begin(), values.end());
+		double total = 0.0;
+		for (double value : values)
+		{
+			total += value;
+		}
+
+		size_t count = values.size();
+		auto percentile = [&values, count](double p)
+		{
+			size_t rank = (size_t)std::ceil(p * count);
+			rank = std::max((size_t)1, std::min(rank, count));
+			return values[rank - 1];
+		};
+
+		summary.mean = total / count;
+		summary.p50 = percentile(0.50);
+		summary.p95 = percentile(0.95);
+		summary.p99 = percentile(0.99);
+		summary.max = values.back();
+		return summary;
+	}
+
+	/***********************************************************
+	 *  WriteSummary()
+	 *
+	 *  This function is used to write one summary as a JSON
+	 *  object member.
+	 ***********************************************************/
+	void WriteSummary(FILE* file, const char* name, const SUMMARY& summary, bool bLast)
+	{
+		fprintf(file, "  \"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+			name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max, bLast ? "" : ",");
+	}
+
+	/***********************************************************
+	 *  WriteJsonString()
+	 *
+	 *  This function is used to write a quoted JSON string,
+	 *  escaping the characters JSON does not allow.
+	 ***********************************************************/
+	void WriteJsonString(FILE* file, const char* text)
+	{
+		fputc('"', file);
+		for (const char* c = text; (nullptr != c) && (*c != '\0'); c++)
+		{
+			if ((*c == '"') || (*c == '\\'))
+			{
+				fputc('\\', file);
+				fputc(*c, file);
+			}
+			else if ((unsigned char)*c >= 0x20)
+			{
+				fputc(*c, file);
+			}
+		}
+		fputc('"', file);
+	}
+}
+
+/***********************************************************
+ *  FrameBenchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameBenchmark::FrameBenchmark()
+{
+	m_timerQuery = 0;
+}
+
+/***********************************************************
+ *  ~FrameBenchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameBenchmark::~FrameBenchmark()
+{
+	if (m_timerQuery != 0)
+	{
+		glDeleteQueries(1, &m_timerQuery);
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the GPU timer query.
+ ***********************************************************/
+bool FrameBenchmark::Initialize()
+{
+	glGenQueries(1, &m_timerQuery);
+	return(m_timerQuery != 0);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start timing a measured frame.
+ ***********************************************************/
+void FrameBenchmark::BeginFrame()
+{
+	m_frameStart = Clock::now();
+	glBeginQuery(GL_TIME_ELAPSED, m_timerQuery);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to finish timing a measured frame.
+ *  The CPU time covers only submitting the work, the frame
+ *  time also waits for the GPU to finish it.  Since the run
+ *  finishes every frame anyway, the query result is ready
+ *  and reading it does not stall.
+ ***********************************************************/
+void FrameBenchmark::EndFrame(const RenderStats& stats)
+{
+	glEndQuery(GL_TIME_ELAPSED);
+	Clock::time_point submitted = Clock::now();
+	glFinish();
+	Clock::time_point finished = Clock::now();
+
+	GLuint64 gpuNanoseconds = 0;
+	glGetQueryObjectui64v(m_timerQuery, GL_QUERY_RESULT, &gpuNanoseconds);
+
+	FRAME_SAMPLE sample;
+	sample.cpuMs = std::chrono::duration<double, std::milli>(submitted - m_frameStart).count();
+	sample.frameMs = std::chrono::duration<double, std::milli>(finished - m_frameStart).count();
+	sample.gpuMs = gpuNanoseconds / 1000000.0;
+	sample.drawCalls = stats.drawCalls;
+	sample.triangles = stats.triangles;
+	sample.uniformUploads = stats.uniformUploads;
+	sample.stateChanges = stats.GetStateChanges();
+	sample.vertexBytes = stats.vertexBytes;
+	m_samples.push_back(sample);
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used to write the statistics of the run
+ *  as JSON, along with what is needed to compare two runs
+ *  fairly (renderer, size, render path and frame counts).
+ ***********************************************************/
+bool FrameBenchmark::WriteReport(const char* filePath, const char* renderPath,
+	int warmupFrames, int width, int height) const
+{
+	std::vector<double> cpuTimes;
+	std::vector<double> frameTimes;
+	std::vector<double> gpuTimes;
+	std::vector<double> drawCalls;
+	std::vector<double> triangles;
+	std::vector<double> uniformUploads;
+	std::vector<double> stateChanges;
+	std::vector<double> vertexBytes;
+	for (const FRAME_SAMPLE& sample : m_samples)
+	{
+		cpuTimes.push_back(sample.cpuMs);
+		frameTimes.push_back(sample.frameMs);
+		gpuTimes.push_back(sample.gpuMs);
+		drawCalls.push_back(sample.drawCalls);
+		triangles.push_back((double)sample.triangles);
+		uniformUploads.push_back(sample.uniformUploads);
+		stateChanges.push_back(sample.stateChanges);
+		vertexBytes.push_back((double)sample.vertexBytes);
+	}
+
+	FILE* file = stdout;
+	if (nullptr != filePath)
+	{
+		file = fopen(filePath, "w");
+		if (file == nullptr)
+		{
+			std::cout << "ERROR: Could not open " << filePath << " for writing" << std::endl;
+			return false;
+		}
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"renderer\": ");
+	WriteJsonString(file, (const char*)glGetString(GL_RENDERER));
+	fprintf(file, ",\n  \"gl_version\": ");
+	WriteJsonString(file, (const char*)glGetString(GL_VERSION));
+	fprintf(file, ",\n  \"render_path\": ");
+	WriteJsonString(file, renderPath);
+	fprintf(file, ",\n  \"width\": %d,\n  \"height\": %d,\n", width, height);
+	fprintf(file, "  \"warmup_frames\": %d,\n  \"frames\": %d,\n", warmupFrames, (int)m_samples.size());
+	WriteSummary(file, "cpu_ms", Summarize(cpuTimes), false);
+	WriteSummary(file, "frame_ms", Summarize(frameTimes), false);
+	WriteSummary(file, "gpu_ms", Summarize(gpuTimes), false);
+	WriteSummary(file, "draw_calls", Summarize(drawCalls), false);
+	WriteSummary(file, "triangles", Summarize(triangles), false);
+	WriteSummary(file, "uniform_uploads", Summarize(uniformUploads), false);
+	WriteSummary(file, "state_changes", Summarize(stateChanges), false);
+	WriteSummary(file, "vertex_bytes", Summarize(vertexBytes), true);
+	fprintf(file, "}\n");
+
+	if (file != stdout)
+	{
+		fclose(file);
+		std::cout << "INFO: Benchmark report written to " << filePath << std::endl;
+	}
+	else
+	{
+		fflush(file);
+	}
+	return true;
+}
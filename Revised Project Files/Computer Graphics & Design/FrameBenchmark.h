@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+// framebenchmark.h
+// ============
+// per-frame timing samples and the JSON report for --bench runs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include "RenderStats.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameBenchmark
+ *
+ *  This class records the CPU time, the GPU time (from a
+ *  GL_TIME_ELAPSED query) and the render statistics of every
+ *  measured frame.  At the end of the run it
+ *  writes the mean, median, 95th / 99th percentile and worst
+ *  case of each as JSON, so runs can be compared by a script.
+ ***********************************************************/
+class FrameBenchmark
+{
+public:
+	// constructor
+	FrameBenchmark();
+	// destructor
+	~FrameBenchmark();
+
+	// create the timer query
+	bool Initialize();
+
+	// bracket the work of one measured frame
+	void BeginFrame();
+	void EndFrame(const RenderStats& stats);
+
+	// write the report to a file, or to stdout when the path is null
+	bool WriteReport(const char* filePath, const char* renderPath,
+		int warmupFrames, int width, int height) const;
+
+	int GetFrameCount() const { return (int)m_samples.size(); }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct FRAME_SAMPLE
+	{
+		double cpuMs;
+		double frameMs;
+		double gpuMs;
+		int drawCalls;
+		long long triangles;
+		int uniformUploads;
+		int stateChanges;
+		long long vertexBytes;
+	};
+
+	GLuint m_timerQuery;
+	Clock::time_point m_frameStart;
+	std::vector<FRAME_SAMPLE> m_samples;
+};
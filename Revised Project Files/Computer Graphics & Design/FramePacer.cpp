@@ -0,0 +1,250 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// vsync control, frame rate limiting and present-to-present timing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#ifdef _WIN32
+// the default Windows timer resolution is ~15.6 ms, far too coarse to pace frames
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// declaration of global variables
+namespace
+{
+	// limits for the spin tail in seconds
+	const double MIN_SPIN_MARGIN = 0.0002;
+	const double MAX_SPIN_MARGIN = 0.004;
+	// smoothing applied to the measured sleep overshoot
+	const double OVERSHOOT_SMOOTHING = 0.05;
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_swapInterval = 1;
+	m_framePeriod = 0.0;
+	m_bHasDeadline = false;
+	m_sleepOvershoot = 0.001;
+	m_sleepOvershootVariance = 0.0;
+	m_spinMargin = 0.002;
+	for (int i = 0; i < SAMPLE_COUNT; i++)
+	{
+		m_samples[i] = 0.0;
+	}
+	m_sampleCount = 0;
+	m_sampleIndex = 0;
+	m_bHasPresent = false;
+
+#ifdef _WIN32
+	timeBeginPeriod(1);
+#endif
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+/***********************************************************
+ *  SetSwapInterval()
+ *
+ *  This method is used to set the vsync mode explicitly
+ *  instead of relying on the driver default.  Adaptive vsync
+ *  falls back to normal vsync when it is not supported.
+ ***********************************************************/
+void FramePacer::SetSwapInterval(int swapInterval)
+{
+	if ((swapInterval < 0) &&
+		(glfwExtensionSupported("WGL_EXT_swap_control_tear") == GLFW_FALSE) &&
+		(glfwExtensionSupported("GLX_EXT_swap_control_tear") == GLFW_FALSE))
+	{
+		std::cout << "Adaptive vsync is not supported, using vsync" << std::endl;
+		swapInterval = 1;
+	}
+
+	m_swapInterval = swapInterval;
+	glfwSwapInterval(m_swapInterval);
+}
+
+/***********************************************************
+ *  SetFrameRateCap()
+ *
+ *  This method is used to set the frame rate cap.
+ ***********************************************************/
+void FramePacer::SetFrameRateCap(double framesPerSecond)
+{
+	m_framePeriod = (framesPerSecond > 0.0) ? (1.0 / framesPerSecond) : 0.0;
+	m_bHasDeadline = false;
+}
+
+/***********************************************************
+ *  UpdateSpinMargin()
+ *
+ *  This method is used to size the spin tail so it covers
+ *  nearly every late wake-up of the OS sleep: the smoothed
+ *  overshoot plus two standard deviations.
+ ***********************************************************/
+void FramePacer::UpdateSpinMargin(double overshoot)
+{
+	double difference = overshoot - m_sleepOvershoot;
+	m_sleepOvershoot += difference * OVERSHOOT_SMOOTHING;
+	m_sleepOvershootVariance += ((difference * difference) - m_sleepOvershootVariance) * OVERSHOOT_SMOOTHING;
+
+	double margin = m_sleepOvershoot + (2.0 * std::sqrt(m_sleepOvershootVariance));
+	m_spinMargin = std::max(MIN_SPIN_MARGIN, std::min(margin, MAX_SPIN_MARGIN));
+}
+
+/***********************************************************
+ *  WaitForNextFrame()
+ *
+ *  This method is used to hold the frame until its deadline.
+ *  Deadlines advance by whole periods, so small errors do not
+ *  add up into drift.
+ ***********************************************************/
+void FramePacer::WaitForNextFrame()
+{
+	if (m_framePeriod <= 0.0)
+	{
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+	std::chrono::duration<double> period(m_framePeriod);
+	if (m_bHasDeadline == false)
+	{
+		m_nextDeadline = now + std::chrono::duration_cast<Clock::duration>(period);
+		m_bHasDeadline = true;
+	}
+
+	// sleep for the bulk of the wait, leaving the spin tail
+	Clock::time_point sleepUntil = m_nextDeadline - std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(m_spinMargin));
+	if (now < sleepUntil)
+	{
+		std::this_thread::sleep_until(sleepUntil);
+		Clock::time_point woke = Clock::now();
+		UpdateSpinMargin(std::chrono::duration<double>(woke - sleepUntil).count());
+	}
+
+	// spin the rest of the way for an accurate release
+	while (Clock::now() < m_nextDeadline)
+	{
+		std::this_thread::yield();
+	}
+
+	// a frame that ran long starts a new schedule instead of trying to catch up
+	now = Clock::now();
+	m_nextDeadline += std::chrono::duration_cast<Clock::duration>(period);
+	if (m_nextDeadline < now)
+	{
+		m_nextDeadline = now + std::chrono::duration_cast<Clock::duration>(period);
+	}
+}
+
+/***********************************************************
+ *  OnFramePresented()
+ *
+ *  This method is used to record the present-to-present
+ *  time of the frame that was just swapped.
+ ***********************************************************/
+void FramePacer::OnFramePresented()
+{
+	Clock::time_point now = Clock::now();
+	if (m_bHasPresent)
+	{
+		m_samples[m_sampleIndex] = std::chrono::duration<double>(now - m_lastPresent).count();
+		m_sampleIndex = (m_sampleIndex + 1) % SAMPLE_COUNT;
+		m_sampleCount = std::min(m_sampleCount + 1, (int)SAMPLE_COUNT);
+	}
+	m_lastPresent = now;
+	m_bHasPresent = true;
+}
+
+/***********************************************************
+ *  ResetTiming()
+ *
+ *  This method is used after the main loop has been waiting
+ *  for events, so the idle time is not counted as a frame.
+ ***********************************************************/
+void FramePacer::ResetTiming()
+{
+	m_bHasPresent = false;
+	m_bHasDeadline = false;
+}
+
+/***********************************************************
+ *  GetMeanFrameTime()
+ *
+ *  This method is used to get the mean present-to-present
+ *  time in seconds over the recent frames.
+ ***********************************************************/
+double FramePacer::GetMeanFrameTime() const
+{
+	if (m_sampleCount == 0)
+	{
+		return 0.0;
+	}
+
+	double total = 0.0;
+	for (int i = 0; i < m_sampleCount; i++)
+	{
+		total += m_samples[i];
+	}
+	return(total / m_sampleCount);
+}
+
+/***********************************************************
+ *  GetFrameTimeJitter()
+ *
+ *  This method is used to get the standard deviation of the
+ *  present-to-present time in seconds.
+ ***********************************************************/
+double FramePacer::GetFrameTimeJitter() const
+{
+	if (m_sampleCount < 2)
+	{
+		return 0.0;
+	}
+
+	double mean = GetMeanFrameTime();
+	double variance = 0.0;
+	for (int i = 0; i < m_sampleCount; i++)
+	{
+		variance += (m_samples[i] - mean) * (m_samples[i] - mean);
+	}
+	return(std::sqrt(variance / (m_sampleCount - 1)));
+}
+
+/***********************************************************
+ *  PrintStats()
+ *
+ *  This method is used to print the frame pacing values.
+ ***********************************************************/
+void FramePacer::PrintStats() const
+{
+	std::cout << "INFO: Frame pacing - swap interval " << m_swapInterval
+		<< ", mean " << (GetMeanFrameTime() * 1000.0) << " ms"
+		<< ", jitter " << (GetFrameTimeJitter() * 1000.0) << " ms"
+		<< ", spin tail " << (m_spinMargin * 1000.0) << " ms" << std::endl;
+}
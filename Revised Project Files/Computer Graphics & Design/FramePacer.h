@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// vsync control, frame rate limiting and present-to-present timing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLFW/glfw3.h"     // GLFW library
+
+#include <chrono>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class sets the swap interval and optionally caps the
+ *  frame rate.  The cap sleeps for most of the wait and then
+ *  spins for the last part, since the OS sleep can wake up
+ *  late.  How late it wakes is measured every frame and the
+ *  spin tail is adapted to it, so CPU use stays low without
+ *  adding jitter.  Present-to-present times are recorded so
+ *  the mean and jitter can be reported.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer();
+	// destructor
+	~FramePacer();
+
+	// 0 = off, 1 = vsync, -1 = adaptive vsync (when supported)
+	void SetSwapInterval(int swapInterval);
+	// frames per second cap, 0 turns the cap off
+	void SetFrameRateCap(double framesPerSecond);
+
+	// wait until the next frame is due - call just before the swap
+	void WaitForNextFrame();
+	// record the present time - call just after the swap
+	void OnFramePresented();
+	// forget the last present and deadline after the loop sat idle
+	void ResetTiming();
+
+	// present-to-present statistics over the recent frames
+	double GetMeanFrameTime() const;
+	double GetFrameTimeJitter() const;
+	int GetSwapInterval() const { return m_swapInterval; }
+
+	// print the pacing statistics
+	void PrintStats() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// number of present-to-present samples kept
+	static const int SAMPLE_COUNT = 128;
+
+	int m_swapInterval;
+	double m_framePeriod;
+	Clock::time_point m_nextDeadline;
+	bool m_bHasDeadline;
+
+	// how late the OS sleep wakes up, smoothed, in seconds
+	double m_sleepOvershoot;
+	double m_sleepOvershootVariance;
+	// time spent spinning at the end of each wait
+	double m_spinMargin;
+
+	// present-to-present samples in seconds
+	double m_samples[SAMPLE_COUNT];
+	int m_sampleCount;
+	int m_sampleIndex;
+	Clock::time_point m_lastPresent;
+	bool m_bHasPresent;
+
+	// adapt the spin tail from the measured sleep overshoot
+	void UpdateSpinMargin(double overshoot);
+};
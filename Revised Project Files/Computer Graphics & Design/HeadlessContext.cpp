@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.cpp
+// ============
+// OpenGL context with no visible window, for benchmarking and CI
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  HeadlessContext()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HeadlessContext::HeadlessContext()
+{
+	m_bUsingEGL = false;
+	m_pHiddenWindow = nullptr;
+#ifdef HEADLESS_USE_EGL
+	m_display = EGL_NO_DISPLAY;
+	m_context = EGL_NO_CONTEXT;
+#endif
+}
+
+/***********************************************************
+ *  ~HeadlessContext()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+#ifdef HEADLESS_USE_EGL
+/***********************************************************
+ *  CreateEGLContext()
+ *
+ *  This method is used to create a desktop OpenGL context on
+ *  the Mesa surfaceless platform, with no window or pbuffer.
+ ***********************************************************/
+bool HeadlessContext::CreateEGLContext()
+{
+	// prefer the surfaceless platform, it needs no X11 or Wayland display
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (nullptr != getPlatformDisplay)
+	{
+		m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (m_display == EGL_NO_DISPLAY)
+	{
+		m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if ((m_display == EGL_NO_DISPLAY) || (eglInitialize(m_display, &major, &minor) == EGL_FALSE))
+	{
+		std::cout << "EGL display could not be initialized" << std::endl;
+		m_display = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	if (eglBindAPI(EGL_OPENGL_API) == EGL_FALSE)
+	{
+		std::cout << "EGL does not support desktop OpenGL" << std::endl;
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	eglChooseConfig(m_display, configAttributes, &config, 1, &configCount);
+
+	// ask for the same 4.6 core profile as the windowed path, then 3.3
+	const EGLint versions[2][2] = { { 4, 6 }, { 3, 3 } };
+	for (int i = 0; (i < 2) && (m_context == EGL_NO_CONTEXT); i++)
+	{
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, versions[i][0],
+			EGL_CONTEXT_MINOR_VERSION, versions[i][1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		m_context = eglCreateContext(m_display, (configCount > 0) ? config : EGL_NO_CONFIG_KHR,
+			EGL_NO_CONTEXT, contextAttributes);
+	}
+
+	if ((m_context == EGL_NO_CONTEXT) ||
+		(eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context) == EGL_FALSE))
+	{
+		std::cout << "EGL surfaceless context could not be created" << std::endl;
+		return false;
+	}
+
+	std::cout << "INFO: EGL " << major << "." << minor << " surfaceless context created" << std::endl;
+	return true;
+}
+#endif
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to create the headless context and
+ *  make it current on this thread.
+ ***********************************************************/
+bool HeadlessContext::Create()
+{
+#ifdef HEADLESS_USE_EGL
+	if (CreateEGLContext())
+	{
+		m_bUsingEGL = true;
+		return true;
+	}
+	Destroy();
+	std::cout << "Falling back to a hidden GLFW window" << std::endl;
+#endif
+
+	// a hidden window still needs a display, but never shows anything
+	if (glfwInit() == GLFW_FALSE)
+	{
+		std::cout << "GLFW could not be initialized for the headless context" << std::endl;
+		return false;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	m_pHiddenWindow = glfwCreateWindow(64, 64, "headless", nullptr, nullptr);
+	if (m_pHiddenWindow == nullptr)
+	{
+		std::cout << "Failed to create the hidden GLFW window" << std::endl;
+		return false;
+	}
+	glfwMakeContextCurrent(m_pHiddenWindow);
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used to release the headless context.
+ ***********************************************************/
+void HeadlessContext::Destroy()
+{
+#ifdef HEADLESS_USE_EGL
+	if (m_display != EGL_NO_DISPLAY)
+	{
+		eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_context != EGL_NO_CONTEXT)
+		{
+			eglDestroyContext(m_display, m_context);
+		}
+		eglTerminate(m_display);
+	}
+	m_display = EGL_NO_DISPLAY;
+	m_context = EGL_NO_CONTEXT;
+#endif
+
+	if (nullptr != m_pHiddenWindow)
+	{
+		glfwDestroyWindow(m_pHiddenWindow);
+		m_pHiddenWindow = nullptr;
+	}
+	m_bUsingEGL = false;
+}
@@ -0,0 +1,57 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.h
+// ============
+// OpenGL context with no visible window, for benchmarking and CI
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+#include "GLFW/glfw3.h"     // GLFW library
+
+// EGL surfaceless contexts are used on Linux, where build machines
+// usually have no display (Mesa llvmpipe works without a GPU)
+#if defined(__linux__)
+#define HEADLESS_USE_EGL 1
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+/***********************************************************
+ *  HeadlessContext
+ *
+ *  This class makes an OpenGL context current without any
+ *  visible window.  On Linux it uses an EGL surfaceless
+ *  context; elsewhere it falls back to a hidden GLFW window.
+ *  All rendering then goes into an OffscreenTarget.
+ ***********************************************************/
+class HeadlessContext
+{
+public:
+	// constructor
+	HeadlessContext();
+	// destructor
+	~HeadlessContext();
+
+	// create the context and make it current
+	bool Create();
+	// release the context
+	void Destroy();
+
+	// true when the context came from EGL instead of GLFW
+	bool IsEGL() const { return m_bUsingEGL; }
+
+private:
+	bool m_bUsingEGL;
+	// fallback hidden window
+	GLFWwindow* m_pHiddenWindow;
+
+#ifdef HEADLESS_USE_EGL
+	EGLDisplay m_display;
+	EGLContext m_context;
+
+	// try to create the EGL surfaceless context
+	bool CreateEGLContext();
+#endif
+};
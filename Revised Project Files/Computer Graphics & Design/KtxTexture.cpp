@@ -0,0 +1,399 @@
+///////////////////////////////////////////////////////////////////////////////
+// ktxtexture.cpp
+// ============
+// read and write block compressed textures in KTX2 containers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "KtxTexture.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// "<<KTX 20>>\r\n\x1A\n" with the chevrons as 0xAB / 0xBB
+	const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+	// identifier, header and index, then the level index
+	const size_t KTX2_HEADER_SIZE = 80;
+	const size_t KTX2_LEVEL_ENTRY_SIZE = 24;
+
+	// Vulkan format numbers, the cook writes the UNORM forms since the
+	// scene samples its textures without sRGB decoding
+	const unsigned int VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+	const unsigned int VK_FORMAT_BC3_UNORM_BLOCK = 137;
+	const unsigned int VK_FORMAT_BC7_UNORM_BLOCK = 145;
+
+	// Khronos data format descriptor values
+	const unsigned int KHR_DF_MODEL_BC1A = 128;
+	const unsigned int KHR_DF_MODEL_BC3 = 130;
+	const unsigned int KHR_DF_MODEL_BC7 = 133;
+	const unsigned int KHR_DF_PRIMARIES_BT709 = 1;
+	const unsigned int KHR_DF_TRANSFER_LINEAR = 1;
+	const unsigned int KHR_DF_CHANNEL_COLOR = 0;
+	const unsigned int KHR_DF_CHANNEL_BC3_ALPHA = 15;
+
+	unsigned int ReadU32(const unsigned char* data)
+	{
+		return (unsigned int)data[0] | ((unsigned int)data[1] << 8) |
+			((unsigned int)data[2] << 16) | ((unsigned int)data[3] << 24);
+	}
+
+	unsigned long long ReadU64(const unsigned char* data)
+	{
+		return (unsigned long long)ReadU32(data) | ((unsigned long long)ReadU32(data + 4) << 32);
+	}
+
+	void WriteU32(std::vector<unsigned char>& out, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			out.push_back((unsigned char)((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	void WriteU64(std::vector<unsigned char>& out, unsigned long long value)
+	{
+		WriteU32(out, (unsigned int)(value & 0xFFFFFFFF));
+		WriteU32(out, (unsigned int)(value >> 32));
+	}
+
+	void PatchU64(std::vector<unsigned char>& out, size_t offset, unsigned long long value)
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			out[offset + i] = (unsigned char)((value >> (i * 8)) & 0xFF);
+		}
+	}
+
+	// size of a mip level, rounded up to whole blocks
+	size_t GetLevelSize(int width, int height, int blockSize)
+	{
+		return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+	}
+
+	/***********************************************************
+	 *  WriteDataFormatDescriptor()
+	 *
+	 *  This function is used to write the basic data format
+	 *  descriptor KTX2 requires.  BC1 and BC7 have one sample
+	 *  covering the block, BC3 has the alpha half and then the
+	 *  color half.
+	 ***********************************************************/
+	void WriteDataFormatDescriptor(std::vector<unsigned char>& out, KtxTexture::BLOCK_FORMAT format)
+	{
+		int blockSize = KtxTexture::GetBlockSize(format);
+		int sampleCount = (format == KtxTexture::FORMAT_BC3) ? 2 : 1;
+		unsigned int descriptorSize = 24 + 16 * sampleCount;
+		unsigned int colorModel = KHR_DF_MODEL_BC1A;
+		if (format == KtxTexture::FORMAT_BC3)
+		{
+			colorModel = KHR_DF_MODEL_BC3;
+		}
+		else if (format == KtxTexture::FORMAT_BC7)
+		{
+			colorModel = KHR_DF_MODEL_BC7;
+		}
+
+		WriteU32(out, 4 + descriptorSize);
+		// vendor 0 (Khronos), descriptor type 0 (basic)
+		WriteU32(out, 0);
+		// version 2, then the block size
+		WriteU32(out, 2 | (descriptorSize << 16));
+		WriteU32(out, colorModel | (KHR_DF_PRIMARIES_BT709 << 8) | (KHR_DF_TRANSFER_LINEAR << 16));
+		// texel block dimensions, stored minus one
+		WriteU32(out, 3 | (3 << 8));
+		WriteU32(out, (unsigned int)blockSize);
+		WriteU32(out, 0);
+
+		int bitOffset = 0;
+		for (int sample = 0; sample < sampleCount; sample++)
+		{
+			int bitLength = (blockSize * 8) / sampleCount;
+			unsigned int channel = ((format == KtxTexture::FORMAT_BC3) && (sample == 0)) ?
+				KHR_DF_CHANNEL_BC3_ALPHA : KHR_DF_CHANNEL_COLOR;
+			WriteU32(out, (unsigned int)bitOffset | ((unsigned int)(bitLength - 1) << 16) | (channel << 24));
+			// sample position, lower and upper
+			WriteU32(out, 0);
+			WriteU32(out, 0);
+			WriteU32(out, 0xFFFFFFFF);
+			bitOffset += bitLength;
+		}
+	}
+}
+
+/***********************************************************
+ *  KtxTexture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+KtxTexture::KtxTexture()
+{
+	m_format = FORMAT_NONE;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  LoadFromFile()
+ *
+ *  This method is used to read a container into memory and
+ *  parse it.  A missing file is not reported, since most
+ *  callers fall back to the source image.
+ ***********************************************************/
+bool KtxTexture::LoadFromFile(const char* filePath)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	m_fileData.resize((size_t)size);
+	if ((size <= 0) || !file.read((char*)m_fileData.data(), size))
+	{
+		std::cout << "ERROR: Could not read " << filePath << std::endl;
+		m_fileData.clear();
+		return false;
+	}
+
+	return LoadFromMemory(m_fileData.data(), m_fileData.size(), filePath);
+}
+
+/***********************************************************
+ *  LoadFromMemory()
+ *
+ *  This method is used to check the header of a container
+ *  and find its mip levels.  Each level has to be the exact
+ *  size its dimensions need and lie inside the data.
+ ***********************************************************/
+bool KtxTexture::LoadFromMemory(const unsigned char* data, size_t size, const char* name)
+{
+	m_format = FORMAT_NONE;
+	m_levels.clear();
+
+	if ((size < KTX2_HEADER_SIZE) || (memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0))
+	{
+		std::cout << "ERROR: " << name << " is not a KTX2 file" << std::endl;
+		return false;
+	}
+
+	unsigned int vkFormat = ReadU32(data + 12);
+	unsigned int width = ReadU32(data + 20);
+	unsigned int height = ReadU32(data + 24);
+	unsigned int depth = ReadU32(data + 28);
+	unsigned int layerCount = ReadU32(data + 32);
+	unsigned int faceCount = ReadU32(data + 36);
+	unsigned int levelCount = ReadU32(data + 40);
+	unsigned int supercompression = ReadU32(data + 44);
+
+	BLOCK_FORMAT format = FORMAT_NONE;
+	switch (vkFormat)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		format = FORMAT_BC1;
+		break;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+		format = FORMAT_BC3;
+		break;
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+		format = FORMAT_BC7;
+		break;
+	}
+
+	// levelCount 0 asks the loader to build the mips, which is what the cook avoids
+	if ((format == FORMAT_NONE) || (width == 0) || (height == 0) || (depth != 0) ||
+		(layerCount > 1) || (faceCount != 1) || (levelCount == 0) || (levelCount > 32) || (supercompression != 0) ||
+		(size < KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_ENTRY_SIZE))
+	{
+		std::cout << "ERROR: " << name << " is not a plain BC1, BC3 or BC7 2D texture" << std::endl;
+		return false;
+	}
+
+	int blockSize = GetBlockSize(format);
+	for (unsigned int level = 0; level < levelCount; level++)
+	{
+		const unsigned char* entry = data + KTX2_HEADER_SIZE + level * KTX2_LEVEL_ENTRY_SIZE;
+		unsigned long long offset = ReadU64(entry);
+		unsigned long long length = ReadU64(entry + 8);
+
+		MIP_LEVEL mipLevel;
+		mipLevel.width = ((width >> level) > 0) ? (int)(width >> level) : 1;
+		mipLevel.height = ((height >> level) > 0) ? (int)(height >> level) : 1;
+		mipLevel.size = GetLevelSize(mipLevel.width, mipLevel.height, blockSize);
+		if ((length != mipLevel.size) || (offset > size) || (length > size - offset))
+		{
+			std::cout << "ERROR: " << name << " has a bad mip level " << level << std::endl;
+			m_levels.clear();
+			return false;
+		}
+		mipLevel.data = data + offset;
+		m_levels.push_back(mipLevel);
+	}
+
+	m_format = format;
+	m_width = (int)width;
+	m_height = (int)height;
+	return true;
+}
+
+/***********************************************************
+ *  SaveToFile()
+ *
+ *  This method is used to write a mip chain as a KTX2 file.
+ *  The levels are stored smallest first, as the format
+ *  recommends, each aligned to its block size.  The file is
+ *  written to a temporary name and renamed, so a cook that
+ *  is stopped part way never leaves a broken texture.
+ ***********************************************************/
+bool KtxTexture::SaveToFile(
+	const char* filePath,
+	BLOCK_FORMAT format,
+	int width,
+	int height,
+	const std::vector<std::vector<unsigned char>>& levels)
+{
+	unsigned int vkFormat = VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	if (format == FORMAT_BC3)
+	{
+		vkFormat = VK_FORMAT_BC3_UNORM_BLOCK;
+	}
+	else if (format == FORMAT_BC7)
+	{
+		vkFormat = VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+
+	std::vector<unsigned char> out(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	WriteU32(out, vkFormat);
+	// type size is 1 for block compressed formats
+	WriteU32(out, 1);
+	WriteU32(out, (unsigned int)width);
+	WriteU32(out, (unsigned int)height);
+	// depth, layers, faces, levels, supercompression
+	WriteU32(out, 0);
+	WriteU32(out, 0);
+	WriteU32(out, 1);
+	WriteU32(out, (unsigned int)levels.size());
+	WriteU32(out, 0);
+
+	// the data format descriptor follows the level index
+	size_t descriptorOffset = KTX2_HEADER_SIZE + levels.size() * KTX2_LEVEL_ENTRY_SIZE;
+	std::vector<unsigned char> descriptor;
+	WriteDataFormatDescriptor(descriptor, format);
+	WriteU32(out, (unsigned int)descriptorOffset);
+	WriteU32(out, (unsigned int)descriptor.size());
+	// no key/value data and no supercompression data
+	WriteU32(out, 0);
+	WriteU32(out, 0);
+	WriteU64(out, 0);
+	WriteU64(out, 0);
+
+	// the level index is filled in once the data offsets are known
+	size_t levelIndexOffset = out.size();
+	out.resize(out.size() + levels.size() * KTX2_LEVEL_ENTRY_SIZE, 0);
+	out.insert(out.end(), descriptor.begin(), descriptor.end());
+
+	size_t alignment = (size_t)GetBlockSize(format);
+	for (int level = (int)levels.size() - 1; level >= 0; level--)
+	{
+		while ((out.size() % alignment) != 0)
+		{
+			out.push_back(0);
+		}
+		size_t entry = levelIndexOffset + level * KTX2_LEVEL_ENTRY_SIZE;
+		PatchU64(out, entry, out.size());
+		PatchU64(out, entry + 8, levels[level].size());
+		PatchU64(out, entry + 16, levels[level].size());
+		out.insert(out.end(), levels[level].begin(), levels[level].end());
+	}
+
+	std::string tempPath = std::string(filePath) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open() || !file.write((const char*)out.data(), (std::streamsize)out.size()))
+		{
+			std::cout << "ERROR: Could not write " << filePath << std::endl;
+			return false;
+		}
+	}
+	std::remove(filePath);
+	if (std::rename(tempPath.c_str(), filePath) != 0)
+	{
+		std::cout << "ERROR: Could not write " << filePath << std::endl;
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  GetCookedPath()
+ *
+ *  This method is used to find where the cooked version of
+ *  a source image lives: the same folder and name, with the
+ *  extension changed to .ktx2.
+ ***********************************************************/
+std::string KtxTexture::GetCookedPath(const char* imagePath)
+{
+	std::string path = imagePath;
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if ((dot != std::string::npos) && ((slash == std::string::npos) || (dot > slash)))
+	{
+		path.erase(dot);
+	}
+	return(path + ".ktx2");
+}
+
+/***********************************************************
+ *  GetBlockSize()
+ *
+ *  This method is used to get the bytes in one 4x4 block.
+ ***********************************************************/
+int KtxTexture::GetBlockSize(BLOCK_FORMAT format)
+{
+	return (format == FORMAT_BC1) ? 8 : 16;
+}
+
+/***********************************************************
+ *  GetFormatName()
+ *
+ *  This method is used to get a short name for logging.
+ ***********************************************************/
+const char* KtxTexture::GetFormatName(BLOCK_FORMAT format)
+{
+	switch (format)
+	{
+	case FORMAT_BC1:
+		return "BC1";
+	case FORMAT_BC3:
+		return "BC3";
+	case FORMAT_BC7:
+		return "BC7";
+	default:
+		return "none";
+	}
+}
+
+/***********************************************************
+ *  GetDataSize()
+ *
+ *  This method is used to add up the block data of every
+ *  mip level, which is what the texture takes in VRAM.
+ ***********************************************************/
+size_t KtxTexture::GetDataSize() const
+{
+	size_t total = 0;
+	for (const MIP_LEVEL& level : m_levels)
+	{
+		total += level.size;
+	}
+	return(total);
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// ktxtexture.h
+// ============
+// read and write block compressed textures in KTX2 containers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  KtxTexture
+ *
+ *  This class holds a BC1, BC3 or BC7 texture with its full
+ *  mip chain, as written by the TextureCook tool.  Only the
+ *  plain 2D subset of KTX2 is handled: one layer, one face
+ *  and no supercompression.  It has no OpenGL code, so the
+ *  cook tool can use it without a context.
+ ***********************************************************/
+class KtxTexture
+{
+public:
+	enum BLOCK_FORMAT
+	{
+		FORMAT_NONE,
+		FORMAT_BC1,
+		FORMAT_BC3,
+		FORMAT_BC7
+	};
+
+	// one mip level - the data points into the loaded file
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		const unsigned char* data;
+		size_t size;
+	};
+
+	// constructor
+	KtxTexture();
+
+	// read a container, false if it is missing or not a supported texture
+	bool LoadFromFile(const char* filePath);
+	// parse a container that is already in memory, which must outlive the levels
+	bool LoadFromMemory(const unsigned char* data, size_t size, const char* name);
+
+	// write a container from a mip chain, level 0 first
+	static bool SaveToFile(
+		const char* filePath,
+		BLOCK_FORMAT format,
+		int width,
+		int height,
+		const std::vector<std::vector<unsigned char>>& levels);
+
+	// the cooked file that goes with a source image ("floor.jpg" -> "floor.ktx2")
+	static std::string GetCookedPath(const char* imagePath);
+	// bytes in one 4x4 block
+	static int GetBlockSize(BLOCK_FORMAT format);
+	static const char* GetFormatName(BLOCK_FORMAT format);
+
+	BLOCK_FORMAT GetFormat() const { return m_format; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	int GetLevelCount() const { return (int)m_levels.size(); }
+	const MIP_LEVEL& GetLevel(int level) const { return m_levels[level]; }
+	// bytes of block data in every level
+	size_t GetDataSize() const;
+
+private:
+	// file contents when read with LoadFromFile()
+	std::vector<unsigned char> m_fileData;
+	BLOCK_FORMAT m_format;
+	int m_width;
+	int m_height;
+	std::vector<MIP_LEVEL> m_levels;
+};
@@ -1,5 +1,10 @@
 #include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
+#include <cstdlib>          // EXIT_FAILURE, atof, atoi
+#include <cstring>          // strcmp
+#include <chrono>           // headless run timing
+#include <algorithm>        // std::max
+#include <filesystem>       // finding the scene file
+#include <string>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -9,10 +14,22 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "SceneManager.h"
-#include "ViewManager.h"
+#include "SceneManager_revised.h"
+#include "ViewManager_revised.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "HeadlessContext.h"
+#include "OffscreenTarget.h"
+#include "CameraPath.h"
+#include "FrameBenchmark.h"
+#include "Profiler.h"
+#include "StatsOverlay.h"
+#include "ShaderUtils.h"
+#include "ShaderHotReload.h"
+#include "SceneHotReload.h"
+#include "AssetPack.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +46,101 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// render with the deferred shading path instead of forward shading
+	bool g_bUseDeferred = false;
+
+	// render offscreen at a scale driven by the GPU frame time
+	bool g_bUseDynamicResolution = false;
+	float g_TargetFrameMs = 16.6f;
+	float g_UpscaleSharpness = 0.2f;
+	DynamicResolution* g_DynamicResolution = nullptr;
+
+	// swap interval and frame rate cap for predictable CPU use
+	int g_SwapInterval = 1;
+	double g_FrameRateCap = 0.0;
+	FramePacer* g_FramePacer = nullptr;
+
+	// only draw a frame when input, a resize or an animation changed something
+	bool g_bOnDemand = false;
+	// the longest the loop sleeps before checking again when idle
+	const double IDLE_WAIT_SECONDS = 0.5;
+
+	// render a fixed number of frames offscreen with no window, then exit
+	bool g_bHeadless = false;
+	int g_HeadlessFrames = 120;
+	int g_HeadlessWidth = 1280;
+	int g_HeadlessHeight = 720;
+	const char* g_CameraPathFile = nullptr;
+	const char* g_CaptureFile = nullptr;
+	HeadlessContext* g_HeadlessContext = nullptr;
+
+	// time every headless frame and report the statistics as JSON
+	bool g_bBenchmark = false;
+	int g_WarmupFrames = 30;
+	const char* g_BenchmarkFile = nullptr;
+
+	// record CPU and GPU scopes and write them as a Chrome trace on exit
+	const char* g_ProfileFile = nullptr;
+	Profiler* g_Profiler = nullptr;
+
+	// draw the render statistics over the scene
+	bool g_bShowStats = false;
+	StatsOverlay* g_StatsOverlay = nullptr;
+
+	// the scene shader files, also watched for edits when requested
+	const char* const VERTEX_SHADER_PATH = "../../Utilities/shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_PATH = "../../Utilities/shaders/fragmentShader.glsl";
+	bool g_bWatchShaders = false;
+	// draw with compiled shader variants instead of the flag uniforms
+	bool g_bUseShaderVariants = true;
+	ShaderHotReload* g_ShaderHotReload = nullptr;
+
+	// the cooked assets in one mapped file, loose files are used without it
+	const char* g_AssetPackFile = "../../Utilities/assets.pack";
+	AssetPack* g_AssetPack = nullptr;
+
+	// leave the mip chains of the source images to glGenerateMipmap
+	bool g_bDriverMipmaps = false;
+
+	// stream the texture mips within this many MB, 0 loads them all up front
+	int g_TextureBudgetMB = 0;
+
+	// draw the large unique surfaces from their cooked page files
+	bool g_bVirtualTextures = true;
+
+	// store the mesh vertices in the 16 byte quantized format
+	bool g_bQuantizedVertices = false;
+	// tessellate the round shapes finely enough to stress vertex throughput
+	bool g_bDenseMeshes = false;
+	// reorder the generated meshes for the vertex cache and overdraw
+	bool g_bOptimizeMeshes = true;
+	// draw distant shapes with fewer triangles, keeping the error under this many pixels
+	bool g_bMeshLods = true;
+	float g_LodErrorPixels = 1.0f;
+	// draw only the meshlets of the large meshes that face the camera inside the view
+	bool g_bMeshletCulling = true;
+
+	// the scene layout, from the working folder or next to the executable -
+	// the scene written in SceneManager is drawn without it
+	const char* g_SceneFile = "desk.scene";
+	std::string g_SceneFilePath;
+	// apply the edits of the scene file to the running scene
+	bool g_bWatchScene = false;
+	SceneHotReload* g_SceneHotReload = nullptr;
+
+	// when the process started, for logging the startup time
+	std::chrono::steady_clock::time_point g_StartupTime;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ParseCommandLine(int argc, char* argv[]);
+std::string FindDataFile(const char* filePath, const char* executablePath);
+void LoadSceneShaders();
+bool RunHeadless();
 
 
 /***********************************************************
@@ -45,8 +151,34 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	g_StartupTime = std::chrono::steady_clock::now();
+
+	// read the options passed in on the command line
+	ParseCommandLine(argc, argv);
+
+	// a relative scene path also works from the folder of the executable
+	if (nullptr != g_SceneFile)
+	{
+		g_SceneFilePath = FindDataFile(g_SceneFile, argv[0]);
+		if (g_SceneFilePath.empty())
+		{
+			std::cout << "INFO: " << g_SceneFile << " is not in the working folder or next to the executable, "
+				<< "drawing the scene written in SceneManager" << std::endl;
+		}
+		g_SceneFile = g_SceneFilePath.empty() ? nullptr : g_SceneFilePath.c_str();
+	}
+
+	// headless runs make their own context instead of a window
+	if (g_bHeadless)
+	{
+		g_HeadlessContext = new HeadlessContext();
+		if (g_HeadlessContext->Create() == false)
+		{
+			return(EXIT_FAILURE);
+		}
+	}
 	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	else if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
@@ -58,7 +190,10 @@ int main(int argc, char* argv[])
 		g_ShaderManager);
 
 	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (g_bHeadless == false)
+	{
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	}
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -66,20 +201,170 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
+	// set the swap interval explicitly instead of relying on the driver default
+	if (g_bHeadless == false)
+	{
+		g_FramePacer = new FramePacer();
+		g_FramePacer->SetSwapInterval(g_SwapInterval);
+		g_FramePacer->SetFrameRateCap(g_FrameRateCap);
+	}
+
+	// the profiler needs a context, so it starts right after GLEW
+	if (nullptr != g_ProfileFile)
+	{
+		g_Profiler = new Profiler();
+		if (g_Profiler->Initialize() == false)
+		{
+			delete g_Profiler;
+			g_Profiler = nullptr;
+		}
+	}
+
 	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
+	LoadSceneShaders();
 	g_ShaderManager->use();
 
+	// rebuild the scene program whenever its files are saved
+	if (g_bWatchShaders && !g_bHeadless)
+	{
+		g_ShaderHotReload = new ShaderHotReload(g_ShaderManager);
+		g_ShaderHotReload->Watch(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+	}
+
+	// map the asset pack, if it has been built, before the scene loads from it
+	if (nullptr != g_AssetPackFile)
+	{
+		std::chrono::steady_clock::time_point packStart = std::chrono::steady_clock::now();
+		g_AssetPack = new AssetPack();
+		if (g_AssetPack->Open(g_AssetPackFile))
+		{
+			double residentFraction = g_AssetPack->GetResidentFraction();
+			std::cout << "INFO: Mapped asset pack " << g_AssetPackFile << " with " << g_AssetPack->GetAssetCount()
+				<< " assets in " << std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - packStart).count() << " ms";
+			if (residentFraction >= 0.0)
+			{
+				std::cout << ", " << (int)(residentFraction * 100.0) << "% already in memory ("
+					<< ((residentFraction > 0.9) ? "warm" : "cold") << " start)";
+			}
+			std::cout << std::endl;
+		}
+		else
+		{
+			delete g_AssetPack;
+			g_AssetPack = nullptr;
+		}
+	}
+
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetAssetPack(g_AssetPack);
+	g_SceneManager->SetCpuMipmaps(g_bDriverMipmaps == false);
+	if (g_TextureBudgetMB > 0)
+	{
+		g_SceneManager->EnableTextureStreaming((long long)g_TextureBudgetMB * 1024 * 1024);
+	}
+	g_SceneManager->SetVirtualTexturing(g_bVirtualTextures);
+	g_SceneManager->SetQuantizedVertices(g_bQuantizedVertices);
+	g_SceneManager->SetDenseMeshes(g_bDenseMeshes);
+	g_SceneManager->SetOptimizeMeshes(g_bOptimizeMeshes);
+	g_SceneManager->SetMeshLods(g_bMeshLods);
+	g_SceneManager->SetLodErrorPixels(g_LodErrorPixels);
+	g_SceneManager->SetMeshletCulling(g_bMeshletCulling);
+	g_SceneManager->SetSceneFile(g_SceneFile);
+	g_SceneManager->SetSceneReload(g_bWatchScene && (nullptr != g_SceneFile) && !g_bHeadless);
 	g_SceneManager->PrepareScene();
+	if (g_bUseShaderVariants)
+	{
+		g_SceneManager->EnableShaderVariants(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+	}
+
+	// update the running scene whenever its file is saved
+	if (g_bWatchScene && (nullptr != g_SceneFile) && !g_bHeadless)
+	{
+		g_SceneHotReload = new SceneHotReload(g_SceneManager);
+		g_SceneHotReload->Watch(g_SceneFile);
+	}
+
+	// Adding a switch between the forward and deferred render paths,
+	// so both can be compared on the same scene
+	if (g_bUseDeferred)
+	{
+		g_SceneManager->SetRenderPath(SceneManager::RENDER_PATH_DEFERRED);
+	}
+
+	// Adding dynamic resolution, so heavy scenes keep a steady frame rate
+	// (headless runs keep a fixed resolution so their results can be compared)
+	if (g_bUseDynamicResolution && g_bHeadless)
+	{
+		std::cout << "INFO: Dynamic resolution is ignored in headless mode" << std::endl;
+	}
+	else if (g_bUseDynamicResolution)
+	{
+		g_DynamicResolution = new DynamicResolution();
+		g_DynamicResolution->SetTargetFrameTime(g_TargetFrameMs);
+		g_DynamicResolution->SetSharpness(g_UpscaleSharpness);
+		if (g_DynamicResolution->Initialize() == false)
+		{
+			delete g_DynamicResolution;
+			g_DynamicResolution = nullptr;
+		}
+		g_ShaderManager->use();
+	}
+
+	// Adding a statistics overlay, so the cost of each frame can be seen
+	if (g_bShowStats)
+	{
+		g_StatsOverlay = new StatsOverlay();
+		if (g_StatsOverlay->Initialize() == false)
+		{
+			delete g_StatsOverlay;
+			g_StatsOverlay = nullptr;
+		}
+		g_ShaderManager->use();
+	}
+
+	// compare this between a cold and a warm shader cache
+	std::cout << "INFO: Startup took " << std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - g_StartupTime).count() << " ms" << std::endl;
+
+	// render the scripted frames and fall through to the cleanup
+	bool bSuccess = true;
+	if (g_bHeadless)
+	{
+		bSuccess = RunHeadless();
+	}
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
-	while (!glfwWindowShouldClose(g_Window))
+	while ((nullptr != g_Window) && !glfwWindowShouldClose(g_Window))
 	{
+		// swap in an edited shader once it has finished building
+		if ((nullptr != g_ShaderHotReload) && g_ShaderHotReload->Poll())
+		{
+			g_SceneManager->OnShaderReloaded();
+			ViewManager::RequestRedraw();
+		}
+		// and apply an edited scene file once it has been read
+		if ((nullptr != g_SceneHotReload) && g_SceneHotReload->Poll())
+		{
+			ViewManager::RequestRedraw();
+		}
+
+		// in on-demand mode sleep on the event queue until something
+		// marks the frame dirty, so an unchanged scene costs nothing
+		if (g_bOnDemand && (ViewManager::ConsumeRedraw() == false))
+		{
+			glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+			g_FramePacer->ResetTiming();
+			continue;
+		}
+
+		if (nullptr != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
@@ -88,20 +373,109 @@ int main(int argc, char* argv[])
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		{
+			GpuScope profileScope("PrepareSceneView");
+			g_ViewManager->PrepareSceneView();
+		}
+
+		// resize the offscreen targets only when the window really changed size
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		if (g_ViewManager->ConsumeFramebufferResize(framebufferWidth, framebufferHeight))
+		{
+			g_SceneManager->OnFramebufferResized(framebufferWidth, framebufferHeight);
+		}
+
+		// with dynamic resolution the scene goes to the scaled offscreen target
+		int renderWidth = framebufferWidth;
+		int renderHeight = framebufferHeight;
+		if (nullptr != g_DynamicResolution)
+		{
+			g_DynamicResolution->BeginFrame(framebufferWidth, framebufferHeight);
+			renderWidth = g_DynamicResolution->GetRenderWidth();
+			renderHeight = g_DynamicResolution->GetRenderHeight();
+			g_SceneManager->SetRenderTarget(g_DynamicResolution->GetFramebuffer());
+		}
+
+		g_SceneManager->SetViewParameters(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetCameraPosition(),
+			renderWidth,
+			renderHeight);
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
 
+		// upscale the offscreen target into the window
+		if (nullptr != g_DynamicResolution)
+		{
+			g_DynamicResolution->EndFrame();
+			g_ShaderManager->use();
+		}
+
+		// the overlay goes on last, at the full window resolution
+		if (nullptr != g_StatsOverlay)
+		{
+			g_StatsOverlay->Draw(g_SceneManager->GetRenderStats(),
+				g_FramePacer->GetMeanFrameTime() * 1000.0, framebufferWidth, framebufferHeight);
+			g_ShaderManager->use();
+		}
+
+		// hold the frame until it is due when the frame rate is capped
+		{
+			CpuScope profileScope("frame pacing");
+			g_FramePacer->WaitForNextFrame();
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		{
+			CpuScope profileScope("swap");
+			glfwSwapBuffers(g_Window);
+		}
+		g_FramePacer->OnFramePresented();
+		if (nullptr != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
 
 		// query the latest GLFW events
 		glfwPollEvents();
 	}
 
 	// clear the allocated manager objects from memory
+	if (nullptr != g_ShaderHotReload)
+	{
+		delete g_ShaderHotReload;
+		g_ShaderHotReload = nullptr;
+	}
+	if (nullptr != g_SceneHotReload)
+	{
+		delete g_SceneHotReload;
+		g_SceneHotReload = nullptr;
+	}
+	if (nullptr != g_Profiler)
+	{
+		g_Profiler->WriteChromeTrace(g_ProfileFile);
+		delete g_Profiler;
+		g_Profiler = nullptr;
+	}
+	if (nullptr != g_FramePacer)
+	{
+		g_FramePacer->PrintStats();
+		delete g_FramePacer;
+		g_FramePacer = nullptr;
+	}
+	if (nullptr != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = nullptr;
+	}
+	if (nullptr != g_StatsOverlay)
+	{
+		delete g_StatsOverlay;
+		g_StatsOverlay = nullptr;
+	}
 	if (nullptr != g_SceneManager)				// Changing this "NULL" to "nullptr", along with the entries below
 	{
 		delete g_SceneManager;
@@ -117,9 +491,161 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = nullptr;
 	}
+	if (nullptr != g_AssetPack)
+	{
+		delete g_AssetPack;
+		g_AssetPack = nullptr;
+	}
+	// the context goes last, after every GL object has been released
+	if (nullptr != g_HeadlessContext)
+	{
+		delete g_HeadlessContext;
+		g_HeadlessContext = nullptr;
+	}
 
 	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	exit(bSuccess ? EXIT_SUCCESS : EXIT_FAILURE); 
+}
+
+/***********************************************************
+ *	RunHeadless()
+ *
+ *  This function is used to render a fixed number of frames
+ *  into an offscreen target, moving the camera along the
+ *  scripted path.  The same options always give the same
+ *  frames, so runs can be compared between builds.
+ ***********************************************************/
+bool RunHeadless()
+{
+	OffscreenTarget target;
+	if (target.Create(g_HeadlessWidth, g_HeadlessHeight) == false)
+	{
+		return false;
+	}
+
+	CameraPath cameraPath;
+	if (nullptr != g_CameraPathFile)
+	{
+		if (cameraPath.LoadFromFile(g_CameraPathFile) == false)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		cameraPath.CreateDefaultPath();
+	}
+
+	g_ViewManager->PrepareHeadlessView(g_HeadlessWidth, g_HeadlessHeight);
+	g_SceneManager->SetRenderTarget(target.GetFramebuffer());
+
+	// benchmark runs first render some unmeasured frames at the start of
+	// the path, so shader compiles and first uploads are not counted
+	FrameBenchmark benchmark;
+	int warmupFrames = 0;
+	if (g_bBenchmark)
+	{
+		if (benchmark.Initialize() == false)
+		{
+			return false;
+		}
+		warmupFrames = g_WarmupFrames;
+	}
+
+	std::cout << "INFO: Rendering " << g_HeadlessFrames << " headless frames at "
+		<< g_HeadlessWidth << "x" << g_HeadlessHeight << std::endl;
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point frameStart = startTime;
+	double lastFrameMs = 0.0;
+	for (int frame = -warmupFrames; frame < g_HeadlessFrames; frame++)
+	{
+		// frames are spread evenly over the path, not over wall time
+		float t = (g_HeadlessFrames > 1) ? ((float)std::max(frame, 0) / (g_HeadlessFrames - 1)) : 0.0f;
+		glm::vec3 position;
+		glm::vec3 front;
+		cameraPath.Evaluate(t, position, front);
+		g_ViewManager->SetCameraPose(position, front);
+
+		bool bMeasured = g_bBenchmark && (frame >= 0);
+		if (bMeasured)
+		{
+			benchmark.BeginFrame();
+		}
+		if (nullptr != g_Profiler)
+		{
+			g_Profiler->BeginFrame();
+		}
+
+		target.Bind();
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		{
+			GpuScope profileScope("PrepareSceneView");
+			g_ViewManager->PrepareSceneView();
+		}
+
+		int width = 0;
+		int height = 0;
+		if (g_ViewManager->ConsumeFramebufferResize(width, height))
+		{
+			g_SceneManager->OnFramebufferResized(width, height);
+		}
+
+		g_SceneManager->SetViewParameters(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetCameraPosition(),
+			g_HeadlessWidth,
+			g_HeadlessHeight);
+		g_SceneManager->RenderScene();
+
+		if (nullptr != g_StatsOverlay)
+		{
+			g_StatsOverlay->Draw(g_SceneManager->GetRenderStats(), lastFrameMs, g_HeadlessWidth, g_HeadlessHeight);
+			g_ShaderManager->use();
+		}
+
+		// there is no swap to pace against, so finish each frame on the GPU
+		if (bMeasured)
+		{
+			benchmark.EndFrame(g_SceneManager->GetRenderStats());
+		}
+		else
+		{
+			glFinish();
+		}
+		if (nullptr != g_Profiler)
+		{
+			g_Profiler->EndFrame();
+		}
+
+		std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+		lastFrameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+		frameStart = frameEnd;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::cout << "INFO: Headless run took " << (seconds * 1000.0) << " ms, "
+		<< (seconds * 1000.0 / std::max(g_HeadlessFrames + warmupFrames, 1)) << " ms per frame" << std::endl;
+
+	bool bSuccess = true;
+	if (g_bBenchmark)
+	{
+		const char* renderPath = (g_SceneManager->GetRenderPath() == SceneManager::RENDER_PATH_DEFERRED) ?
+			"deferred" : "forward";
+		bSuccess = benchmark.WriteReport(g_BenchmarkFile, renderPath, warmupFrames,
+			g_HeadlessWidth, g_HeadlessHeight);
+	}
+	if (nullptr != g_CaptureFile)
+	{
+		bSuccess = target.SaveToPPM(g_CaptureFile) && bSuccess;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return(bSuccess);
 }
 
 /***********************************************************
@@ -144,6 +670,8 @@ bool InitializeGLFW()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #endif
+	// size the window by the monitor content scale on HiDPI displays
+	glfwWindowHint(GLFW_SCALE_TO_MONITOR, GLFW_TRUE);
 	// GLFW: end -------------------------------
 
 	return(true);
@@ -162,6 +690,13 @@ bool InitializeGLEW()
 
 	// try to initialize the GLEW library
 	GLEWInitResult = glewInit();
+	// GLEW built for GLX still loads the core entry points under EGL,
+	// it only fails to find the X display afterwards
+	if (g_bHeadless && (nullptr != g_HeadlessContext) && g_HeadlessContext->IsEGL() &&
+		(GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult))
+	{
+		GLEWInitResult = GLEW_OK;
+	}
 	if (GLEW_OK != GLEWInitResult)
 	{
 		std::cerr << glewGetErrorString(GLEWInitResult) << std::endl;
@@ -174,4 +709,276 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the options passed in on
+ *  the command line.
+ *
+ *    --deferred    use the deferred shading path
+ *    --forward     use the forward shading path (default)
+ *    --dynamic-res render at a scale driven by the GPU frame time
+ *    --target-ms N frame time the dynamic resolution aims at
+ *    --sharpen N   sharpening applied when upscaling (0 - 1)
+ *    --vsync N     swap interval: 0 off, 1 vsync, -1 adaptive
+ *    --fps-cap N   limit the frame rate, 0 for no limit
+ *    --on-demand   only draw when input or a resize changes the frame
+ *    --headless    render offscreen with no window, then exit
+ *    --frames N    number of frames a headless run renders
+ *    --width N     headless target width in pixels
+ *    --height N    headless target height in pixels
+ *    --camera-path FILE  keyframes for the headless camera
+ *    --capture FILE      save the last headless frame as a PPM
+ *    --bench       headless run that reports frame time statistics
+ *    --warmup N    unmeasured frames rendered before a benchmark
+ *    --bench-out FILE    write the benchmark JSON to a file, not stdout
+ *    --profile FILE      write CPU and GPU scopes as a Chrome trace
+ *    --stats       draw the render statistics overlay
+ *    --shader-cache DIR  folder for the program binary cache
+ *    --no-shader-cache   always compile the programs from source
+ *    --watch-shaders     reload the scene shaders when they are saved
+ *    --no-shader-variants  use the single scene program and its flag uniforms
+ *    --asset-pack FILE   mapped pack of cooked assets to load from
+ *    --no-asset-pack     load every asset from its own file
+ *    --driver-mips       build image mips with glGenerateMipmap, not the CPU
+ *    --texture-budget MB stream the texture mips within this much GPU memory
+ *    --no-virtual-textures  draw every surface with its tiled texture
+ *    --quantized-vertices   pack the mesh vertices into 16 bytes
+ *    --dense-meshes      build the round shapes with millions of triangles
+ *    --no-mesh-optimize  keep the triangle order the shape generators emit
+ *    --no-lod      always draw the finest level of detail
+ *    --lod-error N largest level of detail error on screen, in pixels
+ *    --no-meshlet-cull   draw the large meshes whole, without culling their meshlets
+ *    --scene FILE  text .scene file the layout is loaded from
+ *    --no-scene-file     draw the scene written in SceneManager
+ *    --watch-scene apply edits of the scene file while running
+ ***********************************************************/
+void ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--deferred") == 0)
+		{
+			g_bUseDeferred = true;
+		}
+		else if (strcmp(argv[i], "--forward") == 0)
+		{
+			g_bUseDeferred = false;
+		}
+		else if (strcmp(argv[i], "--dynamic-res") == 0)
+		{
+			g_bUseDynamicResolution = true;
+		}
+		else if ((strcmp(argv[i], "--target-ms") == 0) && (i + 1 < argc))
+		{
+			g_TargetFrameMs = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--sharpen") == 0) && (i + 1 < argc))
+		{
+			g_UpscaleSharpness = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--vsync") == 0) && (i + 1 < argc))
+		{
+			g_SwapInterval = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--fps-cap") == 0) && (i + 1 < argc))
+		{
+			g_FrameRateCap = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			g_bOnDemand = true;
+		}
+		else if (strcmp(argv[i], "--headless") == 0)
+		{
+			g_bHeadless = true;
+		}
+		else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc))
+		{
+			g_HeadlessFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--width") == 0) && (i + 1 < argc))
+		{
+			g_HeadlessWidth = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--height") == 0) && (i + 1 < argc))
+		{
+			g_HeadlessHeight = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--camera-path") == 0) && (i + 1 < argc))
+		{
+			g_CameraPathFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--capture") == 0) && (i + 1 < argc))
+		{
+			g_CaptureFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--bench") == 0)
+		{
+			// benchmarks always run headless so the numbers are repeatable
+			g_bBenchmark = true;
+			g_bHeadless = true;
+		}
+		else if ((strcmp(argv[i], "--warmup") == 0) && (i + 1 < argc))
+		{
+			g_WarmupFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--bench-out") == 0) && (i + 1 < argc))
+		{
+			g_BenchmarkFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--profile") == 0) && (i + 1 < argc))
+		{
+			g_ProfileFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--stats") == 0)
+		{
+			g_bShowStats = true;
+		}
+		else if ((strcmp(argv[i], "--shader-cache") == 0) && (i + 1 < argc))
+		{
+			ShaderUtils::SetProgramCacheDirectory(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-shader-cache") == 0)
+		{
+			ShaderUtils::SetProgramCacheDirectory(nullptr);
+		}
+		else if (strcmp(argv[i], "--watch-shaders") == 0)
+		{
+			g_bWatchShaders = true;
+		}
+		else if (strcmp(argv[i], "--no-shader-variants") == 0)
+		{
+			g_bUseShaderVariants = false;
+		}
+		else if ((strcmp(argv[i], "--asset-pack") == 0) && (i + 1 < argc))
+		{
+			g_AssetPackFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-asset-pack") == 0)
+		{
+			g_AssetPackFile = nullptr;
+		}
+		else if (strcmp(argv[i], "--driver-mips") == 0)
+		{
+			g_bDriverMipmaps = true;
+		}
+		else if ((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc))
+		{
+			g_TextureBudgetMB = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-virtual-textures") == 0)
+		{
+			g_bVirtualTextures = false;
+		}
+		else if (strcmp(argv[i], "--quantized-vertices") == 0)
+		{
+			g_bQuantizedVertices = true;
+		}
+		else if (strcmp(argv[i], "--dense-meshes") == 0)
+		{
+			g_bDenseMeshes = true;
+		}
+		else if (strcmp(argv[i], "--no-mesh-optimize") == 0)
+		{
+			g_bOptimizeMeshes = false;
+		}
+		else if (strcmp(argv[i], "--no-lod") == 0)
+		{
+			g_bMeshLods = false;
+		}
+		else if ((strcmp(argv[i], "--lod-error") == 0) && (i + 1 < argc))
+		{
+			g_LodErrorPixels = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--no-meshlet-cull") == 0)
+		{
+			g_bMeshletCulling = false;
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			g_SceneFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-scene-file") == 0)
+		{
+			g_SceneFile = nullptr;
+		}
+		else if (strcmp(argv[i], "--watch-scene") == 0)
+		{
+			g_bWatchScene = true;
+		}
+		else
+		{
+			std::cout << "Unknown option: " << argv[i] << std::endl;
+		}
+	}
+}
+
+/***********************************************************
+ *	FindDataFile()
+ *
+ *  This function is used to find a file that ships with the
+ *  program.  A relative path is tried from the working
+ *  folder first, then from the folder of the executable.
+ *  Returns an empty string when it is in neither.
+ ***********************************************************/
+std::string FindDataFile(const char* filePath, const char* executablePath)
+{
+	std::error_code error;
+	if (std::filesystem::exists(filePath, error))
+	{
+		return(filePath);
+	}
+	if (std::filesystem::path(filePath).is_absolute())
+	{
+		return(std::string());
+	}
+
+	// argv[0] is only a name when the program was found on the PATH
+	std::filesystem::path executable = executablePath;
+#ifdef __linux__
+	std::filesystem::path procExecutable = std::filesystem::read_symlink("/proc/self/exe", error);
+	if (!error)
+	{
+		executable = procExecutable;
+	}
+#endif
+	std::filesystem::path nextToExecutable = executable.parent_path() / filePath;
+	if (std::filesystem::exists(nextToExecutable, error))
+	{
+		return(nextToExecutable.string());
+	}
+	return(std::string());
+}
+
+/***********************************************************
+ *	LoadSceneShaders()
+ *
+ *  This function is used to build the scene program from
+ *  the external GLSL files through the program binary cache,
+ *  so a later launch with the same files skips compiling.
+ *  The ShaderManager compiles them itself if that fails.
+ ***********************************************************/
+void LoadSceneShaders()
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+	GLuint programID = 0;
+	if (ShaderUtils::ReadTextFile(VERTEX_SHADER_PATH, vertexSource) &&
+		ShaderUtils::ReadTextFile(FRAGMENT_SHADER_PATH, fragmentSource))
+	{
+		programID = ShaderUtils::CreateProgram(vertexSource.c_str(), fragmentSource.c_str(), "scene");
+	}
+
+	if (programID != 0)
+	{
+		g_ShaderManager->m_programID = programID;
+	}
+	else
+	{
+		std::cout << "INFO: Building the scene program with the ShaderManager instead" << std::endl;
+		g_ShaderManager->LoadShaders(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH);
+	}
+}
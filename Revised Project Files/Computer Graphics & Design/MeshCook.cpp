@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcook.cpp
+// ============
+// offline tool that converts OBJ models to the binary .mesh format
+//
+//  Build this file with CookedMesh.cpp, MeshOptimizer.cpp, MeshSimplifier.cpp
+//  and ObjImporter.cpp as its own executable, then run it on the model folder:
+//
+//    MeshCook [--no-lods] --dir ../../Utilities/models
+//    MeshCook [--no-lods] model.obj [model.obj ...]
+//
+//  The .mesh is written next to each model, where SceneManager and the
+//  AssetPacker look for it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <algorithm>        // std::max
+#include <chrono>           // cook timing
+#include <filesystem>       // --dir folder listing
+#include <string>
+#include <vector>
+
+#include "CookedMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjImporter.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// build the simplified levels of detail, or only write the full mesh
+	bool g_bLods = true;
+	// levels of detail in a chain, to match the scene's basic shapes
+	const int MAX_LOD_LEVELS = 6;
+	// furthest one simplification step may move the surface, as a
+	// fraction of the model's bounding radius
+	const float LOD_MAX_ERROR_FRACTION = 0.05f;
+}
+
+// Function declarations
+bool CookMesh(const std::string& modelPath);
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function is used to read the options and cook each
+ *  model that was named or found in the --dir folders.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> models;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--dir") == 0) && (i + 1 < argc))
+		{
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(argv[++i], error))
+			{
+				if (entry.path().extension().string() == ".obj")
+				{
+					models.push_back(entry.path().string());
+				}
+			}
+			if (error)
+			{
+				std::cout << "ERROR: Could not list " << argv[i] << std::endl;
+				return(EXIT_FAILURE);
+			}
+		}
+		else if (strcmp(argv[i], "--no-lods") == 0)
+		{
+			g_bLods = false;
+		}
+		else if (argv[i][0] == '-')
+		{
+			std::cout << "Unknown option: " << argv[i] << std::endl;
+		}
+		else
+		{
+			models.push_back(argv[i]);
+		}
+	}
+
+	if (models.empty())
+	{
+		std::cout << "Usage: MeshCook [--no-lods] [--dir FOLDER] [model.obj ...]" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	bool bSuccess = true;
+	for (const std::string& model : models)
+	{
+		bSuccess = CookMesh(model) && bSuccess;
+	}
+
+	return(bSuccess ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *  CookMesh()
+ *
+ *  This function is used to import one model, build its
+ *  levels of detail, reorder each level for the vertex cache
+ *  and write the .mesh next to the model.  All the work the
+ *  scene would otherwise do per vertex at startup is done
+ *  here, once.
+ ***********************************************************/
+bool CookMesh(const std::string& modelPath)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	MeshData mesh;
+	if (ObjImporter::Load(modelPath.c_str(), mesh) == false)
+	{
+		return false;
+	}
+
+	glm::vec3 boundsMin = mesh.vertices[0].position;
+	glm::vec3 boundsMax = mesh.vertices[0].position;
+	for (const MeshVertex& vertex : mesh.vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	float radius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+	std::vector<MeshData> levels;
+	std::vector<float> errors;
+	MeshSimplifier::BuildLevels(mesh, g_bLods ? MAX_LOD_LEVELS : 1, radius * LOD_MAX_ERROR_FRACTION, levels, errors);
+
+	float acmrBefore = MeshOptimizer::ComputeAcmr(levels[0], MeshOptimizer::CACHE_SIZE);
+	std::string triangleCounts;
+	for (MeshData& level : levels)
+	{
+		MeshOptimizer::Optimize(level);
+		triangleCounts += " " + std::to_string(level.GetTriangleCount());
+	}
+	float acmrAfter = MeshOptimizer::ComputeAcmr(levels[0], MeshOptimizer::CACHE_SIZE);
+
+	std::string cookedPath = CookedMesh::GetCookedPath(modelPath.c_str());
+	if (CookedMesh::SaveToFile(cookedPath.c_str(), levels, errors) == false)
+	{
+		return false;
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Cooked " << modelPath << " -> " << cookedPath << ", triangles:" << triangleCounts
+		<< ", ACMR " << acmrBefore << " -> " << acmrAfter << ", " << (int)milliseconds << " ms" << std::endl;
+	return true;
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshdata.h
+// ============
+// CPU side vertices and indices of a triangle mesh
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshVertex
+ *
+ *  One vertex in the layout the scene shaders read:
+ *  position at location 0, normal at 1 and UV at 2.
+ ***********************************************************/
+struct MeshVertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 uv;
+};
+
+/***********************************************************
+ *  MeshData
+ *
+ *  An indexed triangle list, built by the shape generators
+ *  and copied into the mesh pool.  It has no OpenGL objects,
+ *  so meshes can be built on any thread.
+ ***********************************************************/
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	// three per triangle, counter-clockwise from the front
+	std::vector<unsigned int> indices;
+
+	void Clear()
+	{
+		vertices.clear();
+		indices.clear();
+	}
+
+	// add a vertex and return its index
+	unsigned int AddVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv)
+	{
+		MeshVertex vertex;
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.uv = uv;
+		vertices.push_back(vertex);
+		return (unsigned int)(vertices.size() - 1);
+	}
+
+	void AddTriangle(unsigned int a, unsigned int b, unsigned int c)
+	{
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	}
+
+	int GetTriangleCount() const { return (int)(indices.size() / 3); }
+};
@@ -0,0 +1,390 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// reorder mesh triangles and vertices for the GPU vertex cache and overdraw
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// the cache the triangle scores are tuned for, as in Forsyth's article
+	const int SCORE_CACHE_SIZE = 32;
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	/***********************************************************
+	 *  GetVertexScore()
+	 *
+	 *  This function is used to score a vertex by where it is
+	 *  in the cache and how many triangles still use it.  The
+	 *  three vertices of the last triangle get a fixed score so
+	 *  the next triangle does not simply reuse all of them, and
+	 *  vertices with few triangles left are boosted so they get
+	 *  finished instead of leaving single triangles behind.
+	 ***********************************************************/
+	float GetVertexScore(int cachePosition, int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				float scale = 1.0f / (SCORE_CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+			}
+		}
+		score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	/***********************************************************
+	 *  CountCacheMisses()
+	 *
+	 *  This function is used to run one triangle through a FIFO
+	 *  cache model.  A vertex is still cached when fewer than
+	 *  cacheSize misses have happened since it was loaded, so
+	 *  the cache is just a time stamp per vertex.
+	 ***********************************************************/
+	int CountCacheMisses(const unsigned int* triangle, std::vector<unsigned int>& timestamps,
+		unsigned int& time, int cacheSize)
+	{
+		int misses = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			unsigned int vertex = triangle[i];
+			if (time - timestamps[vertex] > (unsigned int)cacheSize)
+			{
+				timestamps[vertex] = time;
+				time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+}
+
+/***********************************************************
+ *  Optimize()
+ *
+ *  This function is used to run every pass over a mesh.
+ ***********************************************************/
+void MeshOptimizer::Optimize(MeshData& mesh)
+{
+	OptimizeVertexCache(mesh);
+	OptimizeOverdraw(mesh, OVERDRAW_THRESHOLD);
+	OptimizeVertexFetch(mesh);
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This function is used to reorder the triangles so each
+ *  one reuses the vertices of those just before it.  It
+ *  keeps a model of the cache, and after every triangle it
+ *  picks the best scoring unused triangle that touches a
+ *  cached vertex.  When none is left it starts again from
+ *  the first unused triangle.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(MeshData& mesh)
+{
+	size_t triangleCount = mesh.indices.size() / 3;
+	size_t vertexCount = mesh.vertices.size();
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// the triangles that use each vertex - the first remainingTriangles
+	// entries of a vertex are the ones not yet emitted
+	std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+	for (unsigned int index : mesh.indices)
+	{
+		adjacencyStart[index + 1]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		adjacencyStart[i + 1] += adjacencyStart[i];
+	}
+	std::vector<unsigned int> adjacency(mesh.indices.size());
+	std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (size_t i = 0; i < mesh.indices.size(); i++)
+	{
+		adjacency[fill[mesh.indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<int> remainingTriangles(vertexCount);
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		remainingTriangles[i] = (int)(adjacencyStart[i + 1] - adjacencyStart[i]);
+		vertexScore[i] = GetVertexScore(-1, remainingTriangles[i]);
+	}
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> bEmitted(triangleCount, false);
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		const unsigned int* triangle = &mesh.indices[i * 3];
+		triangleScore[i] = vertexScore[triangle[0]] + vertexScore[triangle[1]] + vertexScore[triangle[2]];
+	}
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	std::vector<unsigned int> ordered;
+	ordered.reserve(mesh.indices.size());
+	int bestTriangle = -1;
+	size_t nextUnused = 0;
+	for (size_t emitted = 0; emitted < triangleCount; emitted++)
+	{
+		if (bestTriangle < 0)
+		{
+			while (bEmitted[nextUnused])
+			{
+				nextUnused++;
+			}
+			bestTriangle = (int)nextUnused;
+		}
+
+		const unsigned int* triangle = &mesh.indices[bestTriangle * 3];
+		ordered.insert(ordered.end(), triangle, triangle + 3);
+		bEmitted[bestTriangle] = true;
+
+		// the triangle goes to the front of the cache, the rest keep their order
+		newCache.assign(triangle, triangle + 3);
+		for (unsigned int vertex : cache)
+		{
+			if ((vertex != triangle[0]) && (vertex != triangle[1]) && (vertex != triangle[2]))
+			{
+				newCache.push_back(vertex);
+			}
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			unsigned int vertex = triangle[i];
+			unsigned int* first = &adjacency[adjacencyStart[vertex]];
+			unsigned int* last = first + remainingTriangles[vertex];
+			std::iter_swap(std::find(first, last, (unsigned int)bestTriangle), last - 1);
+			remainingTriangles[vertex]--;
+		}
+
+		// rescore everything that was in the cache, including what just fell out
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			unsigned int vertex = newCache[i];
+			cachePosition[vertex] = (i < (size_t)SCORE_CACHE_SIZE) ? (int)i : -1;
+			vertexScore[vertex] = GetVertexScore(cachePosition[vertex], remainingTriangles[vertex]);
+		}
+		for (unsigned int vertex : newCache)
+		{
+			for (int i = 0; i < remainingTriangles[vertex]; i++)
+			{
+				unsigned int adjacent = adjacency[adjacencyStart[vertex] + i];
+				const unsigned int* corners = &mesh.indices[adjacent * 3];
+				triangleScore[adjacent] = vertexScore[corners[0]] + vertexScore[corners[1]] + vertexScore[corners[2]];
+			}
+		}
+
+		newCache.resize(std::min(newCache.size(), (size_t)SCORE_CACHE_SIZE));
+		cache.swap(newCache);
+
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (unsigned int vertex : cache)
+		{
+			for (int i = 0; i < remainingTriangles[vertex]; i++)
+			{
+				unsigned int adjacent = adjacency[adjacencyStart[vertex] + i];
+				if (triangleScore[adjacent] > bestScore)
+				{
+					bestScore = triangleScore[adjacent];
+					bestTriangle = (int)adjacent;
+				}
+			}
+		}
+	}
+
+	mesh.indices.swap(ordered);
+}
+
+/***********************************************************
+ *  OptimizeOverdraw()
+ *
+ *  This function is used to reorder the triangles so the
+ *  surfaces that face away from the middle of the mesh are
+ *  drawn first.  Those are the ones most likely to be in
+ *  front, so the depth test can reject more of what follows.
+ *
+ *  The cache order is cut into clusters, each of which keeps
+ *  its own triangle order.  Cuts are made where the cache
+ *  starts empty anyway, and inside those runs wherever the
+ *  misses from an empty cache are still within the threshold
+ *  of the whole mesh, so moving the clusters around costs
+ *  little of what the cache pass gained.
+ ***********************************************************/
+void MeshOptimizer::OptimizeOverdraw(MeshData& mesh, float threshold)
+{
+	size_t triangleCount = mesh.indices.size() / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+	float targetAcmr = ComputeAcmr(mesh, CACHE_SIZE) * threshold;
+
+	// a triangle that misses all three vertices starts a new run
+	std::vector<size_t> runStarts;
+	std::vector<unsigned int> timestamps(mesh.vertices.size(), 0);
+	unsigned int time = CACHE_SIZE + 1;
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		if ((CountCacheMisses(&mesh.indices[i * 3], timestamps, time, CACHE_SIZE) == 3) || (i == 0))
+		{
+			runStarts.push_back(i);
+		}
+	}
+	runStarts.push_back(triangleCount);
+
+	std::vector<size_t> clusterStarts;
+	for (size_t run = 0; run + 1 < runStarts.size(); run++)
+	{
+		size_t runEnd = runStarts[run + 1];
+		size_t clusterStart = runStarts[run];
+		int misses = 0;
+		time += CACHE_SIZE + 1;
+		clusterStarts.push_back(clusterStart);
+		for (size_t i = clusterStart; i < runEnd; i++)
+		{
+			misses += CountCacheMisses(&mesh.indices[i * 3], timestamps, time, CACHE_SIZE);
+			if ((i + 1 < runEnd) && (misses <= targetAcmr * (i + 1 - clusterStart)))
+			{
+				clusterStart = i + 1;
+				misses = 0;
+				time += CACHE_SIZE + 1;
+				clusterStarts.push_back(clusterStart);
+			}
+		}
+	}
+	clusterStarts.push_back(triangleCount);
+
+	glm::vec3 meshCenter(0.0f);
+	for (const MeshVertex& vertex : mesh.vertices)
+	{
+		meshCenter += vertex.position;
+	}
+	meshCenter /= (float)std::max(mesh.vertices.size(), (size_t)1);
+
+	// how far each cluster faces out from the middle, using the area
+	// weighted normal and center of its triangles
+	size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<float> facing(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; cluster++)
+	{
+		glm::vec3 normal(0.0f);
+		glm::vec3 center(0.0f);
+		float area = 0.0f;
+		for (size_t i = clusterStarts[cluster]; i < clusterStarts[cluster + 1]; i++)
+		{
+			const glm::vec3& a = mesh.vertices[mesh.indices[i * 3]].position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[i * 3 + 1]].position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[i * 3 + 2]].position;
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triangleArea = glm::length(cross);
+			normal += cross;
+			center += (a + b + c) * (triangleArea / 3.0f);
+			area += triangleArea;
+		}
+		float normalLength = glm::length(normal);
+		if ((area > 0.0f) && (normalLength > 0.0f))
+		{
+			facing[cluster] = glm::dot(center / area - meshCenter, normal / normalLength);
+		}
+		else
+		{
+			facing[cluster] = 0.0f;
+		}
+	}
+
+	std::vector<size_t> order(clusterCount);
+	for (size_t i = 0; i < clusterCount; i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[&facing](size_t a, size_t b) { return facing[a] > facing[b]; });
+
+	std::vector<unsigned int> ordered;
+	ordered.reserve(mesh.indices.size());
+	for (size_t cluster : order)
+	{
+		ordered.insert(ordered.end(), mesh.indices.begin() + clusterStarts[cluster] * 3,
+			mesh.indices.begin() + clusterStarts[cluster + 1] * 3);
+	}
+	mesh.indices.swap(ordered);
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This function is used to renumber the vertices in the
+ *  order the triangles first use them.  Vertices that no
+ *  triangle uses are dropped.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexFetch(MeshData& mesh)
+{
+	const unsigned int UNUSED = ~0u;
+	std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+	std::vector<MeshVertex> ordered;
+	ordered.reserve(mesh.vertices.size());
+	for (unsigned int& index : mesh.indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = (unsigned int)ordered.size();
+			ordered.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices.swap(ordered);
+}
+
+/***********************************************************
+ *  ComputeAcmr()
+ *
+ *  This function is used to work out the average number of
+ *  vertices shaded per triangle, starting from an empty
+ *  FIFO cache of the passed in size.
+ ***********************************************************/
+float MeshOptimizer::ComputeAcmr(const MeshData& mesh, int cacheSize)
+{
+	size_t triangleCount = mesh.indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return 0.0f;
+	}
+
+	std::vector<unsigned int> timestamps(mesh.vertices.size(), 0);
+	unsigned int time = cacheSize + 1;
+	long long misses = 0;
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		misses += CountCacheMisses(&mesh.indices[i * 3], timestamps, time, cacheSize);
+	}
+	return (float)misses / triangleCount;
+}
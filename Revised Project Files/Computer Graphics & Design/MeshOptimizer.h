@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// reorder mesh triangles and vertices for the GPU vertex cache and overdraw
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+/***********************************************************
+ *  MeshOptimizer
+ *
+ *  These functions reorder a mesh without changing what it
+ *  looks like.  The generators emit triangles in loop order,
+ *  which reuses few of the vertices the GPU has just shaded.
+ *  Optimize() runs the three passes in the order they
+ *  depend on each other:
+ *
+ *    vertex cache   Tom Forsyth's linear-speed ordering, so
+ *                   each triangle reuses recent vertices
+ *    overdraw       splits that order into clusters and
+ *                   draws the outward facing ones first, as
+ *                   long as the cache misses stay within the
+ *                   threshold
+ *    vertex fetch   renumbers the vertices in the order the
+ *                   triangles first use them, so the fetches
+ *                   walk the vertex buffer forwards
+ *
+ *  The average cache miss ratio (ACMR) is the number of
+ *  vertices shaded per triangle, from a FIFO cache model.
+ *  0.5 is the best a regular grid can reach and 3 means no
+ *  vertex is ever reused.
+ ***********************************************************/
+namespace MeshOptimizer
+{
+	// the FIFO cache size used for the miss ratios
+	const int CACHE_SIZE = 16;
+	// how much worse than the cache order the overdraw order may be
+	const float OVERDRAW_THRESHOLD = 1.05f;
+
+	// run all three passes
+	void Optimize(MeshData& mesh);
+
+	void OptimizeVertexCache(MeshData& mesh);
+	void OptimizeOverdraw(MeshData& mesh, float threshold);
+	void OptimizeVertexFetch(MeshData& mesh);
+
+	// vertices shaded per triangle with a FIFO cache of the passed in size
+	float ComputeAcmr(const MeshData& mesh, int cacheSize);
+}
@@ -0,0 +1,377 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshpool.cpp
+// ============
+// one shared vertex and index buffer that every scene mesh is drawn from
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshPool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the 16 byte vertex - the position has a fourth short so the
+	// normal starts on a 4 byte boundary
+	struct QUANTIZED_VERTEX
+	{
+		unsigned short position[4];
+		unsigned int normal;
+		unsigned short uv[2];
+	};
+
+	/***********************************************************
+	 *  FloatToHalf()
+	 *
+	 *  This function is used to round a float to the nearest
+	 *  16 bit half float.  Values too large become infinity.
+	 ***********************************************************/
+	unsigned short FloatToHalf(float value)
+	{
+		unsigned int bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+		unsigned int sign = (bits >> 16) & 0x8000;
+		int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+		unsigned int mantissa = bits & 0x7FFFFF;
+
+		if (exponent <= 0)
+		{
+			// too small for a normal half, so store it denormalized
+			if (exponent < -10)
+			{
+				return (unsigned short)sign;
+			}
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			if ((mantissa >> (shift - 1)) & 1)
+			{
+				half++;
+			}
+			return (unsigned short)(sign | half);
+		}
+		if (exponent >= 31)
+		{
+			return (unsigned short)(sign | 0x7C00);
+		}
+
+		// a rounding carry out of the mantissa correctly bumps the exponent
+		unsigned int half = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+		if (mantissa & 0x1000)
+		{
+			half++;
+		}
+		return (unsigned short)half;
+	}
+
+	/***********************************************************
+	 *  PackNormal()
+	 *
+	 *  This function is used to pack a unit vector into the
+	 *  signed 10_10_10_2 layout of GL_INT_2_10_10_10_REV.
+	 ***********************************************************/
+	unsigned int PackNormal(const glm::vec3& normal)
+	{
+		unsigned int packed = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			int component = (int)std::lround(std::min(std::max(normal[i], -1.0f), 1.0f) * 511.0f);
+			packed |= ((unsigned int)component & 0x3FF) << (i * 10);
+		}
+		return packed;
+	}
+}
+
+/***********************************************************
+ *  MeshPool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshPool::MeshPool()
+{
+	m_format = VERTEX_FORMAT_FLOAT;
+	m_pendingVertexCount = 0;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+}
+
+/***********************************************************
+ *  ~MeshPool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshPool::~MeshPool()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_vertexBuffer);
+	glDeleteBuffers(1, &m_indexBuffer);
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used to choose the vertex layout.  All
+ *  meshes share one VAO, so it can only change while the
+ *  pool is empty.
+ ***********************************************************/
+bool MeshPool::SetVertexFormat(VERTEX_FORMAT format)
+{
+	if (!m_meshes.empty())
+	{
+		std::cout << "ERROR: The mesh pool vertex format can only change while it is empty" << std::endl;
+		return false;
+	}
+	m_format = format;
+	return true;
+}
+
+/***********************************************************
+ *  GetVertexStride()
+ *
+ *  This method is used to get the bytes of one vertex.
+ ***********************************************************/
+GLsizei MeshPool::GetVertexStride() const
+{
+	return (m_format == VERTEX_FORMAT_QUANTIZED) ? sizeof(QUANTIZED_VERTEX) : sizeof(MeshVertex);
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used to queue a mesh for the next upload.
+ *  Its indices stay relative to its own vertices, and the
+ *  draw adds the base vertex.
+ ***********************************************************/
+int MeshPool::AddMesh(const MeshData& mesh)
+{
+	return AddMesh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used to queue a mesh that is not in a
+ *  MeshData, such as one in a mapped asset pack.  Float
+ *  vertices are already in the buffer layout, so they are
+ *  copied in one block.
+ ***********************************************************/
+int MeshPool::AddMesh(const MeshVertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	MESH_RANGE range;
+	range.baseVertex = (GLint)(m_vertexCount + m_pendingVertexCount);
+	range.firstIndex = (GLuint)(m_indexCount + m_pendingIndices.size());
+	range.indexCount = (GLsizei)indexCount;
+	range.vertexCount = (GLuint)vertexCount;
+	range.decodeTransform = glm::mat4(1.0f);
+
+	if (m_format == VERTEX_FORMAT_QUANTIZED)
+	{
+		QuantizeVertices(vertices, vertexCount, range);
+	}
+	else
+	{
+		const unsigned char* bytes = (const unsigned char*)vertices;
+		m_pendingVertices.insert(m_pendingVertices.end(), bytes, bytes + vertexCount * sizeof(MeshVertex));
+	}
+	m_pendingVertexCount += range.vertexCount;
+	m_pendingIndices.insert(m_pendingIndices.end(), indices, indices + indexCount);
+	m_meshes.push_back(range);
+
+	return (int)m_meshes.size() - 1;
+}
+
+/***********************************************************
+ *  QuantizeVertices()
+ *
+ *  This method is used to pack the vertices of a mesh into
+ *  the 16 byte layout.  Positions are stored from 0 to 1
+ *  across the mesh bounds, and the decode transform scales
+ *  them back.  An axis with no extent, like the height of
+ *  the plane, keeps a scale of 1 so the transform can still
+ *  be inverted for the normal matrix.  Normals are scaled by
+ *  the same extents before packing: the normal matrix of the
+ *  decode transform divides by them again.
+ ***********************************************************/
+void MeshPool::QuantizeVertices(const MeshVertex* vertices, size_t vertexCount, MESH_RANGE& range)
+{
+	glm::vec3 minimum(0.0f);
+	glm::vec3 maximum(0.0f);
+	if (vertexCount > 0)
+	{
+		minimum = vertices[0].position;
+		maximum = vertices[0].position;
+	}
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		minimum = glm::min(minimum, vertices[i].position);
+		maximum = glm::max(maximum, vertices[i].position);
+	}
+	glm::vec3 extent = maximum - minimum;
+	for (int i = 0; i < 3; i++)
+	{
+		if (extent[i] <= 0.0f)
+		{
+			extent[i] = 1.0f;
+		}
+	}
+	range.decodeTransform = glm::scale(glm::translate(glm::mat4(1.0f), minimum), extent);
+
+	size_t first = m_pendingVertices.size();
+	m_pendingVertices.resize(first + vertexCount * sizeof(QUANTIZED_VERTEX));
+	QUANTIZED_VERTEX* packed = (QUANTIZED_VERTEX*)&m_pendingVertices[first];
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const MeshVertex& vertex = vertices[i];
+		glm::vec3 position = (vertex.position - minimum) / extent;
+		for (int c = 0; c < 3; c++)
+		{
+			packed[i].position[c] = (unsigned short)std::lround(std::min(std::max(position[c], 0.0f), 1.0f) * 65535.0f);
+		}
+		packed[i].position[3] = 0;
+		packed[i].normal = PackNormal(glm::normalize(vertex.normal * extent));
+		packed[i].uv[0] = FloatToHalf(vertex.uv.x);
+		packed[i].uv[1] = FloatToHalf(vertex.uv.y);
+	}
+}
+
+/***********************************************************
+ *  GrowBuffer()
+ *
+ *  This method is used to replace a buffer with a larger
+ *  one, copying the uploaded part across on the GPU.
+ ***********************************************************/
+void MeshPool::GrowBuffer(GLuint& buffer, GLsizeiptr usedBytes, GLsizeiptr newBytes)
+{
+	GLuint newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+	if ((buffer != 0) && (usedBytes > 0))
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+	buffer = newBuffer;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used to copy the queued meshes after the
+ *  ones already in the buffers.  A full buffer is doubled,
+ *  and the VAO is pointed at the new buffers.
+ ***********************************************************/
+bool MeshPool::Upload()
+{
+	if (m_pendingIndices.empty())
+	{
+		return true;
+	}
+
+	GLsizei stride = GetVertexStride();
+	GLuint vertexCount = m_vertexCount + m_pendingVertexCount;
+	GLuint indexCount = m_indexCount + (GLuint)m_pendingIndices.size();
+	bool bGrown = false;
+	if (vertexCount > m_vertexCapacity)
+	{
+		m_vertexCapacity = std::max(vertexCount, m_vertexCapacity * 2);
+		GrowBuffer(m_vertexBuffer, (GLsizeiptr)m_vertexCount * stride, (GLsizeiptr)m_vertexCapacity * stride);
+		bGrown = true;
+	}
+	if (indexCount > m_indexCapacity)
+	{
+		m_indexCapacity = std::max(indexCount, m_indexCapacity * 2);
+		GrowBuffer(m_indexBuffer, (GLsizeiptr)m_indexCount * sizeof(unsigned int),
+			(GLsizeiptr)m_indexCapacity * sizeof(unsigned int));
+		bGrown = true;
+	}
+
+	if (m_vao == 0)
+	{
+		glGenVertexArrays(1, &m_vao);
+	}
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	if (bGrown)
+	{
+		// the same layout the scene shaders read: position, normal, UV -
+		// the quantized attributes are unpacked to floats by the fetch
+		if (m_format == VERTEX_FORMAT_QUANTIZED)
+		{
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(QUANTIZED_VERTEX, position));
+			glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(QUANTIZED_VERTEX, normal));
+			glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(QUANTIZED_VERTEX, uv));
+		}
+		else
+		{
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshVertex, position));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshVertex, normal));
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshVertex, uv));
+		}
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	}
+
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)m_vertexCount * stride,
+		(GLsizeiptr)m_pendingVertices.size(), m_pendingVertices.data());
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)m_indexCount * sizeof(unsigned int),
+		(GLsizeiptr)m_pendingIndices.size() * sizeof(unsigned int), m_pendingIndices.data());
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_vertexCount = vertexCount;
+	m_indexCount = indexCount;
+	m_pendingVertices.clear();
+	m_pendingVertices.shrink_to_fit();
+	m_pendingVertexCount = 0;
+	m_pendingIndices.clear();
+	m_pendingIndices.shrink_to_fit();
+
+	std::cout << "INFO: Mesh pool holds " << m_meshes.size() << " meshes, "
+		<< ((m_format == VERTEX_FORMAT_QUANTIZED) ? "quantized" : "float") << " vertices "
+		<< GetVertexBytes() / 1024 << " KB, indices " << GetIndexBytes() / 1024 << " KB" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used to bind the shared VAO.  The other
+ *  passes bind their own VAO, so each pass that draws
+ *  meshes calls this before its first draw.
+ ***********************************************************/
+void MeshPool::Bind() const
+{
+	glBindVertexArray(m_vao);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw one mesh from its range in
+ *  the shared buffers.
+ ***********************************************************/
+void MeshPool::Draw(int handle) const
+{
+	const MESH_RANGE& range = m_meshes[handle];
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+		(void*)((size_t)range.firstIndex * sizeof(unsigned int)), range.baseVertex);
+}
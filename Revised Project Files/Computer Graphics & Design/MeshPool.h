@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshpool.h
+// ============
+// one shared vertex and index buffer that every scene mesh is drawn from
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshPool
+ *
+ *  This class sub-allocates every mesh from one vertex
+ *  buffer and one index buffer, described by a single VAO.
+ *  Meshes are added on the CPU, then Upload() copies the new
+ *  ones to the end of the buffers, growing them when they
+ *  are full.  A pass binds the VAO once and each draw only
+ *  passes its first index and base vertex, so moving from
+ *  one mesh to the next changes no vertex state.
+ *
+ *  The vertices are stored either as 32 byte floats or in a
+ *  16 byte quantized form: 16 bit positions across the
+ *  bounds of their mesh, 10_10_10_2 normals and half float
+ *  UVs.  The vertex fetch unpacks all three, so the shaders
+ *  are the same for both.  Each mesh has a decode transform
+ *  that maps its 0 to 1 positions back to the mesh bounds;
+ *  it goes in front of the model matrix, and the normals are
+ *  stored pre-scaled so the normal matrix of the combined
+ *  transform still gives the right direction.
+ ***********************************************************/
+class MeshPool
+{
+public:
+	// constructor
+	MeshPool();
+	// destructor
+	~MeshPool();
+
+	enum VERTEX_FORMAT
+	{
+		VERTEX_FORMAT_FLOAT,
+		VERTEX_FORMAT_QUANTIZED
+	};
+
+	// choose how vertices are stored, before the first mesh is added
+	bool SetVertexFormat(VERTEX_FORMAT format);
+	VERTEX_FORMAT GetVertexFormat() const { return m_format; }
+	GLsizei GetVertexStride() const;
+
+	// queue a mesh for the next Upload(), returns its handle
+	int AddMesh(const MeshData& mesh);
+	int AddMesh(const MeshVertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+	// copy the queued meshes into the shared buffers
+	bool Upload();
+
+	// bind the shared VAO, once per pass before drawing
+	void Bind() const;
+	// draw one mesh, with the pool bound
+	void Draw(int handle) const;
+
+	int GetMeshCount() const { return (int)m_meshes.size(); }
+	int GetTriangleCount(int handle) const { return m_meshes[handle].indexCount / 3; }
+	// where the mesh sits in the shared buffers, for drawing parts of it
+	GLuint GetFirstIndex(int handle) const { return m_meshes[handle].firstIndex; }
+	GLint GetBaseVertex(int handle) const { return m_meshes[handle].baseVertex; }
+	// put in front of the model matrix when drawing the mesh
+	const glm::mat4& GetDecodeTransform(int handle) const { return m_meshes[handle].decodeTransform; }
+	// bytes of vertex data one draw of the mesh reads
+	long long GetMeshVertexBytes(int handle) const { return (long long)m_meshes[handle].vertexCount * GetVertexStride(); }
+	// bytes used in the GPU buffers
+	long long GetVertexBytes() const { return (long long)m_vertexCount * GetVertexStride(); }
+	long long GetIndexBytes() const { return (long long)m_indexCount * sizeof(unsigned int); }
+
+private:
+	struct MESH_RANGE
+	{
+		// added to every index of the mesh
+		GLint baseVertex;
+		GLuint firstIndex;
+		GLsizei indexCount;
+		GLuint vertexCount;
+		// identity for float vertices
+		glm::mat4 decodeTransform;
+	};
+
+	VERTEX_FORMAT m_format;
+	std::vector<MESH_RANGE> m_meshes;
+	// meshes added since the last Upload(), already in the vertex format
+	std::vector<unsigned char> m_pendingVertices;
+	GLuint m_pendingVertexCount;
+	std::vector<unsigned int> m_pendingIndices;
+
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	// used and allocated sizes, in vertices and indices
+	GLuint m_vertexCount;
+	GLuint m_indexCount;
+	GLuint m_vertexCapacity;
+	GLuint m_indexCapacity;
+
+	// move a buffer to a larger one, keeping what was uploaded
+	static void GrowBuffer(GLuint& buffer, GLsizeiptr usedBytes, GLsizeiptr newBytes);
+	// pack the vertices of a mesh and work out its decode transform
+	void QuantizeVertices(const MeshVertex* vertices, size_t vertexCount, MESH_RANGE& range);
+};
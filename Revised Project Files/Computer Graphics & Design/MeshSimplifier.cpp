@@ -0,0 +1,350 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.cpp
+// ============
+// reduce the triangle count of a mesh for its lower levels of detail
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// the sum of squared distances to a set of planes, as the upper
+	// triangle of a symmetric 4 x 4 matrix
+	struct QUADRIC
+	{
+		double xx, xy, xz, xw;
+		double yy, yz, yw;
+		double zz, zw;
+		double ww;
+	};
+
+	// a collapse may not turn a remaining triangle by more than about 60 degrees
+	const float MAX_NORMAL_TURN_COS = 0.5f;
+	// a level of detail must lose at least a quarter of the triangles
+	const float MIN_LEVEL_REDUCTION = 0.75f;
+
+	// moving one vertex onto a neighbour, and what it costs
+	struct COLLAPSE
+	{
+		float cost;
+		unsigned int from;
+		unsigned int to;
+		// the versions of both vertices when the cost was worked out
+		unsigned int fromVersion;
+		unsigned int toVersion;
+	};
+
+	// orders the queue so the cheapest collapse is on top
+	struct CHEAPEST_FIRST
+	{
+		bool operator()(const COLLAPSE& a, const COLLAPSE& b) const { return a.cost > b.cost; }
+	};
+
+	/***********************************************************
+	 *  AddPlane()
+	 *
+	 *  This function is used to add the plane through a point
+	 *  with the passed in unit normal to a quadric.
+	 ***********************************************************/
+	void AddPlane(QUADRIC& quadric, const glm::vec3& normal, const glm::vec3& point)
+	{
+		double a = normal.x;
+		double b = normal.y;
+		double c = normal.z;
+		double d = -glm::dot(normal, point);
+		quadric.xx += a * a;
+		quadric.xy += a * b;
+		quadric.xz += a * c;
+		quadric.xw += a * d;
+		quadric.yy += b * b;
+		quadric.yz += b * c;
+		quadric.yw += b * d;
+		quadric.zz += c * c;
+		quadric.zw += c * d;
+		quadric.ww += d * d;
+	}
+
+	/***********************************************************
+	 *  AddQuadric()
+	 *
+	 *  This function is used to add one quadric to another.
+	 ***********************************************************/
+	void AddQuadric(QUADRIC& quadric, const QUADRIC& other)
+	{
+		quadric.xx += other.xx;
+		quadric.xy += other.xy;
+		quadric.xz += other.xz;
+		quadric.xw += other.xw;
+		quadric.yy += other.yy;
+		quadric.yz += other.yz;
+		quadric.yw += other.yw;
+		quadric.zz += other.zz;
+		quadric.zw += other.zw;
+		quadric.ww += other.ww;
+	}
+
+	/***********************************************************
+	 *  EvaluateQuadric()
+	 *
+	 *  This function is used to get the sum of the squared
+	 *  distances from a point to the planes of a quadric.
+	 ***********************************************************/
+	double EvaluateQuadric(const QUADRIC& quadric, const glm::vec3& point)
+	{
+		double x = point.x;
+		double y = point.y;
+		double z = point.z;
+		double error = x * x * quadric.xx + 2.0 * x * y * quadric.xy + 2.0 * x * z * quadric.xz + 2.0 * x * quadric.xw
+			+ y * y * quadric.yy + 2.0 * y * z * quadric.yz + 2.0 * y * quadric.yw
+			+ z * z * quadric.zz + 2.0 * z * quadric.zw
+			+ quadric.ww;
+		return std::max(error, 0.0);
+	}
+
+	/***********************************************************
+	 *  GetEdgeKey()
+	 *
+	 *  This function is used to get the same key for an edge
+	 *  whichever way round its vertices are passed in.
+	 ***********************************************************/
+	unsigned long long GetEdgeKey(unsigned int a, unsigned int b)
+	{
+		return ((unsigned long long)std::min(a, b) << 32) | std::max(a, b);
+	}
+}
+
+/***********************************************************
+ *  Simplify()
+ *
+ *  This function is used to collapse the cheapest edges of
+ *  a mesh until it is small enough, or the next collapse
+ *  would move the surface further than allowed.  Costs in the queue go
+ *  stale when a collapse changes one of their vertices, so
+ *  each vertex has a version and out of date entries are
+ *  skipped as they come off the queue.  The returned error
+ *  is the square root of the largest cost, which is never
+ *  less than the distance from a moved vertex to any of the
+ *  original planes around it.
+ ***********************************************************/
+float MeshSimplifier::Simplify(MeshData& mesh, int targetTriangles, float maxError)
+{
+	size_t vertexCount = mesh.vertices.size();
+	int triangleCount = mesh.GetTriangleCount();
+	if (triangleCount <= targetTriangles)
+	{
+		return 0.0f;
+	}
+
+	std::vector<QUADRIC> quadrics(vertexCount, QUADRIC());
+	std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+	std::unordered_map<unsigned long long, int> edgeUses;
+	for (int i = 0; i < triangleCount; i++)
+	{
+		const unsigned int* triangle = &mesh.indices[i * 3];
+		const glm::vec3& a = mesh.vertices[triangle[0]].position;
+		glm::vec3 cross = glm::cross(mesh.vertices[triangle[1]].position - a, mesh.vertices[triangle[2]].position - a);
+		float length = glm::length(cross);
+		for (int corner = 0; corner < 3; corner++)
+		{
+			if (length > 0.0f)
+			{
+				AddPlane(quadrics[triangle[corner]], cross / length, a);
+			}
+			vertexTriangles[triangle[corner]].push_back((unsigned int)i);
+			edgeUses[GetEdgeKey(triangle[corner], triangle[(corner + 1) % 3])]++;
+		}
+	}
+
+	// an edge used by one triangle is an open border or, where the
+	// vertices were split for a new normal or UV, a seam
+	std::vector<bool> bLocked(vertexCount, false);
+	for (const auto& edge : edgeUses)
+	{
+		if (edge.second != 2)
+		{
+			bLocked[(unsigned int)(edge.first >> 32)] = true;
+			bLocked[(unsigned int)(edge.first & 0xFFFFFFFF)] = true;
+		}
+	}
+
+	std::vector<unsigned int> versions(vertexCount, 0);
+	std::vector<bool> bRemoved(vertexCount, false);
+	std::vector<bool> bTriangleRemoved(triangleCount, false);
+	std::priority_queue<COLLAPSE, std::vector<COLLAPSE>, CHEAPEST_FIRST> queue;
+
+	auto pushCollapse = [&](unsigned int from, unsigned int to)
+	{
+		if (bLocked[from])
+		{
+			return;
+		}
+		QUADRIC combined = quadrics[from];
+		AddQuadric(combined, quadrics[to]);
+		COLLAPSE collapse;
+		collapse.cost = (float)EvaluateQuadric(combined, mesh.vertices[to].position);
+		collapse.from = from;
+		collapse.to = to;
+		collapse.fromVersion = versions[from];
+		collapse.toVersion = versions[to];
+		queue.push(collapse);
+	};
+
+	for (int i = 0; i < triangleCount; i++)
+	{
+		const unsigned int* triangle = &mesh.indices[i * 3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			pushCollapse(triangle[corner], triangle[(corner + 1) % 3]);
+			pushCollapse(triangle[(corner + 1) % 3], triangle[corner]);
+		}
+	}
+
+	float largestCost = 0.0f;
+	float maxCost = maxError * maxError;
+	std::vector<unsigned int> neighbours;
+	while ((triangleCount > targetTriangles) && (queue.empty() == false))
+	{
+		COLLAPSE collapse = queue.top();
+		queue.pop();
+		unsigned int from = collapse.from;
+		unsigned int to = collapse.to;
+		if (bRemoved[from] || bRemoved[to] ||
+			(collapse.fromVersion != versions[from]) || (collapse.toVersion != versions[to]))
+		{
+			continue;
+		}
+		if (collapse.cost > maxCost)
+		{
+			break;
+		}
+
+		// skip the collapse if any triangle that stays would turn over
+		bool bFlips = false;
+		const glm::vec3& target = mesh.vertices[to].position;
+		for (unsigned int triangle : vertexTriangles[from])
+		{
+			unsigned int* corners = &mesh.indices[triangle * 3];
+			if ((corners[0] == to) || (corners[1] == to) || (corners[2] == to))
+			{
+				continue;
+			}
+			glm::vec3 moved[3];
+			glm::vec3 original[3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				original[corner] = mesh.vertices[corners[corner]].position;
+				moved[corner] = (corners[corner] == from) ? target : original[corner];
+			}
+			glm::vec3 before = glm::cross(original[1] - original[0], original[2] - original[0]);
+			glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= MAX_NORMAL_TURN_COS * glm::length(before) * glm::length(after))
+			{
+				bFlips = true;
+				break;
+			}
+		}
+		if (bFlips)
+		{
+			continue;
+		}
+
+		// the triangles on the edge disappear, the rest move to the kept vertex
+		for (unsigned int triangle : vertexTriangles[from])
+		{
+			unsigned int* corners = &mesh.indices[triangle * 3];
+			if ((corners[0] == to) || (corners[1] == to) || (corners[2] == to))
+			{
+				bTriangleRemoved[triangle] = true;
+				triangleCount--;
+				for (int corner = 0; corner < 3; corner++)
+				{
+					if (corners[corner] != from)
+					{
+						std::vector<unsigned int>& list = vertexTriangles[corners[corner]];
+						list.erase(std::find(list.begin(), list.end(), triangle));
+					}
+				}
+			}
+			else
+			{
+				*std::find(corners, corners + 3, from) = to;
+				vertexTriangles[to].push_back(triangle);
+			}
+		}
+		vertexTriangles[from].clear();
+		bRemoved[from] = true;
+		AddQuadric(quadrics[to], quadrics[from]);
+		versions[to]++;
+		largestCost = std::max(largestCost, collapse.cost);
+
+		// every edge around the kept vertex has a new cost
+		neighbours.clear();
+		for (unsigned int triangle : vertexTriangles[to])
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int vertex = mesh.indices[triangle * 3 + corner];
+				if ((vertex != to) && (std::find(neighbours.begin(), neighbours.end(), vertex) == neighbours.end()))
+				{
+					neighbours.push_back(vertex);
+				}
+			}
+		}
+		for (unsigned int vertex : neighbours)
+		{
+			pushCollapse(vertex, to);
+			pushCollapse(to, vertex);
+		}
+	}
+
+	std::vector<unsigned int> indices;
+	indices.reserve(triangleCount * 3);
+	for (size_t i = 0; i < bTriangleRemoved.size(); i++)
+	{
+		if (bTriangleRemoved[i] == false)
+		{
+			indices.insert(indices.end(), mesh.indices.begin() + i * 3, mesh.indices.begin() + i * 3 + 3);
+		}
+	}
+	mesh.indices.swap(indices);
+
+	// drop the vertices that were collapsed away
+	MeshOptimizer::OptimizeVertexFetch(mesh);
+
+	return std::sqrt(largestCost);
+}
+
+/***********************************************************
+ *  BuildLevels()
+ *
+ *  This function is used to simplify a mesh over and over,
+ *  halving its triangles each time.  Each step may move the
+ *  surface by up to maxError, and the errors add up, so the
+ *  error of a level is measured against the original mesh.
+ ***********************************************************/
+void MeshSimplifier::BuildLevels(const MeshData& mesh, int maxLevels, float maxError,
+	std::vector<MeshData>& levels, std::vector<float>& errors)
+{
+	levels.assign(1, mesh);
+	errors.assign(1, 0.0f);
+	while ((int)levels.size() < maxLevels)
+	{
+		MeshData level = levels.back();
+		int triangles = level.GetTriangleCount();
+		float error = Simplify(level, triangles / 2, maxError);
+		if (level.GetTriangleCount() > triangles * MIN_LEVEL_REDUCTION)
+		{
+			break;
+		}
+		levels.push_back(level);
+		errors.push_back(errors.back() + error);
+	}
+}
@@ -0,0 +1,41 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.h
+// ============
+// reduce the triangle count of a mesh for its lower levels of detail
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <vector>
+
+/***********************************************************
+ *  MeshSimplifier
+ *
+ *  This reduces an arbitrary indexed mesh with quadric error
+ *  edge collapses (Garland and Heckbert).  Each vertex keeps
+ *  the sum of the planes of the triangles around it, and the
+ *  edge whose collapse moves the surface least from those
+ *  planes goes first.
+ *
+ *  A collapse moves one vertex onto the other instead of to
+ *  a new position, so every remaining vertex keeps its own
+ *  normal and UV.  Vertices on an open edge or a texture
+ *  seam never move, which keeps borders and seams closed,
+ *  and a collapse that would flip a triangle is skipped.
+ ***********************************************************/
+namespace MeshSimplifier
+{
+	// collapse edges until the mesh has at most the target number of
+	// triangles or no edge can go within the error, and return an upper
+	// bound on how far the surface moved, in the units of the mesh
+	float Simplify(MeshData& mesh, int targetTriangles, float maxError);
+
+	// the levels of detail of a mesh: the mesh itself, then each level
+	// with about half the triangles of the one before, and how far each
+	// is from the mesh - stops when a level would save too little
+	void BuildLevels(const MeshData& mesh, int maxLevels, float maxError,
+		std::vector<MeshData>& levels, std::vector<float>& errors);
+}
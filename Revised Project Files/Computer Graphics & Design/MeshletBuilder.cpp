@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletbuilder.cpp
+// ============
+// split meshes into small clusters of triangles that can be culled on their own
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// a cone wider than this (about 84 degrees either side) is never culled
+	const float MIN_CONE_DOT = 0.1f;
+	// positions closer than this fraction of the mesh size are welded,
+	// since a generator's first and last ring rarely match to the bit.
+	// The grid is then 100000 cells across, which packs in 21 bits a side.
+	const float WELD_TOLERANCE = 1.0e-5f;
+	const int WELD_CELL_BITS = 21;
+
+	/***********************************************************
+	 *  ComputeBounds()
+	 *
+	 *  This function is used to fit the bounding sphere and the
+	 *  normal cone of one meshlet.  The sphere is centred on the
+	 *  box around the vertices.  The cone axis is the average of
+	 *  the triangle normals, and its cutoff comes from the
+	 *  normal furthest from that axis.
+	 ***********************************************************/
+	void ComputeBounds(const MeshVertex* vertices, const unsigned int* indices, Meshlet& meshlet)
+	{
+		const unsigned int* first = indices + meshlet.firstIndex;
+		glm::vec3 boundsMin = vertices[first[0]].position;
+		glm::vec3 boundsMax = boundsMin;
+		for (unsigned int i = 0; i < meshlet.indexCount; i++)
+		{
+			boundsMin = glm::min(boundsMin, vertices[first[i]].position);
+			boundsMax = glm::max(boundsMax, vertices[first[i]].position);
+		}
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (unsigned int i = 0; i < meshlet.indexCount; i++)
+		{
+			meshlet.radius = std::max(meshlet.radius, glm::length(vertices[first[i]].position - meshlet.center));
+		}
+
+		std::vector<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+		for (unsigned int i = 0; i < meshlet.indexCount; i += 3)
+		{
+			const glm::vec3& a = vertices[first[i]].position;
+			glm::vec3 normal = glm::cross(vertices[first[i + 1]].position - a, vertices[first[i + 2]].position - a);
+			float length = glm::length(normal);
+			// slivers have no reliable direction and cannot be seen anyway
+			if (length > 0.0f)
+			{
+				normals.push_back(normal / length);
+				axis += normals.back();
+			}
+		}
+
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+		float axisLength = glm::length(axis);
+		if (normals.empty() || (axisLength == 0.0f))
+		{
+			return;
+		}
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+		{
+			minDot = std::min(minDot, glm::dot(axis, normal));
+		}
+		meshlet.coneAxis = axis;
+		if (minDot > MIN_CONE_DOT)
+		{
+			meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		}
+	}
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This function is used to cut the triangles of a mesh,
+ *  in their current order, into meshlets.  Each vertex
+ *  remembers the last meshlet that used it, so counting
+ *  the new vertices of a triangle takes three lookups.
+ ***********************************************************/
+void MeshletBuilder::Build(
+	const MeshVertex* vertices,
+	size_t vertexCount,
+	const unsigned int* indices,
+	size_t indexCount,
+	std::vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+	if (indexCount < 3)
+	{
+		return;
+	}
+
+	std::vector<int> lastMeshlet(vertexCount, -1);
+	Meshlet meshlet;
+	meshlet.firstIndex = 0;
+	meshlet.indexCount = 0;
+	meshlet.vertexCount = 0;
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		int current = (int)meshlets.size();
+		unsigned int newVertices = 0;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int index = indices[i + corner];
+			// a triangle can name the same vertex twice
+			bool bRepeated = ((corner > 0) && (indices[i] == index)) || ((corner > 1) && (indices[i + 1] == index));
+			if ((lastMeshlet[index] != current) && (bRepeated == false))
+			{
+				newVertices++;
+			}
+		}
+
+		if ((meshlet.vertexCount + newVertices > (unsigned int)MAX_VERTICES) ||
+			(meshlet.indexCount / 3 == (unsigned int)MAX_TRIANGLES))
+		{
+			ComputeBounds(vertices, indices, meshlet);
+			meshlets.push_back(meshlet);
+			current++;
+			meshlet.firstIndex = (unsigned int)i;
+			meshlet.indexCount = 0;
+			meshlet.vertexCount = 0;
+		}
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			unsigned int index = indices[i + corner];
+			if (lastMeshlet[index] != current)
+			{
+				lastMeshlet[index] = current;
+				meshlet.vertexCount++;
+			}
+		}
+		meshlet.indexCount += 3;
+	}
+
+	ComputeBounds(vertices, indices, meshlet);
+	meshlets.push_back(meshlet);
+}
+
+/***********************************************************
+ *  IsClosed()
+ *
+ *  This function is used to check whether a mesh has no
+ *  holes, so that its back faces are always hidden behind
+ *  its front faces when the camera is outside it.  Every
+ *  edge has to be used once each way round by the same
+ *  number of triangles.  Triangles that collapse once the
+ *  seams are welded are left out.
+ ***********************************************************/
+bool MeshletBuilder::IsClosed(
+	const MeshVertex* vertices,
+	size_t vertexCount,
+	const unsigned int* indices,
+	size_t indexCount)
+{
+	if (vertexCount == 0)
+	{
+		return false;
+	}
+	glm::vec3 boundsMin = vertices[0].position;
+	glm::vec3 boundsMax = boundsMin;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertices[i].position);
+		boundsMax = glm::max(boundsMax, vertices[i].position);
+	}
+	glm::vec3 extent = boundsMax - boundsMin;
+	float cellSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1.0e-6f)) * WELD_TOLERANCE;
+
+	std::unordered_map<unsigned long long, unsigned int> cellIds;
+	cellIds.reserve(vertexCount);
+	std::vector<unsigned int> welded(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 cell = (vertices[i].position - boundsMin) / cellSize;
+		unsigned long long key = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			key = (key << WELD_CELL_BITS) | (unsigned long long)std::lround(cell[axis]);
+		}
+		welded[i] = cellIds.insert(std::make_pair(key, (unsigned int)cellIds.size())).first->second;
+	}
+
+	// the count of each directed edge, less the count of its reverse
+	std::unordered_map<unsigned long long, int> edges;
+	edges.reserve(indexCount);
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		unsigned int corners[3] = { welded[indices[i]], welded[indices[i + 1]], welded[indices[i + 2]] };
+		if ((corners[0] == corners[1]) || (corners[1] == corners[2]) || (corners[2] == corners[0]))
+		{
+			continue;
+		}
+		for (int edge = 0; edge < 3; edge++)
+		{
+			unsigned int a = corners[edge];
+			unsigned int b = corners[(edge + 1) % 3];
+			if (a < b)
+			{
+				edges[((unsigned long long)a << 32) | b]++;
+			}
+			else
+			{
+				edges[((unsigned long long)b << 32) | a]--;
+			}
+		}
+	}
+
+	for (const auto& edge : edges)
+	{
+		if (edge.second != 0)
+		{
+			return false;
+		}
+	}
+	return !edges.empty();
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshletbuilder.h
+// ============
+// split meshes into small clusters of triangles that can be culled on their own
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  Meshlet
+ *
+ *  One cluster of a mesh: a run of its index buffer with at
+ *  most MAX_VERTICES distinct vertices and MAX_TRIANGLES
+ *  triangles, and the bounds it is culled with.
+ ***********************************************************/
+struct Meshlet
+{
+	// index range within the mesh's own indices
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	unsigned int vertexCount;
+	// bounding sphere, in mesh space
+	glm::vec3 center;
+	float radius;
+	// normal cone - every triangle faces away from a camera when
+	// dot(center - camera, coneAxis) >= coneCutoff * distance + radius.
+	// A cutoff of 1 means the triangles face too many ways to cull.
+	glm::vec3 coneAxis;
+	float coneCutoff;
+};
+
+/***********************************************************
+ *  MeshletBuilder
+ *
+ *  These functions cut a mesh into meshlets.  The triangles
+ *  are taken in the order they are already in, and a new
+ *  meshlet starts whenever the next triangle would go over
+ *  either limit.  Run after MeshOptimizer, that order keeps
+ *  neighbouring triangles together and the overdraw pass
+ *  has grouped them by the way they face, so the meshlets
+ *  come out compact with narrow normal cones.  Keeping the
+ *  order also means each meshlet is one contiguous index
+ *  range, so the mesh is drawn from the same index buffer
+ *  whole or a meshlet at a time.
+ *
+ *  It has no OpenGL code, so the cook tool can use it too.
+ ***********************************************************/
+namespace MeshletBuilder
+{
+	// the limits mesh shading hardware is built around
+	const int MAX_VERTICES = 64;
+	const int MAX_TRIANGLES = 124;
+
+	// cut the triangles of a mesh into meshlets
+	void Build(
+		const MeshVertex* vertices,
+		size_t vertexCount,
+		const unsigned int* indices,
+		size_t indexCount,
+		std::vector<Meshlet>& meshlets);
+
+	// true when every edge is shared by a front and a back triangle,
+	// matching vertices by position so UV and normal seams still join
+	bool IsClosed(
+		const MeshVertex* vertices,
+		size_t vertexCount,
+		const unsigned int* indices,
+		size_t indexCount);
+}
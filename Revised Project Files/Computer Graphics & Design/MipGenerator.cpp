@@ -0,0 +1,201 @@
+///////////////////////////////////////////////////////////////////////////////
+// mipgenerator.cpp
+// ============
+// gamma-correct mip chain builder that runs on the CPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#define MIP_USE_AVX2
+#define MIP_USE_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define MIP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// linear values are looked up at this many steps when encoding to sRGB,
+	// fine enough that every sRGB code near black is still reachable
+	const int SRGB_TABLE_SIZE = 16384;
+
+	/***********************************************************
+	 *  GAMMA_TABLES
+	 *
+	 *  The sRGB transfer curve both ways.  It is built the
+	 *  first time it is used, which is thread safe for a
+	 *  function local static.
+	 ***********************************************************/
+	struct GAMMA_TABLES
+	{
+		float toLinear[256];
+		unsigned char toSRGB[SRGB_TABLE_SIZE + 1];
+
+		GAMMA_TABLES()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				float value = i / 255.0f;
+				toLinear[i] = (value <= 0.04045f) ? (value / 12.92f) : std::pow((value + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i <= SRGB_TABLE_SIZE; i++)
+			{
+				float value = (float)i / SRGB_TABLE_SIZE;
+				float encoded = (value <= 0.0031308f) ? (value * 12.92f) : (1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f);
+				toSRGB[i] = (unsigned char)std::min(encoded * 255.0f + 0.5f, 255.0f);
+			}
+		}
+	};
+
+	const GAMMA_TABLES& GetGammaTables()
+	{
+		static const GAMMA_TABLES tables;
+		return tables;
+	}
+
+	/***********************************************************
+	 *  DownsampleRow()
+	 *
+	 *  This function is used to average 2x2 RGBA float texels
+	 *  from two source rows into one destination row.  Whole
+	 *  pairs go through the SIMD kernels - AVX2 makes two
+	 *  destination texels per step, SSE2 one - and a 1 texel
+	 *  wide source reuses its only column.
+	 ***********************************************************/
+	void DownsampleRow(const float* row0, const float* row1, int sourceWidth, int destinationWidth, float* out)
+	{
+		int x = 0;
+#ifdef MIP_USE_SSE2
+		// destination texels whose two source columns both exist
+		int pairs = std::min(sourceWidth / 2, destinationWidth);
+#endif
+
+#ifdef MIP_USE_AVX2
+		const __m256 quarter8 = _mm256_set1_ps(0.25f);
+		for (; x + 2 <= pairs; x += 2)
+		{
+			// each load is two texels, one per 128 bit lane
+			__m256 top01 = _mm256_loadu_ps(row0 + x * 8);
+			__m256 top23 = _mm256_loadu_ps(row0 + x * 8 + 8);
+			__m256 bottom01 = _mm256_loadu_ps(row1 + x * 8);
+			__m256 bottom23 = _mm256_loadu_ps(row1 + x * 8 + 8);
+			// regroup into even and odd source columns, so one add sums each pair
+			__m256 top = _mm256_add_ps(_mm256_permute2f128_ps(top01, top23, 0x20), _mm256_permute2f128_ps(top01, top23, 0x31));
+			__m256 bottom = _mm256_add_ps(_mm256_permute2f128_ps(bottom01, bottom23, 0x20), _mm256_permute2f128_ps(bottom01, bottom23, 0x31));
+			_mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(top, bottom), quarter8));
+		}
+#endif
+#ifdef MIP_USE_SSE2
+		const __m128 quarter4 = _mm_set1_ps(0.25f);
+		for (; x < pairs; x++)
+		{
+			__m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+			__m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+			_mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter4));
+		}
+#endif
+		for (; x < destinationWidth; x++)
+		{
+			int x0 = std::min(x * 2, sourceWidth - 1);
+			int x1 = std::min(x * 2 + 1, sourceWidth - 1);
+			for (int c = 0; c < 4; c++)
+			{
+				// summed in the same order as the kernels, so every build gives the same bytes
+				out[x * 4 + c] = ((row0[x0 * 4 + c] + row0[x1 * 4 + c]) + (row1[x0 * 4 + c] + row1[x1 * 4 + c])) * 0.25f;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildMipChain()
+ *
+ *  This function is used to decode the image to linear float
+ *  RGBA once, then halve it down to 1x1.  Each level is made
+ *  from the float level above it, not from its 8 bit copy,
+ *  so rounding does not build up down the chain.  A source
+ *  edge of odd length drops its last row or column, the same
+ *  as a 2x2 box filter on the GPU.
+ ***********************************************************/
+void MipGenerator::BuildMipChain(
+	const unsigned char* image,
+	int width,
+	int height,
+	int channels,
+	bool bSRGB,
+	std::vector<std::vector<unsigned char>>& levels)
+{
+	const GAMMA_TABLES& tables = GetGammaTables();
+
+	std::vector<float> current((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned char value = image[i * channels + c];
+			current[i * 4 + c] = bSRGB ? tables.toLinear[value] : (value / 255.0f);
+		}
+		current[i * 4 + 3] = (channels == 4) ? (image[i * channels + 3] / 255.0f) : 1.0f;
+	}
+
+	std::vector<float> next;
+	while ((width > 1) || (height > 1))
+	{
+		int nextWidth = std::max(width / 2, 1);
+		int nextHeight = std::max(height / 2, 1);
+		next.resize((size_t)nextWidth * nextHeight * 4);
+
+		for (int y = 0; y < nextHeight; y++)
+		{
+			const float* row0 = &current[(size_t)std::min(y * 2, height - 1) * width * 4];
+			const float* row1 = &current[(size_t)std::min(y * 2 + 1, height - 1) * width * 4];
+			DownsampleRow(row0, row1, width, nextWidth, &next[(size_t)y * nextWidth * 4]);
+		}
+
+		std::vector<unsigned char> level((size_t)nextWidth * nextHeight * channels);
+		for (size_t i = 0; i < (size_t)nextWidth * nextHeight; i++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				float value = std::min(std::max(next[i * 4 + c], 0.0f), 1.0f);
+				if (bSRGB && (c < 3))
+				{
+					level[i * channels + c] = tables.toSRGB[(int)(value * SRGB_TABLE_SIZE + 0.5f)];
+				}
+				else
+				{
+					level[i * channels + c] = (unsigned char)(value * 255.0f + 0.5f);
+				}
+			}
+		}
+		levels.push_back(level);
+
+		current.swap(next);
+		width = nextWidth;
+		height = nextHeight;
+	}
+}
+
+/***********************************************************
+ *  GetKernelName()
+ *
+ *  This function is used to name the filter kernel this
+ *  build was compiled with.
+ ***********************************************************/
+const char* MipGenerator::GetKernelName()
+{
+#if defined(MIP_USE_AVX2)
+	return "AVX2";
+#elif defined(MIP_USE_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+// mipgenerator.h
+// ============
+// gamma-correct mip chain builder that runs on the CPU
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+/***********************************************************
+ *  MipGenerator
+ *
+ *  These functions build a full mip chain with a 2x2 box
+ *  filter.  Color channels of sRGB images are averaged in
+ *  linear light and encoded back, so dark and bright texels
+ *  blend the way the eye sees them instead of darkening.
+ *  Alpha is always averaged as it is.  The filter works on
+ *  float RGBA rows with AVX2 or SSE2 when the compiler
+ *  targets them, and plain C++ otherwise.  Nothing here
+ *  touches OpenGL, so it is safe on worker threads.
+ ***********************************************************/
+namespace MipGenerator
+{
+	// append levels 1 and down (to 1x1) for an 8 bit image with 3 or 4 channels
+	void BuildMipChain(
+		const unsigned char* image,
+		int width,
+		int height,
+		int channels,
+		bool bSRGB,
+		std::vector<std::vector<unsigned char>>& levels);
+
+	// the kernel this build uses ("AVX2", "SSE2" or "scalar"), for logging
+	const char* GetKernelName();
+}
@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+// objimporter.cpp
+// ============
+// read Wavefront OBJ models for the mesh cook
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ObjImporter.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+
+// declaration of global variables
+namespace
+{
+	// one corner of a face - position, UV and normal index, -1 when missing
+	typedef std::tuple<int, int, int> CORNER;
+
+	/***********************************************************
+	 *  ReadFloats()
+	 *
+	 *  This function is used to read up to count numbers from
+	 *  the rest of a line, leaving missing ones at 0.
+	 ***********************************************************/
+	void ReadFloats(const char* text, float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			char* end = nullptr;
+			values[i] = strtof(text, &end);
+			if (end == text)
+			{
+				for (; i < count; i++)
+				{
+					values[i] = 0.0f;
+				}
+				return;
+			}
+			text = end;
+		}
+	}
+
+	/***********************************************************
+	 *  ResolveIndex()
+	 *
+	 *  This function is used to turn an OBJ index, which counts
+	 *  from 1 or back from the end when negative, into a 0
+	 *  based one.  Returns -1 when it is missing or out of range.
+	 ***********************************************************/
+	int ResolveIndex(const char* text, const char** end, int count)
+	{
+		char* parsed = nullptr;
+		long index = strtol(text, &parsed, 10);
+		*end = parsed;
+		if (parsed == text)
+		{
+			return -1;
+		}
+		index = (index < 0) ? count + index : index - 1;
+		return ((index >= 0) && (index < count)) ? (int)index : -1;
+	}
+
+	/***********************************************************
+	 *  ReadCorner()
+	 *
+	 *  This function is used to read one "v", "v/vt", "v//vn"
+	 *  or "v/vt/vn" corner, and returns where it ends.
+	 ***********************************************************/
+	const char* ReadCorner(const char* text, CORNER& corner, int positions, int uvs, int normals)
+	{
+		const char* end = text;
+		int position = ResolveIndex(text, &end, positions);
+		int uv = -1;
+		int normal = -1;
+		if (*end == '/')
+		{
+			text = end + 1;
+			if (*text != '/')
+			{
+				uv = ResolveIndex(text, &end, uvs);
+			}
+			else
+			{
+				end = text;
+			}
+			if (*end == '/')
+			{
+				normal = ResolveIndex(end + 1, &end, normals);
+			}
+		}
+		corner = CORNER(position, uv, normal);
+		return end;
+	}
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This function is used to read the vertex lists and faces
+ *  of an OBJ file and build the indexed mesh from them.
+ ***********************************************************/
+bool ObjImporter::Load(const char* filePath, MeshData& mesh)
+{
+	mesh.Clear();
+
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not open " << filePath << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::map<CORNER, unsigned int> cornerVertices;
+	// the position each vertex came from, for building missing normals
+	std::vector<int> vertexPositions;
+	bool bMissingNormals = false;
+
+	std::string line;
+	std::vector<unsigned int> polygon;
+	while (std::getline(file, line))
+	{
+		const char* text = line.c_str();
+		while ((*text == ' ') || (*text == '\t'))
+		{
+			text++;
+		}
+
+		float values[3];
+		if (strncmp(text, "v ", 2) == 0)
+		{
+			ReadFloats(text + 2, values, 3);
+			positions.push_back(glm::vec3(values[0], values[1], values[2]));
+		}
+		else if (strncmp(text, "vt ", 3) == 0)
+		{
+			ReadFloats(text + 3, values, 2);
+			uvs.push_back(glm::vec2(values[0], values[1]));
+		}
+		else if (strncmp(text, "vn ", 3) == 0)
+		{
+			ReadFloats(text + 3, values, 3);
+			normals.push_back(glm::vec3(values[0], values[1], values[2]));
+		}
+		else if (strncmp(text, "f ", 2) == 0)
+		{
+			polygon.clear();
+			text += 2;
+			while (*text != '\0')
+			{
+				while ((*text == ' ') || (*text == '\t') || (*text == '\r'))
+				{
+					text++;
+				}
+				if (*text == '\0')
+				{
+					break;
+				}
+
+				CORNER corner;
+				const char* end = ReadCorner(text, corner, (int)positions.size(), (int)uvs.size(), (int)normals.size());
+				if ((end == text) || (std::get<0>(corner) < 0))
+				{
+					std::cout << "ERROR: " << filePath << " has a face with a bad index: " << line << std::endl;
+					return false;
+				}
+				text = end;
+				// skip anything left of a corner this reader does not know
+				while ((*text != '\0') && (*text != ' ') && (*text != '\t'))
+				{
+					text++;
+				}
+
+				auto found = cornerVertices.find(corner);
+				if (found == cornerVertices.end())
+				{
+					int uv = std::get<1>(corner);
+					int normal = std::get<2>(corner);
+					bMissingNormals = bMissingNormals || (normal < 0);
+					unsigned int vertex = mesh.AddVertex(positions[std::get<0>(corner)],
+						(normal >= 0) ? normals[normal] : glm::vec3(0.0f),
+						(uv >= 0) ? uvs[uv] : glm::vec2(0.0f));
+					vertexPositions.push_back(std::get<0>(corner));
+					found = cornerVertices.insert(std::make_pair(corner, vertex)).first;
+				}
+				polygon.push_back(found->second);
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				mesh.AddTriangle(polygon[0], polygon[i - 1], polygon[i]);
+			}
+		}
+	}
+
+	if (mesh.indices.empty())
+	{
+		std::cout << "ERROR: " << filePath << " has no faces" << std::endl;
+		return false;
+	}
+
+	// smooth normals for the corners that had none, shared by position
+	// so a UV seam does not show up as a crease
+	if (bMissingNormals)
+	{
+		std::vector<glm::vec3> smoothNormals(positions.size(), glm::vec3(0.0f));
+		for (size_t i = 0; i < mesh.indices.size(); i += 3)
+		{
+			const glm::vec3& a = mesh.vertices[mesh.indices[i]].position;
+			const glm::vec3& b = mesh.vertices[mesh.indices[i + 1]].position;
+			const glm::vec3& c = mesh.vertices[mesh.indices[i + 2]].position;
+			glm::vec3 areaNormal = glm::cross(b - a, c - a);
+			for (int corner = 0; corner < 3; corner++)
+			{
+				smoothNormals[vertexPositions[mesh.indices[i + corner]]] += areaNormal;
+			}
+		}
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			glm::vec3& normal = mesh.vertices[i].normal;
+			if (normal == glm::vec3(0.0f))
+			{
+				glm::vec3 smooth = smoothNormals[vertexPositions[i]];
+				float length = glm::length(smooth);
+				normal = (length > 0.0f) ? smooth / length : glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////////////////////////////////
+// objimporter.h
+// ============
+// read Wavefront OBJ models for the mesh cook
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+/***********************************************************
+ *  ObjImporter
+ *
+ *  This reads the geometry of an OBJ file into one indexed
+ *  mesh: positions, texture coordinates and normals, with
+ *  polygons split into triangle fans.  Corners that share
+ *  all three indices become one vertex.  Faces without
+ *  normals get smooth area weighted ones.  Groups, objects
+ *  and materials are ignored, so the whole file is one mesh.
+ *  It parses text one line at a time, which is why it only
+ *  runs in the cook tool.
+ ***********************************************************/
+namespace ObjImporter
+{
+	// read a model, false if the file is missing or has no faces
+	bool Load(const char* filePath, MeshData& mesh);
+}
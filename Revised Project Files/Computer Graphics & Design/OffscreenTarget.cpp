@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreentarget.cpp
+// ============
+// fixed size framebuffer for headless rendering and image capture
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OffscreenTarget.h"
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+/***********************************************************
+ *  OffscreenTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OffscreenTarget::OffscreenTarget()
+{
+	m_framebuffer = 0;
+	m_colorBuffer = 0;
+	m_depthBuffer = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ~OffscreenTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OffscreenTarget::~OffscreenTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+	}
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used to allocate the color and depth
+ *  buffers at the requested size.
+ ***********************************************************/
+bool OffscreenTarget::Create(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+	{
+		std::cout << "ERROR: Invalid offscreen target size " << width << "x" << height << std::endl;
+		return false;
+	}
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glGenRenderbuffers(1, &m_depthBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	bool bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (bComplete == false)
+	{
+		std::cout << "ERROR: Offscreen framebuffer is incomplete" << std::endl;
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	return true;
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used to make the target the current draw
+ *  framebuffer.
+ ***********************************************************/
+void OffscreenTarget::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+}
+
+/***********************************************************
+ *  SaveToPPM()
+ *
+ *  This method is used to write the color buffer to a file.
+ *  PPM needs no image library, and the rows are flipped so
+ *  the file is top-down like the window.
+ ***********************************************************/
+bool OffscreenTarget::SaveToPPM(const char* filePath) const
+{
+	std::vector<unsigned char> pixels((size_t)m_width * m_height * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	FILE* file = fopen(filePath, "wb");
+	if (file == nullptr)
+	{
+		std::cout << "ERROR: Could not open " << filePath << " for writing" << std::endl;
+		return false;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", m_width, m_height);
+	size_t rowSize = (size_t)m_width * 3;
+	for (int row = m_height - 1; row >= 0; row--)
+	{
+		fwrite(&pixels[row * rowSize], 1, rowSize, file);
+	}
+	fclose(file);
+
+	std::cout << "INFO: Saved frame to " << filePath << std::endl;
+	return true;
+}
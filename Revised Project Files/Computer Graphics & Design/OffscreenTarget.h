@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreentarget.h
+// ============
+// fixed size framebuffer for headless rendering and image capture
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+/***********************************************************
+ *  OffscreenTarget
+ *
+ *  This class owns a color + depth framebuffer of a fixed
+ *  size.  Headless runs render every frame into it, and the
+ *  final image can be written out as a PPM file so it can be
+ *  compared against a reference image.
+ ***********************************************************/
+class OffscreenTarget
+{
+public:
+	// constructor
+	OffscreenTarget();
+	// destructor
+	~OffscreenTarget();
+
+	// allocate the color and depth buffers
+	bool Create(int width, int height);
+	// bind the framebuffer and set the viewport to cover it
+	void Bind() const;
+	// read the color buffer back and write it as a binary PPM
+	bool SaveToPPM(const char* filePath) const;
+
+	GLuint GetFramebuffer() const { return m_framebuffer; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+private:
+	GLuint m_framebuffer;
+	GLuint m_colorBuffer;
+	GLuint m_depthBuffer;
+	int m_width;
+	int m_height;
+};
@@ -0,0 +1,372 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.cpp
+// ============
+// named CPU and GPU timing scopes with a Chrome trace export
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Profiler.h"
+
+#include <cstdio>
+#include <iostream>
+
+Profiler* Profiler::s_pActive = nullptr;
+
+// declaration of global variables
+namespace
+{
+	// trace viewer thread ids, so CPU and GPU get their own rows
+	const int CPU_THREAD_ID = 1;
+	const int GPU_THREAD_ID = 2;
+}
+
+/***********************************************************
+ *  Profiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Profiler::Profiler()
+{
+	m_startTime = Clock::now();
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		m_slots[i].scopeCount = 0;
+		m_slots[i].bPending = false;
+		m_slots[i].cpuBase = 0.0;
+		m_slots[i].gpuBase = 0;
+		for (int j = 0; j < MAX_GPU_SCOPES * 2; j++)
+		{
+			m_slots[i].queries[j] = 0;
+		}
+	}
+	m_currentSlot = 0;
+	m_bInFrame = false;
+	m_droppedFrames = 0;
+}
+
+/***********************************************************
+ *  ~Profiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Profiler::~Profiler()
+{
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		if (m_slots[i].queries[0] != 0)
+		{
+			glDeleteQueries(MAX_GPU_SCOPES * 2, m_slots[i].queries);
+		}
+	}
+	if (s_pActive == this)
+	{
+		s_pActive = nullptr;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to create the timestamp queries and
+ *  register this profiler with the scopes.
+ ***********************************************************/
+bool Profiler::Initialize()
+{
+	for (int i = 0; i < FRAME_SLOTS; i++)
+	{
+		glGenQueries(MAX_GPU_SCOPES * 2, m_slots[i].queries);
+	}
+
+	GLint timestampBits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &timestampBits);
+	if (timestampBits == 0)
+	{
+		std::cout << "ERROR: GPU timestamps are not supported, profiling is off" << std::endl;
+		return false;
+	}
+
+	m_events.reserve(4096);
+	s_pActive = this;
+	return true;
+}
+
+/***********************************************************
+ *  GetCpuTime()
+ *
+ *  This method is used to get the time since the profiler
+ *  was created, in microseconds.
+ ***********************************************************/
+double Profiler::GetCpuTime() const
+{
+	return(std::chrono::duration<double, std::micro>(Clock::now() - m_startTime).count());
+}
+
+/***********************************************************
+ *  AddEvent()
+ *
+ *  This method is used to append a complete trace event.
+ ***********************************************************/
+void Profiler::AddEvent(const char* name, bool bGpu, double start, double duration)
+{
+	if ((int)m_events.size() >= MAX_TRACE_EVENTS)
+	{
+		return;
+	}
+
+	TRACE_EVENT traceEvent;
+	traceEvent.name = name;
+	traceEvent.bGpu = bGpu;
+	traceEvent.start = start;
+	traceEvent.duration = duration;
+	m_events.push_back(traceEvent);
+}
+
+/***********************************************************
+ *  ResolveSlot()
+ *
+ *  This method is used to read back a finished frame.  When
+ *  bWait is false and the last query is not ready yet, the
+ *  frame is dropped instead of stalling.
+ ***********************************************************/
+bool Profiler::ResolveSlot(FRAME_SLOT& slot, bool bWait)
+{
+	if (slot.bPending == false)
+	{
+		return true;
+	}
+	slot.bPending = false;
+
+	// every query was issued in order, so the last one finishes last
+	int lastQuery = -1;
+	for (int i = 0; i < slot.scopeCount; i++)
+	{
+		if (slot.scopes[i].bClosed)
+		{
+			lastQuery = (i * 2) + 1;
+		}
+	}
+	if (lastQuery < 0)
+	{
+		return true;
+	}
+
+	if (bWait == false)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(slot.queries[lastQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == 0)
+		{
+			m_droppedFrames++;
+			return false;
+		}
+	}
+
+	for (int i = 0; i < slot.scopeCount; i++)
+	{
+		if (slot.scopes[i].bClosed == false)
+		{
+			continue;
+		}
+
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(slot.queries[i * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(slot.queries[(i * 2) + 1], GL_QUERY_RESULT, &end);
+
+		// GPU nanoseconds onto the CPU microsecond timeline
+		double start = slot.cpuBase + ((double)((GLint64)begin - slot.gpuBase) / 1000.0);
+		AddEvent(slot.scopes[i].name, true, start, (double)(end - begin) / 1000.0);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start a new frame.  The query pool
+ *  about to be reused holds the frame from FRAME_SLOTS ago,
+ *  which is read back first.
+ ***********************************************************/
+void Profiler::BeginFrame()
+{
+	m_currentSlot = (m_currentSlot + 1) % FRAME_SLOTS;
+	FRAME_SLOT& slot = m_slots[m_currentSlot];
+	ResolveSlot(slot, false);
+
+	slot.scopeCount = 0;
+	slot.cpuBase = GetCpuTime();
+	glGetInteger64v(GL_TIMESTAMP, &slot.gpuBase);
+	m_bInFrame = true;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used to close the current frame so its
+ *  queries are read back later.
+ ***********************************************************/
+void Profiler::EndFrame()
+{
+	if (m_bInFrame == false)
+	{
+		return;
+	}
+
+	m_slots[m_currentSlot].bPending = true;
+	m_bInFrame = false;
+}
+
+/***********************************************************
+ *  BeginGpuScope()
+ *
+ *  This method is used to write the start timestamp of a GPU
+ *  scope.  Returns -1 when the scope is not recorded.
+ ***********************************************************/
+int Profiler::BeginGpuScope(const char* name)
+{
+	FRAME_SLOT& slot = m_slots[m_currentSlot];
+	if ((m_bInFrame == false) || (slot.scopeCount >= MAX_GPU_SCOPES))
+	{
+		return -1;
+	}
+
+	int scopeIndex = slot.scopeCount++;
+	slot.scopes[scopeIndex].name = name;
+	slot.scopes[scopeIndex].bClosed = false;
+	glQueryCounter(slot.queries[scopeIndex * 2], GL_TIMESTAMP);
+	return(scopeIndex);
+}
+
+/***********************************************************
+ *  EndGpuScope()
+ *
+ *  This method is used to write the end timestamp of a GPU
+ *  scope.
+ ***********************************************************/
+void Profiler::EndGpuScope(int scopeIndex)
+{
+	FRAME_SLOT& slot = m_slots[m_currentSlot];
+	if ((m_bInFrame == false) || (scopeIndex < 0) || (scopeIndex >= slot.scopeCount))
+	{
+		return;
+	}
+
+	glQueryCounter(slot.queries[(scopeIndex * 2) + 1], GL_TIMESTAMP);
+	slot.scopes[scopeIndex].bClosed = true;
+}
+
+/***********************************************************
+ *  AddCpuEvent()
+ *
+ *  This method is used to record a finished CPU scope.
+ ***********************************************************/
+void Profiler::AddCpuEvent(const char* name, double startMicroseconds, double endMicroseconds)
+{
+	AddEvent(name, false, startMicroseconds, endMicroseconds - startMicroseconds);
+}
+
+/***********************************************************
+ *  WriteChromeTrace()
+ *
+ *  This method is used to write every recorded event in the
+ *  Chrome trace-event format.  Frames still in flight are
+ *  waited on here, since the run is over.
+ ***********************************************************/
+bool Profiler::WriteChromeTrace(const char* filePath)
+{
+	EndFrame();
+	for (int i = 1; i <= FRAME_SLOTS; i++)
+	{
+		ResolveSlot(m_slots[(m_currentSlot + i) % FRAME_SLOTS], true);
+	}
+
+	FILE* file = fopen(filePath, "w");
+	if (file == nullptr)
+	{
+		std::cout << "ERROR: Could not open " << filePath << " for writing" << std::endl;
+		return false;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU\"}},\n", CPU_THREAD_ID);
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", GPU_THREAD_ID);
+	for (const TRACE_EVENT& traceEvent : m_events)
+	{
+		// scope names are string literals from the code, so need no escaping
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			traceEvent.name,
+			traceEvent.bGpu ? "gpu" : "cpu",
+			traceEvent.bGpu ? GPU_THREAD_ID : CPU_THREAD_ID,
+			traceEvent.start,
+			traceEvent.duration);
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	std::cout << "INFO: Wrote " << m_events.size() << " trace events to " << filePath;
+	if (m_droppedFrames > 0)
+	{
+		std::cout << " (" << m_droppedFrames << " GPU frames dropped)";
+	}
+	std::cout << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  CpuScope()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CpuScope::CpuScope(const char* name)
+{
+	m_name = name;
+	m_start = (nullptr != Profiler::GetActive()) ? Profiler::GetActive()->GetCpuTime() : 0.0;
+}
+
+/***********************************************************
+ *  ~CpuScope()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CpuScope::~CpuScope()
+{
+	Profiler* pProfiler = Profiler::GetActive();
+	if (nullptr != pProfiler)
+	{
+		pProfiler->AddCpuEvent(m_name, m_start, pProfiler->GetCpuTime());
+	}
+}
+
+/***********************************************************
+ *  GpuScope()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GpuScope::GpuScope(const char* name)
+{
+	m_name = name;
+	m_start = 0.0;
+	m_scopeIndex = -1;
+
+	Profiler* pProfiler = Profiler::GetActive();
+	if (nullptr != pProfiler)
+	{
+		m_start = pProfiler->GetCpuTime();
+		m_scopeIndex = pProfiler->BeginGpuScope(name);
+	}
+}
+
+/***********************************************************
+ *  ~GpuScope()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GpuScope::~GpuScope()
+{
+	Profiler* pProfiler = Profiler::GetActive();
+	if (nullptr != pProfiler)
+	{
+		pProfiler->EndGpuScope(m_scopeIndex);
+		pProfiler->AddCpuEvent(m_name, m_start, pProfiler->GetCpuTime());
+	}
+}
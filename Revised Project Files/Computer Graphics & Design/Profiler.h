@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+// profiler.h
+// ============
+// named CPU and GPU timing scopes with a Chrome trace export
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <chrono>
+#include <vector>
+
+/***********************************************************
+ *  Profiler
+ *
+ *  This class collects named timing scopes for every frame.
+ *  GPU scopes write a GL_TIMESTAMP query at their start and
+ *  end.  The queries come from one pool per frame in flight,
+ *  and a frame's results are only read when its slot comes
+ *  around again, so the CPU never waits on the GPU (a frame
+ *  that is still not finished by then is dropped).  GPU times
+ *  are mapped onto the CPU clock so both show up on the same
+ *  timeline in a trace viewer (chrome://tracing, Perfetto).
+ *
+ *  Scopes do nothing when no profiler is active.
+ ***********************************************************/
+class Profiler
+{
+public:
+	// constructor
+	Profiler();
+	// destructor
+	~Profiler();
+
+	// create the query pools and make this the active profiler
+	bool Initialize();
+
+	// the profiler the scopes report to, nullptr when profiling is off
+	static Profiler* GetActive() { return s_pActive; }
+
+	// bracket every frame - BeginFrame also reads back older frames
+	void BeginFrame();
+	void EndFrame();
+
+	// used by the scope objects below
+	int BeginGpuScope(const char* name);
+	void EndGpuScope(int scopeIndex);
+	void AddCpuEvent(const char* name, double startMicroseconds, double endMicroseconds);
+	double GetCpuTime() const;
+
+	// read back every pending frame and write the trace-event JSON
+	bool WriteChromeTrace(const char* filePath);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// frames in flight before a query pool is reused
+	static const int FRAME_SLOTS = 3;
+	// GPU scopes recorded per frame
+	static const int MAX_GPU_SCOPES = 32;
+	// stop recording after this many events so memory stays bounded
+	static const int MAX_TRACE_EVENTS = 250000;
+
+	struct GPU_SCOPE
+	{
+		const char* name;
+		bool bClosed;
+	};
+
+	struct FRAME_SLOT
+	{
+		// two timestamp queries per scope, begin and end
+		GLuint queries[MAX_GPU_SCOPES * 2];
+		GPU_SCOPE scopes[MAX_GPU_SCOPES];
+		int scopeCount;
+		bool bPending;
+		// the CPU and GPU clocks at the start of the frame
+		double cpuBase;
+		GLint64 gpuBase;
+	};
+
+	struct TRACE_EVENT
+	{
+		const char* name;
+		bool bGpu;
+		double start;
+		double duration;
+	};
+
+	static Profiler* s_pActive;
+
+	Clock::time_point m_startTime;
+	FRAME_SLOT m_slots[FRAME_SLOTS];
+	int m_currentSlot;
+	bool m_bInFrame;
+	int m_droppedFrames;
+	std::vector<TRACE_EVENT> m_events;
+
+	// turn a finished frame's queries into trace events
+	bool ResolveSlot(FRAME_SLOT& slot, bool bWait);
+	void AddEvent(const char* name, bool bGpu, double start, double duration);
+};
+
+/***********************************************************
+ *  CpuScope
+ *
+ *  This class times the CPU work from its creation to the
+ *  end of the enclosing block.
+ ***********************************************************/
+class CpuScope
+{
+public:
+	CpuScope(const char* name);
+	~CpuScope();
+
+private:
+	const char* m_name;
+	double m_start;
+};
+
+/***********************************************************
+ *  GpuScope
+ *
+ *  This class times the GPU work submitted from its creation
+ *  to the end of the enclosing block, along with the CPU time
+ *  spent submitting it.
+ ***********************************************************/
+class GpuScope
+{
+public:
+	GpuScope(const char* name);
+	~GpuScope();
+
+private:
+	const char* m_name;
+	double m_start;
+	int m_scopeIndex;
+};
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstats.h
+// ============
+// per-frame counters filled in by the render passes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  RenderStats
+ *
+ *  This struct counts the work one frame submits.  Each pass
+ *  adds to it as it goes, so it shows what RenderScene()
+ *  actually costs instead of guessing.  The triangle count
+ *  comes from a GL_PRIMITIVES_GENERATED query that is read a
+ *  few frames late so it never stalls.
+ ***********************************************************/
+struct RenderStats
+{
+	int drawCalls;
+	long long triangles;
+	int uniformUploads;
+	int textureBinds;
+	int programSwitches;
+	// texture or material changes between consecutive draws
+	int materialSwitches;
+	int culledObjects;
+	long long bufferBytesUploaded;
+	// vertex buffer bytes the draws read, counting each vertex once per draw
+	long long vertexBytes;
+	// streamed texture residency, all 0 when streaming is off
+	long long textureBytesResident;
+	long long textureBytesBudget;
+	int textureRequestsPending;
+	int textureLevelsStreamed;
+	int textureLevelsEvicted;
+	// virtual texture pages, all 0 when virtual texturing is off
+	int virtualPagesResident;
+	int virtualPagesPending;
+	int virtualPagesUploaded;
+
+	RenderStats() { Reset(); }
+
+	void Reset()
+	{
+		drawCalls = 0;
+		triangles = 0;
+		uniformUploads = 0;
+		textureBinds = 0;
+		programSwitches = 0;
+		materialSwitches = 0;
+		culledObjects = 0;
+		bufferBytesUploaded = 0;
+		vertexBytes = 0;
+		textureBytesResident = 0;
+		textureBytesBudget = 0;
+		textureRequestsPending = 0;
+		textureLevelsStreamed = 0;
+		textureLevelsEvicted = 0;
+		virtualPagesResident = 0;
+		virtualPagesPending = 0;
+		virtualPagesUploaded = 0;
+	}
+
+	// everything a sorted or batched draw list would try to avoid
+	int GetStateChanges() const { return textureBinds + programSwitches + materialSwitches; }
+};
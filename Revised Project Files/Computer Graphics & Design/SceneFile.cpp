@@ -0,0 +1,832 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// read scene descriptions from text .scene files and their compiled form
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "CookedMesh.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+const char* const SceneFile::BASIC_MESH_NAMES[SceneFile::BASIC_MESH_COUNT] = {
+	"plane", "box", "cylinder", "tapered_cylinder", "pyramid", "sphere", "half_sphere" };
+
+// declaration of global variables
+namespace
+{
+	// file layout, all little endian:
+	//
+	//   0   "SCNB", version, then the mesh, texture, virtual texture,
+	//       material, light and object counts
+	//   32  the meshes and textures, as tag and filename strings, the
+	//       virtual textures the same way, the materials as a tag and
+	//       11 floats and the lights as 15 floats
+	//
+	// then the object table on a 4 byte boundary, in the OBJECT_ENTRY
+	// layout.  A string is its length followed by its characters.
+	const unsigned char SCENE_IDENTIFIER[4] = { 'S', 'C', 'N', 'B' };
+	const unsigned int SCENE_VERSION = 1;
+	const size_t SCENE_HEADER_SIZE = 32;
+
+	static_assert(sizeof(SceneDescription::OBJECT_ENTRY) == 68, "the .sceneb object layout is 17 packed 4 byte fields");
+
+	// a tag table built while parsing, from tag to entry index
+	typedef std::unordered_map<std::string, int> TAG_INDEX;
+
+	// a keyword followed by a fixed number of floats
+	struct FLOAT_FIELD
+	{
+		const char* name;
+		float* values;
+		int count;
+	};
+
+	unsigned int ReadU32(const unsigned char* data)
+	{
+		return (unsigned int)data[0] | ((unsigned int)data[1] << 8) |
+			((unsigned int)data[2] << 16) | ((unsigned int)data[3] << 24);
+	}
+
+	void WriteU32(std::vector<unsigned char>& out, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			out.push_back((unsigned char)((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	void WriteFloats(std::vector<unsigned char>& out, const float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			unsigned int bits;
+			memcpy(&bits, &values[i], sizeof(bits));
+			WriteU32(out, bits);
+		}
+	}
+
+	void WriteString(std::vector<unsigned char>& out, const std::string& text)
+	{
+		WriteU32(out, (unsigned int)text.size());
+		out.insert(out.end(), text.begin(), text.end());
+	}
+
+	/***********************************************************
+	 *  COMPILED_READER
+	 *
+	 *  Reads the fields of a compiled scene in order, and
+	 *  remembers when a read would have gone past the end, so
+	 *  the tables are only checked once they have been read.
+	 ***********************************************************/
+	struct COMPILED_READER
+	{
+		const unsigned char* data;
+		size_t size;
+		size_t offset;
+		bool bOverrun;
+
+		const unsigned char* Take(size_t count)
+		{
+			if (bOverrun || (count > size - offset))
+			{
+				bOverrun = true;
+				return nullptr;
+			}
+			const unsigned char* taken = data + offset;
+			offset += count;
+			return taken;
+		}
+
+		void ReadFloats(float* values, int count)
+		{
+			const unsigned char* bytes = Take((size_t)count * 4);
+			for (int i = 0; (i < count) && (nullptr != bytes); i++)
+			{
+				unsigned int bits = ReadU32(bytes + i * 4);
+				memcpy(&values[i], &bits, sizeof(bits));
+			}
+		}
+
+		std::string ReadString()
+		{
+			const unsigned char* length = Take(4);
+			const unsigned char* text = (nullptr != length) ? Take(ReadU32(length)) : nullptr;
+			return (nullptr != text) ? std::string((const char*)text, ReadU32(length)) : std::string();
+		}
+	};
+
+	/***********************************************************
+	 *  SplitLine()
+	 *
+	 *  This function is used to split a line into the words
+	 *  separated by spaces or tabs, stopping at a comment.
+	 ***********************************************************/
+	void SplitLine(const std::string& line, std::vector<std::string>& words)
+	{
+		words.clear();
+		size_t start = 0;
+		while (start < line.size())
+		{
+			start = line.find_first_not_of(" \t\r", start);
+			if ((start == std::string::npos) || (line[start] == '#'))
+			{
+				return;
+			}
+			size_t end = line.find_first_of(" \t\r", start);
+			if (end == std::string::npos)
+			{
+				end = line.size();
+			}
+			words.push_back(line.substr(start, end - start));
+			start = end;
+		}
+	}
+
+	/***********************************************************
+	 *  ReadFloatField()
+	 *
+	 *  This function is used to read the values that follow a
+	 *  keyword, when the word at next is one of the passed in
+	 *  fields.  Returns false only when it is a field but its
+	 *  values are missing or not numbers.
+	 ***********************************************************/
+	bool ReadFloatField(
+		const std::vector<std::string>& words,
+		size_t& next,
+		const FLOAT_FIELD* fields,
+		int fieldCount,
+		bool& bFound)
+	{
+		bFound = false;
+		for (int field = 0; field < fieldCount; field++)
+		{
+			if (words[next] != fields[field].name)
+			{
+				continue;
+			}
+			bFound = true;
+			if (next + fields[field].count >= words.size())
+			{
+				return false;
+			}
+			for (int i = 0; i < fields[field].count; i++)
+			{
+				const char* text = words[next + 1 + i].c_str();
+				char* end = nullptr;
+				fields[field].values[i] = strtof(text, &end);
+				if ((end == text) || (*end != '\0'))
+				{
+					return false;
+				}
+			}
+			next += fields[field].count + 1;
+			return true;
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  FindTag()
+	 *
+	 *  This function is used to get the index of a declared
+	 *  texture or material, or -1 when it was not declared.
+	 ***********************************************************/
+	int FindTag(const std::string& tag, const TAG_INDEX& indices)
+	{
+		TAG_INDEX::const_iterator found = indices.find(tag);
+		return (found != indices.end()) ? found->second : -1;
+	}
+
+	/***********************************************************
+	 *  FindMesh()
+	 *
+	 *  This function is used to get the index of a mesh named
+	 *  by an object.  A basic shape is added to the table the
+	 *  first time it is named.  Returns -1 for an unknown mesh.
+	 ***********************************************************/
+	int FindMesh(const std::string& tag, SceneDescription& scene, TAG_INDEX& meshIndices)
+	{
+		int index = FindTag(tag, meshIndices);
+		if (index >= 0)
+		{
+			return index;
+		}
+		for (int i = 0; i < SceneFile::BASIC_MESH_COUNT; i++)
+		{
+			if (tag == SceneFile::BASIC_MESH_NAMES[i])
+			{
+				index = (int)scene.meshes.size();
+				scene.meshes.push_back({ tag, std::string(), 0 });
+				meshIndices[tag] = index;
+				return index;
+			}
+		}
+		return -1;
+	}
+
+	/***********************************************************
+	 *  AddTagged()
+	 *
+	 *  This function is used to add a mesh or texture line to
+	 *  its table.  Returns false when the tag is already used.
+	 ***********************************************************/
+	template <typename ENTRY>
+	bool AddTagged(const std::vector<std::string>& words, std::vector<ENTRY>& entries, TAG_INDEX& indices)
+	{
+		if ((words.size() != 3) || (indices.count(words[1]) != 0))
+		{
+			return false;
+		}
+		indices[words[1]] = (int)entries.size();
+		entries.push_back({ words[1], words[2], 0 });
+		return true;
+	}
+
+	/***********************************************************
+	 *  ParseMaterial()
+	 *
+	 *  This function is used to read a material line.  Values
+	 *  that are left out keep those of the "default" material
+	 *  of the scene written in code.
+	 ***********************************************************/
+	bool ParseMaterial(const std::vector<std::string>& words, SceneDescription& scene, TAG_INDEX& materialIndices)
+	{
+		if ((words.size() < 2) || (materialIndices.count(words[1]) != 0))
+		{
+			return false;
+		}
+
+		SceneDescription::MATERIAL_ENTRY material;
+		material.tag = words[1];
+		material.ambientColor = glm::vec3(1.0f);
+		material.ambientStrength = 0.0f;
+		material.diffuseColor = glm::vec3(1.0f);
+		material.specularColor = glm::vec3(0.1f);
+		material.shininess = 16.0f;
+		const FLOAT_FIELD fields[] = {
+			{ "ambient", &material.ambientColor.x, 3 },
+			{ "strength", &material.ambientStrength, 1 },
+			{ "diffuse", &material.diffuseColor.x, 3 },
+			{ "specular", &material.specularColor.x, 3 },
+			{ "shininess", &material.shininess, 1 } };
+
+		size_t next = 2;
+		while (next < words.size())
+		{
+			bool bFound = false;
+			if ((ReadFloatField(words, next, fields, 5, bFound) == false) || (bFound == false))
+			{
+				return false;
+			}
+		}
+
+		materialIndices[material.tag] = (int)scene.materials.size();
+		scene.materials.push_back(material);
+		return true;
+	}
+
+	/***********************************************************
+	 *  ParseLight()
+	 *
+	 *  This function is used to read a light line.  Colors
+	 *  that are left out are black.
+	 ***********************************************************/
+	bool ParseLight(const std::vector<std::string>& words, SceneDescription& scene)
+	{
+		SceneDescription::LIGHT_ENTRY light;
+		light.position = glm::vec3(0.0f);
+		light.ambientColor = glm::vec3(0.0f);
+		light.diffuseColor = glm::vec3(0.0f);
+		light.specularColor = glm::vec3(0.0f);
+		light.focalStrength = 1.0f;
+		light.specularIntensity = 0.0f;
+		light.radius = 0.0f;
+		const FLOAT_FIELD fields[] = {
+			{ "position", &light.position.x, 3 },
+			{ "ambient", &light.ambientColor.x, 3 },
+			{ "diffuse", &light.diffuseColor.x, 3 },
+			{ "specular", &light.specularColor.x, 3 },
+			{ "focal", &light.focalStrength, 1 },
+			{ "intensity", &light.specularIntensity, 1 },
+			{ "radius", &light.radius, 1 } };
+
+		size_t next = 1;
+		while (next < words.size())
+		{
+			bool bFound = false;
+			if ((ReadFloatField(words, next, fields, 7, bFound) == false) || (bFound == false))
+			{
+				return false;
+			}
+		}
+
+		scene.lights.push_back(light);
+		return true;
+	}
+
+	/***********************************************************
+	 *  ParseObject()
+	 *
+	 *  This function is used to read an object line, turning
+	 *  the tags it names into table indices.
+	 ***********************************************************/
+	bool ParseObject(
+		const std::vector<std::string>& words,
+		SceneDescription& scene,
+		TAG_INDEX& meshIndices,
+		const TAG_INDEX& textureIndices,
+		const TAG_INDEX& virtualIndices,
+		const TAG_INDEX& materialIndices)
+	{
+		if (words.size() < 2)
+		{
+			return false;
+		}
+
+		SceneDescription::OBJECT_ENTRY object;
+		object.mesh = FindMesh(words[1], scene, meshIndices);
+		object.texture = -1;
+		object.material = -1;
+		object.virtualTexture = -1;
+		object.fallbackFor = -1;
+		object.flags = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			object.scale[i] = 1.0f;
+			object.rotation[i] = 0.0f;
+			object.position[i] = 0.0f;
+		}
+		object.uvScale[0] = 1.0f;
+		object.uvScale[1] = 1.0f;
+		if (object.mesh < 0)
+		{
+			return false;
+		}
+
+		const FLOAT_FIELD fields[] = {
+			{ "scale", object.scale, 3 },
+			{ "rotate", object.rotation, 3 },
+			{ "position", object.position, 3 },
+			{ "uv", object.uvScale, 2 } };
+
+		size_t next = 2;
+		while (next < words.size())
+		{
+			bool bFound = false;
+			if (ReadFloatField(words, next, fields, 4, bFound) == false)
+			{
+				return false;
+			}
+			if (bFound)
+			{
+				continue;
+			}
+
+			const std::string& word = words[next];
+			if (word == "transparent")
+			{
+				object.flags |= SceneDescription::OBJECT_TRANSPARENT;
+			}
+			else if (word == "unlit")
+			{
+				object.flags |= SceneDescription::OBJECT_UNLIT;
+			}
+			else if (word == "alpha_tested")
+			{
+				object.flags |= SceneDescription::OBJECT_ALPHA_TESTED;
+			}
+			else
+			{
+				// the keywords that name an entry of another table
+				if (next + 1 >= words.size())
+				{
+					return false;
+				}
+				const std::string& tag = words[next + 1];
+				int index = -1;
+				if (word == "texture")
+				{
+					index = object.texture = FindTag(tag, textureIndices);
+				}
+				else if (word == "material")
+				{
+					index = object.material = FindTag(tag, materialIndices);
+				}
+				else if (word == "virtual")
+				{
+					index = object.virtualTexture = FindTag(tag, virtualIndices);
+				}
+				else if (word == "fallback")
+				{
+					index = object.fallbackFor = FindMesh(tag, scene, meshIndices);
+				}
+				if (index < 0)
+				{
+					return false;
+				}
+				next++;
+			}
+			next++;
+		}
+
+		scene.objects.push_back(object);
+		return true;
+	}
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to empty every table.
+ ***********************************************************/
+void SceneDescription::Clear()
+{
+	meshes.clear();
+	textures.clear();
+	virtualTextures.clear();
+	materials.clear();
+	lights.clear();
+	objects.clear();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This function is used to read a scene the quickest way
+ *  that is still current.  The compiled file is used when
+ *  it is at least as new as the text, or when there is no
+ *  text at all.  Otherwise the text is parsed and compiled
+ *  again, so only the first load after an edit parses it.
+ ***********************************************************/
+bool SceneFile::Load(const char* filePath, SceneDescription& scene)
+{
+	std::string compiledPath = GetCompiledPath(filePath);
+	std::error_code error;
+	std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(filePath, error);
+	bool bSource = !error;
+	std::filesystem::file_time_type compiledTime = std::filesystem::last_write_time(compiledPath, error);
+	if (!error && ((bSource == false) || (compiledTime >= sourceTime)) &&
+		LoadCompiled(compiledPath.c_str(), scene))
+	{
+		return true;
+	}
+
+	// callers fall back to their own scene, so a missing file is not an error
+	if ((bSource == false) || (LoadText(filePath, scene) == false))
+	{
+		return false;
+	}
+	// a folder that cannot be written to only costs the parse next time
+	SaveCompiled(compiledPath.c_str(), scene);
+	return true;
+}
+
+/***********************************************************
+ *  LoadText()
+ *
+ *  This function is used to parse the text form of a scene
+ *  one line at a time.  The first bad line stops the load,
+ *  so a typo is reported rather than drawn as a missing or
+ *  misplaced object.
+ ***********************************************************/
+bool SceneFile::LoadText(const char* filePath, SceneDescription& scene)
+{
+	scene.Clear();
+
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		std::cout << "ERROR: Could not open " << filePath << std::endl;
+		return false;
+	}
+
+	TAG_INDEX meshIndices;
+	TAG_INDEX textureIndices;
+	TAG_INDEX virtualIndices;
+	TAG_INDEX materialIndices;
+	std::string line;
+	std::vector<std::string> words;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		SplitLine(line, words);
+		if (words.empty())
+		{
+			continue;
+		}
+
+		bool bParsed = false;
+		if (words[0] == "object")
+		{
+			bParsed = ParseObject(words, scene, meshIndices, textureIndices, virtualIndices, materialIndices);
+		}
+		else if (words[0] == "material")
+		{
+			bParsed = ParseMaterial(words, scene, materialIndices);
+		}
+		else if (words[0] == "light")
+		{
+			bParsed = ParseLight(words, scene);
+		}
+		else if (words[0] == "texture")
+		{
+			bParsed = AddTagged(words, scene.textures, textureIndices);
+		}
+		else if (words[0] == "virtual_texture")
+		{
+			bParsed = AddTagged(words, scene.virtualTextures, virtualIndices);
+		}
+		else if (words[0] == "mesh")
+		{
+			bParsed = (FindMesh(words.size() > 1 ? words[1] : std::string(), scene, meshIndices) < 0) &&
+				AddTagged(words, scene.meshes, meshIndices);
+		}
+
+		if (bParsed == false)
+		{
+			std::cout << "ERROR: " << filePath << " line " << lineNumber << " is not a valid scene entry: " << line << std::endl;
+			scene.Clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  LoadCompiled()
+ *
+ *  This function is used to read a compiled scene.  The
+ *  object table is copied in one go, then every index in it
+ *  is checked against the other tables.
+ ***********************************************************/
+bool SceneFile::LoadCompiled(const char* filePath, SceneDescription& scene)
+{
+	scene.Clear();
+
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	std::vector<unsigned char> data((size_t)std::max<std::streamsize>(size, 0));
+	if ((size < (std::streamsize)SCENE_HEADER_SIZE) || !file.read((char*)data.data(), size) ||
+		(memcmp(data.data(), SCENE_IDENTIFIER, sizeof(SCENE_IDENTIFIER)) != 0) ||
+		(ReadU32(data.data() + 4) != SCENE_VERSION))
+	{
+		std::cout << "ERROR: " << filePath << " is not a compiled scene of this version" << std::endl;
+		return false;
+	}
+
+	COMPILED_READER reader = { data.data(), data.size(), SCENE_HEADER_SIZE, false };
+	unsigned int counts[6];
+	for (int i = 0; i < 6; i++)
+	{
+		counts[i] = ReadU32(data.data() + 8 + i * 4);
+	}
+	// every entry takes at least 4 bytes, which bounds the counts before anything is allocated
+	for (int i = 0; i < 6; i++)
+	{
+		if (counts[i] > data.size() / 4)
+		{
+			reader.bOverrun = true;
+		}
+	}
+
+	std::vector<SceneDescription::TEXTURE_ENTRY>* tagTables[] = { &scene.textures, &scene.virtualTextures };
+	for (unsigned int i = 0; (i < counts[0]) && !reader.bOverrun; i++)
+	{
+		std::string tag = reader.ReadString();
+		scene.meshes.push_back({ tag, reader.ReadString(), 0 });
+	}
+	for (int table = 0; table < 2; table++)
+	{
+		for (unsigned int i = 0; (i < counts[table + 1]) && !reader.bOverrun; i++)
+		{
+			std::string tag = reader.ReadString();
+			tagTables[table]->push_back({ tag, reader.ReadString(), 0 });
+		}
+	}
+	for (unsigned int i = 0; (i < counts[3]) && !reader.bOverrun; i++)
+	{
+		SceneDescription::MATERIAL_ENTRY material;
+		material.tag = reader.ReadString();
+		reader.ReadFloats(&material.ambientColor.x, 3);
+		reader.ReadFloats(&material.ambientStrength, 1);
+		reader.ReadFloats(&material.diffuseColor.x, 3);
+		reader.ReadFloats(&material.specularColor.x, 3);
+		reader.ReadFloats(&material.shininess, 1);
+		scene.materials.push_back(material);
+	}
+	for (unsigned int i = 0; (i < counts[4]) && !reader.bOverrun; i++)
+	{
+		SceneDescription::LIGHT_ENTRY light;
+		reader.ReadFloats(&light.position.x, 3);
+		reader.ReadFloats(&light.ambientColor.x, 3);
+		reader.ReadFloats(&light.diffuseColor.x, 3);
+		reader.ReadFloats(&light.specularColor.x, 3);
+		reader.ReadFloats(&light.focalStrength, 1);
+		reader.ReadFloats(&light.specularIntensity, 1);
+		reader.ReadFloats(&light.radius, 1);
+		scene.lights.push_back(light);
+	}
+
+	reader.Take((4 - (reader.offset % 4)) % 4);
+	const unsigned char* objects = reader.Take((size_t)counts[5] * sizeof(SceneDescription::OBJECT_ENTRY));
+	if (reader.bOverrun)
+	{
+		std::cout << "ERROR: " << filePath << " is cut short" << std::endl;
+		scene.Clear();
+		return false;
+	}
+	// the table was written from the same struct, so its bytes are the file layout
+	scene.objects.resize(counts[5]);
+	if (counts[5] > 0)
+	{
+		memcpy(scene.objects.data(), objects, (size_t)counts[5] * sizeof(SceneDescription::OBJECT_ENTRY));
+	}
+
+	// every index is into its table or -1 for none, and an object always has a mesh
+	auto isIndex = [](int index, size_t tableSize)
+	{
+		return (index >= -1) && (index < (int)tableSize);
+	};
+	for (const SceneDescription::OBJECT_ENTRY& object : scene.objects)
+	{
+		if ((object.mesh < 0) || !isIndex(object.mesh, scene.meshes.size()) ||
+			!isIndex(object.fallbackFor, scene.meshes.size()) ||
+			!isIndex(object.texture, scene.textures.size()) ||
+			!isIndex(object.material, scene.materials.size()) ||
+			!isIndex(object.virtualTexture, scene.virtualTextures.size()))
+		{
+			std::cout << "ERROR: " << filePath << " has an object that refers outside its tables" << std::endl;
+			scene.Clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  SaveCompiled()
+ *
+ *  This function is used to write the tables of a scene in
+ *  the compiled form.
+ ***********************************************************/
+bool SceneFile::SaveCompiled(const char* filePath, const SceneDescription& scene)
+{
+	std::vector<unsigned char> out(SCENE_IDENTIFIER, SCENE_IDENTIFIER + sizeof(SCENE_IDENTIFIER));
+	out.reserve(SCENE_HEADER_SIZE + scene.objects.size() * sizeof(SceneDescription::OBJECT_ENTRY) + 4096);
+	WriteU32(out, SCENE_VERSION);
+	WriteU32(out, (unsigned int)scene.meshes.size());
+	WriteU32(out, (unsigned int)scene.textures.size());
+	WriteU32(out, (unsigned int)scene.virtualTextures.size());
+	WriteU32(out, (unsigned int)scene.materials.size());
+	WriteU32(out, (unsigned int)scene.lights.size());
+	WriteU32(out, (unsigned int)scene.objects.size());
+
+	for (const SceneDescription::MESH_ENTRY& mesh : scene.meshes)
+	{
+		WriteString(out, mesh.tag);
+		WriteString(out, mesh.filename);
+	}
+	for (const SceneDescription::TEXTURE_ENTRY& texture : scene.textures)
+	{
+		WriteString(out, texture.tag);
+		WriteString(out, texture.filename);
+	}
+	for (const SceneDescription::TEXTURE_ENTRY& texture : scene.virtualTextures)
+	{
+		WriteString(out, texture.tag);
+		WriteString(out, texture.filename);
+	}
+	for (const SceneDescription::MATERIAL_ENTRY& material : scene.materials)
+	{
+		WriteString(out, material.tag);
+		WriteFloats(out, &material.ambientColor.x, 3);
+		WriteFloats(out, &material.ambientStrength, 1);
+		WriteFloats(out, &material.diffuseColor.x, 3);
+		WriteFloats(out, &material.specularColor.x, 3);
+		WriteFloats(out, &material.shininess, 1);
+	}
+	for (const SceneDescription::LIGHT_ENTRY& light : scene.lights)
+	{
+		WriteFloats(out, &light.position.x, 3);
+		WriteFloats(out, &light.ambientColor.x, 3);
+		WriteFloats(out, &light.diffuseColor.x, 3);
+		WriteFloats(out, &light.specularColor.x, 3);
+		WriteFloats(out, &light.focalStrength, 1);
+		WriteFloats(out, &light.specularIntensity, 1);
+		WriteFloats(out, &light.radius, 1);
+	}
+
+	while ((out.size() % 4) != 0)
+	{
+		out.push_back(0);
+	}
+	const unsigned char* objectBytes = (const unsigned char*)scene.objects.data();
+	out.insert(out.end(), objectBytes, objectBytes + scene.objects.size() * sizeof(SceneDescription::OBJECT_ENTRY));
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file.is_open() || !file.write((const char*)out.data(), (std::streamsize)out.size()))
+	{
+		std::cout << "ERROR: Could not write " << filePath << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  GetCompiledPath()
+ *
+ *  This function is used to swap the extension of a text
+ *  scene for .sceneb, keeping it in the same folder.
+ ***********************************************************/
+std::string SceneFile::GetCompiledPath(const char* sourcePath)
+{
+	std::string path = sourcePath;
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if ((dot != std::string::npos) && ((slash == std::string::npos) || (dot > slash)))
+	{
+		path.erase(dot);
+	}
+	return(path + ".sceneb");
+}
+
+/***********************************************************
+ *  HashFile()
+ *
+ *  This function is used to hash the contents of a file,
+ *  with the 64-bit FNV-1a used for the shader cache keys.
+ *  Returns 0 when the file cannot be read.
+ ***********************************************************/
+unsigned long long SceneFile::HashFile(const char* filePath)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		return 0;
+	}
+
+	unsigned long long hash = 1469598103934665603ULL;
+	std::vector<char> buffer(1 << 16);
+	while (file)
+	{
+		file.read(buffer.data(), (std::streamsize)buffer.size());
+		std::streamsize length = file.gcount();
+		for (std::streamsize i = 0; i < length; i++)
+		{
+			hash = (hash ^ (unsigned char)buffer[(size_t)i]) * 1099511628211ULL;
+		}
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  HashAssets()
+ *
+ *  This function is used to work out the content hash of
+ *  every model and image of a scene.  A model is hashed by
+ *  its cooked .mesh, which is what gets loaded.  A file that
+ *  cannot be read, such as one only in the asset pack, is
+ *  keyed by its path instead, so it still matches itself.
+ *  The page files of the virtual textures are not hashed.
+ ***********************************************************/
+void SceneFile::HashAssets(SceneDescription& scene)
+{
+	auto hashAsset = [](const std::string& filePath)
+	{
+		unsigned long long hash = HashFile(filePath.c_str());
+		if (hash == 0)
+		{
+			hash = 1469598103934665603ULL;
+			for (char c : filePath)
+			{
+				hash = (hash ^ (unsigned char)c) * 1099511628211ULL;
+			}
+		}
+		return(hash);
+	};
+
+	for (SceneDescription::MESH_ENTRY& mesh : scene.meshes)
+	{
+		mesh.contentHash = mesh.filename.empty() ? 0 : hashAsset(CookedMesh::GetCookedPath(mesh.filename.c_str()));
+	}
+	for (SceneDescription::TEXTURE_ENTRY& texture : scene.textures)
+	{
+		texture.contentHash = hashAsset(texture.filename);
+	}
+}
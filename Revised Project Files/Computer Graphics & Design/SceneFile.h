@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// read scene descriptions from text .scene files and their compiled form
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneDescription
+ *
+ *  Everything a scene file lists: the models and textures
+ *  to load, the materials and lights, and the objects drawn
+ *  with them.  Objects refer to the other tables by index,
+ *  so building the draw list needs no lookups by name.
+ ***********************************************************/
+struct SceneDescription
+{
+	// a mesh referred to by the objects - a cooked model when it has
+	// a file, otherwise one of the basic shapes, by name
+	struct MESH_ENTRY
+	{
+		std::string tag;
+		std::string filename;
+		// hash of the cooked model, from SceneFile::HashAssets(), 0 when not worked out
+		unsigned long long contentHash;
+	};
+
+	// an image, or the page file of a virtual texture
+	struct TEXTURE_ENTRY
+	{
+		std::string tag;
+		std::string filename;
+		// hash of the image, from SceneFile::HashAssets(), 0 when not worked out
+		unsigned long long contentHash;
+	};
+
+	struct MATERIAL_ENTRY
+	{
+		std::string tag;
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	struct LIGHT_ENTRY
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+		float radius;
+	};
+
+	// object flags
+	static const unsigned int OBJECT_TRANSPARENT = 1;
+	static const unsigned int OBJECT_UNLIT = 2;
+	static const unsigned int OBJECT_ALPHA_TESTED = 4;
+
+	// one drawn object - plain 4 byte fields, so the compiled
+	// file holds the table exactly as it is in memory
+	struct OBJECT_ENTRY
+	{
+		// indices into the tables above, -1 when not used
+		int mesh;
+		int texture;
+		int material;
+		int virtualTexture;
+		// only drawn when this mesh could not be loaded, -1 to always draw
+		int fallbackFor;
+		unsigned int flags;
+		float scale[3];
+		// degrees about X, Y then Z
+		float rotation[3];
+		float position[3];
+		float uvScale[2];
+	};
+
+	std::vector<MESH_ENTRY> meshes;
+	std::vector<TEXTURE_ENTRY> textures;
+	std::vector<TEXTURE_ENTRY> virtualTextures;
+	std::vector<MATERIAL_ENTRY> materials;
+	std::vector<LIGHT_ENTRY> lights;
+	std::vector<OBJECT_ENTRY> objects;
+
+	void Clear();
+};
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  These functions read and write scene descriptions.  The
+ *  text form is for authoring, one entry per line, with '#'
+ *  starting a comment:
+ *
+ *    mesh <tag> <model.obj>
+ *    texture <tag> <image>
+ *    virtual_texture <tag> <page file>
+ *    material <tag> ambient r g b strength s diffuse r g b
+ *             specular r g b shininess s
+ *    light position x y z ambient r g b diffuse r g b
+ *          specular r g b focal f intensity i [radius r]
+ *    object <mesh> [texture <tag>] [uv u v] [material <tag>]
+ *           [scale x y z] [rotate x y z] [position x y z]
+ *           [virtual <tag>] [fallback <mesh>]
+ *           [transparent] [unlit] [alpha_tested]
+ *
+ *  The basic shapes are the meshes plane, box, cylinder,
+ *  tapered_cylinder, pyramid, sphere and half_sphere, and
+ *  need no mesh line.  Tags are declared before they are
+ *  used, and file paths are relative to the working folder
+ *  and cannot hold spaces.  An object drawn with "fallback"
+ *  stands in for a model that has not been cooked.
+ *
+ *  The compiled .sceneb form holds the same tables, with
+ *  the object table stored as it is in memory, and is
+ *  written next to the text the first time it is read.
+ *  It has no OpenGL code.
+ ***********************************************************/
+namespace SceneFile
+{
+	// the names of the basic shapes, in SceneManager::MESH_TYPE order
+	const int BASIC_MESH_COUNT = 7;
+	extern const char* const BASIC_MESH_NAMES[BASIC_MESH_COUNT];
+
+	// read a scene from its compiled file when that is newer than the text,
+	// otherwise parse the text and compile it for next time - false with no
+	// message when neither file exists
+	bool Load(const char* filePath, SceneDescription& scene);
+	// parse the text form, false with the line reported when it has an error
+	bool LoadText(const char* filePath, SceneDescription& scene);
+	// read the compiled form, false if it is missing or not a compiled scene
+	bool LoadCompiled(const char* filePath, SceneDescription& scene);
+	bool SaveCompiled(const char* filePath, const SceneDescription& scene);
+
+	// the compiled file that goes with a text scene ("desk.scene" -> "desk.sceneb")
+	std::string GetCompiledPath(const char* sourcePath);
+
+	// hash the contents of a file, 64-bit FNV-1a, 0 when it cannot be read
+	unsigned long long HashFile(const char* filePath);
+	// fill in the content hash of every model and image the scene names,
+	// so an asset that is already loaded is recognized under any name
+	void HashAssets(SceneDescription& scene);
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenehotreload.cpp
+// ============
+// watch the scene file and apply its edits to the running scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneHotReload.h"
+#include "SceneManager_revised.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  SceneHotReload()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneHotReload::SceneHotReload(SceneManager* pSceneManager)
+{
+	m_pSceneManager = pSceneManager;
+	m_bReloadPending = false;
+	m_bWorkerDone = false;
+	m_bWorkerLoaded = false;
+}
+
+/***********************************************************
+ *  ~SceneHotReload()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneHotReload::~SceneHotReload()
+{
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
+	m_pSceneManager = nullptr;
+}
+
+/***********************************************************
+ *  Watch()
+ *
+ *  This method is used to start watching the scene file.
+ ***********************************************************/
+bool SceneHotReload::Watch(const char* sceneFilePath)
+{
+	m_sceneFilePath = sceneFilePath;
+
+	// the compiled file written next to it by the worker has
+	// another name, so it does not count as a change
+	m_fileWatcher.Watch({ m_sceneFilePath });
+
+	std::cout << "INFO: Watching " << m_sceneFilePath << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  StartLoad()
+ *
+ *  This method is used to read the scene file on the worker
+ *  thread.  The text is always parsed, since a save within
+ *  the file time resolution of the last compile would leave
+ *  the compiled file looking current.  It is then compiled
+ *  again and the models and images it names are hashed -
+ *  none of it needs the GL context.
+ ***********************************************************/
+void SceneHotReload::StartLoad()
+{
+	m_bWorkerDone = false;
+	m_bWorkerLoaded = false;
+	m_worker = std::thread([this]()
+		{
+			m_bWorkerLoaded = SceneFile::LoadText(m_sceneFilePath.c_str(), m_pendingScene);
+			if (m_bWorkerLoaded)
+			{
+				SceneFile::SaveCompiled(SceneFile::GetCompiledPath(m_sceneFilePath.c_str()).c_str(), m_pendingScene);
+				SceneFile::HashAssets(m_pendingScene);
+			}
+			m_bWorkerDone = true;
+		});
+
+	std::cout << "INFO: Scene file change detected, reloading " << m_sceneFilePath << std::endl;
+}
+
+/***********************************************************
+ *  FinishLoad()
+ *
+ *  This method is used to check on the worker, handing the
+ *  scene over to the SceneManager once it has loaded.
+ ***********************************************************/
+bool SceneHotReload::FinishLoad()
+{
+	if ((m_worker.joinable() == false) || (m_bWorkerDone == false))
+	{
+		return false;
+	}
+	m_worker.join();
+
+	if (m_bWorkerLoaded == false)
+	{
+		std::cout << "ERROR: " << m_sceneFilePath << " was not loaded, keeping the running scene" << std::endl;
+		return false;
+	}
+
+	m_pSceneManager->ReloadScene(m_pendingScene);
+	m_pendingScene.Clear();
+	return true;
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used once per frame to pick up file
+ *  changes and to hand over a scene that has been read.
+ ***********************************************************/
+bool SceneHotReload::Poll()
+{
+	if (m_fileWatcher.Poll())
+	{
+		m_bReloadPending = true;
+	}
+
+	bool bReloaded = FinishLoad();
+
+	// a save made while the worker was busy is read once it is done
+	if (m_bReloadPending && (m_worker.joinable() == false))
+	{
+		m_bReloadPending = false;
+		StartLoad();
+	}
+
+	return(bReloaded);
+}
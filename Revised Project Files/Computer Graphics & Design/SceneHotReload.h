@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenehotreload.h
+// ============
+// watch the scene file and apply its edits to the running scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FileWatcher.h"
+#include "SceneFile.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+class SceneManager;
+
+/***********************************************************
+ *  SceneHotReload
+ *
+ *  This class watches the scene file.  When it is saved,
+ *  the file is parsed, compiled and its assets hashed on a
+ *  worker thread, while frames keep rendering the old scene.  Once that is done
+ *  the SceneManager applies only what changed, in the frame
+ *  that picks it up.  A file with errors prints them and the
+ *  running scene is kept.
+ ***********************************************************/
+class SceneHotReload
+{
+public:
+	// constructor
+	SceneHotReload(SceneManager* pSceneManager);
+	// destructor
+	~SceneHotReload();
+
+	// start watching the file the scene was loaded from
+	bool Watch(const char* sceneFilePath);
+
+	// call once per frame - returns true when the scene was updated
+	bool Poll();
+
+private:
+	SceneManager* m_pSceneManager;
+	std::string m_sceneFilePath;
+
+	FileWatcher m_fileWatcher;
+	// set when a save is seen, until the worker is free to read it
+	bool m_bReloadPending;
+
+	// the scene being read on the worker thread
+	std::thread m_worker;
+	std::atomic<bool> m_bWorkerDone;
+	bool m_bWorkerLoaded;
+	SceneDescription m_pendingScene;
+
+	// start reading the scene file on the worker thread
+	void StartLoad();
+	// check the worker, handing the scene over when it has loaded
+	bool FinishLoad();
+};
@@ -7,7 +7,22 @@
 //	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "SceneManager.h"
+#include "SceneManager_revised.h"
+#include "DeferredRenderer.h"
+#include "Profiler.h"
+#include "ShaderPermutations.h"
+#include "KtxTexture.h"
+#include "AssetPack.h"
+#include "MipGenerator.h"
+#include "TextureStreamer.h"
+#include "VirtualTexturing.h"
+#include "MeshPool.h"
+#include "ShapeBuilder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "CookedMesh.h"
+#include "ClusterCuller.h"
+#include "SceneFile.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,6 +31,16 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
 // declaration of global variables
 namespace
 {
@@ -24,6 +49,76 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+
+	// number of light sources declared in the forward fragment shader
+	const int FORWARD_LIGHT_COUNT = 4;
+
+	// closest an object is treated as being when sizing its texture
+	const float STREAM_MIN_DISTANCE = 0.1f;
+
+	// tessellation of the round basic shapes
+	const int SHAPE_SLICES = 36;
+	const int SPHERE_STACKS = 18;
+	// tessellation of the vertex throughput stress scene
+	const int DENSE_SHAPE_SLICES = 1024;
+	const int DENSE_SPHERE_STACKS = 512;
+
+	// the coarsest round shapes the levels of detail go down to
+	const int LOD_MIN_SLICES = 8;
+	const int LOD_MIN_STACKS = 4;
+	// furthest a simplified level may move from the shape, in mesh units
+	const float LOD_MAX_SIMPLIFY_ERROR = 0.1f;
+	// a coarser level is only taken when its error is this far under
+	// the limit, so an item near the limit does not switch every frame
+	const float LOD_HYSTERESIS = 0.5f;
+	// closest an object is treated as being when picking its level
+	const float LOD_MIN_DISTANCE = 0.1f;
+
+	// names of the basic meshes, in MESH_TYPE order, for the log
+	const char* g_MeshNames[] = {
+		"plane", "box", "cylinder", "tapered cylinder", "pyramid", "sphere", "half sphere" };
+
+	// layout of the draw item sort key
+	const int SORT_KEY_VARIANT_SHIFT = 24;
+	const int SORT_KEY_TEXTURE_SHIFT = 12;
+	const unsigned int SORT_KEY_FIELD_MASK = 0xFFF;
+
+	/***********************************************************
+	 *  MakeMaterial()
+	 *
+	 *  This function is used to turn a material of a scene file
+	 *  into an object material.
+	 ***********************************************************/
+	SceneManager::OBJECT_MATERIAL MakeMaterial(const SceneDescription::MATERIAL_ENTRY& entry)
+	{
+		SceneManager::OBJECT_MATERIAL material;
+		material.ambientColor = entry.ambientColor;
+		material.ambientStrength = entry.ambientStrength;
+		material.diffuseColor = entry.diffuseColor;
+		material.specularColor = entry.specularColor;
+		material.shininess = entry.shininess;
+		material.tag = entry.tag;
+		return(material);
+	}
+
+	/***********************************************************
+	 *  MakeLight()
+	 *
+	 *  This function is used to turn a light of a scene file
+	 *  into a light source.
+	 ***********************************************************/
+	SceneManager::LIGHT_SOURCE MakeLight(const SceneDescription::LIGHT_ENTRY& entry)
+	{
+		SceneManager::LIGHT_SOURCE light;
+		light.position = entry.position;
+		light.ambientColor = entry.ambientColor;
+		light.diffuseColor = entry.diffuseColor;
+		light.specularColor = entry.specularColor;
+		light.focalStrength = entry.focalStrength;
+		light.specularIntensity = entry.specularIntensity;
+		light.radius = entry.radius;
+		return(light);
+	}
 }
 
 /***********************************************************
@@ -34,7 +129,40 @@ namespace
 SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_pMeshPool = new MeshPool();
+	m_bMeshLods = true;
+	m_lodErrorPixels = 1.0f;
+	m_bQuantizedVertices = false;
+	m_bDenseMeshes = false;
+	m_bOptimizeMeshes = true;
+	m_pClusterCuller = nullptr;
+	m_bMeshletCulling = true;
+	m_loadedTextures = 0;
+	m_renderPath = RENDER_PATH_FORWARD;
+	m_pDeferredRenderer = nullptr;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_viewportWidth = 0;
+	m_viewportHeight = 0;
+	m_targetFramebuffer = 0;
+	m_pShaderPermutations = nullptr;
+	m_preparedVariants = 0;
+	m_litVariants = 0;
+	m_pAssetPack = nullptr;
+	m_bCpuMipmaps = true;
+	m_pTextureStreamer = nullptr;
+	m_pVirtualTexturing = nullptr;
+	m_bVirtualTextures = true;
+	m_pScene = nullptr;
+	m_bSceneReload = false;
+	for (int i = 0; i < PRIMITIVE_QUERY_COUNT; i++)
+	{
+		m_primitiveQueries[i] = 0;
+		m_primitiveQueryIssued[i] = false;
+	}
+	m_primitiveQueryIndex = 0;
+	m_lastTriangleCount = 0;
 }
 
 /***********************************************************
@@ -45,8 +173,42 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = nullptr;			// Changing this entry (and the one below it) from "NULL" to "nullptr"
-	delete m_basicMeshes;
-	m_basicMeshes = nullptr;
+	delete m_pMeshPool;
+	m_pMeshPool = nullptr;
+	if (nullptr != m_pDeferredRenderer)
+	{
+		delete m_pDeferredRenderer;
+		m_pDeferredRenderer = nullptr;
+	}
+	if (nullptr != m_pShaderPermutations)
+	{
+		delete m_pShaderPermutations;
+		m_pShaderPermutations = nullptr;
+	}
+	if (m_primitiveQueries[0] != 0)
+	{
+		glDeleteQueries(PRIMITIVE_QUERY_COUNT, m_primitiveQueries);
+	}
+	if (nullptr != m_pTextureStreamer)
+	{
+		delete m_pTextureStreamer;
+		m_pTextureStreamer = nullptr;
+	}
+	if (nullptr != m_pVirtualTexturing)
+	{
+		delete m_pVirtualTexturing;
+		m_pVirtualTexturing = nullptr;
+	}
+	if (nullptr != m_pClusterCuller)
+	{
+		delete m_pClusterCuller;
+		m_pClusterCuller = nullptr;
+	}
+	if (nullptr != m_pScene)
+	{
+		delete m_pScene;
+		m_pScene = nullptr;
+	}
 }
 
 /***********************************************************
@@ -59,67 +221,423 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
+	// a texture cooked by the TextureCook tool skips the decode and the mip build
+	if (CreateCompressedGLTexture(filename, tag))
+	{
+		return true;
+	}
 
 	// indicate to always flip images vertically when loaded
 	stbi_set_flip_vertically_on_load(true);
 
+	DECODED_IMAGE decoded;
+	if (DecodeImage(filename, m_bCpuMipmaps, decoded) == false)
+	{
+		return false;
+	}
+	return UploadDecodedTexture(filename, decoded, tag);
+}
+
+/***********************************************************
+ *  CreateGLTextures()
+ *
+ *  This method is used for loading a list of textures.  The
+ *  images without a cooked file are decoded, and have their
+ *  mips built, on worker threads.  The uploads stay on this
+ *  thread, which owns the GL context, and go in list order
+ *  as each image is ready, so the texture slots are the same
+ *  as loading them one by one.
+ ***********************************************************/
+void SceneManager::CreateGLTextures(const std::vector<TEXTURE_FILE>& textures)
+{
+	int freeSlots = MAX_TEXTURES - m_loadedTextures;
+	for (int slot = 0; slot < m_loadedTextures; slot++)
+	{
+		if (m_textureIDs[slot].ID == 0)
+		{
+			freeSlots++;
+		}
+	}
+	int count = std::min((int)textures.size(), freeSlots);
+	if (count < (int)textures.size())
+	{
+		std::cout << "ERROR: Only " << MAX_TEXTURES << " textures can be loaded, skipping "
+			<< (int)textures.size() - count << " of them" << std::endl;
+	}
+	std::vector<DECODED_IMAGE> decoded(count);
+	// char, not bool, so the workers can write their own entries at once
+	std::vector<char> bCooked(count, 0);
+	std::vector<char> bDecoded(count, 0);
+	std::vector<char> bDone(count, 0);
+	for (int i = 0; i < count; i++)
+	{
+		bCooked[i] = HasCookedTexture(textures[i].filename.c_str()) ? 1 : 0;
+	}
+
+	// stb_image reads this setting on every thread
+	stbi_set_flip_vertically_on_load(true);
+
+	std::mutex mutex;
+	std::condition_variable readyCondition;
+	std::atomic<int> nextIndex(0);
+	bool bCpuMipmaps = m_bCpuMipmaps;
+	auto decodeWorker = [&]()
+	{
+		for (int i = nextIndex++; i < count; i = nextIndex++)
+		{
+			if (bCooked[i] == 0)
+			{
+				bDecoded[i] = DecodeImage(textures[i].filename.c_str(), bCpuMipmaps, decoded[i]) ? 1 : 0;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				bDone[i] = 1;
+			}
+			readyCondition.notify_one();
+		}
+	};
+
+	int workerCount = std::max(1, std::min((int)std::thread::hardware_concurrency(), count));
+	std::vector<std::thread> workers;
+	for (int i = 0; i < workerCount; i++)
+	{
+		workers.push_back(std::thread(decodeWorker));
+	}
+
+	double mipMilliseconds = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			readyCondition.wait(lock, [&]() { return bDone[i] != 0; });
+		}
+
+		if (bCooked[i] != 0)
+		{
+			// a cooked file the driver cannot use is decoded here instead
+			if ((CreateCompressedGLTexture(textures[i].filename.c_str(), textures[i].tag) == false) &&
+				DecodeImage(textures[i].filename.c_str(), bCpuMipmaps, decoded[i]))
+			{
+				mipMilliseconds += decoded[i].mipMilliseconds;
+				UploadDecodedTexture(textures[i].filename.c_str(), decoded[i], textures[i].tag);
+			}
+		}
+		else if (bDecoded[i] != 0)
+		{
+			mipMilliseconds += decoded[i].mipMilliseconds;
+			UploadDecodedTexture(textures[i].filename.c_str(), decoded[i], textures[i].tag);
+		}
+	}
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	if (bCpuMipmaps)
+	{
+		std::cout << "INFO: Built " << MipGenerator::GetKernelName() << " mip chains in "
+			<< mipMilliseconds << " ms of worker time" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  HasCookedTexture()
+ *
+ *  This method is used for checking, without loading it,
+ *  whether an image has a cooked .ktx2 in the asset pack or
+ *  next to it.
+ ***********************************************************/
+bool SceneManager::HasCookedTexture(const char* filename) const
+{
+	std::string cookedPath = KtxTexture::GetCookedPath(filename);
+	if ((nullptr != m_pAssetPack) && (nullptr != m_pAssetPack->Find(AssetPack::GetAssetName(cookedPath))))
+	{
+		return true;
+	}
+	std::ifstream file(cookedPath, std::ios::binary);
+	return file.is_open();
+}
+
+/***********************************************************
+ *  DecodeImage()
+ *
+ *  This method is used for reading an image file and, when
+ *  asked to, building its mip chain on the CPU.  The image
+ *  colors are sRGB, so the mips are filtered in linear light.
+ *  It makes no GL calls and can run on any thread.
+ ***********************************************************/
+bool SceneManager::DecodeImage(const char* filename, bool bCpuMipmaps, DECODED_IMAGE& decoded)
+{
+	decoded.mips.clear();
+	decoded.mipMilliseconds = 0.0;
+
 	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
+	decoded.pixels = stbi_load(
 		filename,
-		&width,
-		&height,
-		&colorChannels,
+		&decoded.width,
+		&decoded.height,
+		&decoded.channels,
 		0);
+	if (nullptr == decoded.pixels)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return false;
+	}
 
-	// if the image was successfully read from the image file
-	if (image)
+	if ((decoded.channels != 3) && (decoded.channels != 4))
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+		std::cout << "Not implemented to handle image with " << decoded.channels << " channels" << std::endl;
+		stbi_image_free(decoded.pixels);
+		decoded.pixels = nullptr;
+		return false;
+	}
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+	if (bCpuMipmaps)
+	{
+		std::chrono::steady_clock::time_point mipStart = std::chrono::steady_clock::now();
+		MipGenerator::BuildMipChain(decoded.pixels, decoded.width, decoded.height, decoded.channels, true, decoded.mips);
+		decoded.mipMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - mipStart).count();
+	}
 
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return true;
+}
 
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
+/***********************************************************
+ *  UploadDecodedTexture()
+ *
+ *  This method is used for creating the OpenGL texture for a
+ *  decoded image.  The CPU built mips are uploaded level by
+ *  level, otherwise the driver generates them.  The decoded
+ *  pixels are freed either way.
+ ***********************************************************/
+bool SceneManager::UploadDecodedTexture(const char* filename, DECODED_IMAGE& decoded, std::string tag)
+{
+	GLuint textureID = 0;
+
+	std::cout << "Successfully loaded image:" << filename << ", width:" << decoded.width << ", height:" << decoded.height << ", channels:" << decoded.channels << std::endl;
+
+	// a streamed texture keeps the decoded levels and uploads only its small mips for now
+	if ((nullptr != m_pTextureStreamer) && (decoded.mips.empty() == false))
+	{
+		int streamHandle = m_pTextureStreamer->AddDecodedTexture(tag, decoded.pixels,
+			decoded.width, decoded.height, decoded.channels, decoded.mips);
+		decoded.pixels = nullptr;
+		RegisterTexture(m_pTextureStreamer->GetTextureID(streamHandle), tag, streamHandle);
+		return true;
+	}
 
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters - minified surfaces blend between
+	// the mips, so they do not alias, once the image has more than one level
+	bool bMipmapped = (std::max(decoded.width, decoded.height) > 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, bMipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// RGB images use RGB8, and RGBA images support transparency
+	GLenum internalFormat = (decoded.channels == 3) ? GL_RGB8 : GL_RGBA8;
+	GLenum format = (decoded.channels == 3) ? GL_RGB : GL_RGBA;
+
+	// the rows of the small RGB mips are not 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, decoded.width, decoded.height, 0, format, GL_UNSIGNED_BYTE, decoded.pixels);
+	if (decoded.mips.empty())
+	{
 		// generate the texture mipmaps for mapping textures to lower resolutions
 		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	for (size_t level = 0; level < decoded.mips.size(); level++)
+	{
+		int levelWidth = std::max(decoded.width >> (level + 1), 1);
+		int levelHeight = std::max(decoded.height >> (level + 1), 1);
+		glTexImage2D(GL_TEXTURE_2D, (GLint)(level + 1), internalFormat, levelWidth, levelHeight, 0,
+			format, GL_UNSIGNED_BYTE, decoded.mips[level].data());
+	}
+	if (decoded.mips.empty() == false)
+	{
+		// the texture is only complete for mipmapped sampling up to the last level built
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)decoded.mips.size());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	// free the image data from local memory
+	stbi_image_free(decoded.pixels);
+	decoded.pixels = nullptr;
+	decoded.mips.clear();
+	glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+
+	RegisterTexture(textureID, tag, -1);
+	return true;
+}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
+/***********************************************************
+ *  RegisterTexture()
+ *
+ *  This method is used for putting a loaded texture in the
+ *  first free slot, associated with the special tag string.
+ *  A slot freed by FreeTextureSlot() is used again before a
+ *  new one is taken.
+ ***********************************************************/
+void SceneManager::RegisterTexture(GLuint textureID, std::string tag, int streamHandle)
+{
+	int slot = 0;
+	while ((slot < m_loadedTextures) && (m_textureIDs[slot].ID != 0))
+	{
+		slot++;
+	}
+	if (slot == m_loadedTextures)
+	{
 		m_loadedTextures++;
+	}
+
+	m_textureIDs[slot].ID = textureID;
+	m_textureIDs[slot].tag = tag;
+	m_textureIDs[slot].streamHandle = streamHandle;
+	m_textureIDs[slot].contentHash = 0;
+}
+
+/***********************************************************
+ *  FreeTextureSlot()
+ *
+ *  This method is used for deleting the texture in a slot,
+ *  and leaving the slot empty for RegisterTexture().  No
+ *  draw item may still use the slot.
+ ***********************************************************/
+void SceneManager::FreeTextureSlot(int slot)
+{
+	if (m_textureIDs[slot].streamHandle >= 0)
+	{
+		m_pTextureStreamer->RemoveTexture(m_textureIDs[slot].streamHandle);
+	}
+	else
+	{
+		glDeleteTextures(1, &m_textureIDs[slot].ID);
+	}
+	m_textureIDs[slot].ID = 0;
+	m_textureIDs[slot].tag.clear();
+	m_textureIDs[slot].streamHandle = -1;
+	m_textureIDs[slot].contentHash = 0;
+}
+
+/***********************************************************
+ *  CreateCompressedGLTexture()
+ *
+ *  This method is used for loading the cooked .ktx2 file
+ *  that goes with an image, if there is one.  The BCn blocks
+ *  and their precomputed mips are uploaded as they are, so
+ *  nothing is decoded and the texture takes a quarter to an
+ *  eighth of the memory.  The asset pack is checked first,
+ *  and a packed texture is uploaded straight from its mapped
+ *  pages.  Returns false, so the image itself is loaded, when
+ *  there is no cooked file or the driver cannot sample its
+ *  format.
+ ***********************************************************/
+bool SceneManager::CreateCompressedGLTexture(const char* filename, std::string tag)
+{
+	std::string cookedPath = KtxTexture::GetCookedPath(filename);
+	// on the heap, since the texture streamer keeps it when streaming
+	KtxTexture* pCooked = new KtxTexture();
+	KtxTexture& cooked = *pCooked;
+	const AssetPack::ASSET* packed = nullptr;
+	if (nullptr != m_pAssetPack)
+	{
+		packed = m_pAssetPack->Find(AssetPack::GetAssetName(cookedPath));
+	}
+	if (nullptr != packed)
+	{
+		if (cooked.LoadFromMemory(packed->data, packed->size, cookedPath.c_str()) == false)
+		{
+			delete pCooked;
+			return false;
+		}
+	}
+	else if (cooked.LoadFromFile(cookedPath.c_str()) == false)
+	{
+		delete pCooked;
+		return false;
+	}
+
+	GLenum internalFormat = 0;
+	bool bSupported = false;
+	switch (cooked.GetFormat())
+	{
+	case KtxTexture::FORMAT_BC1:
+		internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		bSupported = GLEW_EXT_texture_compression_s3tc;
+		break;
+	case KtxTexture::FORMAT_BC3:
+		internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		bSupported = GLEW_EXT_texture_compression_s3tc;
+		break;
+	case KtxTexture::FORMAT_BC7:
+		internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+		bSupported = GLEW_ARB_texture_compression_bptc;
+		break;
+	default:
+		break;
+	}
+	if (bSupported == false)
+	{
+		std::cout << "No driver support for " << KtxTexture::GetFormatName(cooked.GetFormat())
+			<< ", decoding " << filename << " instead" << std::endl;
+		delete pCooked;
+		return false;
+	}
+
+	std::cout << "Successfully loaded cooked texture:" << cookedPath << ((nullptr != packed) ? " (asset pack)" : "")
+		<< ", width:" << cooked.GetWidth() << ", height:" << cooked.GetHeight() << ", mips:" << cooked.GetLevelCount() << ", format:"
+		<< KtxTexture::GetFormatName(cooked.GetFormat()) << ", bytes:" << cooked.GetDataSize() << std::endl;
+
+	// a streamed texture keeps the cooked levels and uploads only its small mips for now
+	if (nullptr != m_pTextureStreamer)
+	{
+		int streamHandle = m_pTextureStreamer->AddCompressedTexture(tag, pCooked, internalFormat);
+		RegisterTexture(m_pTextureStreamer->GetTextureID(streamHandle), tag, streamHandle);
 		return true;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// the same wrapping and filtering as the decoded textures, sampling the cooked mips
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		(cooked.GetLevelCount() > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// immutable storage for the whole chain, then each level is filled in
+	if (GLEW_ARB_texture_storage)
+	{
+		glTexStorage2D(GL_TEXTURE_2D, cooked.GetLevelCount(), internalFormat, cooked.GetWidth(), cooked.GetHeight());
+	}
+	for (int level = 0; level < cooked.GetLevelCount(); level++)
+	{
+		const KtxTexture::MIP_LEVEL& mip = cooked.GetLevel(level);
+		if (GLEW_ARB_texture_storage)
+		{
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip.width, mip.height,
+				internalFormat, (GLsizei)mip.size, mip.data);
+		}
+		else
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, mip.width, mip.height, 0,
+				(GLsizei)mip.size, mip.data);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.GetLevelCount() - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	delete pCooked;
 
-	// Error loading the image
-	return false;
+	RegisterTexture(textureID, tag, -1);
+	return true;
 }
 
 /***********************************************************
@@ -130,12 +648,15 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
+	GpuScope profileScope("BindGLTextures");
+
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
 		// bind textures on corresponding texture units
 		glActiveTexture(GL_TEXTURE0 + i);
 		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
 	}
+	m_renderStats.textureBinds += m_loadedTextures;
 }
 
 /***********************************************************
@@ -204,6 +725,26 @@ int SceneManager::FindTextureSlot(std::string tag)
 	return(textureSlot);
 }
 
+/***********************************************************
+ *  FindTextureByContent()
+ *
+ *  This method is used for getting the slot of a loaded
+ *  texture from the hash of its image, so an image that is
+ *  already loaded is reused whatever tag it is given.
+ ***********************************************************/
+int SceneManager::FindTextureByContent(unsigned long long contentHash) const
+{
+	for (int index = 0; (index < m_loadedTextures) && (contentHash != 0); index++)
+	{
+		if (m_textureIDs[index].contentHash == contentHash)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
 /***********************************************************
  *  FindMaterial()
  *
@@ -240,12 +781,31 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  FindMaterialIndex()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for getting the index of a previously
+ *  defined material associated with the passed in tag.
  ***********************************************************/
-void SceneManager::SetTransformations(
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  BuildTransformation()
+ *
+ *  This method is used for building the model matrix from
+ *  the passed in transformation values.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildTransformation(
 	glm::vec3 scaleXYZ,
 	float XrotationDegrees,
 	float YrotationDegrees,
@@ -253,7 +813,6 @@ void SceneManager::SetTransformations(
 	glm::vec3 positionXYZ)
 {
 	// variables for this method
-	glm::mat4 modelView;
 	glm::mat4 scale;
 	glm::mat4 rotationX;
 	glm::mat4 rotationY;
@@ -269,7 +828,31 @@ void SceneManager::SetTransformations(
 	// set the translation value in the transform buffer
 	translation = glm::translate(positionXYZ);
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	return(translation * rotationX * rotationY * rotationZ * scale);
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
+	glm::mat4 modelView;
+
+	modelView = BuildTransformation(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
 	if (nullptr != m_pShaderManager)			// Making a change here, from "NULL" to "nullptr"
 	{
@@ -322,11 +905,7 @@ void SceneManager::SetShaderTexture(
 		// Adding a "default" material here, for the textures to use.
 		OBJECT_MATERIAL def;
 		FindMaterial("default", def);
-		m_pShaderManager->setVec3Value("material.ambientColor", def.ambientColor);
-		m_pShaderManager->setFloatValue("material.ambientStrength", def.ambientStrength);
-		m_pShaderManager->setVec3Value("material.diffuseColor", def.diffuseColor);
-		m_pShaderManager->setVec3Value("material.specularColor", def.specularColor);
-		m_pShaderManager->setFloatValue("material.shininess", def.shininess);
+		SetMaterialUniforms(def);
 
 		int textureID = -1;
 		textureID = FindTextureSlot(textureTag);
@@ -369,42 +948,1675 @@ void SceneManager::SetShaderMaterial(
 		bReturn = FindMaterial(materialTag, material);
 		if (bReturn == true)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			SetMaterialUniforms(material);
 		}
 	}
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-// Adding in a DefineObjectMaterials helper here for creating a wine bottle (with wine)
-void SceneManager::DefineObjectMaterials() {
+/***********************************************************
+ *  SetMaterialUniforms()
+ *
+ *  This method is used for passing the lighting values of
+ *  a material into the shader.
+ ***********************************************************/
+void SceneManager::SetMaterialUniforms(
+	const OBJECT_MATERIAL& material)
+{
+	m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
+	m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
+	m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
+	m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
+	m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+}
 
-	// Adding a "default" material here, for the textures to use.
-	OBJECT_MATERIAL def;
-	def.ambientColor = glm::vec3(1.0);
-	def.ambientStrength = 0.0f;
-	def.diffuseColor = glm::vec3(1.0f);
-	def.specularColor = glm::vec3(0.1f);
-	def.shininess = 16.0f;
-	def.tag = "default";
-	m_objectMaterials.push_back(def);
+/***********************************************************
+ *  AddTexturedDrawItem()
+ *
+ *  This method is used for adding a textured object to the
+ *  scene draw list.
+ ***********************************************************/
+void SceneManager::AddTexturedDrawItem(
+	int mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	std::string textureTag,
+	float u, float v)
+{
+	DRAW_ITEM item;
+	item.mesh = mesh;
+	item.model = BuildTransformation(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	item.textureSlot = FindTextureSlot(textureTag);
+	// textured objects are lit with the "default" material
+	item.materialIndex = FindMaterialIndex("default");
+	item.uvScale = glm::vec2(u, v);
+	item.bTransparent = false;
+	item.bLit = true;
+	item.bAlphaTested = false;
+	item.virtualTexture = -1;
+	item.lod = 0;
+	item.meshletDraw = -1;
+	item.sceneObject = -1;
+	item.sortKey = 0;
+
+	if (item.textureSlot < 0)
+	{
+		std::cout << "Draw item uses unknown texture:" << textureTag << std::endl;
+	}
 
-	// Adding a wine bottle material
-	OBJECT_MATERIAL wine;
-	wine.ambientColor = glm::vec3(0.2f, 0.005f, 0.2f);  // Creating a dark color
-	wine.ambientStrength = 0.15f;
-	wine.diffuseColor = glm::vec3(0.1f, 0.05f, 0.1f);  // Creating a purple hue
-	wine.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	wine.shininess = 180.0f;   // making the glass shiny
-	wine.tag = "wineBottle";
+	m_drawItems.push_back(item);
+}
+
+/***********************************************************
+ *  AddMaterialDrawItem()
+ *
+ *  This method is used for adding an object that is only
+ *  drawn with a material to the scene draw list.
+ ***********************************************************/
+void SceneManager::AddMaterialDrawItem(
+	int mesh,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	std::string materialTag)
+{
+	DRAW_ITEM item;
+	item.mesh = mesh;
+	item.model = BuildTransformation(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
+	item.textureSlot = -1;
+	item.materialIndex = FindMaterialIndex(materialTag);
+	item.uvScale = glm::vec2(1.0f, 1.0f);
+	item.bTransparent = false;
+	item.bLit = true;
+	item.bAlphaTested = false;
+	item.virtualTexture = -1;
+	item.lod = 0;
+	item.meshletDraw = -1;
+	item.sceneObject = -1;
+	item.sortKey = 0;
+
+	if (item.materialIndex < 0)
+	{
+		std::cout << "Draw item uses unknown material:" << materialTag << std::endl;
+	}
+
+	m_drawItems.push_back(item);
+}
+
+/***********************************************************
+ *  LoadBasicMeshes()
+ *
+ *  This method is used for building every basic shape and
+ *  uploading them together into the mesh pool, so the whole
+ *  scene draws from one vertex and one index buffer.
+ *
+ *  Each shape also gets coarser levels of detail.  The round
+ *  shapes are rebuilt with half the segments each time, and
+ *  the others are simplified to half their triangles, until
+ *  a level would save too little.
+ ***********************************************************/
+void SceneManager::LoadBasicMeshes()
+{
+	int slices = m_bDenseMeshes ? DENSE_SHAPE_SLICES : SHAPE_SLICES;
+	int stacks = m_bDenseMeshes ? DENSE_SPHERE_STACKS : SPHERE_STACKS;
+	m_pMeshPool->SetVertexFormat(m_bQuantizedVertices ? MeshPool::VERTEX_FORMAT_QUANTIZED : MeshPool::VERTEX_FORMAT_FLOAT);
+
+	m_meshLods.clear();
+	for (int i = 0; i < MESH_TYPE_COUNT; i++)
+	{
+		std::vector<MeshData> levels(1);
+		std::vector<float> errors(1, 0.0f);
+		if (BuildBasicMesh((MESH_TYPE)i, slices, stacks, levels[0], errors[0]))
+		{
+			int levelSlices = slices;
+			int levelStacks = stacks;
+			while (m_bMeshLods && ((int)levels.size() < MAX_LOD_LEVELS) && (levelSlices / 2 >= LOD_MIN_SLICES))
+			{
+				levelSlices /= 2;
+				levelStacks = std::max(levelStacks / 2, LOD_MIN_STACKS);
+				levels.push_back(MeshData());
+				errors.push_back(0.0f);
+				BuildBasicMesh((MESH_TYPE)i, levelSlices, levelStacks, levels.back(), errors.back());
+			}
+		}
+		else if (m_bMeshLods)
+		{
+			MeshData mesh = levels[0];
+			MeshSimplifier::BuildLevels(mesh, MAX_LOD_LEVELS, LOD_MAX_SIMPLIFY_ERROR, levels, errors);
+		}
+		AddMeshLevels(g_MeshNames[i], levels, errors);
+	}
+	UploadPoolMeshes();
+}
+
+/***********************************************************
+ *  AddMeshLevels()
+ *
+ *  This method is used for adding the levels of detail of a
+ *  basic shape to the mesh pool as one chain.  The triangles
+ *  are reordered for the vertex cache first, and the cache
+ *  miss ratio of the full mesh before and after is logged.
+ ***********************************************************/
+void SceneManager::AddMeshLevels(const std::string& tag, std::vector<MeshData>& levels, const std::vector<float>& errors)
+{
+	MESH_LOD_CHAIN chain;
+	chain.tag = tag;
+	chain.levelCount = 0;
+	chain.contentHash = 0;
+
+	// the bounding sphere of the full shape, around the middle of its
+	// bounds - the cylinders stand on their origin, and the plane's
+	// corners are outside the unit sphere
+	const std::vector<MeshVertex>& vertices = levels[0].vertices;
+	glm::vec3 boundsMin = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+	glm::vec3 boundsMax = boundsMin;
+	for (const MeshVertex& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	chain.center = (boundsMin + boundsMax) * 0.5f;
+	chain.radius = 0.0f;
+	for (const MeshVertex& vertex : vertices)
+	{
+		chain.radius = std::max(chain.radius, glm::length(vertex.position - chain.center));
+	}
+	std::string triangleCounts;
+	for (size_t level = 0; (level < levels.size()) && (chain.levelCount < MAX_LOD_LEVELS); level++)
+	{
+		MeshData& mesh = levels[level];
+		if (m_bOptimizeMeshes)
+		{
+			float acmrBefore = MeshOptimizer::ComputeAcmr(mesh, MeshOptimizer::CACHE_SIZE);
+			MeshOptimizer::Optimize(mesh);
+			float acmrAfter = MeshOptimizer::ComputeAcmr(mesh, MeshOptimizer::CACHE_SIZE);
+			if (level == 0)
+			{
+				char message[128];
+				snprintf(message, sizeof(message), "INFO: Optimized %s, %d triangles, ACMR %.3f -> %.3f",
+					tag.c_str(), mesh.GetTriangleCount(), acmrBefore, acmrAfter);
+				std::cout << message << std::endl;
+			}
+		}
+		chain.handles[chain.levelCount] = AddPoolMesh(mesh.vertices.data(), mesh.vertices.size(),
+			mesh.indices.data(), mesh.indices.size());
+		chain.errors[chain.levelCount] = errors[level];
+		chain.levelCount++;
+		triangleCounts += " " + std::to_string(mesh.GetTriangleCount());
+	}
+	if (chain.levelCount > 1)
+	{
+		std::cout << "INFO: Levels of detail for " << tag << ":" << triangleCounts << " triangles" << std::endl;
+	}
+	m_meshLods.push_back(chain);
+}
+
+/***********************************************************
+ *  AddPoolMesh()
+ *
+ *  This method is used for adding one mesh to the mesh pool
+ *  and, when meshlet culling is on, splitting it into
+ *  meshlets from the same vertices and indices.
+ ***********************************************************/
+int SceneManager::AddPoolMesh(const MeshVertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount)
+{
+	int handle = m_pMeshPool->AddMesh(vertices, vertexCount, indices, indexCount);
+	if (nullptr != m_pClusterCuller)
+	{
+		m_pClusterCuller->AddMesh(*m_pMeshPool, handle, vertices, vertexCount, indices, indexCount);
+	}
+	return handle;
+}
+
+/***********************************************************
+ *  UploadPoolMeshes()
+ *
+ *  This method is used for copying the meshes added since
+ *  the last upload, and their meshlets, to the GPU.
+ ***********************************************************/
+void SceneManager::UploadPoolMeshes()
+{
+	m_pMeshPool->Upload();
+	if (nullptr != m_pClusterCuller)
+	{
+		m_pClusterCuller->Upload();
+	}
+}
+
+/***********************************************************
+ *  LoadImportedMeshes()
+ *
+ *  This method is used for loading a list of cooked models
+ *  and uploading them together.  A model without a cooked
+ *  .mesh is skipped, and the scene builds that object from
+ *  the basic shapes instead.
+ ***********************************************************/
+void SceneManager::LoadImportedMeshes(const std::vector<MESH_FILE>& meshes)
+{
+	int loaded = 0;
+	for (const MESH_FILE& mesh : meshes)
+	{
+		if (LoadImportedMesh(mesh.filename.c_str(), mesh.tag))
+		{
+			loaded++;
+		}
+	}
+	if (loaded > 0)
+	{
+		UploadPoolMeshes();
+	}
+}
+
+/***********************************************************
+ *  LoadImportedMesh()
+ *
+ *  This method is used for loading the cooked .mesh of a
+ *  model.  The asset pack is checked first, and a packed
+ *  mesh is copied straight from its mapped pages into the
+ *  mesh pool.  Its levels of detail and bounds were worked
+ *  out by the cook, so nothing is built here.
+ ***********************************************************/
+bool SceneManager::LoadImportedMesh(const char* filename, std::string tag)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::string cookedPath = CookedMesh::GetCookedPath(filename);
+	CookedMesh cooked;
+	const AssetPack::ASSET* packed = nullptr;
+	if (nullptr != m_pAssetPack)
+	{
+		packed = m_pAssetPack->Find(AssetPack::GetAssetName(cookedPath));
+	}
+	if (nullptr != packed)
+	{
+		if (cooked.LoadFromMemory(packed->data, packed->size, cookedPath.c_str()) == false)
+		{
+			return false;
+		}
+	}
+	else if (cooked.LoadFromFile(cookedPath.c_str()) == false)
+	{
+		std::cout << "INFO: No cooked mesh for " << filename << ", run MeshCook to import it" << std::endl;
+		return false;
+	}
+
+	MESH_LOD_CHAIN chain;
+	chain.tag = tag;
+	chain.levelCount = std::min(cooked.GetLevelCount(), m_bMeshLods ? MAX_LOD_LEVELS : 1);
+	chain.center = (cooked.GetBoundsMin() + cooked.GetBoundsMax()) * 0.5f;
+	chain.radius = cooked.GetRadius();
+	chain.contentHash = 0;
+	for (int level = 0; level < chain.levelCount; level++)
+	{
+		const CookedMesh::MESH_LEVEL& meshLevel = cooked.GetLevel(level);
+		chain.handles[level] = AddPoolMesh(meshLevel.vertices, meshLevel.vertexCount,
+			meshLevel.indices, meshLevel.indexCount);
+		chain.errors[level] = meshLevel.error;
+	}
+	m_meshLods.push_back(chain);
+
+	std::cout << "Successfully loaded cooked mesh:" << cookedPath << ((nullptr != packed) ? " (asset pack)" : "")
+		<< ", triangles:" << cooked.GetLevel(0).indexCount / 3 << ", levels:" << chain.levelCount << ", ms:"
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  FindImportedMesh()
+ *
+ *  This method is used for getting the mesh index of an
+ *  imported model by its tag, to pass to a draw item.
+ *  Returns -1 when the model was not loaded.
+ ***********************************************************/
+int SceneManager::FindImportedMesh(std::string tag) const
+{
+	for (size_t i = MESH_TYPE_COUNT; i < m_meshLods.size(); i++)
+	{
+		if (m_meshLods[i].tag == tag)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/***********************************************************
+ *  FindImportedMeshByContent()
+ *
+ *  This method is used for getting the mesh index of an
+ *  imported model from the hash of its cooked file.  Returns
+ *  -1 when no loaded model has that content.
+ ***********************************************************/
+int SceneManager::FindImportedMeshByContent(unsigned long long contentHash) const
+{
+	for (size_t i = MESH_TYPE_COUNT; (i < m_meshLods.size()) && (contentHash != 0); i++)
+	{
+		if (m_meshLods[i].contentHash == contentHash)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+/***********************************************************
+ *  BuildBasicMesh()
+ *
+ *  This method is used for building one basic shape with
+ *  the passed in number of segments, and getting how far it
+ *  is from the true round shape.  The flat sided shapes are
+ *  exact and cannot be rebuilt any coarser.
+ ***********************************************************/
+bool SceneManager::BuildBasicMesh(MESH_TYPE mesh, int slices, int stacks, MeshData& data, float& error)
+{
+	error = 0.0f;
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		ShapeBuilder::BuildPlane(data);
+		return false;
+	case MESH_BOX:
+		ShapeBuilder::BuildBox(data);
+		return false;
+	case MESH_PYRAMID4:
+		ShapeBuilder::BuildPyramid4(data);
+		return false;
+	case MESH_CYLINDER:
+		ShapeBuilder::BuildCylinder(data, slices);
+		break;
+	case MESH_TAPERED_CYLINDER:
+		ShapeBuilder::BuildTaperedCylinder(data, slices);
+		break;
+	case MESH_SPHERE:
+		ShapeBuilder::BuildSphere(data, stacks, slices);
+		break;
+	case MESH_HALF_SPHERE:
+		ShapeBuilder::BuildHalfSphere(data, stacks, slices);
+		break;
+	default:
+		data.Clear();
+		return false;
+	}
+
+	// the stacks only go half way around, from pole to pole
+	error = ShapeBuilder::GetChordError(slices);
+	if ((mesh == MESH_SPHERE) || (mesh == MESH_HALF_SPHERE))
+	{
+		error = std::max(error, ShapeBuilder::GetChordError(stacks * 2));
+	}
+	return true;
+}
+
+/***********************************************************
+ *  UpdateMeshLods()
+ *
+ *  This method is used for picking the level of detail of
+ *  every item.  The error of each level is scaled by the
+ *  item and projected to pixels at its closest point, and
+ *  the coarsest level that stays under the limit is drawn.
+ *  An item moves to a finer level as soon as its level goes
+ *  over the limit, but only to a coarser one once that is
+ *  well under it.
+ ***********************************************************/
+void SceneManager::UpdateMeshLods()
+{
+	CpuScope profileScope("mesh lods");
+
+	// an orthographic projection has the same scale at every distance
+	bool bOrthographic = (m_projectionMatrix[3][3] == 1.0f);
+	float pixelsPerUnit = 0.5f * m_viewportHeight * m_projectionMatrix[1][1];
+	for (DRAW_ITEM& item : m_drawItems)
+	{
+		const MESH_LOD_CHAIN& chain = m_meshLods[item.mesh];
+		if (chain.levelCount < 2)
+		{
+			continue;
+		}
+
+		float size = std::max(glm::length(glm::vec3(item.model[0])),
+			std::max(glm::length(glm::vec3(item.model[1])), glm::length(glm::vec3(item.model[2]))));
+		float pixelsPerError = size * pixelsPerUnit;
+		if (bOrthographic == false)
+		{
+			glm::vec3 center = glm::vec3(item.model * glm::vec4(chain.center, 1.0f));
+			float radius = size * chain.radius;
+			pixelsPerError /= std::max(glm::length(center - m_viewPosition) - radius, LOD_MIN_DISTANCE);
+		}
+
+		int lod = std::min(item.lod, chain.levelCount - 1);
+		while ((lod > 0) && (chain.errors[lod] * pixelsPerError > m_lodErrorPixels))
+		{
+			lod--;
+		}
+		while ((lod + 1 < chain.levelCount) &&
+			(chain.errors[lod + 1] * pixelsPerError <= m_lodErrorPixels * LOD_HYSTERESIS))
+		{
+			lod++;
+		}
+		item.lod = lod;
+	}
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This method is used for culling the meshlets of every
+ *  item whose mesh has them, once per frame before any pass
+ *  draws.  Back facing meshlets are only culled on opaque
+ *  items, since the others can show their back faces.
+ ***********************************************************/
+void SceneManager::CullMeshlets()
+{
+	CpuScope profileScope("meshlet culling");
+
+	m_pClusterCuller->BeginFrame(m_viewMatrix, m_projectionMatrix, m_viewPosition);
+	for (DRAW_ITEM& item : m_drawItems)
+	{
+		bool bBackfaceCulling = (item.bTransparent == false) && (item.bAlphaTested == false);
+		item.meshletDraw = m_pClusterCuller->AddDraw(GetMeshHandle(item), item.model, bBackfaceCulling);
+	}
+	m_pClusterCuller->EndFrame();
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the mesh of an item, at
+ *  its level of detail, with whatever shader state is
+ *  currently set.  The pass has already bound the mesh pool.
+ *  A mesh with meshlets only draws the ones left after
+ *  CullMeshlets().
+ ***********************************************************/
+void SceneManager::DrawMesh(const DRAW_ITEM& item)
+{
+	int handle = GetMeshHandle(item);
+	if (item.meshletDraw >= 0)
+	{
+		m_pClusterCuller->Draw(item.meshletDraw);
+	}
+	else
+	{
+		m_pMeshPool->Draw(handle);
+	}
+	m_renderStats.vertexBytes += m_pMeshPool->GetMeshVertexBytes(handle);
+}
+
+/***********************************************************
+ *  GetMeshTransform()
+ *
+ *  This method is used to get the matrix an item is drawn
+ *  with.  Quantized meshes store their positions from 0 to
+ *  1, so their decode transform is applied first.
+ ***********************************************************/
+glm::mat4 SceneManager::GetMeshTransform(const DRAW_ITEM& item) const
+{
+	return item.model * m_pMeshPool->GetDecodeTransform(GetMeshHandle(item));
+}
+
+/***********************************************************
+ *  RenderForwardItems()
+ *
+ *  This method is used for drawing the opaque or the
+ *  transparent draw items with the forward scene shader.
+ *  The sampler, material and UV scale uniforms are only sent
+ *  when they differ from what the current program already
+ *  has, which the sorted opaque list makes rare.
+ ***********************************************************/
+void SceneManager::RenderForwardItems(bool bTransparent)
+{
+	// the values last sent to the current program, reset when it changes
+	GLuint lastProgram = 0;
+	int lastTextureSlot = -2;
+	int lastMaterialIndex = -2;
+	glm::vec2 lastUVScale(0.0f);
+	bool bUVScaleSent = false;
+	GLuint defaultProgram = m_pShaderManager->m_programID;
+	unsigned int lastVariant = ~0u;
+	bool bUsingVariant = false;
+	m_pMeshPool->Bind();
+	for (const DRAW_ITEM& item : m_drawItems)
+	{
+		// virtual textured items are drawn by RenderVirtualTexturedItems()
+		if ((item.bTransparent != bTransparent) || (item.virtualTexture >= 0))
+		{
+			continue;
+		}
+
+		// the opaque items are sorted, so variants change rarely
+		unsigned int variant = item.sortKey >> SORT_KEY_VARIANT_SHIFT;
+		if ((nullptr != m_pShaderPermutations) && (variant != lastVariant))
+		{
+			bUsingVariant = UseShaderVariant(item.sortKey, defaultProgram);
+			lastVariant = variant;
+		}
+		if (m_pShaderManager->m_programID != lastProgram)
+		{
+			lastProgram = m_pShaderManager->m_programID;
+			lastTextureSlot = -2;
+			lastMaterialIndex = -2;
+			bUVScaleSent = false;
+		}
+
+		m_pShaderManager->setMat4Value(g_ModelName, GetMeshTransform(item));
+		m_renderStats.uniformUploads++;
+		if (bUsingVariant == false)
+		{
+			m_pShaderManager->setIntValue(g_UseTextureName, (item.textureSlot >= 0) ? 1 : 0);
+			m_pShaderManager->setIntValue(g_UseLightingName, item.bLit);
+			m_renderStats.uniformUploads += 2;
+		}
+		if ((item.textureSlot >= 0) && (item.textureSlot != lastTextureSlot))
+		{
+			m_pShaderManager->setSampler2DValue(g_TextureValueName, item.textureSlot);
+			m_renderStats.uniformUploads++;
+			m_renderStats.materialSwitches++;
+			lastTextureSlot = item.textureSlot;
+		}
+		if ((item.materialIndex >= 0) && (item.materialIndex != lastMaterialIndex))
+		{
+			SetMaterialUniforms(m_objectMaterials[item.materialIndex]);
+			m_renderStats.uniformUploads += 5;
+			m_renderStats.materialSwitches++;
+			lastMaterialIndex = item.materialIndex;
+		}
+		if ((bUVScaleSent == false) || (item.uvScale != lastUVScale))
+		{
+			SetTextureUVScale(item.uvScale.x, item.uvScale.y);
+			m_renderStats.uniformUploads++;
+			lastUVScale = item.uvScale;
+			bUVScaleSent = true;
+		}
+
+		DrawMesh(item);
+		m_renderStats.drawCalls++;
+	}
+
+	// leave the single program current for whoever draws next
+	if (m_pShaderManager->m_programID != defaultProgram)
+	{
+		m_pShaderManager->m_programID = defaultProgram;
+		m_pShaderManager->use();
+		m_renderStats.programSwitches++;
+	}
+}
+
+/***********************************************************
+ *  UseShaderVariant()
+ *
+ *  This method is used for making the shader variant of a
+ *  sort key current.  The ShaderManager is pointed at the
+ *  variant so the usual set*Value() calls reach it.  A new
+ *  variant gets the lights, and each variant gets the camera
+ *  the first time it is used in a frame.  Returns false when
+ *  the variant could not be built and the single program,
+ *  with its flag uniforms, has to be used instead.
+ ***********************************************************/
+bool SceneManager::UseShaderVariant(unsigned int sortKey, GLuint defaultProgram)
+{
+	int variant = (int)(sortKey >> SORT_KEY_VARIANT_SHIFT);
+	bool bCreated = false;
+	GLuint program = m_pShaderPermutations->GetProgram(variant, bCreated);
+	if (program == 0)
+	{
+		program = defaultProgram;
+	}
+
+	if (m_pShaderManager->m_programID != program)
+	{
+		m_pShaderManager->m_programID = program;
+		m_pShaderManager->use();
+		m_renderStats.programSwitches++;
+	}
+	if (program == defaultProgram)
+	{
+		return false;
+	}
+
+	if (bCreated || ((m_litVariants & (1u << variant)) == 0))
+	{
+		UploadLightUniforms();
+		m_renderStats.uniformUploads += 1 + 6 * std::min((int)m_lightSources.size(), FORWARD_LIGHT_COUNT);
+		m_litVariants |= (1u << variant);
+	}
+	if ((m_preparedVariants & (1u << variant)) == 0)
+	{
+		m_pShaderManager->setMat4Value("view", m_viewMatrix);
+		m_pShaderManager->setMat4Value("projection", m_projectionMatrix);
+		m_pShaderManager->setVec3Value("viewPosition", m_viewPosition);
+		m_renderStats.uniformUploads += 3;
+		m_preparedVariants |= (1u << variant);
+	}
+	return true;
+}
+
+/***********************************************************
+ *  SortDrawList()
+ *
+ *  This method is used for building the sort key of every
+ *  draw item and ordering the opaque items by it, so items
+ *  sharing a shader variant, texture and material are drawn
+ *  together.  The transparent items keep their order at the
+ *  end of the list, since they are blended back to front.
+ ***********************************************************/
+void SceneManager::SortDrawList()
+{
+	for (DRAW_ITEM& item : m_drawItems)
+	{
+		unsigned int variant = 0;
+		if (item.textureSlot >= 0)
+		{
+			variant |= ShaderPermutations::VARIANT_TEXTURED;
+		}
+		if (item.bLit)
+		{
+			variant |= ShaderPermutations::VARIANT_LIT;
+		}
+		if (item.bAlphaTested)
+		{
+			variant |= ShaderPermutations::VARIANT_ALPHA_TESTED;
+		}
+
+		item.sortKey = (variant << SORT_KEY_VARIANT_SHIFT) |
+			(((unsigned int)(item.textureSlot + 1) & SORT_KEY_FIELD_MASK) << SORT_KEY_TEXTURE_SHIFT) |
+			((unsigned int)(item.materialIndex + 1) & SORT_KEY_FIELD_MASK);
+	}
+
+	std::stable_sort(m_drawItems.begin(), m_drawItems.end(),
+		[](const DRAW_ITEM& a, const DRAW_ITEM& b)
+		{
+			if (a.bTransparent != b.bTransparent)
+			{
+				return b.bTransparent;
+			}
+			return (a.bTransparent == false) && (a.sortKey < b.sortKey);
+		});
+}
+
+/***********************************************************
+ *  EnableShaderVariants()
+ *
+ *  This method is used for switching the forward path from
+ *  the bUseTexture / bUseLighting uniforms to compiled shader
+ *  variants.  Returns false, leaving the single program in
+ *  use, when the shader files cannot be specialized.
+ ***********************************************************/
+bool SceneManager::EnableShaderVariants(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	if (nullptr == m_pShaderPermutations)
+	{
+		m_pShaderPermutations = new ShaderPermutations();
+	}
+	if (m_pShaderPermutations->Load(vertexShaderPath, fragmentShaderPath) == false)
+	{
+		delete m_pShaderPermutations;
+		m_pShaderPermutations = nullptr;
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  RenderDeferred()
+ *
+ *  This method is used for rendering the opaque draw items
+ *  through the G-buffer and the deferred lighting pass.
+ ***********************************************************/
+void SceneManager::RenderDeferred()
+{
+	m_pDeferredRenderer->Resize(m_viewportWidth, m_viewportHeight);
+
+	// geometry pass - every opaque object is drawn once, with no lighting
+	{
+		GpuScope profileScope("geometry pass");
+		m_pDeferredRenderer->BeginGeometryPass(m_viewMatrix, m_projectionMatrix, m_renderStats);
+		m_pMeshPool->Bind();
+		int lastTextureSlot = -2;
+		for (const DRAW_ITEM& item : m_drawItems)
+		{
+			if ((item.bTransparent == false) && (item.virtualTexture < 0))
+			{
+				// the material is a per-draw integer here, so only textures count
+				if (item.textureSlot != lastTextureSlot)
+				{
+					m_renderStats.materialSwitches++;
+					lastTextureSlot = item.textureSlot;
+				}
+				m_pDeferredRenderer->SetDrawItem(item, GetMeshTransform(item), m_renderStats);
+				DrawMesh(item);
+				m_renderStats.drawCalls++;
+			}
+		}
+		m_pDeferredRenderer->EndGeometryPass();
+	}
+
+	// lighting pass - every light is shaded once over the screen
+	{
+		GpuScope profileScope("lighting pass");
+		m_pDeferredRenderer->RunLightingPass(m_lightSources, m_viewPosition, m_targetFramebuffer, m_renderStats);
+	}
+	{
+		GpuScope profileScope("depth copy");
+		m_pDeferredRenderer->CopyDepthTo(m_targetFramebuffer);
+	}
+
+	// the lighting pass used the low texture units, so put the scene
+	// textures and the scene shader back for the forward items
+	m_pShaderManager->use();
+	m_renderStats.programSwitches++;
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  BeginPrimitiveQuery()
+ *
+ *  This method is used for counting the triangles drawn
+ *  this frame.  The query from a few frames back is read
+ *  first, only if its result is already available.
+ ***********************************************************/
+void SceneManager::BeginPrimitiveQuery()
+{
+	if (m_primitiveQueries[0] == 0)
+	{
+		glGenQueries(PRIMITIVE_QUERY_COUNT, m_primitiveQueries);
+	}
+
+	GLuint query = m_primitiveQueries[m_primitiveQueryIndex];
+	if (m_primitiveQueryIssued[m_primitiveQueryIndex])
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available != 0)
+		{
+			GLuint64 primitives = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &primitives);
+			m_lastTriangleCount = (long long)primitives;
+		}
+	}
+	m_renderStats.triangles = m_lastTriangleCount;
+
+	glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+}
+
+/***********************************************************
+ *  EndPrimitiveQuery()
+ *
+ *  This method is used for closing the triangle count query
+ *  of the current frame.
+ ***********************************************************/
+void SceneManager::EndPrimitiveQuery()
+{
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	m_primitiveQueryIssued[m_primitiveQueryIndex] = true;
+	m_primitiveQueryIndex = (m_primitiveQueryIndex + 1) % PRIMITIVE_QUERY_COUNT;
+}
+
+/***********************************************************
+ *  SetRenderPath()
+ *
+ *  This method is used for switching between the forward
+ *  and deferred render paths.  The deferred renderer is
+ *  created the first time it is selected.
+ ***********************************************************/
+bool SceneManager::SetRenderPath(RENDER_PATH renderPath)
+{
+	if ((renderPath == RENDER_PATH_DEFERRED) && (nullptr == m_pDeferredRenderer))
+	{
+		m_pDeferredRenderer = new DeferredRenderer();
+		if (m_pDeferredRenderer->Initialize() == false)
+		{
+			std::cout << "Deferred renderer failed to initialize, staying on the forward path" << std::endl;
+			delete m_pDeferredRenderer;
+			m_pDeferredRenderer = nullptr;
+			return false;
+		}
+		m_pDeferredRenderer->UploadMaterials(m_objectMaterials);
+		if (nullptr != m_pShaderManager)
+		{
+			m_pShaderManager->use();
+		}
+	}
+
+	m_renderPath = renderPath;
+	std::cout << "Render path: " << ((m_renderPath == RENDER_PATH_DEFERRED) ? "deferred" : "forward") << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  OnFramebufferResized()
+ *
+ *  This method is used for resizing the offscreen render
+ *  targets once the display window has changed size.
+ ***********************************************************/
+void SceneManager::OnFramebufferResized(int width, int height)
+{
+	if (nullptr != m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer->Reserve(width, height);
+	}
+}
+
+/***********************************************************
+ *  SetViewParameters()
+ *
+ *  This method is used for passing in the camera values
+ *  for the current frame, which the deferred lighting pass
+ *  needs to rebuild positions from depth.
+ ***********************************************************/
+void SceneManager::SetViewParameters(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition,
+	int viewportWidth,
+	int viewportHeight)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = viewPosition;
+	m_viewportWidth = viewportWidth;
+	m_viewportHeight = viewportHeight;
+}
+
+/***********************************************************
+ *  EnableTextureStreaming()
+ *
+ *  This method is used for loading the textures with only
+ *  their small mips, and streaming in the larger ones as
+ *  the camera gets close, within the passed in budget.  It
+ *  needs the CPU built mips, so images left to the driver
+ *  with SetCpuMipmaps(false) are still fully loaded.
+ ***********************************************************/
+void SceneManager::EnableTextureStreaming(long long budgetBytes)
+{
+	if (nullptr == m_pTextureStreamer)
+	{
+		m_pTextureStreamer = new TextureStreamer();
+	}
+	m_pTextureStreamer->SetBudget(budgetBytes);
+	std::cout << "INFO: Streaming textures within " << (budgetBytes / (1024 * 1024)) << " MB" << std::endl;
+}
+
+/***********************************************************
+ *  UpdateTextureStreaming()
+ *
+ *  This method is used for working out how many texels of
+ *  its texture each visible item covers across the screen,
+ *  and passing that to the texture streamer.  The basic
+ *  meshes fit in a unit box, so the scale of the model
+ *  matrix is how far the texture is stretched, and the
+ *  distance is taken to the mesh's bounding sphere, as for
+ *  the levels of detail.  Items behind the camera ask for
+ *  nothing, and so become the first to be evicted.
+ ***********************************************************/
+void SceneManager::UpdateTextureStreaming()
+{
+	CpuScope profileScope("texture streaming");
+
+	m_pTextureStreamer->BeginFrame();
+
+	// an orthographic projection has the same scale at every distance
+	bool bOrthographic = (m_projectionMatrix[3][3] == 1.0f);
+	float pixelsPerUnit = 0.5f * m_viewportHeight * m_projectionMatrix[1][1];
+	for (const DRAW_ITEM& item : m_drawItems)
+	{
+		if ((item.textureSlot < 0) || (m_textureIDs[item.textureSlot].streamHandle < 0) ||
+			(item.virtualTexture >= 0))
+		{
+			continue;
+		}
+
+		float size = std::max(glm::length(glm::vec3(item.model[0])),
+			std::max(glm::length(glm::vec3(item.model[1])), glm::length(glm::vec3(item.model[2]))));
+		const MESH_LOD_CHAIN& chain = m_meshLods[item.mesh];
+		glm::vec3 center = glm::vec3(item.model * glm::vec4(chain.center, 1.0f));
+		float radius = size * chain.radius;
+		float viewDepth = -(m_viewMatrix * glm::vec4(center, 1.0f)).z;
+		if (viewDepth + radius < 0.0f)
+		{
+			continue;
+		}
+
+		float pixelsAcross = size * pixelsPerUnit;
+		if (bOrthographic == false)
+		{
+			pixelsAcross /= std::max(glm::length(center - m_viewPosition) - radius, STREAM_MIN_DISTANCE);
+		}
+		// a tiled texture repeats, so each repeat covers fewer pixels
+		float texelsAcross = pixelsAcross / std::max(std::max(item.uvScale.x, item.uvScale.y), 1.0f);
+		m_pTextureStreamer->RequestResolution(m_textureIDs[item.textureSlot].streamHandle, texelsAcross);
+	}
+
+	m_pTextureStreamer->Update(m_renderStats);
+}
+
+/***********************************************************
+ *  LoadVirtualTextures()
+ *
+ *  This method is used for opening the page files of the
+ *  surfaces with a very large unique texture.  The page
+ *  files are cooked by TextureCook --virtual, and when none
+ *  of them exist the surfaces keep their tiled textures.
+ ***********************************************************/
+void SceneManager::LoadVirtualTextures(const std::vector<TEXTURE_FILE>& textures)
+{
+	if ((m_bVirtualTextures == false) || textures.empty())
+	{
+		return;
+	}
+
+	m_pVirtualTexturing = new VirtualTexturing();
+	if (m_pVirtualTexturing->Initialize(16) == false)
+	{
+		std::cout << "Virtual texturing failed to initialize, using the tiled textures" << std::endl;
+		delete m_pVirtualTexturing;
+		m_pVirtualTexturing = nullptr;
+		return;
+	}
+
+	for (const TEXTURE_FILE& texture : textures)
+	{
+		m_pVirtualTexturing->AddTexture(texture.filename.c_str(), texture.tag);
+	}
+	if (m_pVirtualTexturing->GetTextureCount() == 0)
+	{
+		delete m_pVirtualTexturing;
+		m_pVirtualTexturing = nullptr;
+	}
+}
+
+/***********************************************************
+ *  SetVirtualTexture()
+ *
+ *  This method is used for drawing the last added item with
+ *  a virtual texture.  Nothing changes if it was not loaded.
+ ***********************************************************/
+void SceneManager::SetVirtualTexture(std::string tag)
+{
+	if ((nullptr == m_pVirtualTexturing) || m_drawItems.empty())
+	{
+		return;
+	}
+	m_drawItems.back().virtualTexture = m_pVirtualTexturing->FindTexture(tag);
+}
+
+/***********************************************************
+ *  RenderVirtualTextureFeedback()
+ *
+ *  This method is used for loading the pages asked for by
+ *  an earlier frame, then drawing the virtual textured
+ *  items into the small feedback target to find the pages
+ *  this frame needs.
+ ***********************************************************/
+void SceneManager::RenderVirtualTextureFeedback()
+{
+	GpuScope profileScope("virtual texture feedback");
+
+	m_pVirtualTexturing->Update(m_renderStats);
+
+	m_pVirtualTexturing->BeginFeedbackPass(m_viewMatrix, m_projectionMatrix,
+		m_viewportWidth, m_viewportHeight, m_renderStats);
+	m_pMeshPool->Bind();
+	for (const DRAW_ITEM& item : m_drawItems)
+	{
+		if (item.virtualTexture >= 0)
+		{
+			m_pVirtualTexturing->SetFeedbackItem(GetMeshTransform(item), item.virtualTexture, m_renderStats);
+			DrawMesh(item);
+			m_renderStats.drawCalls++;
+		}
+	}
+	m_pVirtualTexturing->EndFeedbackPass();
+
+	m_pShaderManager->use();
+	m_renderStats.programSwitches++;
+}
+
+/***********************************************************
+ *  RenderVirtualTexturedItems()
+ *
+ *  This method is used for drawing the virtual textured
+ *  items with their own forward program, on top of the
+ *  opaque pass of either render path.
+ ***********************************************************/
+void SceneManager::RenderVirtualTexturedItems()
+{
+	GpuScope profileScope("virtual textures");
+
+	m_pVirtualTexturing->BeginDrawPass(m_viewMatrix, m_projectionMatrix,
+		m_viewPosition, m_lightSources, m_renderStats);
+	m_pMeshPool->Bind();
+	for (const DRAW_ITEM& item : m_drawItems)
+	{
+		if ((item.virtualTexture >= 0) && (item.materialIndex >= 0))
+		{
+			m_pVirtualTexturing->SetDrawItem(GetMeshTransform(item), item.virtualTexture,
+				m_objectMaterials[item.materialIndex], m_renderStats);
+			DrawMesh(item);
+			m_renderStats.drawCalls++;
+		}
+	}
+
+	// the page cache and page table used the low texture units
+	m_pShaderManager->use();
+	m_renderStats.programSwitches++;
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for reading the scene file, when one
+ *  was set.  Returns false, so the scene written in code is
+ *  drawn, when there is no file or it has an error.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(SceneDescription& scene)
+{
+	if (m_sceneFile.empty())
+	{
+		return false;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (SceneFile::Load(m_sceneFile.c_str(), scene) == false)
+	{
+		std::cout << "INFO: Drawing the scene written in code, " << m_sceneFile << " was not loaded" << std::endl;
+		return false;
+	}
+
+	std::cout << "INFO: Loaded scene " << m_sceneFile << " with " << scene.objects.size() << " objects, "
+		<< scene.materials.size() << " materials and " << scene.lights.size() << " lights in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+		<< " ms" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  SetSceneMaterials()
+ *
+ *  This method is used for defining the materials listed in
+ *  a scene file, in place of DefineObjectMaterials().
+ ***********************************************************/
+void SceneManager::SetSceneMaterials(const SceneDescription& scene)
+{
+	m_objectMaterials.clear();
+	for (const SceneDescription::MATERIAL_ENTRY& entry : scene.materials)
+	{
+		m_objectMaterials.push_back(MakeMaterial(entry));
+	}
+}
+
+/***********************************************************
+ *  SetSceneLights()
+ *
+ *  This method is used for setting up the lights listed in
+ *  a scene file, in place of SetupSceneLights().
+ ***********************************************************/
+void SceneManager::SetSceneLights(const SceneDescription& scene)
+{
+	m_lightSources.clear();
+	for (const SceneDescription::LIGHT_ENTRY& entry : scene.lights)
+	{
+		m_lightSources.push_back(MakeLight(entry));
+	}
+
+	UploadLightUniforms();
+}
+
+/***********************************************************
+ *  BindSceneTables()
+ *
+ *  This method is used for looking up every mesh, texture
+ *  and material of a scene file once, so the objects, of
+ *  which there may be very many, only index arrays.
+ ***********************************************************/
+void SceneManager::BindSceneTables(const SceneDescription& scene, SCENE_BINDINGS& bindings)
+{
+	bindings.meshes.assign(scene.meshes.size(), -1);
+	for (size_t i = 0; i < scene.meshes.size(); i++)
+	{
+		const SceneDescription::MESH_ENTRY& mesh = scene.meshes[i];
+		if (mesh.filename.empty() == false)
+		{
+			bindings.meshes[i] = (mesh.contentHash != 0) ? FindImportedMeshByContent(mesh.contentHash) : FindImportedMesh(mesh.tag);
+			continue;
+		}
+		for (int type = 0; type < SceneFile::BASIC_MESH_COUNT; type++)
+		{
+			if (mesh.tag == SceneFile::BASIC_MESH_NAMES[type])
+			{
+				bindings.meshes[i] = type;
+			}
+		}
+	}
+
+	bindings.textureSlots.assign(scene.textures.size(), -1);
+	for (size_t i = 0; i < scene.textures.size(); i++)
+	{
+		const SceneDescription::TEXTURE_ENTRY& texture = scene.textures[i];
+		bindings.textureSlots[i] = (texture.contentHash != 0) ? FindTextureByContent(texture.contentHash) : FindTextureSlot(texture.tag);
+		if (bindings.textureSlots[i] < 0)
+		{
+			std::cout << "Draw items use unloaded texture:" << scene.textures[i].tag << std::endl;
+		}
+	}
+
+	bindings.materials.assign(scene.materials.size(), -1);
+	for (size_t i = 0; i < scene.materials.size(); i++)
+	{
+		bindings.materials[i] = FindMaterialIndex(scene.materials[i].tag);
+	}
+	// textured objects are lit with the "default" material
+	bindings.defaultMaterial = FindMaterialIndex("default");
+
+	bindings.virtualTextures.assign(scene.virtualTextures.size(), -1);
+	for (size_t i = 0; (i < scene.virtualTextures.size()) && (nullptr != m_pVirtualTexturing); i++)
+	{
+		bindings.virtualTextures[i] = m_pVirtualTexturing->FindTexture(scene.virtualTextures[i].tag);
+	}
+}
+
+/***********************************************************
+ *  MakeSceneDrawItem()
+ *
+ *  This method is used for building the draw item of one
+ *  object of a scene file.  Returns false when the object
+ *  is not drawn: its model did not load, or it stands in
+ *  for a model that did.
+ ***********************************************************/
+bool SceneManager::MakeSceneDrawItem(const SceneDescription& scene, int object, const SCENE_BINDINGS& bindings, DRAW_ITEM& item)
+{
+	const SceneDescription::OBJECT_ENTRY& entry = scene.objects[object];
+	if ((bindings.meshes[entry.mesh] < 0) ||
+		((entry.fallbackFor >= 0) && (bindings.meshes[entry.fallbackFor] >= 0)))
+	{
+		return false;
+	}
+
+	item.mesh = bindings.meshes[entry.mesh];
+	item.model = BuildTransformation(
+		glm::vec3(entry.scale[0], entry.scale[1], entry.scale[2]),
+		entry.rotation[0], entry.rotation[1], entry.rotation[2],
+		glm::vec3(entry.position[0], entry.position[1], entry.position[2]));
+	item.textureSlot = (entry.texture >= 0) ? bindings.textureSlots[entry.texture] : -1;
+	if (entry.material >= 0)
+	{
+		item.materialIndex = bindings.materials[entry.material];
+	}
+	else
+	{
+		item.materialIndex = (entry.texture >= 0) ? bindings.defaultMaterial : -1;
+	}
+	item.uvScale = glm::vec2(entry.uvScale[0], entry.uvScale[1]);
+	item.bTransparent = (entry.flags & SceneDescription::OBJECT_TRANSPARENT) != 0;
+	item.bLit = (entry.flags & SceneDescription::OBJECT_UNLIT) == 0;
+	item.bAlphaTested = (entry.flags & SceneDescription::OBJECT_ALPHA_TESTED) != 0;
+	item.virtualTexture = (entry.virtualTexture >= 0) ? bindings.virtualTextures[entry.virtualTexture] : -1;
+	item.lod = 0;
+	item.meshletDraw = -1;
+	item.sceneObject = object;
+	item.sortKey = 0;
+	return true;
+}
+
+/***********************************************************
+ *  BuildDrawListFromScene()
+ *
+ *  This method is used for building the list of objects
+ *  from a scene file, in place of BuildSceneDrawList().
+ ***********************************************************/
+void SceneManager::BuildDrawListFromScene(const SceneDescription& scene)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	BindSceneTables(scene, m_sceneBindings);
+
+	m_drawItems.clear();
+	m_drawItems.reserve(scene.objects.size());
+	DRAW_ITEM item;
+	for (int object = 0; object < (int)scene.objects.size(); object++)
+	{
+		if (MakeSceneDrawItem(scene, object, m_sceneBindings, item))
+		{
+			m_drawItems.push_back(item);
+		}
+	}
+	SortDrawList();
+
+	std::cout << "INFO: Built " << m_drawItems.size() << " draw items in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+		<< " ms" << std::endl;
+}
+
+/***********************************************************
+ *  SetAssetHashes()
+ *
+ *  This method is used for recording the content hash of
+ *  each texture and model loaded from a scene file - the
+ *  slots that have none yet and the meshes from the passed
+ *  in one on - so a later edit of the file can find them by
+ *  what they hold.  The models that did not load are kept
+ *  too, so they are not tried again until they change.
+ ***********************************************************/
+void SceneManager::SetAssetHashes(const SceneDescription& scene, size_t firstMesh)
+{
+	for (int slot = 0; slot < m_loadedTextures; slot++)
+	{
+		if ((m_textureIDs[slot].ID == 0) || (m_textureIDs[slot].contentHash != 0))
+		{
+			continue;
+		}
+		for (const SceneDescription::TEXTURE_ENTRY& texture : scene.textures)
+		{
+			if (texture.tag == m_textureIDs[slot].tag)
+			{
+				m_textureIDs[slot].contentHash = texture.contentHash;
+				break;
+			}
+		}
+	}
+	for (size_t i = firstMesh; i < m_meshLods.size(); i++)
+	{
+		for (const SceneDescription::MESH_ENTRY& mesh : scene.meshes)
+		{
+			if ((mesh.filename.empty() == false) && (mesh.tag == m_meshLods[i].tag))
+			{
+				m_meshLods[i].contentHash = mesh.contentHash;
+				break;
+			}
+		}
+	}
+	for (const SceneDescription::MESH_ENTRY& mesh : scene.meshes)
+	{
+		if ((mesh.filename.empty() == false) && (FindImportedMeshByContent(mesh.contentHash) < 0) &&
+			(std::find(m_failedMeshes.begin(), m_failedMeshes.end(), mesh.contentHash) == m_failedMeshes.end()))
+		{
+			m_failedMeshes.push_back(mesh.contentHash);
+		}
+	}
+}
+
+/***********************************************************
+ *  LoadSceneAssets()
+ *
+ *  This method is used for loading what an edited scene
+ *  file adds: the models and textures whose content is not
+ *  loaded yet, and the virtual textures not yet opened.  An
+ *  asset that is already loaded is reused, even when it has
+ *  been renamed, and a file that was changed on disk loads
+ *  as a new asset.  A model that failed to load is skipped
+ *  until its cooked file changes.  The textures the edited
+ *  file no longer lists are deleted first, so their slots
+ *  can be used again; the meshes stay in the pool.
+ ***********************************************************/
+void SceneManager::LoadSceneAssets(const SceneDescription& scene, int& loadedMeshes, int& loadedTextures)
+{
+	std::vector<MESH_FILE> meshes;
+	for (size_t i = 0; i < scene.meshes.size(); i++)
+	{
+		const SceneDescription::MESH_ENTRY& mesh = scene.meshes[i];
+		bool bListed = (mesh.filename.empty() || (FindImportedMeshByContent(mesh.contentHash) >= 0) ||
+			(std::find(m_failedMeshes.begin(), m_failedMeshes.end(), mesh.contentHash) != m_failedMeshes.end()));
+		for (size_t j = 0; (j < i) && !bListed; j++)
+		{
+			bListed = (scene.meshes[j].contentHash == mesh.contentHash);
+		}
+		if (bListed == false)
+		{
+			meshes.push_back({ mesh.filename, mesh.tag });
+		}
+	}
+
+	std::vector<TEXTURE_FILE> textures;
+	for (size_t i = 0; i < scene.textures.size(); i++)
+	{
+		const SceneDescription::TEXTURE_ENTRY& texture = scene.textures[i];
+		bool bListed = (FindTextureByContent(texture.contentHash) >= 0);
+		for (size_t j = 0; (j < i) && !bListed; j++)
+		{
+			bListed = (scene.textures[j].contentHash == texture.contentHash);
+		}
+		if (bListed == false)
+		{
+			textures.push_back({ texture.filename, texture.tag });
+		}
+	}
+
+	// the items still drawn from a texture the edited file does not list
+	// are all rebuilt or dropped by ReloadScene(), so its slot is free
+	int slotsUsed = 0;
+	for (int slot = 0; slot < m_loadedTextures; slot++)
+	{
+		bool bListed = (m_textureIDs[slot].contentHash == 0);
+		for (size_t i = 0; (i < scene.textures.size()) && !bListed; i++)
+		{
+			bListed = (scene.textures[i].contentHash == m_textureIDs[slot].contentHash);
+		}
+		if ((bListed == false) && (m_textureIDs[slot].ID != 0))
+		{
+			FreeTextureSlot(slot);
+		}
+		if (m_textureIDs[slot].ID != 0)
+		{
+			slotsUsed++;
+		}
+	}
+
+	size_t firstMesh = m_meshLods.size();
+	if (meshes.empty() == false)
+	{
+		LoadImportedMeshes(meshes);
+	}
+	if (textures.empty() == false)
+	{
+		CreateGLTextures(textures);
+	}
+	SetAssetHashes(scene, firstMesh);
+	loadedMeshes = (int)(m_meshLods.size() - firstMesh);
+	loadedTextures = 0;
+	for (int slot = 0; slot < m_loadedTextures; slot++)
+	{
+		if (m_textureIDs[slot].ID != 0)
+		{
+			loadedTextures++;
+		}
+	}
+	loadedTextures -= slotsUsed;
+
+	// the page files are matched by tag, they are too large to hash
+	std::vector<TEXTURE_FILE> virtualTextures;
+	for (const SceneDescription::TEXTURE_ENTRY& texture : scene.virtualTextures)
+	{
+		if ((nullptr == m_pVirtualTexturing) || (m_pVirtualTexturing->FindTexture(texture.tag) < 0))
+		{
+			virtualTextures.push_back({ texture.filename, texture.tag });
+		}
+	}
+	if (nullptr == m_pVirtualTexturing)
+	{
+		LoadVirtualTextures(virtualTextures);
+	}
+	else
+	{
+		for (const TEXTURE_FILE& texture : virtualTextures)
+		{
+			m_pVirtualTexturing->AddTexture(texture.filename.c_str(), texture.tag);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateSceneMaterials()
+ *
+ *  This method is used for updating the materials to those
+ *  of an edited scene file.  A material keeps its index,
+ *  so the items using it need no change, and one that is
+ *  no longer listed is left in place.  Returns the number
+ *  of materials that were changed or added.
+ ***********************************************************/
+int SceneManager::UpdateSceneMaterials(const SceneDescription& scene)
+{
+	int changed = 0;
+	for (const SceneDescription::MATERIAL_ENTRY& entry : scene.materials)
+	{
+		OBJECT_MATERIAL material = MakeMaterial(entry);
+		int index = FindMaterialIndex(entry.tag);
+		if (index < 0)
+		{
+			m_objectMaterials.push_back(material);
+			changed++;
+		}
+		else if ((m_objectMaterials[index].ambientColor != material.ambientColor) ||
+			(m_objectMaterials[index].ambientStrength != material.ambientStrength) ||
+			(m_objectMaterials[index].diffuseColor != material.diffuseColor) ||
+			(m_objectMaterials[index].specularColor != material.specularColor) ||
+			(m_objectMaterials[index].shininess != material.shininess))
+		{
+			m_objectMaterials[index] = material;
+			changed++;
+		}
+	}
+
+	// the forward path sets the material of each item as it is drawn
+	if ((changed > 0) && (nullptr != m_pDeferredRenderer))
+	{
+		m_pDeferredRenderer->UploadMaterials(m_objectMaterials);
+	}
+	return(changed);
+}
+
+/***********************************************************
+ *  UpdateSceneLights()
+ *
+ *  This method is used for replacing the lights with those
+ *  of an edited scene file.  The uniforms are only sent
+ *  again when a light changed - to the single program now,
+ *  and to each shader variant the next time it is drawn.
+ ***********************************************************/
+bool SceneManager::UpdateSceneLights(const SceneDescription& scene)
+{
+	std::vector<LIGHT_SOURCE> lights;
+	for (const SceneDescription::LIGHT_ENTRY& entry : scene.lights)
+	{
+		lights.push_back(MakeLight(entry));
+	}
+
+	// the light fields are all floats, so they can be compared as bytes
+	if ((lights.size() == m_lightSources.size()) &&
+		(lights.empty() || (memcmp(lights.data(), m_lightSources.data(), lights.size() * sizeof(LIGHT_SOURCE)) == 0)))
+	{
+		return false;
+	}
+
+	m_lightSources.swap(lights);
+	m_pShaderManager->use();
+	UploadLightUniforms();
+	m_litVariants = 0;
+	return true;
+}
+
+/***********************************************************
+ *  IsSceneObjectUnchanged()
+ *
+ *  This method is used for checking whether an object of an
+ *  edited scene file draws the same as one of the applied
+ *  file.  The records have to match, and so does what their
+ *  indices resolved to, since a renamed texture or a model
+ *  that has just been cooked changes the item without
+ *  changing the object line.
+ ***********************************************************/
+bool SceneManager::IsSceneObjectUnchanged(int oldObject, const SceneDescription& scene, int object, const SCENE_BINDINGS& bindings) const
+{
+	const SceneDescription::OBJECT_ENTRY& before = m_pScene->objects[oldObject];
+	const SceneDescription::OBJECT_ENTRY& entry = scene.objects[object];
+	if (memcmp(&before, &entry, sizeof(SceneDescription::OBJECT_ENTRY)) != 0)
+	{
+		return false;
+	}
+
+	const SCENE_BINDINGS& applied = m_sceneBindings;
+	if ((applied.meshes[entry.mesh] != bindings.meshes[entry.mesh]) ||
+		((entry.fallbackFor >= 0) && (applied.meshes[entry.fallbackFor] != bindings.meshes[entry.fallbackFor])) ||
+		((entry.texture >= 0) && (applied.textureSlots[entry.texture] != bindings.textureSlots[entry.texture])) ||
+		((entry.material >= 0) && (applied.materials[entry.material] != bindings.materials[entry.material])) ||
+		((entry.virtualTexture >= 0) && (applied.virtualTextures[entry.virtualTexture] != bindings.virtualTextures[entry.virtualTexture])))
+	{
+		return false;
+	}
+	return((entry.material >= 0) || (entry.texture < 0) || (applied.defaultMaterial == bindings.defaultMaterial));
+}
+
+/***********************************************************
+ *  ReloadScene()
+ *
+ *  This method is used for applying an edited scene file to
+ *  the running scene without preparing it again.  Assets
+ *  that are already loaded are reused by content, materials
+ *  and lights are updated in place, and only the items of
+ *  the objects that changed are rebuilt.  With the same
+ *  number of objects they are compared one to one and
+ *  rebuilt where they are in the list; otherwise the runs of
+ *  unchanged objects at the start and end are kept.  The
+ *  list is only sorted again when an item was added or its
+ *  shader, texture or material changed.
+ ***********************************************************/
+void SceneManager::ReloadScene(SceneDescription& scene)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int loadedMeshes = 0;
+	int loadedTextures = 0;
+	LoadSceneAssets(scene, loadedMeshes, loadedTextures);
+	int changedMaterials = UpdateSceneMaterials(scene);
+	bool bLightsChanged = UpdateSceneLights(scene);
+
+	SCENE_BINDINGS bindings;
+	BindSceneTables(scene, bindings);
+
+	// where each applied object is in the edited file, -1 when it changed or was removed
+	int oldCount = (nullptr != m_pScene) ? (int)m_pScene->objects.size() : 0;
+	int newCount = (int)scene.objects.size();
+	std::vector<int> oldToNew(oldCount, -1);
+	// the objects of the edited file that need their items built
+	std::vector<char> bDirty(newCount, 1);
+	if (oldCount == newCount)
+	{
+		for (int object = 0; object < newCount; object++)
+		{
+			if (IsSceneObjectUnchanged(object, scene, object, bindings))
+			{
+				oldToNew[object] = object;
+				bDirty[object] = 0;
+			}
+		}
+	}
+	else
+	{
+		// a line added or removed shifts the objects after it
+		int common = std::min(oldCount, newCount);
+		int prefix = 0;
+		while ((prefix < common) && IsSceneObjectUnchanged(prefix, scene, prefix, bindings))
+		{
+			oldToNew[prefix] = prefix;
+			bDirty[prefix] = 0;
+			prefix++;
+		}
+		for (int suffix = 1; (suffix <= common - prefix) &&
+			IsSceneObjectUnchanged(oldCount - suffix, scene, newCount - suffix, bindings); suffix++)
+		{
+			oldToNew[oldCount - suffix] = newCount - suffix;
+			bDirty[newCount - suffix] = 0;
+		}
+	}
+
+	// keep the items of the unchanged objects in their sorted order, and
+	// drop the rest - including the items of the scene written in code
+	bool bResort = false;
+	int updated = 0;
+	int removed = 0;
+	size_t kept = 0;
+	for (size_t i = 0; i < m_drawItems.size(); i++)
+	{
+		DRAW_ITEM& item = m_drawItems[i];
+		if ((item.sceneObject >= 0) && (oldToNew[item.sceneObject] >= 0))
+		{
+			item.sceneObject = oldToNew[item.sceneObject];
+		}
+		else if ((item.sceneObject >= 0) && (oldCount == newCount))
+		{
+			bDirty[item.sceneObject] = 0;
+			DRAW_ITEM rebuilt;
+			if (MakeSceneDrawItem(scene, item.sceneObject, bindings, rebuilt) == false)
+			{
+				removed++;
+				continue;
+			}
+			if ((rebuilt.textureSlot != item.textureSlot) || (rebuilt.materialIndex != item.materialIndex) ||
+				(rebuilt.bLit != item.bLit) || (rebuilt.bAlphaTested != item.bAlphaTested) ||
+				(rebuilt.bTransparent != item.bTransparent))
+			{
+				bResort = true;
+			}
+			if (rebuilt.mesh == item.mesh)
+			{
+				rebuilt.lod = item.lod;
+			}
+			rebuilt.sortKey = item.sortKey;
+			item = rebuilt;
+			updated++;
+		}
+		else
+		{
+			removed++;
+			continue;
+		}
+		if (kept != i)
+		{
+			m_drawItems[kept] = item;
+		}
+		kept++;
+	}
+	m_drawItems.erase(m_drawItems.begin() + kept, m_drawItems.end());
+
+	int added = 0;
+	DRAW_ITEM item;
+	for (int object = 0; object < newCount; object++)
+	{
+		if ((bDirty[object] != 0) && MakeSceneDrawItem(scene, object, bindings, item))
+		{
+			m_drawItems.push_back(item);
+			added++;
+		}
+	}
+	if ((added > 0) || bResort)
+	{
+		SortDrawList();
+	}
+
+	if (nullptr == m_pScene)
+	{
+		m_pScene = new SceneDescription();
+	}
+	std::swap(*m_pScene, scene);
+	std::swap(m_sceneBindings, bindings);
+
+	std::cout << "INFO: Reloaded scene in " << std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count() << " ms: " << updated << " items updated, "
+		<< added << " added, " << removed << " removed, " << changedMaterials << " materials changed, lights "
+		<< (bLightsChanged ? "changed" : "unchanged") << ", " << loadedTextures << " textures and "
+		<< loadedMeshes << " models loaded" << std::endl;
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+// Adding in a DefineObjectMaterials helper here for creating a wine bottle (with wine)
+void SceneManager::DefineObjectMaterials() {
+
+	// Adding a "default" material here, for the textures to use.
+	OBJECT_MATERIAL def;
+	def.ambientColor = glm::vec3(1.0);
+	def.ambientStrength = 0.0f;
+	def.diffuseColor = glm::vec3(1.0f);
+	def.specularColor = glm::vec3(0.1f);
+	def.shininess = 16.0f;
+	def.tag = "default";
+	m_objectMaterials.push_back(def);
+
+	// Adding a wine bottle material
+	OBJECT_MATERIAL wine;
+	wine.ambientColor = glm::vec3(0.2f, 0.005f, 0.2f);  // Creating a dark color
+	wine.ambientStrength = 0.15f;
+	wine.diffuseColor = glm::vec3(0.1f, 0.05f, 0.1f);  // Creating a purple hue
+	wine.specularColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	wine.shininess = 180.0f;   // making the glass shiny
+	wine.tag = "wineBottle";
 	m_objectMaterials.push_back(wine);
 
 	// Adding 3 new materials here (to avoid hitting the texture cap) for the three books on the desk;
@@ -442,27 +2654,81 @@ void SceneManager::DefineObjectMaterials() {
 // Adding in a SetupSceneLights() helper here for creating lighting for the scene.
 void SceneManager::SetupSceneLights() {
 
-	// Turning on the lights
-	m_pShaderManager->setBoolValue("bUseLighting", true);
+	LIGHT_SOURCE light;
+	m_lightSources.clear();
 
 	// Creating the first light (Light [0] ) to create a very soft, white fill - similar
 	// To soft, natural sunlight.
-	m_pShaderManager->setVec3Value("lightSources[0].position", 20.0f, 30.0f, 3.0f);
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.1f, 0.1f, 0.1f);
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.3f, 0.3f, 0.3f);
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 32.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.0f);
+	light.position = glm::vec3(20.0f, 30.0f, 3.0f);
+	light.ambientColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	light.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	light.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	light.focalStrength = 32.0f;
+	light.specularIntensity = 0.0f;
+	light.radius = 0.0f;
+	m_lightSources.push_back(light);
 
 	// Creating the second light (Light [1] ) to create a faint, soft, yellowish light,
 	// Hoping to emulate the faint hint of sunlight without being overpowering.
-	m_pShaderManager->setVec3Value("lightSources[1].position", 50.0f, 0.0f, 20.0f);
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.1f, 0.08f, 0.04f);
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.9f, 0.75f, 0.4f);
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.8f, 0.7f, 0.5f);
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.0f);
+	light.position = glm::vec3(50.0f, 0.0f, 20.0f);
+	light.ambientColor = glm::vec3(0.1f, 0.08f, 0.04f);
+	light.diffuseColor = glm::vec3(0.9f, 0.75f, 0.4f);
+	light.specularColor = glm::vec3(0.8f, 0.7f, 0.5f);
+	light.focalStrength = 1.0f;
+	light.specularIntensity = 0.0f;
+	light.radius = 0.0f;
+	m_lightSources.push_back(light);
 
+	UploadLightUniforms();
+
+}
+
+/***********************************************************
+ *  UploadLightUniforms()
+ *
+ *  This method is used to pass the scene lights into the
+ *  forward shader.
+ ***********************************************************/
+void SceneManager::UploadLightUniforms()
+{
+	// Turning on the lights
+	m_pShaderManager->setBoolValue("bUseLighting", true);
+
+	// the forward shader only has room for a fixed number of lights,
+	// the deferred path reads every light from m_lightSources
+	for (int i = 0; (i < (int)m_lightSources.size()) && (i < FORWARD_LIGHT_COUNT); i++)
+	{
+		std::string lightName = "lightSources[" + std::to_string(i) + "]";
+		m_pShaderManager->setVec3Value(lightName + ".position", m_lightSources[i].position);
+		m_pShaderManager->setVec3Value(lightName + ".ambientColor", m_lightSources[i].ambientColor);
+		m_pShaderManager->setVec3Value(lightName + ".diffuseColor", m_lightSources[i].diffuseColor);
+		m_pShaderManager->setVec3Value(lightName + ".specularColor", m_lightSources[i].specularColor);
+		m_pShaderManager->setFloatValue(lightName + ".focalStrength", m_lightSources[i].focalStrength);
+		m_pShaderManager->setFloatValue(lightName + ".specularIntensity", m_lightSources[i].specularIntensity);
+	}
+}
+
+/***********************************************************
+ *  OnShaderReloaded()
+ *
+ *  This method is used after the scene program has been
+ *  replaced.  A new program starts with all of its uniforms
+ *  at their defaults, so the values that are only set once
+ *  at startup have to be sent again.  Everything else is set
+ *  by RenderScene() each frame.
+ ***********************************************************/
+void SceneManager::OnShaderReloaded()
+{
+	m_pShaderManager->use();
+	UploadLightUniforms();
+
+	// the variants are rebuilt from the edited files in the background,
+	// and keep drawing with their old programs until they link
+	if ((nullptr != m_pShaderPermutations) && (m_pShaderPermutations->Reload() == false))
+	{
+		delete m_pShaderPermutations;
+		m_pShaderPermutations = nullptr;
+	}
 }
 
 /***********************************************************
@@ -476,262 +2742,282 @@ void SceneManager::PrepareScene()
 {
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	// in the rendered 3D scene - the plane, box (desk and other
+	// objects), tapered cylinder (vase), cylinder (flower stems),
+	// pyramid (PC monitor's base) and the sphere and half-sphere
+	// (wine bottle) all go into one shared mesh pool
+	if (m_bMeshletCulling && (nullptr == m_pClusterCuller))
+	{
+		m_pClusterCuller = new ClusterCuller();
+		m_pClusterCuller->Initialize();
+	}
+	LoadBasicMeshes();
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadBoxMesh();  // Loading Box Mesh method to create Desk and other objects
-	m_basicMeshes->LoadTaperedCylinderMesh();  // Loading a Tapered Cylinder Mesh, to create a vase for flowers
-	m_basicMeshes->LoadCylinderMesh();  // Loading a Cylinder Mesh, to create the stems for the flowers
-	m_basicMeshes->LoadPyramid4Mesh();  // Loading a Pyramid Mesh, for the PC monitor's base
-	m_basicMeshes->LoadSphereMesh();  // Loading a Sphere mesh, to use for a half-sphere for the wine bottle
+	// the layout is read from the scene file when there is one, and
+	// otherwise comes from the code in the methods below
+	SceneDescription scene;
+	bool bSceneFile = LoadSceneFile(scene);
+
+	// models cooked with MeshCook, drawn in place of the shapes they stand in for
+	std::vector<MESH_FILE> meshes = { { "../../Utilities/models/wine_bottle.obj", "wineBottle" } };
 
 	// Creating the use of the textures to be used for the various objects
-	CreateGLTexture("../../Utilities/textures/floor_tile.jpg", "floorTile");
-	CreateGLTexture("../../Utilities/textures/desk_wood.jpg", "deskWood");
-	CreateGLTexture("../../Utilities/textures/desk_metal.jpg", "deskBlotter");
-	CreateGLTexture("../../Utilities/textures/flower_stem.png", "stem");
-	CreateGLTexture("../../Utilities/textures/clay_vase.png", "clay");
-	CreateGLTexture("../../Utilities/textures/red_petal.png", "red_petal");
-	CreateGLTexture("../../Utilities/textures/blue_petal.png", "blue_petal");
-	CreateGLTexture("../../Utilities/textures/pc_desktop.png", "pc_desktop");
-	CreateGLTexture("../../Utilities/textures/pc_plastic.png", "pc_plastic");
-	CreateGLTexture("../../Utilities/textures/knife_handle.jpg", "knife_handle");
-	CreateGLTexture("../../Utilities/textures/stainless_end.jpg", "stainless");
-	CreateGLTexture("../../Utilities/textures/bottle_holder.png", "bottle_holder");
-	CreateGLTexture("../../Utilities/textures/white_paint.png", "white_paint");
-	CreateGLTexture("../../Utilities/textures/white_paint_2.png", "white_accent");
-	CreateGLTexture("../../Utilities/textures/book_pages.png", "book_pages");
+	// (decoded together on worker threads, see CreateGLTextures())
+	std::vector<TEXTURE_FILE> textures = {
+		{ "../../Utilities/textures/floor_tile.jpg", "floorTile" },
+		{ "../../Utilities/textures/desk_wood.jpg", "deskWood" },
+		{ "../../Utilities/textures/desk_metal.jpg", "deskBlotter" },
+		{ "../../Utilities/textures/flower_stem.png", "stem" },
+		{ "../../Utilities/textures/clay_vase.png", "clay" },
+		{ "../../Utilities/textures/red_petal.png", "red_petal" },
+		{ "../../Utilities/textures/blue_petal.png", "blue_petal" },
+		{ "../../Utilities/textures/pc_desktop.png", "pc_desktop" },
+		{ "../../Utilities/textures/pc_plastic.png", "pc_plastic" },
+		{ "../../Utilities/textures/knife_handle.jpg", "knife_handle" },
+		{ "../../Utilities/textures/stainless_end.jpg", "stainless" },
+		{ "../../Utilities/textures/bottle_holder.png", "bottle_holder" },
+		{ "../../Utilities/textures/white_paint.png", "white_paint" },
+		{ "../../Utilities/textures/white_paint_2.png", "white_accent" },
+		{ "../../Utilities/textures/book_pages.png", "book_pages" }
+	};
+
+	// the surfaces with a very large unique texture
+	std::vector<TEXTURE_FILE> virtualTextures = {
+		{ "../../Utilities/textures/floor_unique.vtex", "floorUnique" },
+		{ "../../Utilities/textures/back_wall_unique.vtex", "backWallUnique" }
+	};
+
+	if (bSceneFile)
+	{
+		meshes.clear();
+		for (const SceneDescription::MESH_ENTRY& mesh : scene.meshes)
+		{
+			if (mesh.filename.empty() == false)
+			{
+				meshes.push_back({ mesh.filename, mesh.tag });
+			}
+		}
+		textures.clear();
+		for (const SceneDescription::TEXTURE_ENTRY& texture : scene.textures)
+		{
+			textures.push_back({ texture.filename, texture.tag });
+		}
+		virtualTextures.clear();
+		for (const SceneDescription::TEXTURE_ENTRY& texture : scene.virtualTextures)
+		{
+			virtualTextures.push_back({ texture.filename, texture.tag });
+		}
+	}
 
-	// Calling the helper DefineOjectMaterials() to load in the wine bottle's material.
-	DefineObjectMaterials();
+	// hash what is loaded, so an edit of the scene file can reuse it - the
+	// lists of the scene written in code are hashed the same way
+	if (m_bSceneReload)
+	{
+		if (bSceneFile == false)
+		{
+			for (const MESH_FILE& mesh : meshes)
+			{
+				scene.meshes.push_back({ mesh.tag, mesh.filename, 0 });
+			}
+			for (const TEXTURE_FILE& texture : textures)
+			{
+				scene.textures.push_back({ texture.tag, texture.filename, 0 });
+			}
+		}
+		SceneFile::HashAssets(scene);
+	}
 
-	// Calling the helper SetupSceneLights() here to load in the lighting for the scene.
-	SetupSceneLights();
+	LoadImportedMeshes(meshes);
 
-}
+	// time the texture loads, to compare the pack, cooked and source files
+	std::chrono::steady_clock::time_point textureStart = std::chrono::steady_clock::now();
+	CreateGLTextures(textures);
 
-/***********************************************************
- *  RenderScene()
- *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
- ***********************************************************/
-void SceneManager::RenderScene()
-{
+	std::cout << "INFO: Loaded " << m_loadedTextures << " textures in " << std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - textureStart).count() << " ms" << std::endl;
 
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	if (m_bSceneReload)
+	{
+		SetAssetHashes(scene, MESH_TYPE_COUNT);
+	}
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if (bSceneFile)
+	{
+		SetSceneMaterials(scene);
+		SetSceneLights(scene);
+	}
+	else
+	{
+		// Calling the helper DefineOjectMaterials() to load in the wine bottle's material.
+		DefineObjectMaterials();
 
-	m_pShaderManager->use();
-	
+		// Calling the helper SetupSceneLights() here to load in the lighting for the scene.
+		SetupSceneLights();
+	}
 
-	BindGLTextures();
+	// Opening the page files of the large unique surfaces, when they were cooked
+	LoadVirtualTextures(virtualTextures);
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	// Building the list of objects once, now that the textures and materials are known
+	if (bSceneFile)
+	{
+		BuildDrawListFromScene(scene);
+	}
+	else
+	{
+		BuildSceneDrawList();
+	}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	if (nullptr != m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer->UploadMaterials(m_objectMaterials);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	// keep the file, so its edits can be compared with what is drawn
+	if (bSceneFile && m_bSceneReload)
+	{
+		m_pScene = new SceneDescription();
+		std::swap(*m_pScene, scene);
+	}
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  BuildSceneDrawList()
+ *
+ *  This method is used for building the list of objects in
+ *  the 3D scene.  Each entry holds the transformation and the
+ *  texture or material for drawing one of the basic shapes,
+ *  so the list only has to be built once.
+ ***********************************************************/
+void SceneManager::BuildSceneDrawList()
+{
+	// declare the variables for the transformations
+	glm::vec3 scaleXYZ;
+	glm::vec3 positionXYZ;
 
+	m_drawItems.clear();
 
 	// Creating the floor plane with texture
 	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
 	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	//SetShaderMaterial("def");
-	SetShaderTexture("floorTile");
-	SetTextureUVScale(4.0f, 4.0f);  // Making a tile floor, 4x4
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	AddTexturedDrawItem(MESH_PLANE, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "floorTile", 4.0f, 4.0f);  // Making a tile floor, 4x4
+	SetVirtualTexture("floorUnique");
 	/****************************************************************/
 
 	// Creation of TV Stand / Desk object, using a Box (now with texture)
 	scaleXYZ = glm::vec3(20.0f, 8.0f, -1.5f); // Width, Height, and Depth
 	positionXYZ = glm::vec3(0.0f, -0.5f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("deskWood");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddTexturedDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "deskWood", 1.0f, 1.0f);
 
 	// Creating a plane to sit on top of the desk, to appear as a kind of ink blotter
 	scaleXYZ = glm::vec3(9.5f, 3.0f, 0.62f); 
 	positionXYZ = glm::vec3(0.0f, 3.54f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("deskBlotter");
-	SetTextureUVScale(6.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	AddTexturedDrawItem(MESH_PLANE, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "deskBlotter", 6.0f, 1.0f);
 
 
 	// Creating a Tapered Cylinder to sit on the desk, to represent a vase
 	scaleXYZ = glm::vec3(0.7f, 0.7f, 0.5f);
 	positionXYZ = glm::vec3(-6.0f, 4.25f, -0.25f);
-	SetTransformations(scaleXYZ, 180.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("clay");
-	SetTextureUVScale(5.0f, 5.0f);
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddTexturedDrawItem(MESH_TAPERED_CYLINDER, scaleXYZ, 180.0f, 0.0f, 0.0f, positionXYZ, "clay", 5.0f, 5.0f);
 
 
 	// Creating a set of two slim cylinders, to represent flower stems (to go into the vase)
 	scaleXYZ = glm::vec3(0.03f, 2.5f, 0.03f);
 	positionXYZ = glm::vec3(-6.4f, 4.25f, -0.1f);
-	SetTransformations(scaleXYZ, 5.0f, 0.0f, 20.0f, positionXYZ);
-	SetShaderTexture("stem");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 5.0f, 0.0f, 20.0f, positionXYZ, "stem", 1.0f, 1.0f);
 
 	scaleXYZ = glm::vec3(0.03f, 2.5f, 0.03f);
 	positionXYZ = glm::vec3(-5.5f, 4.25f, -0.1f);
-	SetTransformations(scaleXYZ, -5.0f, 0.0f, -20.0f, positionXYZ);
-	SetShaderTexture("stem");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, -5.0f, 0.0f, -20.0f, positionXYZ, "stem", 1.0f, 1.0f);
 
 	// Creating two tapered cylinders to go with the flower stems (to act as flower bulbs / petals)
 	scaleXYZ = glm::vec3(0.4f, 0.4f, 0.4f);
 	positionXYZ = glm::vec3(-7.5f, 6.8f, 0.18f);
-	SetTransformations(scaleXYZ, -160.0f, 0.0f, -40.0f, positionXYZ);
-	SetShaderTexture("red_petal");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddTexturedDrawItem(MESH_TAPERED_CYLINDER, scaleXYZ, -160.0f, 0.0f, -40.0f, positionXYZ, "red_petal", 1.0f, 1.0f);
 
 	scaleXYZ = glm::vec3(0.4f, 0.4f, 0.4f);
 	positionXYZ = glm::vec3(-4.55f, 6.8f, -0.3f);
-	SetTransformations(scaleXYZ, 150.0f, 60.0f, 40.0f, positionXYZ);
-	SetShaderTexture("blue_petal");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawTaperedCylinderMesh();
+	AddTexturedDrawItem(MESH_TAPERED_CYLINDER, scaleXYZ, 150.0f, 60.0f, 40.0f, positionXYZ, "blue_petal", 1.0f, 1.0f);
 
 	// Creating a pyramid for the PC monitor, using a gray plastic texture
 	scaleXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
 	positionXYZ = glm::vec3(0.0f, 4.05f, -0.29f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("pc_plastic");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPyramid4Mesh();
+	AddTexturedDrawItem(MESH_PYRAMID4, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "pc_plastic", 1.0f, 1.0f);
 
 	// Creating a plane for the PC monitor's screen
 	scaleXYZ = glm::vec3(2.0f, 1.0f, 1.0f);
 	positionXYZ = glm::vec3(0.0f, 5.0f, -0.29f);
-	SetTransformations(scaleXYZ, 70.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("pc_desktop");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	AddTexturedDrawItem(MESH_PLANE, scaleXYZ, 70.0f, 0.0f, 0.0f, positionXYZ, "pc_desktop", 1.0f, 1.0f);
 
 	// Creating a large box to go beneath the desk, to serve as a kind of pull out drawer
 	scaleXYZ = glm::vec3(10.0f, 4.0f, 1.0f);
 	positionXYZ = glm::vec3(0.0f, 0.0f, 0.5f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("knife_handle");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddTexturedDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "knife_handle", 1.0f, 1.0f);
 
 	// Creating two cylinders here, which will serve as handles for the pull-out drawer beneath the desk
 	scaleXYZ = glm::vec3(0.1f, 2.0f, 0.1f);
 	positionXYZ = glm::vec3(-2.0f, 1.0f, 1.1f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ);
-	SetShaderTexture("stainless");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ, "stainless", 1.0f, 1.0f);
 
 	scaleXYZ = glm::vec3(0.1f, 2.0f, 0.1f);
 	positionXYZ = glm::vec3(4.0f, 1.0f, 1.1f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ);
-	SetShaderTexture("stainless");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ, "stainless", 1.0f, 1.0f);
 
 	// Creating a plane for the back wall, and using a white paint texture
 	scaleXYZ = glm::vec3(20.0f, 100.0f, 10.0f);
 	positionXYZ = glm::vec3(0.0f, 10.0f, -2.0f);
-	SetTransformations(scaleXYZ, 90.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("white_paint");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawPlaneMesh();
+	AddTexturedDrawItem(MESH_PLANE, scaleXYZ, 90.0f, 0.0f, 0.0f, positionXYZ, "white_paint", 1.0f, 1.0f);
+	SetVirtualTexture("backWallUnique");
 
 	// Creating 4 Cylinders here (the first two are top and bottom, the last two are the sides)
 	// For the rectangular molding on the back wall
 	scaleXYZ = glm::vec3(0.3f, 17.0f, 0.3f);
 	positionXYZ = glm::vec3(8.0f, 13.0f, -1.8f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ);
-	SetShaderTexture("white_accent");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ, "white_accent", 1.0f, 1.0f);
 
 	scaleXYZ = glm::vec3(0.3f, 17.0f, 0.3f);
 	positionXYZ = glm::vec3(8.0f, 8.0f, -1.8f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ);
-	SetShaderTexture("white_accent");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, 90.0f, positionXYZ, "white_accent", 1.0f, 1.0f);
 
 	// Now for the sides
 	scaleXYZ = glm::vec3(0.3f, 5.0f, 0.3f);
 	positionXYZ = glm::vec3(-9.0f, 8.0f, -1.8f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("white_accent");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "white_accent", 1.0f, 1.0f);
 
 	scaleXYZ = glm::vec3(0.3f, 5.0f, 0.3f);
 	positionXYZ = glm::vec3(8.0f, 8.0f, -1.8f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("white_accent");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddTexturedDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "white_accent", 1.0f, 1.0f);
 
 	// Creating a small box here for a stand for the wine bottle
 	scaleXYZ = glm::vec3(0.2f, 0.7f, 1.0f);
 	positionXYZ = glm::vec3(5.0f, 3.9f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("bottle_holder");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddTexturedDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "bottle_holder", 1.0f, 1.0f);
 
 	// Creating several shapes for a wine bottle: a cylinder for the base, a half-sphere for the shoulder,
 	// And another cylinder for the neck.  Going to probably have to use a created material for this,
 	// To represent a dark, purplish glass (reflecting the wine within).
-	
-	scaleXYZ = glm::vec3(0.3f, 1.8f, 0.3f);
-	positionXYZ = glm::vec3(3.8f, 3.8f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ);
-	SetShaderMaterial("wineBottle");
-	m_basicMeshes->DrawCylinderMesh();
-
-	scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);
-	positionXYZ = glm::vec3(5.45f, 4.4f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ);
-	SetShaderMaterial("wineBottle");
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	scaleXYZ = glm::vec3(0.15f, 0.8f, 0.15f);
-	positionXYZ = glm::vec3(5.5f, 4.45f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ);
-	SetShaderMaterial("wineBottle");
-	m_basicMeshes->DrawCylinderMesh();
+	// When a cooked wine bottle model was loaded, it is drawn in their place.
+	int bottleMesh = FindImportedMesh("wineBottle");
+	if (bottleMesh >= 0)
+	{
+		scaleXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
+		positionXYZ = glm::vec3(3.8f, 3.8f, 0.0f);
+		AddMaterialDrawItem(bottleMesh, scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ, "wineBottle");
+	}
+	else
+	{
+		scaleXYZ = glm::vec3(0.3f, 1.8f, 0.3f);
+		positionXYZ = glm::vec3(3.8f, 3.8f, 0.0f);
+		AddMaterialDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ, "wineBottle");
+
+		scaleXYZ = glm::vec3(0.3f, 0.3f, 0.3f);
+		positionXYZ = glm::vec3(5.45f, 4.4f, 0.0f);
+		AddMaterialDrawItem(MESH_HALF_SPHERE, scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ, "wineBottle");
+
+		scaleXYZ = glm::vec3(0.15f, 0.8f, 0.15f);
+		positionXYZ = glm::vec3(5.5f, 4.45f, 0.0f);
+		AddMaterialDrawItem(MESH_CYLINDER, scaleXYZ, 0.0f, 0.0f, -70.0f, positionXYZ, "wineBottle");
+	}
 
 	// This next section is going to be creating the three books that are on the right side of the desk,
 	// Their covers, spines, and the pages therein.
@@ -739,88 +3025,133 @@ void SceneManager::RenderScene()
 	// Bottom Cover (Coffee Book)
 	scaleXYZ = glm::vec3(1.0f, 0.05f, 1.0f);
 	positionXYZ = glm::vec3(9.0f, 3.57f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("coffeeLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "coffeeLeather");
 
 	scaleXYZ = glm::vec3(0.95f, 0.25f, 0.8f);
 	positionXYZ = glm::vec3(9.0f, 3.7f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("book_pages");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddTexturedDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "book_pages", 1.0f, 1.0f);
 
 	// Top Cover (Coffee Book)
 	scaleXYZ = glm::vec3(1.0f, 0.05f, 1.0f);
 	positionXYZ = glm::vec3(9.0f, 3.85f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("coffeeLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "coffeeLeather");
 
 	// Book Spine (Coffee Book)
 	scaleXYZ = glm::vec3(0.05f, 0.28f, 1.0f);
 	positionXYZ = glm::vec3(8.5f, 3.71f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("coffeeLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "coffeeLeather");
 
 	// Now for the second book (red), sitting on top of the first.
 	// Bottom Cover (Red Book)
 	scaleXYZ = glm::vec3(1.0f, 0.05f, 1.0f);
 	positionXYZ = glm::vec3(9.0f, 3.9f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("redLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ, "redLeather");
 
 	scaleXYZ = glm::vec3(0.95f, 0.25f, 0.8f);
 	positionXYZ = glm::vec3(9.0f, 4.0f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ);
-	SetShaderTexture("book_pages");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddTexturedDrawItem(MESH_BOX, scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ, "book_pages", 1.0f, 1.0f);
 
 	// Top Cover (Red Book)
 	scaleXYZ = glm::vec3(1.0f, 0.05f, 1.0f);
 	positionXYZ = glm::vec3(9.0f, 4.15f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("redLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ, "redLeather");
 
 	// Book Spine (Red Book)
 	scaleXYZ = glm::vec3(0.05f, 0.28f, 1.0f);
 	positionXYZ = glm::vec3(8.56f, 4.03f, -0.25f);
-	SetTransformations(scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("redLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, -30.0f, 0.0f, positionXYZ, "redLeather");
 
 	// Lastly, we have the blue book, sitting on top of the other two
 	// Bottom Cover (Blue Book)
 	scaleXYZ = glm::vec3(1.0f, 0.05f, 1.0f);
 	positionXYZ = glm::vec3(9.0f, 4.2f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("royalBlueLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "royalBlueLeather");
 
 	scaleXYZ = glm::vec3(0.95f, 0.25f, 0.8f);
 	positionXYZ = glm::vec3(9.0f, 4.3f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderTexture("book_pages");
-	SetTextureUVScale(1.0f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddTexturedDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "book_pages", 1.0f, 1.0f);
 
 	// Top Cover (Blue Book)
 	scaleXYZ = glm::vec3(1.0f, 0.05f, 1.0f);
 	positionXYZ = glm::vec3(9.0f, 4.45f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("royalBlueLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "royalBlueLeather");
 
 	// Book Spine (Blue Book)
 	scaleXYZ = glm::vec3(0.05f, 0.28f, 1.0f);
 	positionXYZ = glm::vec3(8.5f, 4.33f, 0.0f);
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
-	SetShaderMaterial("royalBlueLeather");
-	m_basicMeshes->DrawBoxMesh();
+	AddMaterialDrawItem(MESH_BOX, scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ, "royalBlueLeather");
+
+	SortDrawList();
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  transforming and drawing the basic 3D shapes
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	GpuScope sceneScope("RenderScene");
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	m_renderStats.Reset();
+	m_preparedVariants = 0;
+	BeginPrimitiveQuery();
+
+	// a variant rebuilt after a shader edit starts without the lights
+	if (nullptr != m_pShaderPermutations)
+	{
+		m_litVariants &= ~m_pShaderPermutations->FinishBuilds();
+	}
+
+	if (m_bMeshLods)
+	{
+		UpdateMeshLods();
+	}
+	// after the levels are picked, since each level has its own meshlets,
+	// and before the scene program is bound, since the culling has its own
+	if (nullptr != m_pClusterCuller)
+	{
+		CullMeshlets();
+	}
+
+	m_pShaderManager->use();
+	m_renderStats.programSwitches++;
 
+	// stream before binding, since the streamer binds the textures it changes
+	if (nullptr != m_pTextureStreamer)
+	{
+		UpdateTextureStreaming();
+	}
+	if (nullptr != m_pVirtualTexturing)
+	{
+		RenderVirtualTextureFeedback();
+	}
+
+	BindGLTextures();
+
+	// the deferred path shades the opaque items itself and then
+	// hands the transparent items back to the forward shader
+	if ((m_renderPath == RENDER_PATH_DEFERRED) && (nullptr != m_pDeferredRenderer))
+	{
+		RenderDeferred();
+	}
+	else
+	{
+		GpuScope profileScope("opaque");
+		RenderForwardItems(false);
+	}
+	if (nullptr != m_pVirtualTexturing)
+	{
+		RenderVirtualTexturedItems();
+	}
+
+	{
+		GpuScope profileScope("transparent");
+		RenderForwardItems(true);
+	}
 
+	EndPrimitiveQuery();
 }
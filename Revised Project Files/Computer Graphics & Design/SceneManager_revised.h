@@ -0,0 +1,488 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadermanager.h
+// ============
+// manage the loading and rendering of 3D scenes
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "RenderStats.h"
+
+#include <string>
+#include <vector>
+
+// Adding a forward declaration for the deferred shading path
+class DeferredRenderer;
+class ShaderPermutations;
+class AssetPack;
+class TextureStreamer;
+class VirtualTexturing;
+class MeshPool;
+class ClusterCuller;
+struct MeshData;
+struct MeshVertex;
+struct SceneDescription;
+
+/***********************************************************
+ *  SceneManager
+ *
+ *  This class contains the code for preparing and rendering
+ *  3D scenes, including the shader settings.
+ ***********************************************************/
+class SceneManager
+{
+public:
+	// constructor
+	SceneManager(ShaderManager *pShaderManager);
+	// destructor
+	~SceneManager();
+
+	struct TEXTURE_INFO
+	{
+		std::string tag;
+		uint32_t ID;
+		// handle in the texture streamer, -1 when fully resident
+		int streamHandle;
+		// hash of the image it was loaded from, 0 when not known
+		unsigned long long contentHash;
+	};
+
+	// an image to be loaded by CreateGLTextures()
+	struct TEXTURE_FILE
+	{
+		std::string filename;
+		std::string tag;
+	};
+
+	// a model to be loaded by LoadImportedMeshes(), from its cooked .mesh
+	struct MESH_FILE
+	{
+		std::string filename;
+		std::string tag;
+	};
+
+	struct OBJECT_MATERIAL
+	{
+		float ambientStrength;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		std::string tag;
+	};
+
+	// Adding a light source struct, so the lights are kept on the CPU side
+	// and can be fed to either the forward or the deferred lighting
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+		// radius of influence, 0 means the light reaches the whole scene
+		float radius;
+	};
+
+	// the basic meshes that can be referenced by a draw item
+	enum MESH_TYPE
+	{
+		MESH_PLANE,
+		MESH_BOX,
+		MESH_CYLINDER,
+		MESH_TAPERED_CYLINDER,
+		MESH_PYRAMID4,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		// number of basic meshes
+		MESH_TYPE_COUNT
+	};
+
+	// one drawn object in the scene - built once in PrepareScene()
+	// and consumed by whichever render path is active
+	struct DRAW_ITEM
+	{
+		// a MESH_TYPE, or an imported mesh from FindImportedMesh()
+		int mesh;
+		glm::mat4 model;
+		// texture slot, or -1 when the object only uses a material
+		int textureSlot;
+		// index into the defined object materials
+		int materialIndex;
+		glm::vec2 uvScale;
+		// transparent items are always drawn by the forward path
+		bool bTransparent;
+		// shader variant flags - unlit items skip the lighting code,
+		// alpha-tested items discard the cut-out texels
+		bool bLit;
+		bool bAlphaTested;
+		// virtual texture index, or -1 when the texture slot is used
+		int virtualTexture;
+		// level of detail drawn, picked each frame by UpdateMeshLods()
+		int lod;
+		// this frame's draw in the cluster culler, or -1 to draw the whole mesh
+		int meshletDraw;
+		// object of the scene file it was built from, -1 for the scene written in code
+		int sceneObject;
+		// shader variant, then texture, then material - the opaque
+		// items are drawn in this order
+		unsigned int sortKey;
+	};
+
+	// the render paths that can be switched between
+	enum RENDER_PATH
+	{
+		RENDER_PATH_FORWARD,
+		RENDER_PATH_DEFERRED
+	};
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// the basic shapes, all in one shared vertex and index buffer
+	MeshPool* m_pMeshPool;
+	// the levels of detail of one mesh, finest first
+	static const int MAX_LOD_LEVELS = 6;
+	struct MESH_LOD_CHAIN
+	{
+		std::string tag;
+		int levelCount;
+		int handles[MAX_LOD_LEVELS];
+		// how far each level is from the true shape, in mesh units
+		float errors[MAX_LOD_LEVELS];
+		// bounding sphere of the mesh before the item is placed and scaled
+		glm::vec3 center;
+		float radius;
+		// hash of the cooked model it was loaded from, 0 when not known
+		unsigned long long contentHash;
+	};
+	// the basic shapes in MESH_TYPE order, then the imported meshes
+	std::vector<MESH_LOD_CHAIN> m_meshLods;
+	// build the coarser levels, or only the finest one
+	bool m_bMeshLods;
+	// largest error a level may show on screen, in pixels
+	float m_lodErrorPixels;
+	// store the vertices in the 16 byte quantized format
+	bool m_bQuantizedVertices;
+	// tessellate the round shapes very finely, to stress vertex throughput
+	bool m_bDenseMeshes;
+	// reorder the mesh triangles and vertices for the vertex cache
+	bool m_bOptimizeMeshes;
+	// culls the meshlets of the large meshes, or nullptr to draw them whole
+	ClusterCuller* m_pClusterCuller;
+	bool m_bMeshletCulling;
+	// total number of loaded textures
+	int m_loadedTextures;
+	// loaded textures info, one per texture unit
+	static const int MAX_TEXTURES = 16;
+	TEXTURE_INFO m_textureIDs[MAX_TEXTURES];
+	// defined object materials
+	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// defined scene lights
+	std::vector<LIGHT_SOURCE> m_lightSources;
+	// every object drawn in the scene
+	std::vector<DRAW_ITEM> m_drawItems;
+	// scene file the layout is read from, empty for the scene written in code
+	std::string m_sceneFile;
+
+	// the tables of a scene file, resolved to loaded meshes, texture
+	// slots and materials, -1 for the entries that did not load
+	struct SCENE_BINDINGS
+	{
+		std::vector<int> meshes;
+		std::vector<int> textureSlots;
+		std::vector<int> materials;
+		std::vector<int> virtualTextures;
+		// material of the textured objects that do not name one
+		int defaultMaterial;
+	};
+	// the scene file as last applied and its bindings, kept so an edited
+	// file can be compared with it, nullptr when it is not kept
+	SceneDescription* m_pScene;
+	SCENE_BINDINGS m_sceneBindings;
+	bool m_bSceneReload;
+	// content hashes of the scene models that did not load
+	std::vector<unsigned long long> m_failedMeshes;
+
+	// active render path and the deferred renderer (created on demand)
+	RENDER_PATH m_renderPath;
+	DeferredRenderer* m_pDeferredRenderer;
+
+	// camera values needed by the deferred lighting pass
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	int m_viewportWidth;
+	int m_viewportHeight;
+	// framebuffer the scene is rendered into (0 is the window)
+	GLuint m_targetFramebuffer;
+
+	// compiled variants of the scene shader, or nullptr for the single program
+	ShaderPermutations* m_pShaderPermutations;
+	// variants that already have this frame's camera uniforms
+	unsigned int m_preparedVariants;
+	// variants that have the current lights
+	unsigned int m_litVariants;
+
+	// mapped pack the cooked textures are read from, or nullptr for loose files
+	const AssetPack* m_pAssetPack;
+	// build the mip chains on the CPU instead of with glGenerateMipmap
+	bool m_bCpuMipmaps;
+	// streams the texture mips within a memory budget, or nullptr to load them all
+	TextureStreamer* m_pTextureStreamer;
+	// pages in the very large unique textures, or nullptr when there are none
+	VirtualTexturing* m_pVirtualTexturing;
+	bool m_bVirtualTextures;
+
+	// an image decoded by a worker thread, waiting to be uploaded
+	struct DECODED_IMAGE
+	{
+		unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		// levels 1 and down, empty when the driver builds them
+		std::vector<std::vector<unsigned char>> mips;
+		double mipMilliseconds;
+	};
+
+	// work submitted during the last RenderScene()
+	RenderStats m_renderStats;
+	// primitive count queries, read a few frames late to avoid stalls
+	static const int PRIMITIVE_QUERY_COUNT = 3;
+	GLuint m_primitiveQueries[PRIMITIVE_QUERY_COUNT];
+	bool m_primitiveQueryIssued[PRIMITIVE_QUERY_COUNT];
+	int m_primitiveQueryIndex;
+	long long m_lastTriangleCount;
+
+	// load texture images and convert to OpenGL texture data
+	bool CreateGLTexture(const char* filename, std::string tag);
+	// add a loaded texture to the first free slot
+	void RegisterTexture(GLuint textureID, std::string tag, int streamHandle);
+	// delete the texture in a slot so the slot can be used again
+	void FreeTextureSlot(int slot);
+	// upload the cooked BCn texture for an image, false when there is none
+	bool CreateCompressedGLTexture(const char* filename, std::string tag);
+	// load a list of textures, decoding them on worker threads
+	void CreateGLTextures(const std::vector<TEXTURE_FILE>& textures);
+	bool HasCookedTexture(const char* filename) const;
+	// read an image and build its mips - no GL calls, so safe on any thread
+	static bool DecodeImage(const char* filename, bool bCpuMipmaps, DECODED_IMAGE& decoded);
+	bool UploadDecodedTexture(const char* filename, DECODED_IMAGE& decoded, std::string tag);
+	// bind loaded OpenGL textures to slots in memory
+	void BindGLTextures();
+	// free the loaded OpenGL textures
+	void DestroyGLTextures();
+	// find a loaded texture by tag
+	int FindTextureID(std::string tag);
+	int FindTextureSlot(std::string tag);
+	// find a loaded texture by the hash of its image, -1 when it is not loaded
+	int FindTextureByContent(unsigned long long contentHash) const;
+	// find a defined material by tag
+	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string tag);
+
+	// build the transformation matrix from the passed in values
+	glm::mat4 BuildTransformation(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the transformation values
+	// into the transform buffer
+	void SetTransformations(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// set the color values into the shader
+	void SetShaderColor(
+		float redColorValue,
+		float greenColorValue,
+		float blueColorValue,
+		float alphaValue);
+
+	// set the texture data into the shader
+	void SetShaderTexture(
+		std::string textureTag);
+
+	// set the UV scale for the texture mapping
+	void SetTextureUVScale(
+		float u, float v);
+
+	// set the object material into the shader
+	void SetShaderMaterial(
+		std::string materialTag);
+
+	// set the material lighting values into the shader
+	void SetMaterialUniforms(
+		const OBJECT_MATERIAL& material);
+
+	// add objects to the scene draw list
+	void AddTexturedDrawItem(
+		int mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		std::string textureTag,
+		float u, float v);
+	void AddMaterialDrawItem(
+		int mesh,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		std::string materialTag);
+
+	// build the basic shapes and their levels of detail into the mesh pool
+	void LoadBasicMeshes();
+	// build one basic shape, false when it has no segments to reduce
+	bool BuildBasicMesh(MESH_TYPE mesh, int slices, int stacks, MeshData& data, float& error);
+	// optimize the levels of a mesh and add them to the mesh pool
+	void AddMeshLevels(const std::string& tag, std::vector<MeshData>& levels, const std::vector<float>& errors);
+	// add a mesh to the pool and build its meshlets, returns its pool handle
+	int AddPoolMesh(const MeshVertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount);
+	// copy the added meshes and meshlets to the GPU
+	void UploadPoolMeshes();
+	// load cooked models into the mesh pool, straight from their files
+	void LoadImportedMeshes(const std::vector<MESH_FILE>& meshes);
+	bool LoadImportedMesh(const char* filename, std::string tag);
+	// find an imported mesh by tag, -1 when it was not loaded
+	int FindImportedMesh(std::string tag) const;
+	int FindImportedMeshByContent(unsigned long long contentHash) const;
+	// pick the level of detail of each item from its error on screen
+	void UpdateMeshLods();
+	// find the visible meshlets of the items drawn with them
+	void CullMeshlets();
+	// the mesh pool handle of the level an item is drawn with
+	int GetMeshHandle(const DRAW_ITEM& item) const { return m_meshLods[item.mesh].handles[item.lod]; }
+	// draw the mesh of an item with the current shader state
+	void DrawMesh(const DRAW_ITEM& item);
+	// the model matrix of an item with the decode transform of its mesh
+	glm::mat4 GetMeshTransform(const DRAW_ITEM& item) const;
+	// draw the opaque or transparent items with the forward shader
+	void RenderForwardItems(bool bTransparent);
+	// render the opaque items through the deferred renderer
+	void RenderDeferred();
+	// count the triangles drawn by the frame
+	void BeginPrimitiveQuery();
+	void EndPrimitiveQuery();
+	// pass the scene lights into the forward shader
+	void UploadLightUniforms();
+	// build the sort keys and order the opaque items by them
+	void SortDrawList();
+	// request the texture resolution each visible item needs on screen
+	void UpdateTextureStreaming();
+	// switch to the shader variant of a sort key, false to use the single program
+	bool UseShaderVariant(unsigned int sortKey, GLuint defaultProgram);
+	// open the page files of the virtual textures, if any were cooked
+	void LoadVirtualTextures(const std::vector<TEXTURE_FILE>& textures);
+	// draw the last added item with a virtual texture, when it was loaded
+	void SetVirtualTexture(std::string tag);
+	// record the pages the virtual textures need, and load them
+	void RenderVirtualTextureFeedback();
+	// draw the items that use a virtual texture
+	void RenderVirtualTexturedItems();
+	// read the scene file, false to draw the scene written in code
+	bool LoadSceneFile(SceneDescription& scene);
+	// define the materials and lights listed in a scene file
+	void SetSceneMaterials(const SceneDescription& scene);
+	void SetSceneLights(const SceneDescription& scene);
+	// resolve the tables of a scene file once its assets are loaded
+	void BindSceneTables(const SceneDescription& scene, SCENE_BINDINGS& bindings);
+	// build the draw item of one scene file object, false when it is not drawn
+	bool MakeSceneDrawItem(const SceneDescription& scene, int object, const SCENE_BINDINGS& bindings, DRAW_ITEM& item);
+	// build the list of objects from a scene file
+	void BuildDrawListFromScene(const SceneDescription& scene);
+	// record the content hashes of the textures and models loaded from a scene file
+	void SetAssetHashes(const SceneDescription& scene, size_t firstMesh);
+	// load the models and textures of an edited scene file that are not loaded yet
+	void LoadSceneAssets(const SceneDescription& scene, int& loadedMeshes, int& loadedTextures);
+	// update the materials and lights to those of an edited scene file
+	int UpdateSceneMaterials(const SceneDescription& scene);
+	bool UpdateSceneLights(const SceneDescription& scene);
+	// whether an object draws the same in the applied scene and in an edited one
+	bool IsSceneObjectUnchanged(int oldObject, const SceneDescription& scene, int object, const SCENE_BINDINGS& bindings) const;
+
+public:
+
+	// The following methods are for the students to
+	// customize for their own 3D scene
+	void PrepareScene();
+	void RenderScene();
+	// Adding helper here, for creating a wine bottle material (couldn't really find a glass texture to use)
+	void DefineObjectMaterials();
+	// Adding method for setting up the lighting for the scene here
+	void SetupSceneLights();
+	// Adding method for building the list of objects drawn in the scene
+	void BuildSceneDrawList();
+
+	// switch between the forward and deferred render paths
+	bool SetRenderPath(RENDER_PATH renderPath);
+	RENDER_PATH GetRenderPath() const { return m_renderPath; }
+
+	// pass in the camera values for the current frame
+	void SetViewParameters(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition,
+		int viewportWidth,
+		int viewportHeight);
+
+	// set the framebuffer the scene is rendered into
+	void SetRenderTarget(GLuint framebuffer) { m_targetFramebuffer = framebuffer; }
+
+	// resize the offscreen render targets after the window changed size
+	void OnFramebufferResized(int width, int height);
+
+	// the work submitted by the last RenderScene()
+	const RenderStats& GetRenderStats() const { return m_renderStats; }
+
+	// send the startup-only uniforms again after a shader reload
+	void OnShaderReloaded();
+
+	// apply an edited scene file, changing only what differs from the running scene
+	void ReloadScene(SceneDescription& scene);
+
+	// draw with compiled shader variants instead of the flag uniforms
+	bool EnableShaderVariants(const char* vertexShaderPath, const char* fragmentShaderPath);
+
+	// read the cooked textures from a mapped asset pack (set before PrepareScene)
+	void SetAssetPack(const AssetPack* pAssetPack) { m_pAssetPack = pAssetPack; }
+	// build mips on the CPU (default) or leave them to the driver (set before PrepareScene)
+	void SetCpuMipmaps(bool bCpuMipmaps) { m_bCpuMipmaps = bCpuMipmaps; }
+	// stream the texture mips within a GPU memory budget (set before PrepareScene)
+	void EnableTextureStreaming(long long budgetBytes);
+	// draw the surfaces that have a cooked page file with virtual textures (set before PrepareScene)
+	void SetVirtualTexturing(bool bEnabled) { m_bVirtualTextures = bEnabled; }
+	// store the mesh vertices quantized to 16 bytes (set before PrepareScene)
+	void SetQuantizedVertices(bool bQuantized) { m_bQuantizedVertices = bQuantized; }
+	// build the round shapes with far more triangles (set before PrepareScene)
+	void SetDenseMeshes(bool bDense) { m_bDenseMeshes = bDense; }
+	// optimize the mesh index and vertex order (default, set before PrepareScene)
+	void SetOptimizeMeshes(bool bOptimize) { m_bOptimizeMeshes = bOptimize; }
+	// build lower levels of detail for the shapes (default, set before PrepareScene)
+	void SetMeshLods(bool bEnabled) { m_bMeshLods = bEnabled; }
+	// largest geometric error a level of detail may show, in pixels
+	void SetLodErrorPixels(float pixels) { m_lodErrorPixels = pixels; }
+	// cull the meshlets of the large meshes (default, set before PrepareScene)
+	void SetMeshletCulling(bool bEnabled) { m_bMeshletCulling = bEnabled; }
+	// read the layout from a .scene file, nullptr for the code below (set before PrepareScene)
+	void SetSceneFile(const char* filePath) { m_sceneFile = (nullptr != filePath) ? filePath : ""; }
+	// keep the scene file and hash its assets for ReloadScene() (set before PrepareScene)
+	void SetSceneReload(bool bEnabled) { m_bSceneReload = bEnabled; }
+
+
+};
@@ -0,0 +1,161 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderhotreload.cpp
+// ============
+// watch the scene shader files and swap in a rebuilt program
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderHotReload.h"
+#include "ShaderUtils.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  ShaderHotReload()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderHotReload::ShaderHotReload(ShaderManager* pShaderManager)
+{
+	m_pShaderManager = pShaderManager;
+	m_bParallelCompile = false;
+	m_pendingProgram = 0;
+	m_pendingShaders[0] = 0;
+	m_pendingShaders[1] = 0;
+}
+
+/***********************************************************
+ *  ~ShaderHotReload()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderHotReload::~ShaderHotReload()
+{
+	DiscardBuild();
+	m_pShaderManager = nullptr;
+}
+
+/***********************************************************
+ *  Watch()
+ *
+ *  This method is used to start watching the shader files.
+ ***********************************************************/
+bool ShaderHotReload::Watch(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	m_vertexShaderPath = vertexShaderPath;
+	m_fragmentShaderPath = fragmentShaderPath;
+
+	// let the driver compile on its own threads when it can
+	m_bParallelCompile = (GLEW_KHR_parallel_shader_compile != GL_FALSE);
+	if (m_bParallelCompile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+
+	m_fileWatcher.Watch({ m_vertexShaderPath, m_fragmentShaderPath });
+
+	std::cout << "INFO: Watching " << m_vertexShaderPath << " and " << m_fragmentShaderPath
+		<< (m_bParallelCompile ? " (parallel compile)" : "") << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  StartBuild()
+ *
+ *  This method is used to submit the compile and link of the
+ *  new program.  No status is queried here - with parallel
+ *  compile the work carries on in the driver while frames
+ *  keep rendering with the old program.
+ ***********************************************************/
+void ShaderHotReload::StartBuild()
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+	if (!ShaderUtils::ReadTextFile(m_vertexShaderPath, vertexSource) ||
+		!ShaderUtils::ReadTextFile(m_fragmentShaderPath, fragmentSource))
+	{
+		std::cout << "Could not read the shader files, keeping the old program" << std::endl;
+		return;
+	}
+
+	// a newer save replaces a build that is still running
+	DiscardBuild();
+
+	m_pendingProgram = ShaderUtils::StartProgramBuild(vertexSource.c_str(), fragmentSource.c_str(), m_pendingShaders);
+
+	std::cout << "INFO: Shader change detected, rebuilding the scene program" << std::endl;
+}
+
+/***********************************************************
+ *  FinishBuild()
+ *
+ *  This method is used to check on the background build.
+ *  The live program is only replaced once the new one has
+ *  linked, so a broken edit never takes the scene down.
+ ***********************************************************/
+bool ShaderHotReload::FinishBuild()
+{
+	if (m_pendingProgram == 0)
+	{
+		return false;
+	}
+
+	// with parallel compile, come back next frame until it is done
+	if (ShaderUtils::IsProgramBuildComplete(m_pendingProgram) == false)
+	{
+		return false;
+	}
+
+	GLuint newProgram = m_pendingProgram;
+	bool bBuilt = ShaderUtils::FinishProgramBuild(newProgram, m_pendingShaders, "scene");
+	m_pendingProgram = 0;
+	m_pendingShaders[0] = 0;
+	m_pendingShaders[1] = 0;
+	if (bBuilt == false)
+	{
+		std::cout << "INFO: Keeping the old scene program" << std::endl;
+		return false;
+	}
+
+	// swap in one step - the next use() picks up the new program
+	GLuint oldProgram = m_pShaderManager->m_programID;
+	m_pShaderManager->m_programID = newProgram;
+	glDeleteProgram(oldProgram);
+
+	std::cout << "INFO: Scene program reloaded" << std::endl;
+	return true;
+}
+
+/***********************************************************
+ *  DiscardBuild()
+ *
+ *  This method is used to drop a background build.
+ ***********************************************************/
+void ShaderHotReload::DiscardBuild()
+{
+	if (m_pendingProgram != 0)
+	{
+		glDeleteProgram(m_pendingProgram);
+		glDeleteShader(m_pendingShaders[0]);
+		glDeleteShader(m_pendingShaders[1]);
+	}
+	m_pendingProgram = 0;
+	m_pendingShaders[0] = 0;
+	m_pendingShaders[1] = 0;
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used once per frame to pick up file
+ *  changes and to advance the background build.
+ ***********************************************************/
+bool ShaderHotReload::Poll()
+{
+	if (m_fileWatcher.Poll())
+	{
+		StartBuild();
+	}
+
+	return(FinishBuild());
+}
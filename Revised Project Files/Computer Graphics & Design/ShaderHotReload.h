@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderhotreload.h
+// ============
+// watch the scene shader files and swap in a rebuilt program
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include "FileWatcher.h"
+#include "ShaderManager.h"
+
+#include <string>
+
+
+/***********************************************************
+ *  ShaderHotReload
+ *
+ *  This class watches the vertex and fragment shader files.
+ *  When one is saved, a new program is compiled next to the live one,
+ *  using GL_KHR_parallel_shader_compile when the driver has
+ *  it so the render thread never waits on the compiler.  The
+ *  ShaderManager only switches to the new program after it
+ *  links; a shader with errors prints its log and the old
+ *  program keeps running.
+ ***********************************************************/
+class ShaderHotReload
+{
+public:
+	// constructor
+	ShaderHotReload(ShaderManager* pShaderManager);
+	// destructor
+	~ShaderHotReload();
+
+	// start watching the files the scene program was loaded from
+	bool Watch(const char* vertexShaderPath, const char* fragmentShaderPath);
+
+	// call once per frame - returns true when a new program was swapped in
+	bool Poll();
+
+private:
+	ShaderManager* m_pShaderManager;
+	std::string m_vertexShaderPath;
+	std::string m_fragmentShaderPath;
+
+	FileWatcher m_fileWatcher;
+
+	// the program being built in the background
+	bool m_bParallelCompile;
+	GLuint m_pendingProgram;
+	GLuint m_pendingShaders[2];
+
+	// read the sources and start compiling and linking them
+	void StartBuild();
+	// check the background build, swapping it in when it links
+	bool FinishBuild();
+	// release the objects of the background build
+	void DiscardBuild();
+};
@@ -0,0 +1,331 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderpermutations.cpp
+// ============
+// compile-time variants of the scene shader, built on first use
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderPermutations.h"
+#include "ShaderUtils.h"
+
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_UseTextureName = "bUseTexture";
+	const char* g_UseLightingName = "bUseLighting";
+
+	/***********************************************************
+	 *  SpecializeFlag()
+	 *
+	 *  This function is used to replace the declaration
+	 *  "uniform bool name;" (or int) with a constant of the
+	 *  same type.  Returns false when the source does not
+	 *  declare the uniform.
+	 ***********************************************************/
+	bool SpecializeFlag(std::string& source, const char* uniformName, bool bValue)
+	{
+		size_t lineStart = 0;
+		while (lineStart < source.size())
+		{
+			size_t lineEnd = source.find('\n', lineStart);
+			if (lineEnd == std::string::npos)
+			{
+				lineEnd = source.size();
+			}
+
+			// split the line into words, ignoring the ';'
+			std::string line = source.substr(lineStart, lineEnd - lineStart);
+			size_t semicolon = line.find(';');
+			std::istringstream words(line.substr(0, semicolon));
+			std::string qualifier, type, name, extra;
+			words >> qualifier >> type >> name;
+			if ((semicolon != std::string::npos) && !(words >> extra) &&
+				(qualifier == "uniform") && (name == uniformName) &&
+				((type == "bool") || (type == "int")))
+			{
+				std::string value;
+				if (type == "bool")
+				{
+					value = bValue ? "true" : "false";
+				}
+				else
+				{
+					value = bValue ? "1" : "0";
+				}
+				source.replace(lineStart, lineEnd - lineStart,
+					"const " + type + " " + name + " = " + value + ";" + line.substr(semicolon + 1));
+				return true;
+			}
+
+			lineStart = lineEnd + 1;
+		}
+		return false;
+	}
+}
+
+/***********************************************************
+ *  ShaderPermutations()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderPermutations::ShaderPermutations()
+{
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		m_programs[i] = 0;
+		m_bFailed[i] = false;
+		m_pendingPrograms[i] = 0;
+		m_pendingShaders[i][0] = 0;
+		m_pendingShaders[i][1] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~ShaderPermutations()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderPermutations::~ShaderPermutations()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used to delete every built variant.
+ ***********************************************************/
+void ShaderPermutations::Clear()
+{
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		DiscardBuild(i);
+		if (m_programs[i] != 0)
+		{
+			glDeleteProgram(m_programs[i]);
+		}
+		m_programs[i] = 0;
+		m_bFailed[i] = false;
+	}
+}
+
+/***********************************************************
+ *  DiscardBuild()
+ *
+ *  This method is used to drop the background build of a
+ *  variant.
+ ***********************************************************/
+void ShaderPermutations::DiscardBuild(int variant)
+{
+	if (m_pendingPrograms[variant] != 0)
+	{
+		glDeleteProgram(m_pendingPrograms[variant]);
+		glDeleteShader(m_pendingShaders[variant][0]);
+		glDeleteShader(m_pendingShaders[variant][1]);
+	}
+	m_pendingPrograms[variant] = 0;
+	m_pendingShaders[variant][0] = 0;
+	m_pendingShaders[variant][1] = 0;
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used to read the scene shader sources.
+ *  A shader that does not declare the flag uniforms cannot
+ *  be specialized, and the scene keeps the single program.
+ ***********************************************************/
+bool ShaderPermutations::Load(const char* vertexShaderPath, const char* fragmentShaderPath)
+{
+	m_vertexShaderPath = vertexShaderPath;
+	m_fragmentShaderPath = fragmentShaderPath;
+	return(Reload());
+}
+
+/***********************************************************
+ *  Reload()
+ *
+ *  This method is used to read the shader files again, for
+ *  when they were edited.  The variants that are built are
+ *  submitted to the driver now, the same way the hot reload
+ *  builds the single program, and keep drawing with their
+ *  old programs until FinishBuilds() swaps the new ones in.
+ *  The others are built from the new files on first use.
+ ***********************************************************/
+bool ShaderPermutations::Reload()
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+	if (!ShaderUtils::ReadTextFile(m_vertexShaderPath, vertexSource) ||
+		!ShaderUtils::ReadTextFile(m_fragmentShaderPath, fragmentSource))
+	{
+		std::cout << "Could not read the scene shaders, shader variants are disabled" << std::endl;
+		return false;
+	}
+
+	// both flags have to be declared in one of the stages
+	const char* flagNames[2] = { g_UseTextureName, g_UseLightingName };
+	for (const char* flagName : flagNames)
+	{
+		std::string vertexCheck = vertexSource;
+		std::string fragmentCheck = fragmentSource;
+		if (!SpecializeFlag(vertexCheck, flagName, true) && !SpecializeFlag(fragmentCheck, flagName, true))
+		{
+			std::cout << "The scene shaders do not declare the uniform " << flagName
+				<< ", shader variants are disabled" << std::endl;
+			return false;
+		}
+	}
+
+	m_vertexSource.swap(vertexSource);
+	m_fragmentSource.swap(fragmentSource);
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		// a newer save replaces a build that is still running
+		DiscardBuild(i);
+		m_bFailed[i] = false;
+		if (m_programs[i] != 0)
+		{
+			std::string variantVertex = BuildSource(m_vertexSource, i);
+			std::string variantFragment = BuildSource(m_fragmentSource, i);
+			m_pendingPrograms[i] = ShaderUtils::StartProgramBuild(
+				variantVertex.c_str(), variantFragment.c_str(), m_pendingShaders[i]);
+		}
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  FinishBuilds()
+ *
+ *  This method is used to check on the background builds.
+ *  A variant only changes program once its new one has
+ *  linked; one that fails prints its log and keeps the old.
+ ***********************************************************/
+unsigned int ShaderPermutations::FinishBuilds()
+{
+	unsigned int swapped = 0;
+	for (int i = 0; i < VARIANT_COUNT; i++)
+	{
+		if ((m_pendingPrograms[i] == 0) || (ShaderUtils::IsProgramBuildComplete(m_pendingPrograms[i]) == false))
+		{
+			continue;
+		}
+
+		GLuint program = m_pendingPrograms[i];
+		std::string programName = GetProgramName(i);
+		bool bBuilt = ShaderUtils::FinishProgramBuild(program, m_pendingShaders[i], programName.c_str());
+		m_pendingPrograms[i] = 0;
+		m_pendingShaders[i][0] = 0;
+		m_pendingShaders[i][1] = 0;
+		if (bBuilt == false)
+		{
+			std::cout << "INFO: Keeping the old " << programName << " program" << std::endl;
+			continue;
+		}
+
+		glDeleteProgram(m_programs[i]);
+		m_programs[i] = program;
+		swapped |= (1u << i);
+	}
+
+	if (swapped != 0)
+	{
+		std::cout << "INFO: Shader variants reloaded" << std::endl;
+	}
+	return(swapped);
+}
+
+/***********************************************************
+ *  BuildSource()
+ *
+ *  This method is used to apply the variant flags to one
+ *  shader stage.  The defines go right after the #version
+ *  line, which has to stay first.
+ ***********************************************************/
+std::string ShaderPermutations::BuildSource(const std::string& source, int variant) const
+{
+	std::string defines;
+	if (variant & VARIANT_TEXTURED)
+	{
+		defines += "#define USE_TEXTURE 1\n";
+	}
+	if (variant & VARIANT_LIT)
+	{
+		defines += "#define USE_LIGHTING 1\n";
+	}
+	if (variant & VARIANT_ALPHA_TESTED)
+	{
+		defines += "#define ALPHA_TEST 1\n";
+	}
+
+	std::string result = source;
+	size_t insertAt = 0;
+	size_t version = result.find("#version");
+	if (version != std::string::npos)
+	{
+		size_t lineEnd = result.find('\n', version);
+		insertAt = (lineEnd == std::string::npos) ? result.size() : lineEnd + 1;
+	}
+	result.insert(insertAt, defines);
+
+	SpecializeFlag(result, g_UseTextureName, (variant & VARIANT_TEXTURED) != 0);
+	SpecializeFlag(result, g_UseLightingName, (variant & VARIANT_LIT) != 0);
+	return(result);
+}
+
+/***********************************************************
+ *  GetProgramName()
+ *
+ *  This method is used to name the program of a variant
+ *  after its flags.
+ ***********************************************************/
+std::string ShaderPermutations::GetProgramName(int variant) const
+{
+	std::string programName = "scene";
+	programName += (variant & VARIANT_TEXTURED) ? "_textured" : "_untextured";
+	programName += (variant & VARIANT_LIT) ? "_lit" : "_unlit";
+	if (variant & VARIANT_ALPHA_TESTED)
+	{
+		programName += "_alphatest";
+	}
+	return(programName);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used to get the program of a variant.  The
+ *  first call compiles it (or loads it from the program
+ *  binary cache), and bCreated tells the caller to set the
+ *  uniforms that are only uploaded once.
+ ***********************************************************/
+GLuint ShaderPermutations::GetProgram(int variant, bool& bCreated)
+{
+	bCreated = false;
+	if ((variant < 0) || (variant >= VARIANT_COUNT) || m_bFailed[variant])
+	{
+		return 0;
+	}
+	if (m_programs[variant] != 0)
+	{
+		return(m_programs[variant]);
+	}
+
+	std::string programName = GetProgramName(variant);
+	std::string vertexSource = BuildSource(m_vertexSource, variant);
+	std::string fragmentSource = BuildSource(m_fragmentSource, variant);
+	m_programs[variant] = ShaderUtils::CreateProgram(vertexSource.c_str(), fragmentSource.c_str(), programName.c_str());
+	if (m_programs[variant] == 0)
+	{
+		m_bFailed[variant] = true;
+		return 0;
+	}
+
+	bCreated = true;
+	return(m_programs[variant]);
+}
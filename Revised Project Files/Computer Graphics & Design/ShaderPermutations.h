@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderpermutations.h
+// ============
+// compile-time variants of the scene shader, built on first use
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <string>
+
+/***********************************************************
+ *  ShaderPermutations
+ *
+ *  This class builds specialized copies of the scene shader.
+ *  Each variant gets its flags as #defines after the #version
+ *  line, and the bUseTexture / bUseLighting uniforms are
+ *  turned into constants, so the compiler strips the branches
+ *  the variant does not take.  Variants are only compiled the
+ *  first time a draw asks for them.  When the files are
+ *  edited, the variants already built are rebuilt in the
+ *  background and each one is swapped in once it links.
+ ***********************************************************/
+class ShaderPermutations
+{
+public:
+	// the flags a variant is built from
+	enum VARIANT_FLAG
+	{
+		VARIANT_TEXTURED = 1,
+		VARIANT_LIT = 2,
+		VARIANT_ALPHA_TESTED = 4
+	};
+	static const int VARIANT_COUNT = 8;
+
+	// constructor
+	ShaderPermutations();
+	// destructor
+	~ShaderPermutations();
+
+	// read the scene shader sources, false when they have no flag uniforms
+	bool Load(const char* vertexShaderPath, const char* fragmentShaderPath);
+	// read the same files again and start rebuilding the built variants,
+	// which keep their old programs until the new ones link
+	bool Reload();
+	// call once per frame - swaps in the rebuilt variants that have linked,
+	// returns a bit for each variant whose program changed
+	unsigned int FinishBuilds();
+
+	// the program for a variant, compiled now if needed (0 on failure)
+	GLuint GetProgram(int variant, bool& bCreated);
+
+private:
+	std::string m_vertexShaderPath;
+	std::string m_fragmentShaderPath;
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+
+	GLuint m_programs[VARIANT_COUNT];
+	// a variant that failed is not compiled again every frame
+	bool m_bFailed[VARIANT_COUNT];
+	// the variants being rebuilt in the background, 0 when not
+	GLuint m_pendingPrograms[VARIANT_COUNT];
+	GLuint m_pendingShaders[VARIANT_COUNT][2];
+
+	// delete every built variant
+	void Clear();
+	// release the objects of a background build
+	void DiscardBuild(int variant);
+	// the name a variant's program is logged and cached under
+	std::string GetProgramName(int variant) const;
+	// the source of one stage with the variant flags applied
+	std::string BuildSource(const std::string& source, int variant) const;
+};
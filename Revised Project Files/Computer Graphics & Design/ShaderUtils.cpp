@@ -0,0 +1,488 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderutils.cpp
+// ============
+// helpers for building the internal GLSL programs used by the render passes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderUtils.h"
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// where the program binaries are kept, empty when the cache is off
+	std::string g_CacheDirectory = "shader_cache";
+
+	// "SPBC" - shader program binary cache
+	const unsigned int CACHE_MAGIC = 0x43425053;
+	const unsigned int CACHE_VERSION = 1;
+
+	struct CACHE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int format;
+		unsigned int length;
+		unsigned long long key;
+	};
+
+	/***********************************************************
+	 *  PrintShaderLog()
+	 *
+	 *  This function is used to print why a shader stage
+	 *  failed to compile.
+	 ***********************************************************/
+	void PrintShaderLog(GLuint shaderID, GLenum shaderType, const char* programName)
+	{
+		GLint logLength = 0;
+		glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> infoLog(logLength > 1 ? logLength : 1, '\0');
+		glGetShaderInfoLog(shaderID, (GLsizei)infoLog.size(), nullptr, infoLog.data());
+
+		const char* stageName = (shaderType == GL_VERTEX_SHADER) ? " vertex" :
+			((shaderType == GL_COMPUTE_SHADER) ? " compute" : " fragment");
+		std::cout << "ERROR: " << programName << stageName
+			<< " shader failed to compile\n" << infoLog.data() << std::endl;
+	}
+
+	/***********************************************************
+	 *  PrintProgramLog()
+	 *
+	 *  This function is used to print why a program failed to
+	 *  link.
+	 ***********************************************************/
+	void PrintProgramLog(GLuint programID, const char* programName)
+	{
+		GLint logLength = 0;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> infoLog(logLength > 1 ? logLength : 1, '\0');
+		glGetProgramInfoLog(programID, (GLsizei)infoLog.size(), nullptr, infoLog.data());
+
+		std::cout << "ERROR: " << programName << " program failed to link\n" << infoLog.data() << std::endl;
+	}
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This function is used to compile one shader stage from
+ *  the passed in source.  The info log is printed on failure.
+ ***********************************************************/
+GLuint ShaderUtils::CompileShader(GLenum shaderType, const char* source, const char* programName)
+{
+	GLuint shaderID = glCreateShader(shaderType);
+	glShaderSource(shaderID, 1, &source, nullptr);
+	glCompileShader(shaderID);
+
+	GLint success = GL_FALSE;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &success);
+	if (success == GL_FALSE)
+	{
+		PrintShaderLog(shaderID, shaderType, programName);
+		glDeleteShader(shaderID);
+		return 0;
+	}
+
+	return(shaderID);
+}
+
+// helpers for the program binary cache
+namespace
+{
+	/***********************************************************
+	 *  LinkProgram()
+	 *
+	 *  This function is used to compile and link a complete
+	 *  program from the source of each of its stages.  The
+	 *  binary retrievable hint is set so it can be cached.
+	 ***********************************************************/
+	GLuint LinkProgram(const GLenum* stageTypes, const char* const* stageSources, int stageCount, const char* programName)
+	{
+		std::vector<GLuint> shaderIDs;
+		bool bCompiled = true;
+		for (int i = 0; i < stageCount; i++)
+		{
+			shaderIDs.push_back(ShaderUtils::CompileShader(stageTypes[i], stageSources[i], programName));
+			bCompiled = bCompiled && (shaderIDs.back() != 0);
+		}
+		if (bCompiled == false)
+		{
+			for (GLuint shaderID : shaderIDs)
+			{
+				glDeleteShader(shaderID);
+			}
+			return 0;
+		}
+
+		GLuint programID = glCreateProgram();
+		for (GLuint shaderID : shaderIDs)
+		{
+			glAttachShader(programID, shaderID);
+		}
+		glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(programID);
+
+		// the shader objects are no longer needed once linked
+		for (GLuint shaderID : shaderIDs)
+		{
+			glDetachShader(programID, shaderID);
+			glDeleteShader(shaderID);
+		}
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(programID, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			PrintProgramLog(programID, programName);
+			glDeleteProgram(programID);
+			return 0;
+		}
+
+		return(programID);
+	}
+
+	/***********************************************************
+	 *  GetCachePath()
+	 *
+	 *  This function is used to build the cache key and the file
+	 *  name for a program.  The key hashes the sources together
+	 *  with the driver strings, since a binary is only valid for
+	 *  the driver that produced it.
+	 ***********************************************************/
+	std::string GetCachePath(const char* const* stageSources, int stageCount,
+		const char* programName, unsigned long long& key)
+	{
+		// 64-bit FNV-1a
+		key = 1469598103934665603ULL;
+		auto hash = [&key](const char* text)
+		{
+			for (const char* c = text; (nullptr != c) && (*c != '\0'); c++)
+			{
+				key = (key ^ (unsigned char)*c) * 1099511628211ULL;
+			}
+			// a separator, so moving text between fields changes the key
+			key = (key ^ 0xFF) * 1099511628211ULL;
+		};
+		for (int i = 0; i < stageCount; i++)
+		{
+			hash(stageSources[i]);
+		}
+		hash((const char*)glGetString(GL_VENDOR));
+		hash((const char*)glGetString(GL_RENDERER));
+		hash((const char*)glGetString(GL_VERSION));
+
+		// keep the program name readable in the file name
+		std::string fileName = programName;
+		for (char& c : fileName)
+		{
+			if (!isalnum((unsigned char)c))
+			{
+				c = '_';
+			}
+		}
+
+		char keyText[17];
+		snprintf(keyText, sizeof(keyText), "%016llx", key);
+		return(g_CacheDirectory + "/" + fileName + "-" + keyText + ".bin");
+	}
+
+	/***********************************************************
+	 *  LoadCachedProgram()
+	 *
+	 *  This function is used to create a program from a cached
+	 *  binary.  Returns 0 when there is no usable entry or the
+	 *  driver rejects the binary (after a driver update, etc.).
+	 ***********************************************************/
+	GLuint LoadCachedProgram(const std::string& cachePath, unsigned long long key)
+	{
+		std::ifstream file(cachePath, std::ios::binary);
+		if (!file.is_open())
+		{
+			return 0;
+		}
+
+		CACHE_HEADER header;
+		if (!file.read((char*)&header, sizeof(header)) ||
+			(header.magic != CACHE_MAGIC) ||
+			(header.version != CACHE_VERSION) ||
+			(header.key != key) ||
+			(header.length == 0))
+		{
+			return 0;
+		}
+
+		std::vector<char> binary(header.length);
+		if (!file.read(binary.data(), header.length))
+		{
+			return 0;
+		}
+
+		GLuint programID = glCreateProgram();
+		glProgramBinary(programID, (GLenum)header.format, binary.data(), (GLsizei)header.length);
+
+		GLint success = GL_FALSE;
+		glGetProgramiv(programID, GL_LINK_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			glDeleteProgram(programID);
+			return 0;
+		}
+
+		return(programID);
+	}
+
+	/***********************************************************
+	 *  SaveCachedProgram()
+	 *
+	 *  This function is used to write the binary of a linked
+	 *  program to the cache.  The file is written under a
+	 *  temporary name and renamed, so a crash never leaves a
+	 *  half written entry behind.
+	 ***********************************************************/
+	void SaveCachedProgram(GLuint programID, const std::string& cachePath, unsigned long long key)
+	{
+		GLint length = 0;
+		glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(programID, length, nullptr, &format, binary.data());
+
+		std::error_code error;
+		std::filesystem::create_directories(g_CacheDirectory, error);
+
+		std::string temporaryPath = cachePath + ".tmp";
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::cout << "Could not write the shader cache entry " << cachePath << std::endl;
+				return;
+			}
+
+			CACHE_HEADER header;
+			header.magic = CACHE_MAGIC;
+			header.version = CACHE_VERSION;
+			header.format = format;
+			header.length = (unsigned int)length;
+			header.key = key;
+			file.write((const char*)&header, sizeof(header));
+			file.write(binary.data(), length);
+		}
+		std::filesystem::rename(temporaryPath, cachePath, error);
+	}
+
+	/***********************************************************
+	 *  BuildProgram()
+	 *
+	 *  This function is used to get a complete program, from
+	 *  the binary cache on a warm start or by compiling it on
+	 *  a cold start.  The time taken is logged either way.
+	 ***********************************************************/
+	GLuint BuildProgram(const GLenum* stageTypes, const char* const* stageSources, int stageCount, const char* programName)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+		// the cache needs the driver to support at least one binary format
+		GLint formatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+		bool bUseCache = (!g_CacheDirectory.empty()) && (formatCount > 0);
+
+		unsigned long long key = 0;
+		std::string cachePath;
+		GLuint programID = 0;
+		if (bUseCache)
+		{
+			cachePath = GetCachePath(stageSources, stageCount, programName, key);
+			programID = LoadCachedProgram(cachePath, key);
+		}
+
+		bool bFromCache = (programID != 0);
+		if (bFromCache == false)
+		{
+			programID = LinkProgram(stageTypes, stageSources, stageCount, programName);
+			if ((programID != 0) && bUseCache)
+			{
+				SaveCachedProgram(programID, cachePath, key);
+			}
+		}
+
+		if (programID != 0)
+		{
+			double milliseconds = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - startTime).count();
+			std::cout << "INFO: " << programName << " program "
+				<< (bFromCache ? "loaded from cache" : "compiled") << " in " << milliseconds << " ms" << std::endl;
+		}
+
+		return(programID);
+	}
+}
+
+/***********************************************************
+ *  SetProgramCacheDirectory()
+ *
+ *  This function is used to choose where the program
+ *  binaries are kept.
+ ***********************************************************/
+void ShaderUtils::SetProgramCacheDirectory(const char* directory)
+{
+	g_CacheDirectory = (nullptr != directory) ? directory : "";
+}
+
+/***********************************************************
+ *  CreateProgram()
+ *
+ *  This function is used to get a complete vertex +
+ *  fragment shader program.
+ ***********************************************************/
+GLuint ShaderUtils::CreateProgram(const char* vertexSource, const char* fragmentSource, const char* programName)
+{
+	const GLenum stageTypes[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char* stageSources[2] = { vertexSource, fragmentSource };
+	return BuildProgram(stageTypes, stageSources, 2, programName);
+}
+
+/***********************************************************
+ *  StartProgramBuild()
+ *
+ *  This function is used to submit the compile and link of
+ *  a vertex + fragment program without querying any status,
+ *  so with GL_KHR_parallel_shader_compile the driver builds
+ *  it on its own threads while frames keep rendering.
+ ***********************************************************/
+GLuint ShaderUtils::StartProgramBuild(const char* vertexSource, const char* fragmentSource, GLuint shaderIDs[2])
+{
+	const GLenum stageTypes[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char* stageSources[2] = { vertexSource, fragmentSource };
+	GLuint programID = glCreateProgram();
+	for (int i = 0; i < 2; i++)
+	{
+		shaderIDs[i] = glCreateShader(stageTypes[i]);
+		glShaderSource(shaderIDs[i], 1, &stageSources[i], nullptr);
+		glCompileShader(shaderIDs[i]);
+		glAttachShader(programID, shaderIDs[i]);
+	}
+	glLinkProgram(programID);
+	return(programID);
+}
+
+/***********************************************************
+ *  IsProgramBuildComplete()
+ *
+ *  This function is used to find out, without waiting, if a
+ *  program from StartProgramBuild() can be checked.  Without
+ *  parallel compile the check simply waits for the driver.
+ ***********************************************************/
+bool ShaderUtils::IsProgramBuildComplete(GLuint programID)
+{
+	if (GLEW_KHR_parallel_shader_compile == GL_FALSE)
+	{
+		return true;
+	}
+	GLint bComplete = GL_FALSE;
+	glGetProgramiv(programID, GL_COMPLETION_STATUS_KHR, &bComplete);
+	return(bComplete != GL_FALSE);
+}
+
+/***********************************************************
+ *  FinishProgramBuild()
+ *
+ *  This function is used to check a program built by
+ *  StartProgramBuild(), printing the log of the stage or
+ *  link that failed.  The shader objects are freed, and so
+ *  is the program when it failed.
+ ***********************************************************/
+bool ShaderUtils::FinishProgramBuild(GLuint programID, const GLuint shaderIDs[2], const char* programName)
+{
+	const GLenum stageTypes[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	bool bCompiled = true;
+	for (int i = 0; i < 2; i++)
+	{
+		GLint success = GL_FALSE;
+		glGetShaderiv(shaderIDs[i], GL_COMPILE_STATUS, &success);
+		if (success == GL_FALSE)
+		{
+			PrintShaderLog(shaderIDs[i], stageTypes[i], programName);
+			bCompiled = false;
+		}
+	}
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(programID, GL_LINK_STATUS, &bLinked);
+	if (bCompiled && (bLinked == GL_FALSE))
+	{
+		PrintProgramLog(programID, programName);
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		glDetachShader(programID, shaderIDs[i]);
+		glDeleteShader(shaderIDs[i]);
+	}
+	if (!bCompiled || (bLinked == GL_FALSE))
+	{
+		glDeleteProgram(programID);
+		return false;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  CreateComputeProgram()
+ *
+ *  This function is used to get a compute shader program.
+ *  The context has to support compute (OpenGL 4.3).
+ ***********************************************************/
+GLuint ShaderUtils::CreateComputeProgram(const char* computeSource, const char* programName)
+{
+	const GLenum stageTypes[1] = { GL_COMPUTE_SHADER };
+	const char* stageSources[1] = { computeSource };
+	return BuildProgram(stageTypes, stageSources, 1, programName);
+}
+
+/***********************************************************
+ *  SetSamplerUnit()
+ *
+ *  This function is used to point a sampler uniform at a
+ *  fixed texture unit.  The program must already be in use.
+ ***********************************************************/
+void ShaderUtils::SetSamplerUnit(GLuint programID, const char* samplerName, int textureUnit)
+{
+	GLint location = glGetUniformLocation(programID, samplerName);
+	if (location >= 0)
+	{
+		glUniform1i(location, textureUnit);
+	}
+}
+
+/***********************************************************
+ *  ReadTextFile()
+ *
+ *  This function is used to read a whole shader file.
+ ***********************************************************/
+bool ShaderUtils::ReadTextFile(const std::string& filePath, std::string& text)
+{
+	std::ifstream file(filePath);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	text = contents.str();
+	return true;
+}
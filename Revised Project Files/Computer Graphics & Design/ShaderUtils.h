@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderutils.h
+// ============
+// helpers for building the internal GLSL programs used by the render passes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include <string>
+
+/***********************************************************
+ *  ShaderUtils
+ *
+ *  The scene shaders are read from the external GLSL files,
+ *  and the extra render passes (G-buffer, lighting, etc.)
+ *  keep their small shaders embedded in the source.  These
+ *  helpers compile and link both.
+ *
+ *  Linked programs are cached on disk as driver binaries, so
+ *  later launches skip compiling.  The cache key covers the
+ *  sources and the driver vendor, renderer and version, and
+ *  any binary the driver rejects is simply rebuilt.
+ ***********************************************************/
+namespace ShaderUtils
+{
+	// compile a single shader stage, returns 0 on failure
+	GLuint CompileShader(GLenum shaderType, const char* source, const char* programName);
+
+	// compile and link a vertex + fragment program, returns 0 on failure
+	// (loaded from the program binary cache when possible)
+	GLuint CreateProgram(const char* vertexSource, const char* fragmentSource, const char* programName);
+
+	// submit the compile and link of a vertex + fragment program without
+	// waiting on the driver, returns the program and its two stages
+	GLuint StartProgramBuild(const char* vertexSource, const char* fragmentSource, GLuint shaderIDs[2]);
+	// true once a submitted program can be checked without stalling
+	bool IsProgramBuildComplete(GLuint programID);
+	// check a submitted program and free its stages, printing what failed
+	// (false, and the program deleted, when it did not compile or link)
+	bool FinishProgramBuild(GLuint programID, const GLuint shaderIDs[2], const char* programName);
+
+	// compile and link a compute program, returns 0 on failure
+	GLuint CreateComputeProgram(const char* computeSource, const char* programName);
+
+	// folder for the program binary cache, nullptr turns the cache off
+	void SetProgramCacheDirectory(const char* directory);
+
+	// set a sampler uniform to a fixed texture unit (program must be in use)
+	void SetSamplerUnit(GLuint programID, const char* samplerName, int textureUnit);
+
+	// read a whole shader file, false when it cannot be opened
+	bool ReadTextFile(const std::string& filePath, std::string& text);
+}
@@ -0,0 +1,271 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapebuilder.cpp
+// ============
+// generators for the basic shapes the scene is built from
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeBuilder.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	/***********************************************************
+	 *  AddQuad()
+	 *
+	 *  This function is used to add a flat square facing along
+	 *  the cross product of its two axes, as two triangles
+	 *  with texture coordinates 0 to 1.
+	 ***********************************************************/
+	void AddQuad(MeshData& mesh, const glm::vec3& center, const glm::vec3& axisU, const glm::vec3& axisV)
+	{
+		glm::vec3 normal = glm::normalize(glm::cross(axisU, axisV));
+		unsigned int first = mesh.AddVertex(center - axisU - axisV, normal, glm::vec2(0.0f, 0.0f));
+		mesh.AddVertex(center + axisU - axisV, normal, glm::vec2(1.0f, 0.0f));
+		mesh.AddVertex(center + axisU + axisV, normal, glm::vec2(1.0f, 1.0f));
+		mesh.AddVertex(center - axisU + axisV, normal, glm::vec2(0.0f, 1.0f));
+		mesh.AddTriangle(first, first + 1, first + 2);
+		mesh.AddTriangle(first, first + 2, first + 3);
+	}
+
+	/***********************************************************
+	 *  AddDisc()
+	 *
+	 *  This function is used to add a flat round cap at the
+	 *  passed in height, facing up or down.
+	 ***********************************************************/
+	void AddDisc(MeshData& mesh, float y, float radius, int slices, bool bFacingUp)
+	{
+		glm::vec3 normal(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+		unsigned int center = mesh.AddVertex(glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+		for (int i = 0; i <= slices; i++)
+		{
+			float angle = glm::two_pi<float>() * i / slices;
+			float c = std::cos(angle);
+			float s = std::sin(angle);
+			mesh.AddVertex(glm::vec3(radius * c, y, radius * s), normal, glm::vec2(0.5f + 0.5f * c, 0.5f + 0.5f * s));
+		}
+		for (int i = 0; i < slices; i++)
+		{
+			unsigned int ring = center + 1 + i;
+			if (bFacingUp)
+			{
+				mesh.AddTriangle(center, ring + 1, ring);
+			}
+			else
+			{
+				mesh.AddTriangle(center, ring, ring + 1);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  BuildFrustum()
+	 *
+	 *  This function is used to build a closed cylinder from
+	 *  Y 0 to Y 1 whose radius can change from the bottom to
+	 *  the top.  The side normals lean out by the slope, and
+	 *  the texture wraps once around the side.
+	 ***********************************************************/
+	void BuildFrustum(MeshData& mesh, float bottomRadius, float topRadius, int slices)
+	{
+		mesh.Clear();
+		slices = std::max(slices, 3);
+
+		// the side repeats its first column so the texture seam can close
+		unsigned int first = (unsigned int)mesh.vertices.size();
+		float slope = bottomRadius - topRadius;
+		for (int i = 0; i <= slices; i++)
+		{
+			float angle = glm::two_pi<float>() * i / slices;
+			float c = std::cos(angle);
+			float s = std::sin(angle);
+			glm::vec3 normal = glm::normalize(glm::vec3(c, slope, s));
+			float u = (float)i / slices;
+			mesh.AddVertex(glm::vec3(bottomRadius * c, 0.0f, bottomRadius * s), normal, glm::vec2(u, 0.0f));
+			mesh.AddVertex(glm::vec3(topRadius * c, 1.0f, topRadius * s), normal, glm::vec2(u, 1.0f));
+		}
+		for (int i = 0; i < slices; i++)
+		{
+			unsigned int bottom = first + i * 2;
+			unsigned int top = bottom + 1;
+			mesh.AddTriangle(bottom, top, bottom + 2);
+			mesh.AddTriangle(bottom + 2, top, top + 2);
+		}
+
+		AddDisc(mesh, 1.0f, topRadius, slices, true);
+		AddDisc(mesh, 0.0f, bottomRadius, slices, false);
+	}
+
+	/***********************************************************
+	 *  AddSphereBand()
+	 *
+	 *  This function is used to add the rings of a unit sphere
+	 *  from the north pole down to the passed in stack.  The
+	 *  texture V runs from 1 at the north pole to 0 at the
+	 *  south pole of the whole sphere.
+	 ***********************************************************/
+	void AddSphereBand(MeshData& mesh, int stacks, int lastStack, int sectors)
+	{
+		unsigned int first = (unsigned int)mesh.vertices.size();
+		for (int stack = 0; stack <= lastStack; stack++)
+		{
+			float polar = glm::pi<float>() * stack / stacks;
+			float ringRadius = std::sin(polar);
+			float y = std::cos(polar);
+			for (int sector = 0; sector <= sectors; sector++)
+			{
+				float angle = glm::two_pi<float>() * sector / sectors;
+				glm::vec3 position(ringRadius * std::cos(angle), y, ringRadius * std::sin(angle));
+				mesh.AddVertex(position, position, glm::vec2((float)sector / sectors, 1.0f - (float)stack / stacks));
+			}
+		}
+
+		// the triangles that touch a pole would have no area, so they are left out
+		unsigned int rowLength = sectors + 1;
+		for (int stack = 0; stack < lastStack; stack++)
+		{
+			for (int sector = 0; sector < sectors; sector++)
+			{
+				unsigned int upper = first + stack * rowLength + sector;
+				unsigned int lower = upper + rowLength;
+				if (stack != stacks - 1)
+				{
+					mesh.AddTriangle(lower, upper, lower + 1);
+				}
+				if (stack != 0)
+				{
+					mesh.AddTriangle(lower + 1, upper, upper + 1);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This function is used to build the 2 x 2 plane.
+ ***********************************************************/
+void ShapeBuilder::BuildPlane(MeshData& mesh)
+{
+	mesh.Clear();
+	AddQuad(mesh, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This function is used to build the unit box, with its
+ *  own normals and full texture on every face.
+ ***********************************************************/
+void ShapeBuilder::BuildBox(MeshData& mesh)
+{
+	mesh.Clear();
+	const glm::vec3 x(0.5f, 0.0f, 0.0f);
+	const glm::vec3 y(0.0f, 0.5f, 0.0f);
+	const glm::vec3 z(0.0f, 0.0f, 0.5f);
+	AddQuad(mesh, z, x, y);
+	AddQuad(mesh, -z, -x, y);
+	AddQuad(mesh, x, -z, y);
+	AddQuad(mesh, -x, z, y);
+	AddQuad(mesh, y, x, -z);
+	AddQuad(mesh, -y, x, z);
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This function is used to build the closed cylinder.
+ ***********************************************************/
+void ShapeBuilder::BuildCylinder(MeshData& mesh, int slices)
+{
+	BuildFrustum(mesh, 1.0f, 1.0f, slices);
+}
+
+/***********************************************************
+ *  BuildTaperedCylinder()
+ *
+ *  This function is used to build the closed cylinder that
+ *  narrows to half its radius at the top.
+ ***********************************************************/
+void ShapeBuilder::BuildTaperedCylinder(MeshData& mesh, int slices)
+{
+	BuildFrustum(mesh, 1.0f, 0.5f, slices);
+}
+
+/***********************************************************
+ *  BuildPyramid4()
+ *
+ *  This function is used to build the four sided pyramid.
+ *  Each side is one triangle with a flat normal, and the
+ *  base is a square facing down.
+ ***********************************************************/
+void ShapeBuilder::BuildPyramid4(MeshData& mesh)
+{
+	mesh.Clear();
+	const glm::vec3 apex(0.0f, 0.5f, 0.0f);
+	const glm::vec3 up(0.0f, 1.0f, 0.0f);
+	const glm::vec3 sides[4] = {
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f) };
+	for (const glm::vec3& side : sides)
+	{
+		glm::vec3 along = glm::cross(up, side);
+		glm::vec3 left = 0.5f * (side - along) - 0.5f * up;
+		glm::vec3 right = 0.5f * (side + along) - 0.5f * up;
+		glm::vec3 normal = glm::normalize(glm::cross(right - left, apex - left));
+		unsigned int first = mesh.AddVertex(left, normal, glm::vec2(0.0f, 0.0f));
+		mesh.AddVertex(right, normal, glm::vec2(1.0f, 0.0f));
+		mesh.AddVertex(apex, normal, glm::vec2(0.5f, 1.0f));
+		mesh.AddTriangle(first, first + 1, first + 2);
+	}
+	AddQuad(mesh, glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f));
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This function is used to build the unit sphere from
+ *  rings of latitude, north pole first.
+ ***********************************************************/
+void ShapeBuilder::BuildSphere(MeshData& mesh, int stacks, int sectors)
+{
+	mesh.Clear();
+	stacks = std::max(stacks, 2);
+	sectors = std::max(sectors, 3);
+	AddSphereBand(mesh, stacks, stacks, sectors);
+}
+
+/***********************************************************
+ *  BuildHalfSphere()
+ *
+ *  This function is used to build the top half of the unit
+ *  sphere, with a flat base so it is closed.  The stack
+ *  count is for the whole sphere, so both halves match.
+ ***********************************************************/
+void ShapeBuilder::BuildHalfSphere(MeshData& mesh, int stacks, int sectors)
+{
+	mesh.Clear();
+	stacks = std::max((stacks + 1) / 2 * 2, 2);
+	sectors = std::max(sectors, 3);
+	AddSphereBand(mesh, stacks, stacks / 2, sectors);
+	AddDisc(mesh, 0.0f, 1.0f, sectors, false);
+}
+
+/***********************************************************
+ *  GetChordError()
+ *
+ *  This function is used to get the gap between a unit
+ *  circle and the segments it was built from, which is the
+ *  geometric error of the round shapes.
+ ***********************************************************/
+float ShapeBuilder::GetChordError(int segments)
+{
+	return 1.0f - std::cos(glm::pi<float>() / std::max(segments, 3));
+}
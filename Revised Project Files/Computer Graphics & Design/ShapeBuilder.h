@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// shapebuilder.h
+// ============
+// generators for the basic shapes the scene is built from
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+/***********************************************************
+ *  ShapeBuilder
+ *
+ *  These functions build the basic shapes as indexed
+ *  triangle lists, with the same sizes and texture mapping
+ *  as the course ShapeMeshes, so the scene transformations
+ *  did not have to change:
+ *
+ *    plane            -1 to 1 in X and Z, facing +Y
+ *    box              -0.5 to 0.5 on every axis
+ *    cylinder         radius 1, from Y 0 up to Y 1
+ *    tapered cylinder radius 1 at the bottom, 0.5 at the top
+ *    pyramid          base -0.5 to 0.5 at Y -0.5, apex at Y 0.5
+ *    sphere           radius 1 around the origin
+ *    half sphere      the top half of the sphere, closed at Y 0
+ *
+ *  Each call replaces the contents of the passed in mesh.
+ ***********************************************************/
+namespace ShapeBuilder
+{
+	void BuildPlane(MeshData& mesh);
+	void BuildBox(MeshData& mesh);
+	void BuildCylinder(MeshData& mesh, int slices);
+	void BuildTaperedCylinder(MeshData& mesh, int slices);
+	void BuildPyramid4(MeshData& mesh);
+	void BuildSphere(MeshData& mesh, int stacks, int sectors);
+	void BuildHalfSphere(MeshData& mesh, int stacks, int sectors);
+
+	// how far a circle of radius 1 cut into this many straight
+	// segments is from the true circle, at the middle of a segment
+	float GetChordError(int segments);
+}
@@ -0,0 +1,361 @@
+///////////////////////////////////////////////////////////////////////////////
+// statsoverlay.cpp
+// ============
+// on-screen render statistics drawn with a small bitmap font
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StatsOverlay.h"
+#include "ShaderUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// glyphs are 5x7 pixels in 6x8 cells, so they never touch
+	const int GLYPH_WIDTH = 5;
+	const int GLYPH_HEIGHT = 7;
+	const int CELL_WIDTH = 6;
+	const int CELL_HEIGHT = 8;
+	// each font pixel covers this many screen pixels
+	const float PIXEL_SCALE = 2.0f;
+	const float MARGIN = 8.0f;
+
+	struct GLYPH
+	{
+		char character;
+		// one byte per row, top row first, bit 4 is the left column
+		unsigned char rows[GLYPH_HEIGHT];
+	};
+
+	// only the characters the overlay needs - lower case is drawn as upper case
+	const GLYPH g_Font[] = {
+		{ ' ', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+		{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+		{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+		{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+		{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+		{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+		{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+		{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+		{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+		{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+		{ 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'B', { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E } },
+		{ 'C', { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E } },
+		{ 'D', { 0x1E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1E } },
+		{ 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+		{ 'F', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'G', { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F } },
+		{ 'H', { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'I', { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+		{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+		{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F } },
+		{ 'M', { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+		{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+		{ 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'P', { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 } },
+		{ 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+		{ 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+		{ 'S', { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E } },
+		{ 'T', { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+		{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+		{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 } },
+		{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A } },
+		{ 'X', { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 } },
+		{ 'Y', { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 } },
+		{ 'Z', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F } },
+		{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+		{ ',', { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+		{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+		{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+		{ '/', { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 } },
+		{ '%', { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+		{ '(', { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 } },
+		{ ')', { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 } },
+	};
+	const int FONT_GLYPH_COUNT = sizeof(g_Font) / sizeof(g_Font[0]);
+
+	const char* g_OverlayVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec2 inTextureCoordinate;
+layout (location = 2) in vec4 inColor;
+
+uniform vec2 screenSize;
+
+out vec2 fragmentTextureCoordinate;
+out vec4 fragmentColor;
+
+void main()
+{
+	// pixel coordinates with the origin at the top left
+	vec2 ndc = (inPosition / screenSize) * 2.0 - 1.0;
+	gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+	fragmentTextureCoordinate = inTextureCoordinate;
+	fragmentColor = inColor;
+}
+)";
+
+	const char* g_OverlayFragmentShader = R"(
+#version 330 core
+in vec2 fragmentTextureCoordinate;
+in vec4 fragmentColor;
+
+uniform sampler2D fontTexture;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+	float coverage = texture(fontTexture, fragmentTextureCoordinate).r;
+	outFragmentColor = vec4(fragmentColor.rgb, fragmentColor.a * coverage);
+}
+)";
+}
+
+/***********************************************************
+ *  StatsOverlay()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StatsOverlay::StatsOverlay()
+{
+	m_fontTexture = 0;
+	m_program = 0;
+	m_screenSizeLocation = -1;
+	m_vao = 0;
+	m_vbo = 0;
+	m_fontTextureWidth = 0;
+	for (int i = 0; i < 128; i++)
+	{
+		m_glyphCell[i] = -1;
+	}
+	m_solidCell = 0;
+}
+
+/***********************************************************
+ *  ~StatsOverlay()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StatsOverlay::~StatsOverlay()
+{
+	glDeleteTextures(1, &m_fontTexture);
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteVertexArrays(1, &m_vao);
+	if (m_program != 0)
+	{
+		glDeleteProgram(m_program);
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to unpack the font into a texture
+ *  (one cell per glyph plus a solid cell for the panel) and
+ *  to set up the program and the vertex layout.
+ ***********************************************************/
+bool StatsOverlay::Initialize()
+{
+	m_program = ShaderUtils::CreateProgram(g_OverlayVertexShader, g_OverlayFragmentShader, "stats overlay");
+	if (m_program == 0)
+	{
+		return false;
+	}
+	m_screenSizeLocation = glGetUniformLocation(m_program, "screenSize");
+	glUseProgram(m_program);
+	ShaderUtils::SetSamplerUnit(m_program, "fontTexture", 0);
+	glUseProgram(0);
+
+	m_solidCell = FONT_GLYPH_COUNT;
+	m_fontTextureWidth = (FONT_GLYPH_COUNT + 1) * CELL_WIDTH;
+	std::vector<unsigned char> pixels(m_fontTextureWidth * CELL_HEIGHT, 0);
+	for (int glyph = 0; glyph < FONT_GLYPH_COUNT; glyph++)
+	{
+		m_glyphCell[(int)g_Font[glyph].character] = glyph;
+		for (int row = 0; row < GLYPH_HEIGHT; row++)
+		{
+			for (int column = 0; column < GLYPH_WIDTH; column++)
+			{
+				if (g_Font[glyph].rows[row] & (0x10 >> column))
+				{
+					pixels[(row * m_fontTextureWidth) + (glyph * CELL_WIDTH) + column] = 255;
+				}
+			}
+		}
+	}
+	for (int row = 0; row < CELL_HEIGHT; row++)
+	{
+		for (int column = 0; column < CELL_WIDTH; column++)
+		{
+			pixels[(row * m_fontTextureWidth) + (m_solidCell * CELL_WIDTH) + column] = 255;
+		}
+	}
+
+	glGenTextures(1, &m_fontTexture);
+	glBindTexture(GL_TEXTURE_2D, m_fontTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_fontTextureWidth, CELL_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vbo);
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(OVERLAY_VERTEX), (void*)offsetof(OVERLAY_VERTEX, x));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(OVERLAY_VERTEX), (void*)offsetof(OVERLAY_VERTEX, u));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(OVERLAY_VERTEX), (void*)offsetof(OVERLAY_VERTEX, r));
+	glEnableVertexAttribArray(2);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return true;
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used to add two triangles covering one
+ *  font atlas cell to the batch.
+ ***********************************************************/
+void StatsOverlay::AddQuad(float x, float y, float width, float height, int cell, const float color[4])
+{
+	float u0 = (float)(cell * CELL_WIDTH) / m_fontTextureWidth;
+	float u1 = (float)((cell * CELL_WIDTH) + GLYPH_WIDTH) / m_fontTextureWidth;
+	float v0 = 0.0f;
+	float v1 = (float)GLYPH_HEIGHT / CELL_HEIGHT;
+
+	const OVERLAY_VERTEX corners[4] = {
+		{ x, y, u0, v0, color[0], color[1], color[2], color[3] },
+		{ x + width, y, u1, v0, color[0], color[1], color[2], color[3] },
+		{ x + width, y + height, u1, v1, color[0], color[1], color[2], color[3] },
+		{ x, y + height, u0, v1, color[0], color[1], color[2], color[3] }
+	};
+	const int order[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; i++)
+	{
+		m_vertices.push_back(corners[order[i]]);
+	}
+}
+
+/***********************************************************
+ *  AddText()
+ *
+ *  This method is used to add one line of text to the batch.
+ ***********************************************************/
+float StatsOverlay::AddText(float x, float y, const char* text, const float color[4])
+{
+	float startX = x;
+	for (const char* c = text; *c != '\0'; c++)
+	{
+		int character = toupper((unsigned char)*c);
+		int cell = (character < 128) ? m_glyphCell[character] : -1;
+		if ((cell >= 0) && (character != ' '))
+		{
+			AddQuad(x, y, GLYPH_WIDTH * PIXEL_SCALE, GLYPH_HEIGHT * PIXEL_SCALE, cell, color);
+		}
+		x += CELL_WIDTH * PIXEL_SCALE;
+	}
+	return(x - startX);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used to draw the statistics panel in the
+ *  top left corner of the bound framebuffer.
+ ***********************************************************/
+void StatsOverlay::Draw(const RenderStats& stats, double frameMs, int screenWidth, int screenHeight)
+{
+	if ((m_program == 0) || (screenWidth <= 0) || (screenHeight <= 0))
+	{
+		return;
+	}
+
+	char lines[13][64];
+	int lineCount = 10;
+	snprintf(lines[0], 64, "frame       %.2f ms", frameMs);
+	snprintf(lines[1], 64, "draw calls  %d", stats.drawCalls);
+	snprintf(lines[2], 64, "triangles   %lld", stats.triangles);
+	snprintf(lines[3], 64, "uniforms    %d", stats.uniformUploads);
+	snprintf(lines[4], 64, "tex binds   %d", stats.textureBinds);
+	snprintf(lines[5], 64, "programs    %d", stats.programSwitches);
+	snprintf(lines[6], 64, "switches    %d", stats.materialSwitches);
+	snprintf(lines[7], 64, "culled      %d", stats.culledObjects);
+	snprintf(lines[8], 64, "uploaded    %.1f kb", stats.bufferBytesUploaded / 1024.0);
+	snprintf(lines[9], 64, "vertex data %.1f kb", stats.vertexBytes / 1024.0);
+	// the streamed texture lines only show when streaming is on
+	if (stats.textureBytesBudget > 0)
+	{
+		snprintf(lines[10], 64, "tex memory  %.1f / %.1f mb",
+			stats.textureBytesResident / (1024.0 * 1024.0), stats.textureBytesBudget / (1024.0 * 1024.0));
+		snprintf(lines[11], 64, "tex stream  %d pending", stats.textureRequestsPending);
+		lineCount = 12;
+	}
+	// and the virtual texture line only when pages are in the cache
+	if (stats.virtualPagesResident > 0)
+	{
+		snprintf(lines[lineCount], 64, "vt pages    %d +%d, %d pending",
+			stats.virtualPagesResident, stats.virtualPagesUploaded, stats.virtualPagesPending);
+		lineCount++;
+	}
+
+	const float panelColor[4] = { 0.0f, 0.0f, 0.0f, 0.6f };
+	const float textColor[4] = { 1.0f, 1.0f, 0.6f, 1.0f };
+	float lineHeight = CELL_HEIGHT * PIXEL_SCALE + 2.0f;
+
+	// the panel goes in first so the text is drawn over it in the same batch
+	size_t longest = 0;
+	for (int i = 0; i < lineCount; i++)
+	{
+		longest = std::max(longest, strlen(lines[i]));
+	}
+	m_vertices.clear();
+	AddQuad(MARGIN - 4.0f, MARGIN - 4.0f,
+		(longest * CELL_WIDTH * PIXEL_SCALE) + 8.0f, (lineCount * lineHeight) + 6.0f,
+		m_solidCell, panelColor);
+	for (int i = 0; i < lineCount; i++)
+	{
+		AddText(MARGIN, MARGIN + (i * lineHeight), lines[i], textColor);
+	}
+
+	// the overlay is 2D, so it ignores the depth buffer and blends on top
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(m_program);
+	glUniform2f(m_screenSizeLocation, (float)screenWidth, (float)screenHeight);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_fontTexture);
+
+	// one upload and one draw call for the whole overlay
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(OVERLAY_VERTEX), m_vertices.data(), GL_STREAM_DRAW);
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)m_vertices.size());
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (bDepthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+}
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// statsoverlay.h
+// ============
+// on-screen render statistics drawn with a small bitmap font
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include "RenderStats.h"
+
+#include <vector>
+
+/***********************************************************
+ *  StatsOverlay
+ *
+ *  This class draws the render statistics in the corner of
+ *  the screen.  The text uses a built-in 5x7 pixel font kept
+ *  in a tiny texture, and every character of the overlay is
+ *  batched into one vertex buffer so the whole overlay is a
+ *  single draw call.
+ ***********************************************************/
+class StatsOverlay
+{
+public:
+	// constructor
+	StatsOverlay();
+	// destructor
+	~StatsOverlay();
+
+	// build the font texture, the program and the vertex buffer
+	bool Initialize();
+
+	// draw the statistics into the currently bound framebuffer
+	void Draw(const RenderStats& stats, double frameMs, int screenWidth, int screenHeight);
+
+private:
+	struct OVERLAY_VERTEX
+	{
+		float x, y;
+		float u, v;
+		float r, g, b, a;
+	};
+
+	GLuint m_fontTexture;
+	GLuint m_program;
+	GLint m_screenSizeLocation;
+	GLuint m_vao;
+	GLuint m_vbo;
+	int m_fontTextureWidth;
+
+	// atlas cell of every character, -1 when the font does not have it
+	int m_glyphCell[128];
+	// the fully lit cell used for the background panel
+	int m_solidCell;
+
+	std::vector<OVERLAY_VERTEX> m_vertices;
+
+	// add one textured quad to the batch
+	void AddQuad(float x, float y, float width, float height, int cell, const float color[4]);
+	// add a line of text to the batch, returns its width in pixels
+	float AddText(float x, float y, const char* text, const float color[4]);
+};
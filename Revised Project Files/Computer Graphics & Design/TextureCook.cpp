@@ -0,0 +1,283 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecook.cpp
+// ============
+// offline tool that converts the scene textures to block compressed KTX2 files
+//
+//  Build this file with BlockCompression.cpp, KtxTexture.cpp, MipGenerator.cpp
+//  and VirtualPageFile.cpp as its own executable, then run it on the texture
+//  folder:
+//
+//    TextureCook [--format auto|bc1|bc3|bc7] --dir ../../Utilities/textures
+//    TextureCook [--format ...] image.png [image.jpg ...]
+//
+//  --virtual writes the page file of a very large unique image (.vtex) for
+//  virtual texturing instead:
+//
+//    TextureCook --virtual ../../Utilities/textures/floor_unique.png
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp, memcpy
+#include <algorithm>        // std::min, std::max
+#include <chrono>           // cook timing
+#include <filesystem>       // --dir folder listing
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "BlockCompression.h"
+#include "KtxTexture.h"
+#include "MipGenerator.h"
+#include "VirtualPageFile.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// the block format to write, FORMAT_NONE picks BC1 or BC3 per image
+	KtxTexture::BLOCK_FORMAT g_Format = KtxTexture::FORMAT_NONE;
+	// write virtual texture page files instead of KTX2 files
+	bool g_bVirtual = false;
+}
+
+// Function declarations
+bool CookTexture(const std::string& imagePath);
+bool CookVirtualTexture(const std::string& imagePath);
+void CompressLevel(const std::vector<unsigned char>& texels, int width, int height,
+	KtxTexture::BLOCK_FORMAT format, std::vector<unsigned char>& blocks);
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function is used to read the options and cook each
+ *  image that was named or found in the --dir folders.
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> images;
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--format") == 0) && (i + 1 < argc))
+		{
+			i++;
+			if (strcmp(argv[i], "bc1") == 0)
+			{
+				g_Format = KtxTexture::FORMAT_BC1;
+			}
+			else if (strcmp(argv[i], "bc3") == 0)
+			{
+				g_Format = KtxTexture::FORMAT_BC3;
+			}
+			else if (strcmp(argv[i], "bc7") == 0)
+			{
+				g_Format = KtxTexture::FORMAT_BC7;
+			}
+			else
+			{
+				g_Format = KtxTexture::FORMAT_NONE;
+			}
+		}
+		else if ((strcmp(argv[i], "--dir") == 0) && (i + 1 < argc))
+		{
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(argv[++i], error))
+			{
+				std::string extension = entry.path().extension().string();
+				if ((extension == ".jpg") || (extension == ".jpeg") || (extension == ".png"))
+				{
+					images.push_back(entry.path().string());
+				}
+			}
+			if (error)
+			{
+				std::cout << "ERROR: Could not list " << argv[i] << std::endl;
+				return(EXIT_FAILURE);
+			}
+		}
+		else if (strcmp(argv[i], "--virtual") == 0)
+		{
+			g_bVirtual = true;
+		}
+		else if (argv[i][0] == '-')
+		{
+			std::cout << "Unknown option: " << argv[i] << std::endl;
+		}
+		else
+		{
+			images.push_back(argv[i]);
+		}
+	}
+
+	if (images.empty())
+	{
+		std::cout << "Usage: TextureCook [--format auto|bc1|bc3|bc7] [--virtual] [--dir FOLDER] [image ...]" << std::endl;
+		return(EXIT_FAILURE);
+	}
+
+	bool bSuccess = true;
+	for (const std::string& image : images)
+	{
+		bSuccess = (g_bVirtual ? CookVirtualTexture(image) : CookTexture(image)) && bSuccess;
+	}
+
+	return(bSuccess ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *  CookTexture()
+ *
+ *  This function is used to decode one image, build its mip
+ *  chain, compress every level and write the .ktx2 next to
+ *  the image, where SceneManager looks for it.  The image is
+ *  flipped the same way the runtime stb_image path flips it,
+ *  so the texture coordinates stay the same.
+ ***********************************************************/
+bool CookTexture(const std::string& imagePath)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(imagePath.c_str(), &width, &height, &colorChannels, 4);
+	if (nullptr == image)
+	{
+		std::cout << "Could not load image:" << imagePath << std::endl;
+		return false;
+	}
+
+	// images with no transparent texel only need the 8 byte BC1 blocks
+	KtxTexture::BLOCK_FORMAT format = g_Format;
+	if (format == KtxTexture::FORMAT_NONE)
+	{
+		format = KtxTexture::FORMAT_BC1;
+		for (size_t i = 3; i < (size_t)width * height * 4; i += 4)
+		{
+			if (image[i] != 255)
+			{
+				format = KtxTexture::FORMAT_BC3;
+				break;
+			}
+		}
+	}
+
+	std::vector<std::vector<unsigned char>> mips(1);
+	mips[0].assign(image, image + (size_t)width * height * 4);
+	stbi_image_free(image);
+	// the images are sRGB, so the mips are filtered in linear light
+	MipGenerator::BuildMipChain(mips[0].data(), width, height, 4, true, mips);
+
+	std::vector<std::vector<unsigned char>> levels(mips.size());
+	size_t uncompressedSize = 0;
+	size_t compressedSize = 0;
+	for (size_t level = 0; level < mips.size(); level++)
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+		CompressLevel(mips[level], levelWidth, levelHeight, format, levels[level]);
+		uncompressedSize += mips[level].size();
+		compressedSize += levels[level].size();
+	}
+
+	std::string cookedPath = KtxTexture::GetCookedPath(imagePath.c_str());
+	if (KtxTexture::SaveToFile(cookedPath.c_str(), format, width, height, levels) == false)
+	{
+		return false;
+	}
+
+	// the sizes are compared with the RGBA8 mip chain glGenerateMipmap makes
+	std::cout << "Cooked " << imagePath << " -> " << cookedPath << ", " << width << "x" << height
+		<< ", " << levels.size() << " mips, " << KtxTexture::GetFormatName(format) << ", "
+		<< (uncompressedSize / 1024) << " KB -> " << (compressedSize / 1024) << " KB in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+		<< " ms" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  CookVirtualTexture()
+ *
+ *  This function is used to decode one large image and write
+ *  its page file next to it, with the same flip as the
+ *  runtime images.  The pages stay RGBA, since the page
+ *  cache is filled a few pages at a time while drawing.
+ ***********************************************************/
+bool CookVirtualTexture(const std::string& imagePath)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(imagePath.c_str(), &width, &height, &colorChannels, 4);
+	if (nullptr == image)
+	{
+		std::cout << "Could not load image:" << imagePath << std::endl;
+		return false;
+	}
+
+	std::string pagePath = std::filesystem::path(imagePath).replace_extension(".vtex").string();
+	bool bSuccess = VirtualPageFile::Build(pagePath.c_str(), image, width, height, 4);
+	stbi_image_free(image);
+	if (bSuccess == false)
+	{
+		return false;
+	}
+
+	std::cout << "Cooked " << imagePath << " -> " << pagePath << ", " << width << "x" << height << " in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+		<< " ms" << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  CompressLevel()
+ *
+ *  This function is used to encode one mip level block by
+ *  block.  Blocks hanging over the edge of a small level
+ *  repeat the edge texels.
+ ***********************************************************/
+void CompressLevel(const std::vector<unsigned char>& texels, int width, int height,
+	KtxTexture::BLOCK_FORMAT format, std::vector<unsigned char>& blocks)
+{
+	int blockSize = KtxTexture::GetBlockSize(format);
+	int blocksWide = (width + 3) / 4;
+	int blocksHigh = (height + 3) / 4;
+	blocks.resize((size_t)blocksWide * blocksHigh * blockSize);
+
+	unsigned char block[64];
+	for (int by = 0; by < blocksHigh; by++)
+	{
+		for (int bx = 0; bx < blocksWide; bx++)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int x = std::min(bx * 4 + (i % 4), width - 1);
+				int y = std::min(by * 4 + (i / 4), height - 1);
+				memcpy(&block[i * 4], &texels[((size_t)y * width + x) * 4], 4);
+			}
+
+			unsigned char* out = &blocks[((size_t)by * blocksWide + bx) * blockSize];
+			if (format == KtxTexture::FORMAT_BC1)
+			{
+				BlockCompression::EncodeBC1(block, out);
+			}
+			else if (format == KtxTexture::FORMAT_BC3)
+			{
+				BlockCompression::EncodeBC3(block, out);
+			}
+			else
+			{
+				BlockCompression::EncodeBC7(block, out);
+			}
+		}
+	}
+}
@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// keep only the mip levels the camera needs on the GPU, within a budget
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+#include "KtxTexture.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// declaration of global variables
+namespace
+{
+	// levels this size and smaller are loaded up front and never evicted
+	const int TAIL_LEVEL_SIZE = 64;
+	// bytes uploaded in one frame, so a fast camera move does not stall
+	const long long UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+}
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStreamer::TextureStreamer()
+{
+	m_budgetBytes = 256ll * 1024 * 1024;
+	m_residentBytes = 0;
+	m_frame = 0;
+	m_levelsStreamed = 0;
+	m_levelsEvicted = 0;
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	for (STREAMED_TEXTURE& texture : m_textures)
+	{
+		glDeleteTextures(1, &texture.textureID);
+		if (nullptr != texture.pixels)
+		{
+			stbi_image_free(texture.pixels);
+		}
+		if (nullptr != texture.pCooked)
+		{
+			delete texture.pCooked;
+		}
+	}
+	m_textures.clear();
+}
+
+/***********************************************************
+ *  AddDecodedTexture()
+ *
+ *  This method is used to take over a decoded image.  The
+ *  pixels become level 0 and the mips the levels below it,
+ *  all kept in system memory so any level can be uploaded
+ *  again after it has been evicted.
+ ***********************************************************/
+int TextureStreamer::AddDecodedTexture(
+	const std::string& tag,
+	unsigned char* pixels,
+	int width,
+	int height,
+	int channels,
+	std::vector<std::vector<unsigned char>>& mips)
+{
+	STREAMED_TEXTURE texture;
+	texture.tag = tag;
+	texture.pixels = pixels;
+	texture.mips.swap(mips);
+	texture.pCooked = nullptr;
+	texture.internalFormat = (channels == 3) ? GL_RGB8 : GL_RGBA8;
+	texture.format = (channels == 3) ? GL_RGB : GL_RGBA;
+	texture.bCompressed = false;
+
+	for (int level = 0; level <= (int)texture.mips.size(); level++)
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+		texture.levelWidths.push_back(levelWidth);
+		texture.levelHeights.push_back(levelHeight);
+		texture.levelBytes.push_back((size_t)levelWidth * levelHeight * channels);
+		texture.levelData.push_back((level == 0) ? pixels : texture.mips[level - 1].data());
+	}
+
+	return AddTexture(texture);
+}
+
+/***********************************************************
+ *  AddCompressedTexture()
+ *
+ *  This method is used to take over a cooked texture.  Its
+ *  levels point into the loaded file or the mapped asset
+ *  pack, so nothing is copied.
+ ***********************************************************/
+int TextureStreamer::AddCompressedTexture(const std::string& tag, KtxTexture* pCooked, GLenum internalFormat)
+{
+	STREAMED_TEXTURE texture;
+	texture.tag = tag;
+	texture.pixels = nullptr;
+	texture.pCooked = pCooked;
+	texture.internalFormat = internalFormat;
+	texture.format = 0;
+	texture.bCompressed = true;
+
+	for (int level = 0; level < pCooked->GetLevelCount(); level++)
+	{
+		const KtxTexture::MIP_LEVEL& mip = pCooked->GetLevel(level);
+		texture.levelWidths.push_back(mip.width);
+		texture.levelHeights.push_back(mip.height);
+		texture.levelBytes.push_back(mip.size);
+		texture.levelData.push_back(mip.data);
+	}
+
+	return AddTexture(texture);
+}
+
+/***********************************************************
+ *  RemoveTexture()
+ *
+ *  This method is used to free a texture that is no longer
+ *  drawn.  Its entry is kept, empty, so the handles of the
+ *  other textures do not move, and with nothing resident
+ *  above its tail it is never picked to stream or evict.
+ ***********************************************************/
+void TextureStreamer::RemoveTexture(int handle)
+{
+	STREAMED_TEXTURE& texture = m_textures[handle];
+	for (int level = texture.residentLevel; level < (int)texture.levelBytes.size(); level++)
+	{
+		m_residentBytes -= (long long)texture.levelBytes[level];
+	}
+	glDeleteTextures(1, &texture.textureID);
+	texture.textureID = 0;
+	if (nullptr != texture.pixels)
+	{
+		stbi_image_free(texture.pixels);
+		texture.pixels = nullptr;
+	}
+	if (nullptr != texture.pCooked)
+	{
+		delete texture.pCooked;
+		texture.pCooked = nullptr;
+	}
+	texture.mips.clear();
+	texture.levelData.clear();
+	texture.levelWidths.clear();
+	texture.levelHeights.clear();
+	texture.levelBytes.clear();
+	texture.residentLevel = 0;
+	texture.wantedLevel = 0;
+	texture.tailLevel = 0;
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used to create the GL texture with only
+ *  the tail levels resident.  The level sizes are the ones
+ *  of the full chain, so the higher levels can be added or
+ *  freed later without touching the rest.
+ ***********************************************************/
+int TextureStreamer::AddTexture(STREAMED_TEXTURE& texture)
+{
+	int levelCount = (int)texture.levelData.size();
+	texture.tailLevel = levelCount - 1;
+	while ((texture.tailLevel > 0) &&
+		(std::max(texture.levelWidths[texture.tailLevel - 1], texture.levelHeights[texture.tailLevel - 1]) <= TAIL_LEVEL_SIZE))
+	{
+		texture.tailLevel--;
+	}
+	texture.residentLevel = levelCount;
+	texture.wantedLevel = texture.tailLevel;
+	texture.lastUsedFrame = m_frame;
+
+	glGenTextures(1, &texture.textureID);
+	glBindTexture(GL_TEXTURE_2D, texture.textureID);
+	// the same wrapping and filtering as the fully loaded textures - the
+	// mips sampled are always the resident ones, from BASE_LEVEL, which
+	// follows the streaming, down to MAX_LEVEL, the end of the tail
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (levelCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+	for (int level = levelCount - 1; level >= texture.tailLevel; level--)
+	{
+		UploadLevel(texture, level);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// moved, not copied, so levelData still points at the same mip buffers
+	m_textures.push_back(std::move(texture));
+	return (int)m_textures.size() - 1;
+}
+
+/***********************************************************
+ *  UploadLevel()
+ *
+ *  This method is used to upload the level just above the
+ *  resident ones and make it the base level.  The texture
+ *  must be bound.  Each level is its own mutable image, so
+ *  the levels that are not resident take no memory.
+ ***********************************************************/
+void TextureStreamer::UploadLevel(STREAMED_TEXTURE& texture, int level)
+{
+	if (texture.bCompressed)
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat,
+			texture.levelWidths[level], texture.levelHeights[level], 0,
+			(GLsizei)texture.levelBytes[level], texture.levelData[level]);
+	}
+	else
+	{
+		// the rows of the small RGB mips are not 4 byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat,
+			texture.levelWidths[level], texture.levelHeights[level], 0,
+			texture.format, GL_UNSIGNED_BYTE, texture.levelData[level]);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+	texture.residentLevel = level;
+	m_residentBytes += (long long)texture.levelBytes[level];
+	m_levelsStreamed++;
+}
+
+/***********************************************************
+ *  EvictLevel()
+ *
+ *  This method is used to free the highest resident level.
+ *  The base level moves down first, so the texture is never
+ *  sampled from the level while it is being freed.  The
+ *  texture must be bound.
+ ***********************************************************/
+void TextureStreamer::EvictLevel(STREAMED_TEXTURE& texture)
+{
+	int level = texture.residentLevel;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	// redefining the level as empty releases its storage
+	if (texture.bCompressed)
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat, 0, 0, 0, 0, nullptr);
+	}
+	else
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, texture.internalFormat, 0, 0, 0,
+			texture.format, GL_UNSIGNED_BYTE, nullptr);
+	}
+
+	texture.residentLevel = level + 1;
+	m_residentBytes -= (long long)texture.levelBytes[level];
+	m_levelsEvicted++;
+}
+
+/***********************************************************
+ *  EvictLeastRecentlyUsed()
+ *
+ *  This method is used to free one level from the texture
+ *  that was seen the longest time ago.  Textures seen this
+ *  frame only give up levels above the one they asked for,
+ *  unless bEvictVisible is set because the budget has been
+ *  lowered below what is already resident.
+ ***********************************************************/
+bool TextureStreamer::EvictLeastRecentlyUsed(int keepHandle, bool bEvictVisible)
+{
+	int victim = -1;
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		const STREAMED_TEXTURE& texture = m_textures[i];
+		if ((i == keepHandle) || (texture.residentLevel >= texture.tailLevel))
+		{
+			continue;
+		}
+		bool bNeeded = (texture.lastUsedFrame == m_frame) && (texture.residentLevel >= texture.wantedLevel);
+		if (bNeeded && (bEvictVisible == false))
+		{
+			continue;
+		}
+
+		// oldest first, then the one holding the largest level
+		if ((victim < 0) ||
+			(texture.lastUsedFrame < m_textures[victim].lastUsedFrame) ||
+			((texture.lastUsedFrame == m_textures[victim].lastUsedFrame) &&
+				(texture.levelBytes[texture.residentLevel] > m_textures[victim].levelBytes[m_textures[victim].residentLevel])))
+		{
+			victim = i;
+		}
+	}
+	if (victim < 0)
+	{
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_textures[victim].textureID);
+	EvictLevel(m_textures[victim]);
+	return true;
+}
+
+/***********************************************************
+ *  GetEvictableBytes()
+ *
+ *  This method is used to add up the levels that
+ *  EvictLeastRecentlyUsed() may free for a request, without
+ *  freeing them.
+ ***********************************************************/
+long long TextureStreamer::GetEvictableBytes(int keepHandle) const
+{
+	long long bytes = 0;
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		const STREAMED_TEXTURE& texture = m_textures[i];
+		if (i == keepHandle)
+		{
+			continue;
+		}
+		// a texture seen this frame keeps the levels it asked for
+		int keptLevel = (texture.lastUsedFrame == m_frame) ? texture.wantedLevel : texture.tailLevel;
+		for (int level = texture.residentLevel; level < keptLevel; level++)
+		{
+			bytes += (long long)texture.levelBytes[level];
+		}
+	}
+	return bytes;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used to start a new frame of requests.
+ *  Until it is asked for again, a texture only wants its
+ *  tail levels, but keeps what it has while there is room.
+ ***********************************************************/
+void TextureStreamer::BeginFrame()
+{
+	m_frame++;
+	m_levelsStreamed = 0;
+	m_levelsEvicted = 0;
+	for (STREAMED_TEXTURE& texture : m_textures)
+	{
+		texture.wantedLevel = texture.tailLevel;
+	}
+}
+
+/***********************************************************
+ *  RequestResolution()
+ *
+ *  This method is used to turn the texels an object covers
+ *  on screen into the level that is sharp enough for it.
+ *  The sharpest request of the frame wins.
+ ***********************************************************/
+void TextureStreamer::RequestResolution(int handle, float texelsAcross)
+{
+	STREAMED_TEXTURE& texture = m_textures[handle];
+	float size = (float)std::max(texture.levelWidths[0], texture.levelHeights[0]);
+	int level = 0;
+	if (texelsAcross >= 1.0f)
+	{
+		level = (int)std::floor(std::log2(size / texelsAcross));
+	}
+	else
+	{
+		level = texture.tailLevel;
+	}
+	level = std::min(std::max(level, 0), texture.tailLevel);
+
+	texture.wantedLevel = std::min(texture.wantedLevel, level);
+	texture.lastUsedFrame = m_frame;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to move the resident levels toward
+ *  the requested ones.  The textures furthest from what they
+ *  want go first, one level at a time, and uploads stop for
+ *  the frame at UPLOAD_BYTES_PER_FRAME.  A request that does
+ *  not fit in the budget, even after evicting everything not
+ *  needed this frame, stays pending.  Textures have to be
+ *  bound again afterwards, since this binds each one it
+ *  changes to the active unit.
+ ***********************************************************/
+void TextureStreamer::Update(RenderStats& stats)
+{
+	// a lowered budget is met first, whether the textures are seen or not
+	while ((m_residentBytes > m_budgetBytes) && EvictLeastRecentlyUsed(-1, true))
+	{
+	}
+
+	std::vector<int> pending;
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		if (m_textures[i].wantedLevel < m_textures[i].residentLevel)
+		{
+			pending.push_back(i);
+		}
+	}
+	std::sort(pending.begin(), pending.end(),
+		[this](int a, int b)
+		{
+			return (m_textures[a].residentLevel - m_textures[a].wantedLevel) >
+				(m_textures[b].residentLevel - m_textures[b].wantedLevel);
+		});
+
+	long long uploadedBytes = 0;
+	int pendingRequests = 0;
+	for (int handle : pending)
+	{
+		STREAMED_TEXTURE& texture = m_textures[handle];
+		while (texture.wantedLevel < texture.residentLevel)
+		{
+			long long levelBytes = (long long)texture.levelBytes[texture.residentLevel - 1];
+			if ((uploadedBytes > 0) && (uploadedBytes + levelBytes > UPLOAD_BYTES_PER_FRAME))
+			{
+				break;
+			}
+			// check first, so nothing is evicted for a level that cannot fit anyway
+			if (m_residentBytes - GetEvictableBytes(handle) + levelBytes > m_budgetBytes)
+			{
+				break;
+			}
+			while (m_residentBytes + levelBytes > m_budgetBytes)
+			{
+				EvictLeastRecentlyUsed(handle, false);
+			}
+
+			glBindTexture(GL_TEXTURE_2D, texture.textureID);
+			UploadLevel(texture, texture.residentLevel - 1);
+			uploadedBytes += levelBytes;
+		}
+		if (texture.wantedLevel < texture.residentLevel)
+		{
+			pendingRequests++;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	stats.textureBytesResident = m_residentBytes;
+	stats.textureBytesBudget = m_budgetBytes;
+	stats.textureRequestsPending = pendingRequests;
+	stats.textureLevelsStreamed = m_levelsStreamed;
+	stats.textureLevelsEvicted = m_levelsEvicted;
+	stats.bufferBytesUploaded += uploadedBytes;
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// keep only the mip levels the camera needs on the GPU, within a budget
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>        // GLEW library
+
+#include "RenderStats.h"
+
+#include <string>
+#include <vector>
+
+class KtxTexture;
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class owns the streamed textures and the CPU copy of
+ *  their mip chains.  A texture starts on the GPU with only
+ *  its small tail mips.  Each frame the scene asks for the
+ *  resolution every visible object needs, and the streamer
+ *  uploads the missing levels one at a time, largest need
+ *  first.  When that would go over the memory budget, the
+ *  high mips of the least recently seen textures are freed.
+ *
+ *  The GL texture keeps its name the whole time; only its
+ *  GL_TEXTURE_BASE_LEVEL moves, so nothing that binds it has
+ *  to know it is streamed.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// constructor
+	TextureStreamer();
+	// destructor
+	~TextureStreamer();
+
+	// bytes of streamed mip levels allowed on the GPU
+	void SetBudget(long long budgetBytes) { m_budgetBytes = budgetBytes; }
+	long long GetBudget() const { return m_budgetBytes; }
+
+	// take over a decoded 8 bit image and its CPU built mips
+	// (pixels is freed with stbi_image_free), returns a handle
+	int AddDecodedTexture(
+		const std::string& tag,
+		unsigned char* pixels,
+		int width,
+		int height,
+		int channels,
+		std::vector<std::vector<unsigned char>>& mips);
+	// take over a cooked texture, returns a handle
+	int AddCompressedTexture(const std::string& tag, KtxTexture* pCooked, GLenum internalFormat);
+	// free a texture and its CPU copy - the other handles stay valid
+	void RemoveTexture(int handle);
+
+	// the GL texture of a handle, which does not change while streaming
+	GLuint GetTextureID(int handle) const { return m_textures[handle].textureID; }
+
+	// start collecting this frame's requests
+	void BeginFrame();
+	// ask for a texture to be sharp when it covers this many texels across
+	void RequestResolution(int handle, float texelsAcross);
+	// upload and evict mip levels, then report the residency
+	void Update(RenderStats& stats);
+
+private:
+	struct STREAMED_TEXTURE
+	{
+		std::string tag;
+		GLuint textureID;
+		// mip sizes and bytes, level 0 first
+		std::vector<int> levelWidths;
+		std::vector<int> levelHeights;
+		std::vector<size_t> levelBytes;
+		// CPU copy of each level, level 0 first
+		std::vector<const unsigned char*> levelData;
+		// decoded images own their data, cooked ones point into pCooked
+		unsigned char* pixels;
+		std::vector<std::vector<unsigned char>> mips;
+		KtxTexture* pCooked;
+		GLenum internalFormat;
+		GLenum format;
+		bool bCompressed;
+		// highest resolution level on the GPU, and the one that is wanted
+		int residentLevel;
+		int wantedLevel;
+		// the small levels that are never evicted start here
+		int tailLevel;
+		long long lastUsedFrame;
+	};
+
+	std::vector<STREAMED_TEXTURE> m_textures;
+	long long m_budgetBytes;
+	long long m_residentBytes;
+	long long m_frame;
+	int m_levelsStreamed;
+	int m_levelsEvicted;
+
+	// create the GL texture with only the tail levels, returns the handle
+	int AddTexture(STREAMED_TEXTURE& texture);
+	// move one level on or off the GPU
+	void UploadLevel(STREAMED_TEXTURE& texture, int level);
+	void EvictLevel(STREAMED_TEXTURE& texture);
+	// free the top level of the texture that was seen longest ago,
+	// false when nothing but needed or tail levels are left
+	bool EvictLeastRecentlyUsed(int keepHandle, bool bEvictVisible);
+	// bytes EvictLeastRecentlyUsed() could free without touching keepHandle
+	long long GetEvictableBytes(int keepHandle) const;
+};
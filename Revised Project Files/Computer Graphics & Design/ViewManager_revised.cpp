@@ -7,7 +7,7 @@
 //	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "ViewManager.h"
+#include "ViewManager_revised.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
@@ -20,6 +20,23 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
+
+	// the real framebuffer size in pixels - differs from the window
+	// size on HiDPI displays and changes whenever the window is resized
+	int gFramebufferWidth = WINDOW_WIDTH;
+	int gFramebufferHeight = WINDOW_HEIGHT;
+	// set by the resize callback, cleared once the change is handled
+	bool gViewportDirty = true;
+	bool gProjectionDirty = true;
+	bool gResizePending = false;
+
+	// set whenever something changed that needs a new frame drawn,
+	// starts set so the first frame is always drawn
+	bool gFrameDirty = true;
+
+	// the longest time step the camera movement will take, so the
+	// first frame after sitting idle does not jump the camera
+	const float MAX_DELTA_TIME = 0.1f;
 	const char* g_ViewName = "view";
 	const char* g_ProjectionName = "projection";
 
@@ -39,6 +56,10 @@ namespace
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// values the cached projection matrix was built with
+	float gProjectionZoom = 0.0f;
+	bool gProjectionOrthographic = false;
 }
 
 /***********************************************************
@@ -52,6 +73,8 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = nullptr;						// Creating a change here, from "NULL" to "nullptr"
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -100,6 +123,26 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	glfwMakeContextCurrent(window);
 
+	// the framebuffer can be larger than the window on HiDPI displays,
+	// so the viewport and aspect ratio come from the framebuffer size
+	glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+	gViewportDirty = true;
+	gProjectionDirty = true;
+
+	// the mouse works in window coordinates, so center it on the real window size
+	int windowWidth = WINDOW_WIDTH;
+	int windowHeight = WINDOW_HEIGHT;
+	glfwGetWindowSize(window, &windowWidth, &windowHeight);
+	gLastX = windowWidth / 2.0f;
+	gLastY = windowHeight / 2.0f;
+
+	// this callback is used to receive window resize events
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+
+	// these callbacks only mark the frame dirty - the keys are still polled
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
 	// tell GLFW to capture all mouse events
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -118,6 +161,40 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	return(window);
 }
 
+/***********************************************************
+ *  PrepareHeadlessView()
+ *
+ *  This method is used in place of CreateDisplayWindow()
+ *  when rendering into an offscreen target with no window.
+ ***********************************************************/
+void ViewManager::PrepareHeadlessView(int width, int height)
+{
+	gFramebufferWidth = width;
+	gFramebufferHeight = height;
+	gViewportDirty = true;
+	gProjectionDirty = true;
+	gResizePending = true;
+
+	// enable blending for supporting tranparent rendering
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	m_pWindow = nullptr;
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used for moving the camera without any
+ *  input, so a scripted run sees the same frames each time.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const glm::vec3& position, const glm::vec3& front)
+{
+	g_pCamera->Position = position;
+	g_pCamera->Front = front;
+	gFrameDirty = true;
+}
+
 /***********************************************************
  *  Mouse_Position_Callback()
  *
@@ -140,11 +217,92 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 	gLastY = yMousePos;
 
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+	gFrameDirty = true;
 }
 
 // Adding Mouse_Scroll_Callback behavior
 void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset) {
 	g_pCamera->ProcessMouseScroll(yoffset);
+	gFrameDirty = true;
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  key is pressed, repeated or released.  The keys are still
+ *  handled in ProcessKeyboardEvents(); this only makes sure
+ *  a frame gets drawn to handle them.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	gFrameDirty = true;
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the window contents need to be redrawn, such as after
+ *  being uncovered.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	gFrameDirty = true;
+}
+
+/***********************************************************
+ *  RequestRedraw()
+ *
+ *  This method is used for marking the frame as needing to
+ *  be drawn, for example by an animation.  It also wakes the
+ *  main loop if it is waiting for events.
+ ***********************************************************/
+void ViewManager::RequestRedraw()
+{
+	gFrameDirty = true;
+	glfwPostEmptyEvent();
+}
+
+/***********************************************************
+ *  ConsumeRedraw()
+ *
+ *  This method is used for checking if a frame needs to be
+ *  drawn, and clears the request.
+ ***********************************************************/
+bool ViewManager::ConsumeRedraw()
+{
+	bool bDirty = gFrameDirty;
+	gFrameDirty = false;
+	return(bDirty);
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the display window changes size.  The
+ *  new size is only recorded here; the viewport, projection
+ *  and offscreen targets are updated lazily before the next
+ *  frame is rendered.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	// a minimized window reports a zero size - keep the last real size
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	if ((width != gFramebufferWidth) || (height != gFramebufferHeight))
+	{
+		gFramebufferWidth = width;
+		gFramebufferHeight = height;
+		gViewportDirty = true;
+		gProjectionDirty = true;
+		gResizePending = true;
+		gFrameDirty = true;
+	}
 }
 
 /***********************************************************
@@ -155,6 +313,12 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, doub
  ***********************************************************/
 void ViewManager::ProcessKeyboardEvents()
 {
+	// there is no keyboard to read when running headless
+	if (nullptr == m_pWindow)
+	{
+		return;
+	}
+
 	// close the window if the escape key has been pressed
 	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{
@@ -196,6 +360,17 @@ void ViewManager::ProcessKeyboardEvents()
 		bOrthographicProjection = true;
 		std::cout << "Switched to Orthographic View\n";  // Adding functionality to notify user of View
 	}
+
+	// keep drawing frames while a movement key is held down
+	const int movementKeys[] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E };
+	for (int key : movementKeys)
+	{
+		if (glfwGetKey(m_pWindow, key) == GLFW_PRESS)
+		{
+			gFrameDirty = true;
+			break;
+		}
+	}
 }
 
 /***********************************************************
@@ -214,6 +389,10 @@ void ViewManager::PrepareSceneView()
 	float currentFrame = glfwGetTime();
 	gDeltaTime = currentFrame - gLastFrame;
 	gLastFrame = currentFrame;
+	if (gDeltaTime > MAX_DELTA_TIME)
+	{
+		gDeltaTime = MAX_DELTA_TIME;
+	}
 
 	// process any keyboard events that may be waiting in the 
 	// event queue
@@ -222,15 +401,31 @@ void ViewManager::PrepareSceneView()
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
 
+	// only touch the viewport when the framebuffer size has changed
+	if (gViewportDirty)
+	{
+		glViewport(0, 0, gFramebufferWidth, gFramebufferHeight);
+		gViewportDirty = false;
+	}
+
+	// the projection only changes with the size, zoom or projection mode
+	if ((gProjectionZoom != g_pCamera->Zoom) || (gProjectionOrthographic != bOrthographicProjection))
+	{
+		gProjectionDirty = true;
+	}
+
 	// Adding functionality for both Perspective and Orthographic views
 	/************************************************************************************
 	* NOTE: The block below is the original if /else statements for the projection code	*
 	* For "PrepareSceneView()" method.  There was a duplicate block of code at the end	*
 	* Of the file, which has been deleted in order to remove redundancy.				*
 	* ***********************************************************************************/
-	if (bOrthographicProjection) {
+	float aspectRatio = (float)gFramebufferWidth / (float)gFramebufferHeight;
+	if (gProjectionDirty == false) {
+		projection = m_projectionMatrix;
+	}
+	else if (bOrthographicProjection) {
 		float orthoSize = 10.0f;
-		float aspectRatio = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
 		projection = glm::ortho(
 			-orthoSize * aspectRatio, orthoSize * aspectRatio,
 			-orthoSize, orthoSize,
@@ -239,9 +434,12 @@ void ViewManager::PrepareSceneView()
 	else {
 		projection = glm::perspective(
 			glm::radians(g_pCamera->Zoom),
-			(float)WINDOW_WIDTH / (float)WINDOW_HEIGHT,
+			aspectRatio,
 			0.1f, 100.0f);
 	}
+	gProjectionZoom = g_pCamera->Zoom;
+	gProjectionOrthographic = bOrthographicProjection;
+	gProjectionDirty = false;
 
 	
 	// if the shader manager object is valid
@@ -255,7 +453,53 @@ void ViewManager::PrepareSceneView()
 		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
 	}
 
+	// keep the matrices for the render passes that use their own shaders
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
 	/*Here was the location of the redudant block of code 
 	(Mentioned in the comment block above).  It has been removed to improve efficacy.*/
+}
+
+/***********************************************************
+ *  GetCameraPosition()
+ *
+ *  This method is used for getting the current position of
+ *  the camera in world space.
+ ***********************************************************/
+glm::vec3 ViewManager::GetCameraPosition() const
+{
+	return(g_pCamera->Position);
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the current size of the
+ *  display window framebuffer in pixels.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height) const
+{
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  ConsumeFramebufferResize()
+ *
+ *  This method is used for checking if the framebuffer has
+ *  changed size since the last call, so the offscreen
+ *  targets are only resized on a real change.
+ ***********************************************************/
+bool ViewManager::ConsumeFramebufferResize(int& width, int& height)
+{
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+	if (gResizePending == false)
+	{
+		return false;
 	}
-}
\ No newline at end of file
+
+	gResizePending = false;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+///////////////////////////////////////////////////////////////////////////////
+// viewmanager.h
+// ============
+// manage the viewing of 3D objects within the viewport
+//
+//  AUTHOR: Brian Battersby - SNHU Instructor / Computer Science
+//	Created for CS-330-Computational Graphics and Visualization, Nov. 1st, 2023
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "camera.h"
+
+// GLFW library
+#include "GLFW/glfw3.h" 
+
+class ViewManager
+{
+public:
+	// constructor
+	ViewManager(
+		ShaderManager* pShaderManager);
+	// destructor
+	~ViewManager();
+
+	// mouse position callback for mouse interaction with the 3D scene
+	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
+
+	// Adding Mouse Scroll Callback
+	static void Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset);
+
+	// framebuffer size callback for window resizing and HiDPI scaling
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
+	// keyboard and window refresh callbacks, used to wake the on-demand renderer
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
+	// mark the frame as needing to be drawn (input, resize, animation)
+	static void RequestRedraw();
+	// returns true once if the frame needs to be drawn
+	static bool ConsumeRedraw();
+
+private:
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+	// active OpenGL display window
+	GLFWwindow* m_pWindow;
+	// the view and projection matrices from the last PrepareSceneView()
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+
+	// process keyboard events for interaction with the 3D scene
+	void ProcessKeyboardEvents();
+
+public:
+	// create the initial OpenGL display window
+	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
+	// set up the view for an offscreen target when there is no window
+	void PrepareHeadlessView(int width, int height);
+
+	// place the camera directly, used by scripted camera paths
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& front);
+	
+	// prepare the conversion from 3D object display to 2D scene display
+	void PrepareSceneView();
+
+	// the camera values used for the current frame
+	glm::mat4 GetViewMatrix() const { return m_viewMatrix; }
+	glm::mat4 GetProjectionMatrix() const { return m_projectionMatrix; }
+	glm::vec3 GetCameraPosition() const;
+
+	// the current framebuffer size in pixels
+	void GetFramebufferSize(int& width, int& height) const;
+	// returns true once after each change of the framebuffer size
+	bool ConsumeFramebufferResize(int& width, int& height);
+};
\ No newline at end of file
@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////////////
+// virtualpagefile.cpp
+// ============
+// very large textures cut into fixed size pages for virtual texturing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VirtualPageFile.h"
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// "VTEX" - virtual texture pages
+	const unsigned int PAGE_FILE_MAGIC = 0x58455456;
+	const unsigned int PAGE_FILE_VERSION = 1;
+	const size_t PAGE_BYTES = (size_t)VirtualPageFile::PAGE_STRIDE * VirtualPageFile::PAGE_STRIDE * 4;
+
+	struct PAGE_FILE_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int width;
+		unsigned int height;
+		unsigned int pageSize;
+		unsigned int pageBorder;
+		unsigned int levelCount;
+		unsigned int reserved;
+	};
+}
+
+/***********************************************************
+ *  VirtualPageFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+VirtualPageFile::VirtualPageFile()
+{
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  BuildLayout()
+ *
+ *  This method is used to count the pages of every level.
+ *  Each level is half the size of the one above it, and the
+ *  last level is the first one that fits in a single page.
+ ***********************************************************/
+void VirtualPageFile::BuildLayout(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_pagesX.clear();
+	m_pagesY.clear();
+	m_levelOffsets.clear();
+
+	unsigned long long offset = sizeof(PAGE_FILE_HEADER);
+	for (int level = 0; ; level++)
+	{
+		int levelWidth = std::max(width >> level, 1);
+		int levelHeight = std::max(height >> level, 1);
+		m_pagesX.push_back((levelWidth + PAGE_SIZE - 1) / PAGE_SIZE);
+		m_pagesY.push_back((levelHeight + PAGE_SIZE - 1) / PAGE_SIZE);
+		m_levelOffsets.push_back(offset);
+		offset += (unsigned long long)m_pagesX.back() * m_pagesY.back() * PAGE_BYTES;
+		if ((m_pagesX.back() == 1) && (m_pagesY.back() == 1))
+		{
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used to open a page file and check its
+ *  header.  A missing file is not reported, since the
+ *  surface then keeps its ordinary texture.
+ ***********************************************************/
+bool VirtualPageFile::Open(const char* filePath)
+{
+	m_file.open(filePath, std::ios::binary);
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+
+	PAGE_FILE_HEADER header;
+	if (!m_file.read((char*)&header, sizeof(header)) ||
+		(header.magic != PAGE_FILE_MAGIC) || (header.version != PAGE_FILE_VERSION) ||
+		(header.pageSize != PAGE_SIZE) || (header.pageBorder != PAGE_BORDER) ||
+		(header.width == 0) || (header.height == 0) || (header.width > 65536) || (header.height > 65536))
+	{
+		std::cout << "ERROR: " << filePath << " is not a version " << PAGE_FILE_VERSION << " virtual texture" << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	BuildLayout((int)header.width, (int)header.height);
+	if (header.levelCount != m_pagesX.size())
+	{
+		std::cout << "ERROR: " << filePath << " has " << header.levelCount << " levels, expected " << m_pagesX.size() << std::endl;
+		m_file.close();
+		return false;
+	}
+
+	return true;
+}
+
+/***********************************************************
+ *  ReadPage()
+ *
+ *  This method is used to read one page.  It seeks in the
+ *  file, so one object must not be read from two threads.
+ ***********************************************************/
+bool VirtualPageFile::ReadPage(int level, int pageX, int pageY, std::vector<unsigned char>& pixels)
+{
+	if ((level < 0) || (level >= GetLevelCount()) ||
+		(pageX < 0) || (pageX >= m_pagesX[level]) || (pageY < 0) || (pageY >= m_pagesY[level]))
+	{
+		return false;
+	}
+
+	unsigned long long offset = m_levelOffsets[level] +
+		((unsigned long long)pageY * m_pagesX[level] + pageX) * PAGE_BYTES;
+	pixels.resize(PAGE_BYTES);
+	m_file.clear();
+	m_file.seekg((std::streamoff)offset, std::ios::beg);
+	return (bool)m_file.read((char*)pixels.data(), (std::streamsize)PAGE_BYTES);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used to write the page file of an image.
+ *  The mips are built with the gamma-correct generator, then
+ *  each level is cut into pages.  Border texels past the
+ *  edge of the image repeat the edge.  The file is written
+ *  to a temporary name and renamed, like the other cooked
+ *  assets.
+ ***********************************************************/
+bool VirtualPageFile::Build(const char* filePath, const unsigned char* image, int width, int height, int channels)
+{
+	VirtualPageFile layout;
+	layout.BuildLayout(width, height);
+
+	// level 0 is the image itself, expanded to RGBA like every other level
+	std::vector<std::vector<unsigned char>> levels(1);
+	levels[0].resize((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			levels[0][i * 4 + c] = (c < channels) ? image[i * channels + c] : 255;
+		}
+	}
+	MipGenerator::BuildMipChain(levels[0].data(), width, height, 4, true, levels);
+
+	PAGE_FILE_HEADER header;
+	header.magic = PAGE_FILE_MAGIC;
+	header.version = PAGE_FILE_VERSION;
+	header.width = (unsigned int)width;
+	header.height = (unsigned int)height;
+	header.pageSize = PAGE_SIZE;
+	header.pageBorder = PAGE_BORDER;
+	header.levelCount = (unsigned int)layout.GetLevelCount();
+	header.reserved = 0;
+
+	std::string tempPath = std::string(filePath) + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR: Could not write " << filePath << std::endl;
+			return false;
+		}
+		file.write((const char*)&header, sizeof(header));
+
+		std::vector<unsigned char> page(PAGE_BYTES);
+		for (int level = 0; level < layout.GetLevelCount(); level++)
+		{
+			int levelWidth = std::max(width >> level, 1);
+			int levelHeight = std::max(height >> level, 1);
+			const unsigned char* texels = levels[level].data();
+			for (int pageY = 0; pageY < layout.GetPagesY(level); pageY++)
+			{
+				for (int pageX = 0; pageX < layout.GetPagesX(level); pageX++)
+				{
+					for (int y = 0; y < PAGE_STRIDE; y++)
+					{
+						int sourceY = std::min(std::max(pageY * PAGE_SIZE + y - PAGE_BORDER, 0), levelHeight - 1);
+						for (int x = 0; x < PAGE_STRIDE; x++)
+						{
+							int sourceX = std::min(std::max(pageX * PAGE_SIZE + x - PAGE_BORDER, 0), levelWidth - 1);
+							memcpy(&page[((size_t)y * PAGE_STRIDE + x) * 4], &texels[((size_t)sourceY * levelWidth + sourceX) * 4], 4);
+						}
+					}
+					file.write((const char*)page.data(), (std::streamsize)page.size());
+				}
+			}
+		}
+
+		if (!file)
+		{
+			std::cout << "ERROR: Could not write " << filePath << std::endl;
+			file.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+
+	std::remove(filePath);
+	if (std::rename(tempPath.c_str(), filePath) != 0)
+	{
+		std::cout << "ERROR: Could not write " << filePath << std::endl;
+		std::remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+// virtualpagefile.h
+// ============
+// very large textures cut into fixed size pages for virtual texturing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+/***********************************************************
+ *  VirtualPageFile
+ *
+ *  This class reads and writes the page file of a virtual
+ *  texture.  Every mip level of the image is cut into
+ *  PAGE_SIZE square RGBA pages, each with a PAGE_BORDER of
+ *  the texels around it so pages can be filtered on their
+ *  own.  Levels go down until one page holds the whole
+ *  image.  All pages are the same size, so a page is found
+ *  from its level and position with no index.  It has no
+ *  OpenGL code, so the cook tool and the page loader thread
+ *  can both use it.
+ ***********************************************************/
+class VirtualPageFile
+{
+public:
+	// texels across the inside of a page, and the border around it
+	static const int PAGE_SIZE = 128;
+	static const int PAGE_BORDER = 4;
+	// texels across a whole page, border included
+	static const int PAGE_STRIDE = PAGE_SIZE + 2 * PAGE_BORDER;
+
+	// constructor
+	VirtualPageFile();
+
+	// open a page file, false if it is missing or not a page file
+	bool Open(const char* filePath);
+	// read one page as PAGE_STRIDE x PAGE_STRIDE RGBA texels
+	bool ReadPage(int level, int pageX, int pageY, std::vector<unsigned char>& pixels);
+
+	// write the page file for an 8 bit image with 3 or 4 channels
+	static bool Build(const char* filePath, const unsigned char* image, int width, int height, int channels);
+
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	int GetLevelCount() const { return (int)m_pagesX.size(); }
+	int GetPagesX(int level) const { return m_pagesX[level]; }
+	int GetPagesY(int level) const { return m_pagesY[level]; }
+
+private:
+	std::ifstream m_file;
+	int m_width;
+	int m_height;
+	// pages across each level, and where the level's pages start
+	std::vector<int> m_pagesX;
+	std::vector<int> m_pagesY;
+	std::vector<unsigned long long> m_levelOffsets;
+
+	// work out the page counts and offsets of every level
+	void BuildLayout(int width, int height);
+};
@@ -0,0 +1,971 @@
+///////////////////////////////////////////////////////////////////////////////
+// virtualtexturing.cpp
+// ============
+// page table, page cache and feedback passes for sparse virtual textures
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VirtualTexturing.h"
+#include "VirtualPageFile.h"
+#include "ShaderUtils.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// texture units used by the draw pass
+	const int PAGE_CACHE_UNIT = 0;
+	const int PAGE_TABLE_UNIT = 1;
+
+	// the feedback target is this many times smaller than the screen
+	const int FEEDBACK_SCALE = 8;
+
+	// the feedback stores page positions in 8 bits
+	const int MAX_PAGES_ACROSS = 256;
+
+	// limits on the work done each frame
+	const int MAX_PAGE_REQUESTS = 64;
+	const int MAX_PAGE_UPLOADS = 16;
+
+	// number of light sources declared in the draw shader
+	const int VIRTUAL_LIGHT_COUNT = 4;
+
+	// both passes use the same vertex layout as the scene shader,
+	// but the UVs of a virtual texture are unique so they are not scaled
+	const char* g_VirtualVertexShader = R"(
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+
+void main()
+{
+	vec4 worldPosition = model * vec4(inVertexPosition, 1.0);
+	gl_Position = projection * view * worldPosition;
+	fragmentPosition = worldPosition.xyz;
+	fragmentVertexNormal = normalMatrix * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate;
+}
+)";
+
+	// writes the page each pixel needs - x, y, then the level with the texture
+	// in the high 4 bits, and alpha 0 where no virtual surface was drawn
+	const char* g_FeedbackFragmentShader = R"(
+#version 330 core
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+uniform vec2 virtualSize;
+uniform int levelCount;
+uniform int virtualTexture;
+uniform float levelBias;
+
+out vec4 outFeedback;
+
+void main()
+{
+	vec2 uv = clamp(fragmentTextureCoordinate, 0.0, 0.99999);
+	vec2 dx = dFdx(uv * virtualSize);
+	vec2 dy = dFdy(uv * virtualSize);
+	float level = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + levelBias;
+	int pageLevel = clamp(int(floor(level)), 0, levelCount - 1);
+
+	vec2 levelSize = max(floor(virtualSize / exp2(float(pageLevel))), vec2(1.0));
+	ivec2 page = ivec2(uv * levelSize) / 128;
+	outFeedback = vec4(float(page.x), float(page.y), float(pageLevel + virtualTexture * 16), 255.0) / 255.0;
+}
+)";
+
+	// the page table gives the cache slot of the page to sample, which may
+	// be a coarser page while the wanted one is loading - kept in line with
+	// the deferred lighting for the Phong terms
+	const char* g_DrawFragmentShader = R"(
+#version 330 core
+struct LightSource
+{
+	vec3 position;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float focalStrength;
+	float specularIntensity;
+};
+
+struct Material
+{
+	float ambientStrength;
+	vec3 ambientColor;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+uniform sampler2D pageCache;
+uniform usampler2DArray pageTable;
+uniform vec2 virtualSize;
+uniform int levelCount;
+
+uniform vec3 viewPosition;
+uniform LightSource lightSources[4];
+uniform int lightCount;
+uniform Material material;
+
+out vec4 outFragmentColor;
+
+const float PAGE_SIZE = 128.0;
+const float PAGE_BORDER = 4.0;
+const float PAGE_STRIDE = 136.0;
+
+void main()
+{
+	vec2 uv = clamp(fragmentTextureCoordinate, 0.0, 0.99999);
+	vec2 dx = dFdx(uv * virtualSize);
+	vec2 dy = dFdy(uv * virtualSize);
+	float level = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+	int pageLevel = clamp(int(floor(level)), 0, levelCount - 1);
+
+	vec2 levelSize = max(floor(virtualSize / exp2(float(pageLevel))), vec2(1.0));
+	ivec2 page = ivec2(uv * levelSize / PAGE_SIZE);
+	uvec4 entry = texelFetch(pageTable, ivec3(page, pageLevel), 0);
+
+	// find the position inside the page that is actually in the cache
+	int residentLevel = int(entry.b);
+	vec2 residentSize = max(floor(virtualSize / exp2(float(residentLevel))), vec2(1.0));
+	vec2 residentPosition = uv * residentSize / PAGE_SIZE;
+	vec2 insidePage = clamp(residentPosition - vec2(page >> (residentLevel - pageLevel)), 0.0, 1.0);
+	vec2 cacheTexel = vec2(entry.rg) * PAGE_STRIDE + PAGE_BORDER + insidePage * PAGE_SIZE;
+	vec3 albedo = textureLod(pageCache, cacheTexel / vec2(textureSize(pageCache, 0)), 0.0).rgb;
+
+	vec3 lightNormal = normalize(fragmentVertexNormal);
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+	vec3 lighting = vec3(0.0);
+	for (int i = 0; i < lightCount; i++)
+	{
+		vec3 ambient = lightSources[i].ambientColor * material.ambientColor * material.ambientStrength;
+
+		vec3 lightDirection = normalize(lightSources[i].position - fragmentPosition);
+		float impact = max(dot(lightNormal, lightDirection), 0.0);
+		vec3 diffuse = impact * lightSources[i].diffuseColor * material.diffuseColor;
+
+		vec3 reflectDir = reflect(-lightDirection, lightNormal);
+		float specularComponent = pow(max(dot(viewDirection, reflectDir), 0.0), lightSources[i].focalStrength);
+		vec3 specular = lightSources[i].specularIntensity * specularComponent * lightSources[i].specularColor * material.specularColor;
+
+		lighting += ambient + diffuse + specular;
+	}
+
+	outFragmentColor = vec4(lighting * albedo, 1.0);
+}
+)";
+}
+
+/***********************************************************
+ *  VirtualTexturing()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+VirtualTexturing::VirtualTexturing()
+{
+	for (int i = 0; i < MAX_VIRTUAL_TEXTURES; i++)
+	{
+		m_textures[i] = nullptr;
+	}
+	m_textureCount = 0;
+	m_pageCache = 0;
+	m_slotsPerSide = 0;
+	m_feedbackFramebuffer = 0;
+	m_feedbackColor = 0;
+	m_feedbackDepth = 0;
+	m_feedbackWidth = 0;
+	m_feedbackHeight = 0;
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		m_readbackBuffers[i] = 0;
+		m_readbackFences[i] = 0;
+		m_readbackWidths[i] = 0;
+		m_readbackHeights[i] = 0;
+	}
+	m_readbackIndex = 0;
+	m_savedFramebuffer = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		m_savedViewport[i] = 0;
+	}
+	m_bSavedBlend = GL_FALSE;
+	m_feedbackProgram = 0;
+	m_drawProgram = 0;
+	m_feedbackModelLocation = -1;
+	m_feedbackTextureLocation = -1;
+	m_feedbackSizeLocation = -1;
+	m_feedbackLevelCountLocation = -1;
+	m_drawModelLocation = -1;
+	m_drawNormalMatrixLocation = -1;
+	m_drawSizeLocation = -1;
+	m_drawLevelCountLocation = -1;
+	m_bStopLoader = false;
+	m_frame = 0;
+	m_pagesUploaded = 0;
+}
+
+/***********************************************************
+ *  ~VirtualTexturing()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+VirtualTexturing::~VirtualTexturing()
+{
+	// the loader reads the page files, so it has to stop first
+	if (m_loaderThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_loaderMutex);
+			m_bStopLoader = true;
+		}
+		m_loaderCondition.notify_all();
+		m_loaderThread.join();
+	}
+
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		glDeleteTextures(1, &m_textures[i]->pageTable);
+		delete m_textures[i]->pPages;
+		delete m_textures[i];
+		m_textures[i] = nullptr;
+	}
+
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		if (m_readbackFences[i] != 0)
+		{
+			glDeleteSync(m_readbackFences[i]);
+		}
+	}
+	glDeleteBuffers(READBACK_COUNT, m_readbackBuffers);
+	glDeleteFramebuffers(1, &m_feedbackFramebuffer);
+	glDeleteRenderbuffers(1, &m_feedbackColor);
+	glDeleteRenderbuffers(1, &m_feedbackDepth);
+	glDeleteTextures(1, &m_pageCache);
+	glDeleteProgram(m_feedbackProgram);
+	glDeleteProgram(m_drawProgram);
+}
+
+/***********************************************************
+ *  MakePageKey()
+ *
+ *  This method is used to pack a page into one number, used
+ *  to find it in the cache and in the loader queue.
+ ***********************************************************/
+unsigned int VirtualTexturing::MakePageKey(int texture, int level, int pageX, int pageY)
+{
+	return ((unsigned int)texture << 28) | ((unsigned int)level << 24) |
+		((unsigned int)pageY << 12) | (unsigned int)pageX;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used to compile the programs, allocate
+ *  the page cache and start the page loader thread.
+ ***********************************************************/
+bool VirtualTexturing::Initialize(int cacheSlotsPerSide)
+{
+	m_feedbackProgram = ShaderUtils::CreateProgram(
+		g_VirtualVertexShader, g_FeedbackFragmentShader, "virtual texture feedback");
+	m_drawProgram = ShaderUtils::CreateProgram(
+		g_VirtualVertexShader, g_DrawFragmentShader, "virtual texture");
+	if ((m_feedbackProgram == 0) || (m_drawProgram == 0))
+	{
+		return false;
+	}
+
+	m_feedbackModelLocation = glGetUniformLocation(m_feedbackProgram, "model");
+	m_feedbackTextureLocation = glGetUniformLocation(m_feedbackProgram, "virtualTexture");
+	m_feedbackSizeLocation = glGetUniformLocation(m_feedbackProgram, "virtualSize");
+	m_feedbackLevelCountLocation = glGetUniformLocation(m_feedbackProgram, "levelCount");
+	m_drawModelLocation = glGetUniformLocation(m_drawProgram, "model");
+	m_drawNormalMatrixLocation = glGetUniformLocation(m_drawProgram, "normalMatrix");
+	m_drawSizeLocation = glGetUniformLocation(m_drawProgram, "virtualSize");
+	m_drawLevelCountLocation = glGetUniformLocation(m_drawProgram, "levelCount");
+
+	// the smaller feedback target picks coarser levels, so bias them back
+	glUseProgram(m_feedbackProgram);
+	glUniform1f(glGetUniformLocation(m_feedbackProgram, "levelBias"), -std::log2((float)FEEDBACK_SCALE));
+	glUseProgram(m_drawProgram);
+	ShaderUtils::SetSamplerUnit(m_drawProgram, "pageCache", PAGE_CACHE_UNIT);
+	ShaderUtils::SetSamplerUnit(m_drawProgram, "pageTable", PAGE_TABLE_UNIT);
+	glUseProgram(0);
+
+	// slot positions are stored in 8 bits of the page table
+	m_slotsPerSide = std::min(std::max(cacheSlotsPerSide, 2), 255);
+	int cacheSize = m_slotsPerSide * VirtualPageFile::PAGE_STRIDE;
+	GLint maxTextureSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	if (cacheSize > maxTextureSize)
+	{
+		m_slotsPerSide = maxTextureSize / VirtualPageFile::PAGE_STRIDE;
+		cacheSize = m_slotsPerSide * VirtualPageFile::PAGE_STRIDE;
+	}
+
+	// each page carries its own border, so plain bilinear filtering
+	// never reads from the page next to it
+	glGenTextures(1, &m_pageCache);
+	glBindTexture(GL_TEXTURE_2D, m_pageCache);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	CACHE_SLOT emptySlot;
+	emptySlot.pageKey = 0;
+	emptySlot.lastUsedFrame = -1;
+	emptySlot.bUsed = false;
+	emptySlot.bPinned = false;
+	m_slots.assign(m_slotsPerSide * m_slotsPerSide, emptySlot);
+
+	glGenBuffers(READBACK_COUNT, m_readbackBuffers);
+
+	m_loaderThread = std::thread(&VirtualTexturing::LoaderThread, this);
+
+	std::cout << "INFO: Virtual texturing initialized with " << m_slots.size() << " cache pages" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used to open the page file of a virtual
+ *  texture.  Its coarsest page is loaded right away and
+ *  pinned in the cache, so the surface always has something
+ *  to show.  A missing file is not reported.
+ ***********************************************************/
+int VirtualTexturing::AddTexture(const char* pageFilePath, const std::string& tag)
+{
+	if (m_textureCount >= MAX_VIRTUAL_TEXTURES)
+	{
+		std::cout << "ERROR: Only " << MAX_VIRTUAL_TEXTURES << " virtual textures are supported" << std::endl;
+		return -1;
+	}
+
+	VirtualPageFile* pPages = new VirtualPageFile();
+	if (!pPages->Open(pageFilePath))
+	{
+		delete pPages;
+		return -1;
+	}
+	if ((pPages->GetPagesX(0) > MAX_PAGES_ACROSS) || (pPages->GetPagesY(0) > MAX_PAGES_ACROSS))
+	{
+		std::cout << "ERROR: " << pageFilePath << " is larger than " << MAX_PAGES_ACROSS << " pages across" << std::endl;
+		delete pPages;
+		return -1;
+	}
+
+	int index = m_textureCount;
+	int topLevel = pPages->GetLevelCount() - 1;
+	std::vector<unsigned char> pixels;
+	if (!pPages->ReadPage(topLevel, 0, 0, pixels) ||
+		!UploadPage(MakePageKey(index, topLevel, 0, 0), pixels.data(), true))
+	{
+		std::cout << "ERROR: Could not load the top page of " << pageFilePath << std::endl;
+		delete pPages;
+		return -1;
+	}
+
+	VIRTUAL_TEXTURE* pTexture = new VIRTUAL_TEXTURE();
+	pTexture->tag = tag;
+	pTexture->pPages = pPages;
+	pTexture->tableEntries.resize((size_t)pPages->GetPagesX(0) * pPages->GetPagesY(0) * pPages->GetLevelCount() * 4);
+	pTexture->bTableDirty = true;
+
+	// integer page table entries are read with texelFetch
+	glGenTextures(1, &pTexture->pageTable);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, pTexture->pageTable);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8UI, pPages->GetPagesX(0), pPages->GetPagesY(0),
+		pPages->GetLevelCount(), 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// the loader only sees this texture once a page of it is requested
+	m_textures[index] = pTexture;
+	m_textureCount++;
+	RebuildPageTable(index);
+
+	std::cout << "INFO: Virtual texture " << tag << " is " << pPages->GetWidth() << "x" << pPages->GetHeight()
+		<< " in " << pPages->GetLevelCount() << " levels" << std::endl;
+
+	return index;
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used to get the index of a virtual
+ *  texture from its tag, or -1.
+ ***********************************************************/
+int VirtualTexturing::FindTexture(const std::string& tag) const
+{
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		if (m_textures[i]->tag == tag)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/***********************************************************
+ *  LoaderThread()
+ *
+ *  This method is used to read the requested pages from
+ *  disk, one at a time, and hand them back to the main
+ *  thread.  Only the main thread touches OpenGL.
+ ***********************************************************/
+void VirtualTexturing::LoaderThread()
+{
+	std::unique_lock<std::mutex> lock(m_loaderMutex);
+	while (true)
+	{
+		m_loaderCondition.wait(lock, [this]() { return m_bStopLoader || !m_pageRequests.empty(); });
+		if (m_bStopLoader)
+		{
+			return;
+		}
+
+		LOADED_PAGE page;
+		page.pageKey = m_pageRequests.front();
+		m_pageRequests.pop_front();
+		lock.unlock();
+
+		int texture = (int)(page.pageKey >> 28);
+		int level = (int)((page.pageKey >> 24) & 0xF);
+		int pageY = (int)((page.pageKey >> 12) & 0xFFF);
+		int pageX = (int)(page.pageKey & 0xFFF);
+		if (!m_textures[texture]->pPages->ReadPage(level, pageX, pageY, page.pixels))
+		{
+			page.pixels.clear();
+		}
+
+		lock.lock();
+		m_loadedPages.push_back(std::move(page));
+	}
+}
+
+/***********************************************************
+ *  ReadFeedback()
+ *
+ *  This method is used to map the oldest feedback readback
+ *  whose fence has passed, and collect the pages it names.
+ *  Nothing waits on the GPU; if no readback is done yet the
+ *  last requests simply stay in place.
+ ***********************************************************/
+bool VirtualTexturing::ReadFeedback(std::unordered_set<unsigned int>& neededPages)
+{
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		// the next slot to be written holds the oldest readback
+		int index = (m_readbackIndex + i) % READBACK_COUNT;
+		if (m_readbackFences[index] == 0)
+		{
+			continue;
+		}
+		GLenum result = glClientWaitSync(m_readbackFences[index], 0, 0);
+		if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+		{
+			continue;
+		}
+		glDeleteSync(m_readbackFences[index]);
+		m_readbackFences[index] = 0;
+
+		size_t pixelCount = (size_t)m_readbackWidths[index] * m_readbackHeights[index];
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffers[index]);
+		const unsigned char* pixels = (const unsigned char*)glMapBufferRange(
+			GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)(pixelCount * 4), GL_MAP_READ_BIT);
+		if (pixels != nullptr)
+		{
+			for (size_t p = 0; p < pixelCount; p++)
+			{
+				const unsigned char* feedback = &pixels[p * 4];
+				if (feedback[3] == 0)
+				{
+					continue;
+				}
+				int texture = feedback[2] >> 4;
+				int level = feedback[2] & 0xF;
+				if ((texture >= m_textureCount) || (level >= m_textures[texture]->pPages->GetLevelCount()) ||
+					(feedback[0] >= m_textures[texture]->pPages->GetPagesX(level)) ||
+					(feedback[1] >= m_textures[texture]->pPages->GetPagesY(level)))
+				{
+					continue;
+				}
+				neededPages.insert(MakePageKey(texture, level, feedback[0], feedback[1]));
+			}
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		return true;
+	}
+	return false;
+}
+
+/***********************************************************
+ *  AllocateSlot()
+ *
+ *  This method is used to find a cache slot for a new page.
+ *  A free slot is used first, then the least recently used
+ *  page that was not needed this frame and is not pinned.
+ *  Returns -1 when every page is in use.
+ ***********************************************************/
+int VirtualTexturing::AllocateSlot()
+{
+	int oldestSlot = -1;
+	for (int i = 0; i < (int)m_slots.size(); i++)
+	{
+		if (!m_slots[i].bUsed)
+		{
+			return i;
+		}
+		if (!m_slots[i].bPinned && (m_slots[i].lastUsedFrame < m_frame) &&
+			((oldestSlot < 0) || (m_slots[i].lastUsedFrame < m_slots[oldestSlot].lastUsedFrame)))
+		{
+			oldestSlot = i;
+		}
+	}
+
+	if (oldestSlot >= 0)
+	{
+		// the page table that pointed here falls back to a coarser page
+		unsigned int evictedKey = m_slots[oldestSlot].pageKey;
+		m_residentPages.erase(evictedKey);
+		m_textures[evictedKey >> 28]->bTableDirty = true;
+		m_slots[oldestSlot].bUsed = false;
+	}
+	return oldestSlot;
+}
+
+/***********************************************************
+ *  UploadPage()
+ *
+ *  This method is used to copy a loaded page into a slot of
+ *  the physical cache.
+ ***********************************************************/
+bool VirtualTexturing::UploadPage(unsigned int pageKey, const unsigned char* pixels, bool bPinned)
+{
+	int slot = AllocateSlot();
+	if (slot < 0)
+	{
+		return false;
+	}
+
+	int slotX = slot % m_slotsPerSide;
+	int slotY = slot / m_slotsPerSide;
+	glBindTexture(GL_TEXTURE_2D, m_pageCache);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0,
+		slotX * VirtualPageFile::PAGE_STRIDE, slotY * VirtualPageFile::PAGE_STRIDE,
+		VirtualPageFile::PAGE_STRIDE, VirtualPageFile::PAGE_STRIDE,
+		GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	m_slots[slot].pageKey = pageKey;
+	m_slots[slot].lastUsedFrame = m_frame;
+	m_slots[slot].bUsed = true;
+	m_slots[slot].bPinned = bPinned;
+	m_residentPages[pageKey] = slot;
+	if (m_textures[pageKey >> 28] != nullptr)
+	{
+		m_textures[pageKey >> 28]->bTableDirty = true;
+	}
+	return true;
+}
+
+/***********************************************************
+ *  RebuildPageTable()
+ *
+ *  This method is used to fill the page table of a texture
+ *  from the coarsest level down.  Every entry names the
+ *  cache slot of its own page when that page is in the
+ *  cache, and otherwise copies the entry of its parent, so
+ *  a missing page shows the best coarser page instead.
+ ***********************************************************/
+void VirtualTexturing::RebuildPageTable(int virtualTexture)
+{
+	VIRTUAL_TEXTURE& texture = *m_textures[virtualTexture];
+	VirtualPageFile& pages = *texture.pPages;
+	int tableWidth = pages.GetPagesX(0);
+	size_t layerSize = (size_t)tableWidth * pages.GetPagesY(0);
+
+	for (int level = pages.GetLevelCount() - 1; level >= 0; level--)
+	{
+		for (int pageY = 0; pageY < pages.GetPagesY(level); pageY++)
+		{
+			for (int pageX = 0; pageX < pages.GetPagesX(level); pageX++)
+			{
+				unsigned char* entry = &texture.tableEntries[(level * layerSize + (size_t)pageY * tableWidth + pageX) * 4];
+				auto resident = m_residentPages.find(MakePageKey(virtualTexture, level, pageX, pageY));
+				if (resident != m_residentPages.end())
+				{
+					entry[0] = (unsigned char)(resident->second % m_slotsPerSide);
+					entry[1] = (unsigned char)(resident->second / m_slotsPerSide);
+					entry[2] = (unsigned char)level;
+					entry[3] = 255;
+				}
+				else if (level < pages.GetLevelCount() - 1)
+				{
+					const unsigned char* parent = &texture.tableEntries[((level + 1) * layerSize + (size_t)(pageY >> 1) * tableWidth + (pageX >> 1)) * 4];
+					memcpy(entry, parent, 4);
+				}
+			}
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture.pageTable);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, tableWidth, pages.GetPagesY(0), pages.GetLevelCount(),
+		GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, texture.tableEntries.data());
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	texture.bTableDirty = false;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used to act on the oldest feedback that
+ *  is ready.  The pages it names, and the coarser pages
+ *  above them, are marked as used, and the missing ones are
+ *  queued for the loader coarse levels first, replacing the
+ *  requests of the last feedback.  Then a few of the loaded
+ *  pages are put in the cache and the page tables that
+ *  changed are uploaded.
+ ***********************************************************/
+void VirtualTexturing::Update(RenderStats& stats)
+{
+	m_frame++;
+
+	std::unordered_set<unsigned int> neededPages;
+	if (ReadFeedback(neededPages))
+	{
+		std::vector<unsigned int> missingPages;
+		std::unordered_set<unsigned int> visitedPages;
+		for (unsigned int pageKey : neededPages)
+		{
+			int texture = (int)(pageKey >> 28);
+			int pageY = (int)((pageKey >> 12) & 0xFFF);
+			int pageX = (int)(pageKey & 0xFFF);
+			int levelCount = m_textures[texture]->pPages->GetLevelCount();
+			for (int level = (int)((pageKey >> 24) & 0xF); level < levelCount; level++)
+			{
+				unsigned int key = MakePageKey(texture, level, pageX, pageY);
+				if (!visitedPages.insert(key).second)
+				{
+					break;
+				}
+				auto resident = m_residentPages.find(key);
+				if (resident != m_residentPages.end())
+				{
+					m_slots[resident->second].lastUsedFrame = m_frame;
+				}
+				else
+				{
+					missingPages.push_back(key);
+				}
+				pageX >>= 1;
+				pageY >>= 1;
+			}
+		}
+
+		// coarse pages first, so the fallback sharpens a step at a time
+		std::sort(missingPages.begin(), missingPages.end(), [](unsigned int a, unsigned int b)
+			{
+				return ((a >> 24) & 0xF) > ((b >> 24) & 0xF);
+			});
+
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		for (unsigned int staleKey : m_pageRequests)
+		{
+			m_pagesInFlight.erase(staleKey);
+		}
+		m_pageRequests.clear();
+		for (unsigned int pageKey : missingPages)
+		{
+			if ((int)m_pageRequests.size() >= MAX_PAGE_REQUESTS)
+			{
+				break;
+			}
+			if (m_pagesInFlight.insert(pageKey).second)
+			{
+				m_pageRequests.push_back(pageKey);
+			}
+		}
+	}
+	m_loaderCondition.notify_one();
+
+	{
+		std::lock_guard<std::mutex> lock(m_loaderMutex);
+		for (LOADED_PAGE& page : m_loadedPages)
+		{
+			m_uploadQueue.push_back(std::move(page));
+		}
+		m_loadedPages.clear();
+	}
+
+	int uploads = 0;
+	size_t consumed = 0;
+	for (; (consumed < m_uploadQueue.size()) && (uploads < MAX_PAGE_UPLOADS); consumed++)
+	{
+		LOADED_PAGE& page = m_uploadQueue[consumed];
+		m_pagesInFlight.erase(page.pageKey);
+		if (page.pixels.empty() || (m_residentPages.count(page.pageKey) > 0))
+		{
+			continue;
+		}
+		// a page that finds no free slot is simply asked for again later
+		if (UploadPage(page.pageKey, page.pixels.data(), false))
+		{
+			uploads++;
+		}
+	}
+	m_uploadQueue.erase(m_uploadQueue.begin(), m_uploadQueue.begin() + consumed);
+	m_pagesUploaded = uploads;
+
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		if (m_textures[i]->bTableDirty)
+		{
+			RebuildPageTable(i);
+		}
+	}
+
+	stats.virtualPagesResident = (int)m_residentPages.size();
+	stats.virtualPagesPending = (int)m_pagesInFlight.size();
+	stats.virtualPagesUploaded = m_pagesUploaded;
+}
+
+/***********************************************************
+ *  ResizeFeedbackTarget()
+ *
+ *  This method is used to reallocate the feedback target
+ *  when the screen size changes.
+ ***********************************************************/
+void VirtualTexturing::ResizeFeedbackTarget(int width, int height)
+{
+	if ((width == m_feedbackWidth) && (height == m_feedbackHeight))
+	{
+		return;
+	}
+
+	glDeleteFramebuffers(1, &m_feedbackFramebuffer);
+	glDeleteRenderbuffers(1, &m_feedbackColor);
+	glDeleteRenderbuffers(1, &m_feedbackDepth);
+	m_feedbackWidth = width;
+	m_feedbackHeight = height;
+
+	glGenRenderbuffers(1, &m_feedbackColor);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_feedbackColor);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &m_feedbackDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_feedbackDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_feedbackFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_feedbackFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_feedbackColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_feedbackDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: Virtual texture feedback framebuffer is incomplete" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  SetTextureUniforms()
+ *
+ *  This method is used to set the size and level count of
+ *  a virtual texture into the program in use.
+ ***********************************************************/
+void VirtualTexturing::SetTextureUniforms(GLint sizeLocation, GLint levelCountLocation, int virtualTexture)
+{
+	const VirtualPageFile& pages = *m_textures[virtualTexture]->pPages;
+	glUniform2f(sizeLocation, (float)pages.GetWidth(), (float)pages.GetHeight());
+	glUniform1i(levelCountLocation, pages.GetLevelCount());
+}
+
+/***********************************************************
+ *  BeginFeedbackPass()
+ *
+ *  This method is used to bind and clear the feedback
+ *  target.  The framebuffer, viewport and blending in use
+ *  are saved, so the pass can run in any render path.
+ ***********************************************************/
+void VirtualTexturing::BeginFeedbackPass(const glm::mat4& view, const glm::mat4& projection, int width, int height, RenderStats& stats)
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	m_bSavedBlend = glIsEnabled(GL_BLEND);
+
+	ResizeFeedbackTarget(std::max(width / FEEDBACK_SCALE, 1), std::max(height / FEEDBACK_SCALE, 1));
+	glBindFramebuffer(GL_FRAMEBUFFER, m_feedbackFramebuffer);
+	glViewport(0, 0, m_feedbackWidth, m_feedbackHeight);
+
+	// alpha 0 marks the pixels with no virtual surface
+	const GLfloat clearFeedback[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearDepth = 1.0f;
+	glClearBufferfv(GL_COLOR, 0, clearFeedback);
+	glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glUseProgram(m_feedbackProgram);
+	glUniformMatrix4fv(glGetUniformLocation(m_feedbackProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(glGetUniformLocation(m_feedbackProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	stats.programSwitches++;
+	stats.uniformUploads += 2;
+}
+
+/***********************************************************
+ *  SetFeedbackItem()
+ *
+ *  This method is used to set the per-object values into
+ *  the feedback program before the mesh is drawn.
+ ***********************************************************/
+void VirtualTexturing::SetFeedbackItem(const glm::mat4& model, int virtualTexture, RenderStats& stats)
+{
+	glUniformMatrix4fv(m_feedbackModelLocation, 1, GL_FALSE, glm::value_ptr(model));
+	glUniform1i(m_feedbackTextureLocation, virtualTexture);
+	SetTextureUniforms(m_feedbackSizeLocation, m_feedbackLevelCountLocation, virtualTexture);
+	stats.uniformUploads += 4;
+}
+
+/***********************************************************
+ *  EndFeedbackPass()
+ *
+ *  This method is used to start the copy of the feedback
+ *  into the next readback buffer and put the framebuffer,
+ *  viewport and blending back.  A readback that was never
+ *  read is dropped for the newer one.
+ ***********************************************************/
+void VirtualTexturing::EndFeedbackPass()
+{
+	int index = m_readbackIndex;
+	if (m_readbackFences[index] != 0)
+	{
+		glDeleteSync(m_readbackFences[index]);
+		m_readbackFences[index] = 0;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbackBuffers[index]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)m_feedbackWidth * m_feedbackHeight * 4, nullptr, GL_STREAM_READ);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_feedbackWidth, m_feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_readbackFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_readbackWidths[index] = m_feedbackWidth;
+	m_readbackHeights[index] = m_feedbackHeight;
+	m_readbackIndex = (index + 1) % READBACK_COUNT;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	if (m_bSavedBlend)
+	{
+		glEnable(GL_BLEND);
+	}
+}
+
+/***********************************************************
+ *  BeginDrawPass()
+ *
+ *  This method is used to bind the draw program, the page
+ *  cache and the camera and light values.  It draws into
+ *  whatever framebuffer is bound, after the opaque pass.
+ ***********************************************************/
+void VirtualTexturing::BeginDrawPass(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const glm::vec3& viewPosition,
+	const std::vector<SceneManager::LIGHT_SOURCE>& lights,
+	RenderStats& stats)
+{
+	glUseProgram(m_drawProgram);
+	glUniformMatrix4fv(glGetUniformLocation(m_drawProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(glGetUniformLocation(m_drawProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+	glUniform3fv(glGetUniformLocation(m_drawProgram, "viewPosition"), 1, glm::value_ptr(viewPosition));
+
+	int lightCount = std::min((int)lights.size(), VIRTUAL_LIGHT_COUNT);
+	glUniform1i(glGetUniformLocation(m_drawProgram, "lightCount"), lightCount);
+	for (int i = 0; i < lightCount; i++)
+	{
+		std::string lightName = "lightSources[" + std::to_string(i) + "]";
+		glUniform3fv(glGetUniformLocation(m_drawProgram, (lightName + ".position").c_str()), 1, glm::value_ptr(lights[i].position));
+		glUniform3fv(glGetUniformLocation(m_drawProgram, (lightName + ".ambientColor").c_str()), 1, glm::value_ptr(lights[i].ambientColor));
+		glUniform3fv(glGetUniformLocation(m_drawProgram, (lightName + ".diffuseColor").c_str()), 1, glm::value_ptr(lights[i].diffuseColor));
+		glUniform3fv(glGetUniformLocation(m_drawProgram, (lightName + ".specularColor").c_str()), 1, glm::value_ptr(lights[i].specularColor));
+		glUniform1f(glGetUniformLocation(m_drawProgram, (lightName + ".focalStrength").c_str()), lights[i].focalStrength);
+		glUniform1f(glGetUniformLocation(m_drawProgram, (lightName + ".specularIntensity").c_str()), lights[i].specularIntensity);
+	}
+
+	glActiveTexture(GL_TEXTURE0 + PAGE_CACHE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_pageCache);
+
+	stats.programSwitches++;
+	stats.textureBinds++;
+	stats.uniformUploads += 4 + 6 * lightCount;
+}
+
+/***********************************************************
+ *  SetDrawItem()
+ *
+ *  This method is used to set the per-object values and the
+ *  page table into the draw program before the mesh is
+ *  drawn.
+ ***********************************************************/
+void VirtualTexturing::SetDrawItem(
+	const glm::mat4& model,
+	int virtualTexture,
+	const SceneManager::OBJECT_MATERIAL& material,
+	RenderStats& stats)
+{
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+	glUniformMatrix4fv(m_drawModelLocation, 1, GL_FALSE, glm::value_ptr(model));
+	glUniformMatrix3fv(m_drawNormalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+	SetTextureUniforms(m_drawSizeLocation, m_drawLevelCountLocation, virtualTexture);
+
+	glUniform1f(glGetUniformLocation(m_drawProgram, "material.ambientStrength"), material.ambientStrength);
+	glUniform3fv(glGetUniformLocation(m_drawProgram, "material.ambientColor"), 1, glm::value_ptr(material.ambientColor));
+	glUniform3fv(glGetUniformLocation(m_drawProgram, "material.diffuseColor"), 1, glm::value_ptr(material.diffuseColor));
+	glUniform3fv(glGetUniformLocation(m_drawProgram, "material.specularColor"), 1, glm::value_ptr(material.specularColor));
+	glUniform1f(glGetUniformLocation(m_drawProgram, "material.shininess"), material.shininess);
+
+	glActiveTexture(GL_TEXTURE0 + PAGE_TABLE_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_textures[virtualTexture]->pageTable);
+	glActiveTexture(GL_TEXTURE0);
+
+	stats.textureBinds++;
+	stats.uniformUploads += 9;
+}
@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// virtualtexturing.h
+// ============
+// page table, page cache and feedback passes for sparse virtual textures
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager_revised.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class VirtualPageFile;
+
+/***********************************************************
+ *  VirtualTexturing
+ *
+ *  This class draws surfaces whose texture is far too large
+ *  to load, such as a unique floor or wall.  Every virtual
+ *  texture has a page table, and all of them share one
+ *  physical cache of fixed size pages, so the memory used is
+ *  set by the cache and not by the texture sizes.
+ *
+ *  Each frame the virtual surfaces are drawn into a small
+ *  feedback target that records the page every pixel needs.
+ *  It is read back a few frames later, the missing pages are
+ *  queued for a loader thread, and the loaded ones replace
+ *  the least recently needed pages in the cache.  Until a
+ *  page arrives, the page table points at the closest
+ *  coarser page that is in the cache.
+ ***********************************************************/
+class VirtualTexturing
+{
+public:
+	// constructor
+	VirtualTexturing();
+	// destructor
+	~VirtualTexturing();
+
+	// build the programs, the page cache and the feedback target,
+	// and start the page loader
+	bool Initialize(int cacheSlotsPerSide);
+
+	// open a page file and load its coarsest level, returns the index or -1
+	int AddTexture(const char* pageFilePath, const std::string& tag);
+	int FindTexture(const std::string& tag) const;
+	int GetTextureCount() const { return m_textureCount; }
+
+	// read the oldest feedback, queue the missing pages and put the
+	// loaded ones in the cache
+	void Update(RenderStats& stats);
+
+	// feedback pass - record the pages the virtual surfaces need
+	void BeginFeedbackPass(const glm::mat4& view, const glm::mat4& projection, int width, int height, RenderStats& stats);
+	void SetFeedbackItem(const glm::mat4& model, int virtualTexture, RenderStats& stats);
+	void EndFeedbackPass();
+
+	// draw pass - shade the virtual surfaces through their page tables
+	void BeginDrawPass(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		const glm::vec3& viewPosition,
+		const std::vector<SceneManager::LIGHT_SOURCE>& lights,
+		RenderStats& stats);
+	void SetDrawItem(
+		const glm::mat4& model,
+		int virtualTexture,
+		const SceneManager::OBJECT_MATERIAL& material,
+		RenderStats& stats);
+
+private:
+	// the feedback encodes the texture in 4 bits
+	static const int MAX_VIRTUAL_TEXTURES = 16;
+	// feedback readbacks in flight, read a few frames late to avoid stalls
+	static const int READBACK_COUNT = 3;
+
+	struct VIRTUAL_TEXTURE
+	{
+		std::string tag;
+		VirtualPageFile* pPages;
+		// one array layer per level, each as large as level 0, holding
+		// the cache slot and level of the page to sample
+		GLuint pageTable;
+		std::vector<unsigned char> tableEntries;
+		bool bTableDirty;
+	};
+
+	struct CACHE_SLOT
+	{
+		unsigned int pageKey;
+		long long lastUsedFrame;
+		bool bUsed;
+		// the coarsest level of each texture never leaves the cache
+		bool bPinned;
+	};
+
+	struct LOADED_PAGE
+	{
+		unsigned int pageKey;
+		// empty when the page could not be read
+		std::vector<unsigned char> pixels;
+	};
+
+	VIRTUAL_TEXTURE* m_textures[MAX_VIRTUAL_TEXTURES];
+	int m_textureCount;
+
+	// physical page cache and what is in each slot
+	GLuint m_pageCache;
+	int m_slotsPerSide;
+	std::vector<CACHE_SLOT> m_slots;
+	std::unordered_map<unsigned int, int> m_residentPages;
+
+	// feedback target and its readbacks
+	GLuint m_feedbackFramebuffer;
+	GLuint m_feedbackColor;
+	GLuint m_feedbackDepth;
+	int m_feedbackWidth;
+	int m_feedbackHeight;
+	GLuint m_readbackBuffers[READBACK_COUNT];
+	GLsync m_readbackFences[READBACK_COUNT];
+	int m_readbackWidths[READBACK_COUNT];
+	int m_readbackHeights[READBACK_COUNT];
+	int m_readbackIndex;
+	GLint m_savedFramebuffer;
+	GLint m_savedViewport[4];
+	GLboolean m_bSavedBlend;
+
+	GLuint m_feedbackProgram;
+	GLuint m_drawProgram;
+	GLint m_feedbackModelLocation;
+	GLint m_feedbackTextureLocation;
+	GLint m_feedbackSizeLocation;
+	GLint m_feedbackLevelCountLocation;
+	GLint m_drawModelLocation;
+	GLint m_drawNormalMatrixLocation;
+	GLint m_drawSizeLocation;
+	GLint m_drawLevelCountLocation;
+
+	// page loader thread - the requests and loaded pages are shared
+	std::thread m_loaderThread;
+	std::mutex m_loaderMutex;
+	std::condition_variable m_loaderCondition;
+	bool m_bStopLoader;
+	std::deque<unsigned int> m_pageRequests;
+	std::vector<LOADED_PAGE> m_loadedPages;
+	// main thread only - pages asked for and not yet in the cache
+	std::unordered_set<unsigned int> m_pagesInFlight;
+	std::vector<LOADED_PAGE> m_uploadQueue;
+
+	long long m_frame;
+	int m_pagesUploaded;
+
+	// load pages in the background until told to stop
+	void LoaderThread();
+	// turn the oldest finished readback into the set of needed pages,
+	// false when no readback has finished yet
+	bool ReadFeedback(std::unordered_set<unsigned int>& neededPages);
+	// put a page in a free or least recently used cache slot
+	bool UploadPage(unsigned int pageKey, const unsigned char* pixels, bool bPinned);
+	int AllocateSlot();
+	// point every page table entry at the best page in the cache
+	void RebuildPageTable(int virtualTexture);
+	// set the values that come from the texture being drawn
+	void SetTextureUniforms(GLint sizeLocation, GLint levelCountLocation, int virtualTexture);
+	// resize the feedback target to the passed in size
+	void ResizeFeedbackTarget(int width, int height);
+
+	static unsigned int MakePageKey(int texture, int level, int pageX, int pageY);
+};